@@ -0,0 +1,124 @@
+#include "binlog.h"
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include "binlog_codec.h"
+
+static const char *TAG = "binlog";
+
+#define BINLOG_LINE_MAX 192 // Sformatowany wpis bez prefiksu (dłuższe są obcinane)
+
+// Nagłówek wpisu w buforze; po nim argumenty z binlog_pack()
+typedef struct {
+    const char *fmt;    // Identyfikator wpisu
+    const char *tag;
+    uint32_t time_ms;   // esp_log_timestamp() przy zapisie
+    uint8_t level;
+} binlog_header_t;
+
+static RingbufHandle_t ring;
+static atomic_uint written;
+static atomic_uint dropped;
+
+#if CONFIG_MONITOR_BINLOG
+static StaticRingbuffer_t ring_struct;
+static uint8_t ring_storage[CONFIG_MONITOR_BINLOG_BUFFER];
+#endif
+
+void binlog_init(void) {
+#if CONFIG_MONITOR_BINLOG
+    if (ring == NULL) {
+        ring = xRingbufferCreateStatic(sizeof(ring_storage), RINGBUF_TYPE_NOSPLIT, ring_storage, &ring_struct);
+    }
+#endif
+}
+
+static void print_line(esp_log_level_t level, const char *tag, uint32_t time_ms, const char *text) {
+    switch (level) {
+        case ESP_LOG_ERROR:
+            esp_log_write(level, tag, LOG_FORMAT(E, "%s"), time_ms, tag, text);
+            break;
+        case ESP_LOG_WARN:
+            esp_log_write(level, tag, LOG_FORMAT(W, "%s"), time_ms, tag, text);
+            break;
+        case ESP_LOG_INFO:
+            esp_log_write(level, tag, LOG_FORMAT(I, "%s"), time_ms, tag, text);
+            break;
+        case ESP_LOG_DEBUG:
+            esp_log_write(level, tag, LOG_FORMAT(D, "%s"), time_ms, tag, text);
+            break;
+        default:
+            esp_log_write(level, tag, LOG_FORMAT(V, "%s"), time_ms, tag, text);
+            break;
+    }
+}
+
+void binlog_write(esp_log_level_t level, const char *tag, const char *fmt, ...) {
+    uint8_t record[sizeof(binlog_header_t) + BINLOG_ARGS_MAX];
+    binlog_header_t header = {
+        .fmt = fmt,
+        .tag = tag,
+        .time_ms = esp_log_timestamp(),
+        .level = (uint8_t)level,
+    };
+    memcpy(record, &header, sizeof(header));
+    va_list args;
+    va_start(args, fmt);
+    size_t len = sizeof(header) + binlog_pack(record + sizeof(header), BINLOG_ARGS_MAX, fmt, args);
+    va_end(args);
+
+    if (ring == NULL) {
+        // Przed binlog_init() (albo bez CONFIG_MONITOR_BINLOG) - od razu, jak ESP_LOG
+        char line[BINLOG_LINE_MAX];
+        binlog_format(line, sizeof(line), fmt, record + sizeof(header), len - sizeof(header));
+        print_line(level, tag, header.time_ms, line);
+        return;
+    }
+
+    BaseType_t sent;
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        sent = xRingbufferSendFromISR(ring, record, len, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    } else {
+        sent = xRingbufferSend(ring, record, len, 0); // Bez czekania - pełny bufor odrzuca wpis
+    }
+    atomic_fetch_add_explicit(sent == pdTRUE ? &written : &dropped, 1, memory_order_relaxed);
+}
+
+void binlog_drain_task(void *arg) {
+    if (ring == NULL) {
+        vTaskDelete(NULL);
+        return;
+    }
+    static char line[BINLOG_LINE_MAX];
+    uint32_t reported = 0;
+    while (1) {
+        size_t size = 0;
+        uint8_t *record = xRingbufferReceive(ring, &size, portMAX_DELAY);
+        if (record == NULL) {
+            continue;
+        }
+        binlog_header_t header;
+        memcpy(&header, record, sizeof(header));
+        binlog_format(line, sizeof(line), header.fmt, record + sizeof(header), size - sizeof(header));
+        vRingbufferReturnItem(ring, record); // Zwolnienie miejsca przed powolnym zapisem na UART
+        print_line((esp_log_level_t)header.level, header.tag, header.time_ms, line);
+
+        uint32_t lost = atomic_load_explicit(&dropped, memory_order_relaxed);
+        if (lost != reported) {
+            ESP_LOGW(TAG, "Pominięto %lu wpisów dziennika (pełny bufor).", (unsigned long)(lost - reported));
+            reported = lost;
+        }
+    }
+}
+
+void binlog_get_stats(uint32_t *written_out, uint32_t *dropped_out) {
+    *written_out = atomic_load_explicit(&written, memory_order_relaxed);
+    *dropped_out = atomic_load_explicit(&dropped, memory_order_relaxed);
+}
@@ -0,0 +1,58 @@
+/**
+ * @file binlog.h
+ * Dziennik binarny: wpisy z gorących ścieżek bez formatowania i bez zapisu na UART.
+ *
+ * BINLOGI()/BINLOGW()... zapisują do bufora pierścieniowego wskaźnik ciągu
+ * formatującego (jego identyfikator - literał leży we flashu), znacznik, czas
+ * i surowe argumenty (binlog_codec.h). Tekst formatuje dopiero zadanie
+ * binlog_drain_task o niskim priorytecie i wypisuje go przez esp_log_write
+ * w zwykłym formacie ESP_LOG - z czasem zapisu wpisu, nie wypisania. Poziom
+ * logowania znacznika (esp_log_level_set) sprawdzany jest przy wypisaniu.
+ *
+ * Znacznik i ciąg formatujący muszą żyć do wypisania wpisu (literały, stałe TAG).
+ * Przy zapełnionym buforze nowe wpisy są odrzucane i liczone; zadanie zgłasza ich
+ * liczbę przy następnym wypisaniu. Przed binlog_init() wpisy są formatowane od razu.
+ *
+ * Bez CONFIG_MONITOR_BINLOG makra są zwykłymi ESP_LOG_LEVEL_LOCAL.
+ */
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdint.h>
+#include "esp_log.h"
+#include "sdkconfig.h"
+
+/** Tworzy bufor wpisów (statyczny, CONFIG_MONITOR_BINLOG_BUFFER bajtów). */
+void binlog_init(void);
+
+/** Zapis wpisu - przez makra BINLOG*. Można wywołać z przerwania. */
+void binlog_write(esp_log_level_t level, const char *tag, const char *fmt, ...);
+
+/** Zadanie wypisujące wpisy (task_table: TASK_LOG_DRAIN). */
+void binlog_drain_task(void *arg);
+
+/** Wpisy zapisane do bufora i odrzucone przy zapełnionym buforze od startu. */
+void binlog_get_stats(uint32_t *written, uint32_t *dropped);
+
+// Sprawdzenie argumentów przez kompilator (-Wformat) jak dla ESP_LOG
+static inline __attribute__((format(printf, 1, 2))) void binlog_check_format(const char *fmt, ...) {
+    (void)fmt;
+}
+
+#if CONFIG_MONITOR_BINLOG
+#define BINLOG(level, tag, fmt, ...) do {                                 \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                 \
+            binlog_check_format(fmt, ##__VA_ARGS__);                      \
+            binlog_write((level), (tag), (fmt), ##__VA_ARGS__);           \
+        }                                                                 \
+    } while (0)
+#else
+#define BINLOG(level, tag, fmt, ...) ESP_LOG_LEVEL_LOCAL((level), (tag), fmt, ##__VA_ARGS__)
+#endif
+
+#define BINLOGE(tag, fmt, ...) BINLOG(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define BINLOGW(tag, fmt, ...) BINLOG(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define BINLOGI(tag, fmt, ...) BINLOG(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define BINLOGD(tag, fmt, ...) BINLOG(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+#endif // BINLOG_H
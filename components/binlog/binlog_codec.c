@@ -0,0 +1,248 @@
+#include "binlog_codec.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef enum {
+    ARG_NONE = 0,   // "%%" - bez argumentu
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_STR,
+    ARG_PTR,
+    ARG_INVALID,
+} arg_type_t;
+
+typedef struct {
+    const char *start;  // Znak '%'
+    size_t len;
+    arg_type_t type;
+    bool is_unsigned;
+} spec_t;
+
+#define SPEC_MAX 16         // Najdłuższa obsługiwana specyfikacja, np. "%-+012.6llx"
+#define STR_NULL 0xFF       // Długość napisu NULL
+
+// Następna specyfikacja w ciągu; NULL, gdy ciąg się skończył
+static const char *next_spec(const char *p, spec_t *spec) {
+    p = strchr(p, '%');
+    if (p == NULL) {
+        return NULL;
+    }
+    spec->start = p++;
+    spec->is_unsigned = false;
+    if (*p == '%') {
+        spec->type = ARG_NONE;
+        spec->len = 2;
+        return p + 1;
+    }
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    arg_type_t length = ARG_INT;
+    if (*p == 'h') {
+        p += p[1] == 'h' ? 2 : 1; // Promocja do int
+    } else if (*p == 'l') {
+        length = p[1] == 'l' ? ARG_LLONG : ARG_LONG;
+        p += p[1] == 'l' ? 2 : 1;
+    } else if (*p == 'z' || *p == 'j' || *p == 't') {
+        length = *p == 'z' ? ARG_SIZE : *p == 'j' ? ARG_INTMAX : ARG_PTRDIFF;
+        p++;
+    }
+    char conv = *p;
+    if (conv == '\0') {
+        spec->type = ARG_INVALID;
+        spec->len = (size_t)(p - spec->start);
+        return p;
+    }
+    p++;
+    spec->len = (size_t)(p - spec->start);
+    if (strchr("di", conv)) {
+        spec->type = length;
+    } else if (strchr("uoxX", conv)) {
+        spec->type = length;
+        spec->is_unsigned = true;
+    } else if (conv == 'c') {
+        spec->type = ARG_INT;
+    } else if (strchr("fFeEgGaA", conv) && length == ARG_INT) {
+        spec->type = ARG_DOUBLE;
+    } else if (conv == 's' && length == ARG_INT) {
+        spec->type = ARG_STR;
+    } else if (conv == 'p') {
+        spec->type = ARG_PTR;
+    } else {
+        spec->type = ARG_INVALID; // '*', %n, %Lf, %ls
+    }
+    if (spec->len >= SPEC_MAX) {
+        spec->type = ARG_INVALID;
+    }
+    return p;
+}
+
+static size_t arg_size(arg_type_t type) {
+    switch (type) {
+        case ARG_INT:     return sizeof(int);
+        case ARG_LONG:    return sizeof(long);
+        case ARG_LLONG:   return sizeof(long long);
+        case ARG_SIZE:    return sizeof(size_t);
+        case ARG_INTMAX:  return sizeof(intmax_t);
+        case ARG_PTRDIFF: return sizeof(ptrdiff_t);
+        case ARG_DOUBLE:  return sizeof(double);
+        case ARG_PTR:     return sizeof(void *);
+        default:          return 0;
+    }
+}
+
+#define PACK(type) do { type v = va_arg(args, type); memcpy(out + pos, &v, sizeof(v)); } while (0)
+
+size_t binlog_pack(uint8_t *out, size_t out_size, const char *fmt, va_list args) {
+    size_t pos = 0;
+    spec_t spec;
+    const char *p = fmt;
+    while ((p = next_spec(p, &spec)) != NULL) {
+        if (spec.type == ARG_NONE) {
+            continue;
+        }
+        if (spec.type == ARG_INVALID) {
+            break; // Dalsze argumenty byłyby pobrane z przesunięciem
+        }
+        if (spec.type == ARG_STR) {
+            const char *s = va_arg(args, const char *);
+            size_t len = s ? strnlen(s, BINLOG_STR_MAX) : 0;
+            if (pos + 1 + len > out_size) {
+                break;
+            }
+            out[pos++] = s ? (uint8_t)len : STR_NULL;
+            memcpy(out + pos, s ? s : "", len);
+            pos += len;
+            continue;
+        }
+        if (pos + arg_size(spec.type) > out_size) {
+            break;
+        }
+        switch (spec.type) {
+            case ARG_INT:     PACK(int); break;
+            case ARG_LONG:    PACK(long); break;
+            case ARG_LLONG:   PACK(long long); break;
+            case ARG_SIZE:    PACK(size_t); break;
+            case ARG_INTMAX:  PACK(intmax_t); break;
+            case ARG_PTRDIFF: PACK(ptrdiff_t); break;
+            case ARG_DOUBLE:  PACK(double); break;
+            case ARG_PTR:     PACK(void *); break;
+            default: break;
+        }
+        pos += arg_size(spec.type);
+    }
+    return pos;
+}
+
+static void append(char *out, size_t out_size, size_t *pos, const char *text, size_t len) {
+    size_t room = out_size - 1 - *pos;
+    if (len > room) {
+        len = room;
+    }
+    memcpy(out + *pos, text, len);
+    *pos += len;
+}
+
+// Dopisuje wynik snprintf, pilnując końca bufora
+static void append_result(size_t out_size, size_t *pos, int written) {
+    if (written > 0) {
+        *pos += (size_t)written < out_size - 1 - *pos ? (size_t)written : out_size - 1 - *pos;
+    }
+}
+
+#define FORMAT(type, utype) do {                                                       \
+        type v;                                                                       \
+        memcpy(&v, args + used, sizeof(v));                                           \
+        written = spec.is_unsigned ? snprintf(out + pos, out_size - pos, buf, (utype)v) \
+                                   : snprintf(out + pos, out_size - pos, buf, v);      \
+    } while (0)
+
+size_t binlog_format(char *out, size_t out_size, const char *fmt, const uint8_t *args, size_t args_len) {
+    if (out_size == 0) {
+        return 0;
+    }
+    size_t pos = 0;
+    size_t used = 0;
+    spec_t spec;
+    const char *p = fmt;
+    const char *text = fmt;
+    while ((p = next_spec(p, &spec)) != NULL) {
+        append(out, out_size, &pos, text, (size_t)(spec.start - text));
+        text = p;
+        if (spec.type == ARG_NONE) {
+            append(out, out_size, &pos, "%", 1);
+            continue;
+        }
+        if (spec.type == ARG_INVALID) {
+            append(out, out_size, &pos, spec.start, strlen(spec.start));
+            break;
+        }
+        char buf[SPEC_MAX];
+        memcpy(buf, spec.start, spec.len);
+        buf[spec.len] = '\0';
+        int written = 0;
+        if (spec.type == ARG_STR) {
+            if (used >= args_len || (args[used] != STR_NULL && used + 1 + args[used] > args_len)) {
+                append(out, out_size, &pos, "?", 1);
+                used = args_len;
+                continue;
+            }
+            char s[BINLOG_STR_MAX + 1];
+            size_t len = args[used] == STR_NULL ? 0 : args[used];
+            memcpy(s, args + used + 1, len);
+            s[len] = '\0';
+            written = snprintf(out + pos, out_size - pos, buf, args[used] == STR_NULL ? "(null)" : s);
+            used += 1 + len;
+            append_result(out_size, &pos, written);
+            continue;
+        }
+        if (used + arg_size(spec.type) > args_len) {
+            append(out, out_size, &pos, "?", 1);
+            used = args_len;
+            continue;
+        }
+        switch (spec.type) {
+            case ARG_INT:     FORMAT(int, unsigned int); break;
+            case ARG_LONG:    FORMAT(long, unsigned long); break;
+            case ARG_LLONG:   FORMAT(long long, unsigned long long); break;
+            case ARG_SIZE:    FORMAT(size_t, size_t); break;
+            case ARG_INTMAX:  FORMAT(intmax_t, uintmax_t); break;
+            case ARG_PTRDIFF: FORMAT(ptrdiff_t, size_t); break;
+            case ARG_DOUBLE: {
+                double v;
+                memcpy(&v, args + used, sizeof(v));
+                written = snprintf(out + pos, out_size - pos, buf, v);
+                break;
+            }
+            case ARG_PTR: {
+                void *v;
+                memcpy(&v, args + used, sizeof(v));
+                written = snprintf(out + pos, out_size - pos, buf, v);
+                break;
+            }
+            default: break;
+        }
+        used += arg_size(spec.type);
+        append_result(out_size, &pos, written);
+    }
+    if (p == NULL) {
+        append(out, out_size, &pos, text, strlen(text));
+    }
+    out[pos] = '\0';
+    return pos;
+}
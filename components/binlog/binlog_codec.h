@@ -0,0 +1,38 @@
+/**
+ * @file binlog_codec.h
+ * Zapis argumentów wpisu dziennika binarnego w postaci surowej i późniejsze formatowanie.
+ *
+ * Pakowanie przechodzi ciąg formatujący tylko po to, by pobrać argumenty właściwego
+ * typu (va_arg) i skopiować je bajt po bajcie - bez konwersji liczb na tekst.
+ * Formatowanie odtwarza tekst z tego samego ciągu, wywołując snprintf osobno dla
+ * każdej specyfikacji. Obsługiwane są konwersje d i u o x X c f F e E g G a A s p
+ * z flagami, szerokością, precyzją i modyfikatorami hh h l ll z j t; napisy (%s)
+ * są kopiowane do BINLOG_STR_MAX bajtów. Szerokość i precyzja '*' oraz %n
+ * nie są obsługiwane - od takiej specyfikacji ciąg jest wypisywany bez zmian.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef BINLOG_CODEC_H
+#define BINLOG_CODEC_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BINLOG_STR_MAX 48   // Dłuższe napisy są obcinane
+#define BINLOG_ARGS_MAX 112 // Bajty argumentów jednego wpisu
+
+/**
+ * Kopiuje argumenty opisane ciągiem fmt do out.
+ * @return Liczba zapisanych bajtów; argumenty, które się nie mieszczą, są pomijane.
+ */
+size_t binlog_pack(uint8_t *out, size_t out_size, const char *fmt, va_list args);
+
+/**
+ * Formatuje wpis jak snprintf(out, out_size, fmt, ...) z argumentami z binlog_pack().
+ * Brakujące argumenty są zastępowane przez "?".
+ * @return Długość tekstu w out (obcięty do out_size - 1).
+ */
+size_t binlog_format(char *out, size_t out_size, const char *fmt, const uint8_t *args, size_t args_len);
+
+#endif // BINLOG_CODEC_H
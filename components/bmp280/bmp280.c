@@ -1,6 +1,7 @@
 #include "bmp280.h"
 #include "i2c_driver.h"
 #include "esp_log.h"
+#include "binlog.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -24,7 +25,7 @@ static bmp280_calib_t bmp280_calib;
 
 
 esp_err_t bmp280_write_register(uint8_t reg, uint8_t value) {
-    ESP_LOGI(TAG, "Zapis do rejestru 0x%02X: wartość = 0x%02X", reg, value);
+    BINLOGI(TAG, "Zapis do rejestru 0x%02X: wartość = 0x%02X", reg, value);
     esp_err_t err = i2c_write_register(bmp280_state.i2c_address, reg, value);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Błąd zapisu do rejestru 0x%02X", reg);
@@ -99,7 +100,7 @@ esp_err_t bmp280_set_mode(bmp280_mode_t mode) {
         return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "Tryb pracy ustawiony pomyślnie: 0x%02X", mode);
+    BINLOGI(TAG, "Tryb pracy ustawiony pomyślnie: 0x%02X", mode);
     return ESP_OK;
 }
 
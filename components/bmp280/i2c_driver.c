@@ -1,9 +1,22 @@
 #include "i2c_driver.h"
 #include "driver/i2c.h"
 #include "esp_log.h"
+#include "binlog.h"
 
 static const char *TAG = "I2C_DRIVER";
 
+// Liczniki błędów transakcji rejestrów (odczyt w i2c_get_error_counts())
+static volatile uint32_t error_count = 0;
+static volatile uint32_t timeout_count = 0;
+
+static void count_result(esp_err_t ret) {
+    if (ret == ESP_ERR_TIMEOUT) {
+        timeout_count++;
+    } else if (ret != ESP_OK) {
+        error_count++;
+    }
+}
+
 void i2c_master_init() {
     i2c_config_t conf = {
         .mode = I2C_MODE_MASTER,
@@ -36,7 +49,7 @@ void i2c_scan() {
 
 // Zapis pojedynczego bajta do określonego rejestru
 esp_err_t i2c_write_register(uint8_t device_addr, uint8_t reg_addr, uint8_t data) { // adres urządzenia, adres rejestru, wartość
-    ESP_LOGI("I2C", "Próba zapisu: addr=0x%02X, reg=0x%02X, val=0x%02X", device_addr, reg_addr, data);
+    BINLOGI("I2C", "Próba zapisu: addr=0x%02X, reg=0x%02X, val=0x%02X", device_addr, reg_addr, data);
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
     i2c_master_start(cmd);
     i2c_master_write_byte(cmd, (device_addr << 1) | I2C_MASTER_WRITE, true); // przesuwa adres o 1 w lewo i ustawia najmłodszy bit na 0
@@ -45,6 +58,7 @@ esp_err_t i2c_write_register(uint8_t device_addr, uint8_t reg_addr, uint8_t data
     i2c_master_stop(cmd);
     esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
     i2c_cmd_link_delete(cmd);
+    count_result(ret);
     return ret;
 }
 
@@ -52,6 +66,7 @@ esp_err_t i2c_write_register(uint8_t device_addr, uint8_t reg_addr, uint8_t data
 esp_err_t i2c_read_register(uint8_t device_addr, uint8_t reg_addr, uint8_t *data, size_t len) {
     i2c_cmd_handle_t cmd = i2c_cmd_link_create();
     if (cmd == NULL) {
+        count_result(ESP_FAIL);
         return ESP_FAIL;
     }
 
@@ -70,6 +85,7 @@ esp_err_t i2c_read_register(uint8_t device_addr, uint8_t reg_addr, uint8_t *data
 
     esp_err_t ret = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
     i2c_cmd_link_delete(cmd);
+    count_result(ret);
 
     if (ret != ESP_OK) {
         ESP_LOGE("I2C_READ", "Błąd przy odczycie rejestru 0x%02X z urządzenia 0x%02X", reg_addr, device_addr);
@@ -77,4 +93,7 @@ esp_err_t i2c_read_register(uint8_t device_addr, uint8_t reg_addr, uint8_t *data
     return ret;
 }
 
-
+void i2c_get_error_counts(uint32_t *errors, uint32_t *timeouts) {
+    *errors = error_count;
+    *timeouts = timeout_count;
+}
@@ -9,6 +9,8 @@ szukanie urządzeń na magistrali oraz operacje zapisu i odczytu rejestrów.
 #ifndef I2C_DRIVER_H
 #define I2C_DRIVER_H
 
+#include <stdint.h>
+#include <stddef.h>
 #include "esp_err.h"
 
 /**
@@ -75,4 +77,12 @@ esp_err_t i2c_write_register(uint8_t device_addr, uint8_t reg_addr, uint8_t data
  */
 esp_err_t i2c_read_register(uint8_t device_addr, uint8_t reg_addr, uint8_t *data, size_t len);
 
+/**
+ * @brief Zwraca liczbę nieudanych zapisów i odczytów rejestrów od startu.
+ *
+ * @param errors Błędy transakcji (brak potwierdzenia, błąd magistrali).
+ * @param timeouts Transakcje przerwane po przekroczeniu czasu.
+ */
+void i2c_get_error_counts(uint32_t *errors, uint32_t *timeouts);
+
 #endif // I2C_DRIVER_H
@@ -2,6 +2,7 @@
 #include "driver/adc.h"
 #include <stdio.h>
 #include "esp_log.h"
+#include "binlog.h"
 #include <math.h>
 
 int current_light = 0;
@@ -32,7 +33,7 @@ void light_sensor_read(int* read) {
 
     *read = (int)lux;
     current_light = (int)lux;
-    ESP_LOGI("LIGHT_SENSOR", "ADC: %d, V_out: %.2f V, R_LDR: %.2f Ohm, Lux: %.2f", adc_value, v_out, r_ldr, lux);
+    BINLOGI("LIGHT_SENSOR", "ADC: %d, V_out: %.2f V, R_LDR: %.2f Ohm, Lux: %.2f", adc_value, v_out, r_ldr, lux);
 }
 
 
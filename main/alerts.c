@@ -0,0 +1,170 @@
+#include "alerts.h"
+#include <stdio.h>
+#include <string.h>
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "light_sensor.h"
+#include "mqtt_publisher.h"
+#include "payload_writer.h"
+#include "sensors.h"
+#include "threshold_engine.h"
+
+static const char *TAG = "alerts";
+
+#define ALERTS_TEMPERATURE_HYSTERESIS 0.2f // °C - dioda nie miga przy wartości na granicy zakresu
+#define ALERTS_LIGHT_HYSTERESIS 10.0f      // lux
+
+// Id reguł: diody, a dalej metryki - id wynika z pozycji w rejestrze i rodzaju próbki,
+// więc nie zmienia się przy dodawaniu innych metryk (threshold_table_restore())
+#define ALERTS_RULE_LED_TEMPERATURE 0
+#define ALERTS_RULE_LED_LIGHT 1
+#define ALERTS_RULE_METRIC_FIRST 2
+#define ALERTS_METRIC_RULE_ID(user, device, kind) \
+    (ALERTS_RULE_METRIC_FIRST + ((user) * MAX_DEVICES + (device)) * SAMPLE_KIND_COUNT + (kind))
+
+_Static_assert(SAMPLE_KIND_COUNT <= THRESHOLD_MAX_CHANNELS, "Rodzaj próbki jest kanałem silnika reguł");
+
+static threshold_table_t table;
+static threshold_table_t previous; // Stan sprzed kompilacji
+static TaskHandle_t alerts_task = NULL;
+
+static int metric_kind(const char *sensor_type, const char *metric) {
+    for (int kind = 0; kind < SAMPLE_KIND_COUNT; kind++) {
+        const sample_kind_info_t *info = sample_kind_info(kind);
+        if (info && strcmp(info->sensor_type, sensor_type) == 0 && strcmp(info->metric, metric) == 0) {
+            return kind;
+        }
+    }
+    return -1;
+}
+
+static void set_led(int gpio, threshold_state_t state) {
+    gpio_set_level(gpio, state != THRESHOLD_STATE_NORMAL);
+}
+
+void alerts_compile(void) {
+    threshold_rule_t rules[THRESHOLD_MAX_RULES];
+    int count = 0;
+    rules[count++] = (threshold_rule_t){
+        .id = ALERTS_RULE_LED_TEMPERATURE,
+        .channel = SAMPLE_KIND_TEMPERATURE_BMP280,
+        .debounce = 1,
+        .low = min_temperature_threshold,
+        .high = max_temperature_threshold,
+        .hysteresis = ALERTS_TEMPERATURE_HYSTERESIS,
+    };
+    rules[count++] = (threshold_rule_t){
+        .id = ALERTS_RULE_LED_LIGHT,
+        .channel = SAMPLE_KIND_LIGHT,
+        .debounce = 1,
+        .low = (float)min_light_threshold,
+        .high = (float)max_light_threshold,
+        .hysteresis = ALERTS_LIGHT_HYSTERESIS,
+    };
+
+    int skipped = 0;
+    for (int i = 0; i < user_count; i++) {
+        for (int j = 0; j < users[i].device_count; j++) {
+            const device_t *device = &users[i].devices[j];
+            for (int k = 0; k < device->sensor_count; k++) {
+                for (int m = 0; m < device->sensors[k].metric_count; m++) {
+                    const metric_t *metric = &device->sensors[k].metrics[m];
+                    if (!metric->alert.enabled) {
+                        continue;
+                    }
+                    int kind = metric_kind(device->sensors[k].sensor_type, metric->metric);
+                    if (kind < 0 || count >= THRESHOLD_MAX_RULES) {
+                        skipped++;
+                        continue;
+                    }
+                    rules[count++] = (threshold_rule_t){
+                        .id = ALERTS_METRIC_RULE_ID(i, j, kind),
+                        .channel = (uint8_t)kind,
+                        .debounce = metric->alert.debounce,
+                        .low = metric->alert.low,
+                        .high = metric->alert.high,
+                        .hysteresis = metric->alert.hysteresis,
+                    };
+                }
+            }
+        }
+    }
+
+    previous = table;
+    int compiled = threshold_table_compile(&table, rules, count);
+    threshold_table_restore(&table, &previous);
+    set_led(LED1_GPIO, threshold_rule_state(&table, ALERTS_RULE_LED_TEMPERATURE));
+    set_led(LED2_GPIO, threshold_rule_state(&table, ALERTS_RULE_LED_LIGHT));
+
+    ESP_LOGI(TAG, "Reguły alarmów: %d (metryki: %d)", compiled, compiled - 2);
+    if (skipped > 0) {
+        ESP_LOGW(TAG, "Pominięte alarmy metryk: %d (metryka bez pomiaru albo ponad %d reguł).", skipped,
+                 THRESHOLD_MAX_RULES);
+    }
+}
+
+static void publish_event(const threshold_event_t *event) {
+    int id = event->id - ALERTS_RULE_METRIC_FIRST;
+    int kind = id % SAMPLE_KIND_COUNT;
+    int device = (id / SAMPLE_KIND_COUNT) % MAX_DEVICES;
+    int user = id / SAMPLE_KIND_COUNT / MAX_DEVICES;
+    const sample_kind_info_t *info = sample_kind_info(kind);
+    if (user >= user_count || device >= users[user].device_count || !info) {
+        return; // Rejestr zmienił się od kompilacji - reguły zostaną przekompilowane
+    }
+    const char *user_id = users[user].user_id;
+    const char *device_id = users[user].devices[device].device_id;
+
+    char topic[MQTT_TOPIC_MAX_LEN];
+    snprintf(topic, sizeof(topic), "/%s/%s/%s/%s/alert", user_id, device_id, info->sensor_type, info->metric);
+
+    char data[96];
+    payload_writer_t w;
+    payload_writer_init(&w, data, sizeof(data));
+    payload_begin_object(&w);
+    payload_key(&w, "state");
+    payload_string(&w, threshold_state_name(event->to));
+    payload_key(&w, "from");
+    payload_string(&w, threshold_state_name(event->from));
+    payload_key(&w, "value");
+    payload_fixed(&w, event->value, info->decimals);
+    payload_key(&w, "threshold");
+    payload_fixed(&w, event->threshold, info->decimals);
+    payload_end_object(&w);
+    size_t len = payload_writer_finish(&w);
+
+    ESP_LOGW(TAG, "%s/%s %s/%s: %s -> %s (%.2f, próg %.2f)", user_id, device_id, info->sensor_type, info->metric,
+             threshold_state_name(event->from), threshold_state_name(event->to), event->value, event->threshold);
+    if (len > 0) {
+        safe_publish_data(client_handle, topic, data, (int)len, 1); // Bez połączenia - kolejka telemetrii
+    }
+}
+
+void alerts_process(const sample_t *sample) {
+    threshold_event_t events[THRESHOLD_MAX_RULES];
+    int count = threshold_evaluate(&table, sample->kind, sample->value, events, THRESHOLD_MAX_RULES);
+    for (int i = 0; i < count; i++) {
+        switch (events[i].id) {
+            case ALERTS_RULE_LED_TEMPERATURE:
+                set_led(LED1_GPIO, events[i].to);
+                break;
+            case ALERTS_RULE_LED_LIGHT:
+                set_led(LED2_GPIO, events[i].to);
+                break;
+            default:
+                publish_event(&events[i]);
+                break;
+        }
+    }
+}
+
+void alerts_init(TaskHandle_t task) {
+    alerts_task = task;
+    alerts_compile();
+}
+
+void alerts_rules_changed(void) {
+    if (alerts_task != NULL) {
+        xTaskNotify(alerts_task, ALERTS_RULES_BIT, eSetBits);
+    }
+}
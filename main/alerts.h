@@ -0,0 +1,36 @@
+/**
+ * @file alerts.h
+ * Alarmy progowe sprawdzane przy każdej próbce z szyny (threshold_engine.h).
+ *
+ * Dwa rodzaje reguł:
+ * - diody LED1/LED2: zakresy temperatury i światła z /system/settings/temp_range
+ *   i light_range, zmiana stanu diody od razu po próbce,
+ * - metryki urządzeń: progi alert_* z add_metric lub /system/settings/alert;
+ *   zmiana stanu jest publikowana na /user/device/<sensor>/<metric>/alert
+ *   jako {"state": "high", "from": "normal", "value": 41.20, "threshold": 40.00}.
+ *
+ * Tablicę reguł posiada task wywołujący alerts_process(); zmiany konfiguracji
+ * z innych tasków tylko go powiadamiają (alerts_rules_changed()).
+ */
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sample_bus.h"
+
+#define ALERTS_RULES_BIT (1u << 0) // Bit powiadomienia: reguły do przekompilowania
+
+/** Ustawia task sprawdzający próbki i kompiluje reguły. */
+void alerts_init(TaskHandle_t task);
+
+/** Z dowolnego taska: reguły zostaną przekompilowane przed następną próbką. */
+void alerts_rules_changed(void);
+
+/** Kompiluje reguły z progów diod i rejestru metryk (w tasku z alerts_init()). */
+void alerts_compile(void);
+
+/** Sprawdza próbkę, przełącza diody i publikuje zdarzenia alarmów. */
+void alerts_process(const sample_t *sample);
+
+#endif // ALERTS_H
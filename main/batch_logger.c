@@ -0,0 +1,215 @@
+#include "batch_logger.h"
+#include "sdkconfig.h"
+
+#if CONFIG_MONITOR_BATCH_LOGGER
+#include <stdio.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "driver/i2c.h"
+#include "driver/rtc_io.h"
+#include "bmp280.h"
+#include "i2c_driver.h"
+#include "light_sensor.h"
+#include "batch_ring.h"
+#include "sensors.h"
+#include "mqtt_publisher.h"
+#include "wifi_station.h"
+#include "task_table.h"
+
+static const char *TAG = "batch_logger";
+
+#define BATCH_WAKE_BUTTON GPIO_NUM_0        // Przycisk budzi układ do pełnego startu
+#define BATCH_REGISTRY_SETTLE_MS 2000       // Na zachowane wiadomości /system/add_* po subskrypcji
+#define BATCH_PUBLISH_TIMEOUT_MS 30000      // Publikacja i opróżnienie outboxa
+#define BATCH_POLL_MS 100
+
+static RTC_DATA_ATTR batch_ring_t ring;
+
+// Pomiar z małym poborem: oversampling x1, bez filtra IIR (każdy pomiar jest osobny)
+static const bmp280_config_t batch_bmp280_config = {
+    .oversampling_temp = BMP280_OSRS_X1,
+    .oversampling_press = BMP280_OSRS_X1,
+    .standby_time = 0x00,
+    .filter = 0x00,
+    .mode = BMP280_SLEEP_MODE
+};
+
+static void measure(void) {
+    i2c_master_init();
+    light_sensor_init();
+
+    batch_record_t *record = batch_ring_push(&ring);
+    record->timestamp = (uint32_t)time(NULL); // Zegar RTC działa w deep sleep
+    if (bmp280_init() == ESP_OK && bmp280_apply_config(&batch_bmp280_config) == ESP_OK) {
+        float pressure;
+        if (bmp280_trigger_measurement(&record->temperature, &pressure) == ESP_OK) {
+            record->pressure = pressure / 100.0f; // Konwersja ciśnienia na hPa
+        }
+    }
+    int light = 0;
+    light_sensor_read(&light);
+    record->light = light < 0 ? 0 : (light > UINT16_MAX ? UINT16_MAX : (uint16_t)light);
+    record->wake_ms = (uint16_t)(esp_timer_get_time() / 1000);
+
+    i2c_driver_delete(I2C_MASTER_NUM); // Pełny start instaluje sterownik ponownie
+}
+
+static void enter_deep_sleep(batch_record_t *measured) {
+    // Następna pobudka liczona od obecnej, nie od zaśnięcia
+    int64_t elapsed_us = esp_timer_get_time();
+    int64_t sleep_us = (int64_t)CONFIG_MONITOR_BATCH_WAKE_INTERVAL_S * 1000000 - elapsed_us;
+    if (sleep_us < 1000000) {
+        sleep_us = 1000000;
+    }
+    esp_sleep_enable_timer_wakeup(sleep_us);
+    rtc_gpio_pullup_en(BATCH_WAKE_BUTTON);
+    esp_sleep_enable_ext0_wakeup(BATCH_WAKE_BUTTON, 0);
+
+    if (measured != NULL) {
+        measured->wake_ms = (uint16_t)(elapsed_us / 1000);
+    }
+    esp_deep_sleep_start();
+}
+
+void batch_logger_wake(void) {
+    if (!batch_ring_valid(&ring)) {
+        batch_ring_reset(&ring);
+    }
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+        return; // Włączenie zasilania, reset albo przycisk - pełny start
+    }
+
+    measure();
+    ring.wakes++;
+    if (ring.wakes < CONFIG_MONITOR_BATCH_PUBLISH_EVERY) {
+        ESP_LOGI(TAG, "Rekord %u/%d zapisany.", ring.count, BATCH_RING_CAPACITY);
+        enter_deep_sleep(batch_ring_last(&ring));
+    }
+    ESP_LOGI(TAG, "Pobudka z publikacją: %u rekordów.", ring.count);
+}
+
+// Pozycja w bieżącym rekordzie - po odrzuceniu publikacji (pełny outbox) wysyłanie
+// wznawia się od metryki, która nie przeszła, bez powtarzania już wysłanych
+typedef struct {
+    int user;
+    int device;
+    int kind;
+} record_cursor_t;
+
+// Rekord dla wszystkich urządzeń z rejestru - metryki z czasem pomiaru ("ts")
+static bool publish_record(const batch_record_t *record, record_cursor_t *cursor) {
+    static const sample_kind_t kinds[] = {
+        SAMPLE_KIND_TEMPERATURE_BMP280, SAMPLE_KIND_PRESSURE_BMP280, SAMPLE_KIND_LIGHT
+    };
+    const float values[] = { record->temperature, record->pressure, record->light };
+
+    for (; cursor->user < user_count; cursor->user++, cursor->device = 0) {
+        for (; cursor->device < users[cursor->user].device_count; cursor->device++, cursor->kind = 0) {
+            const char *user = users[cursor->user].user_id;
+            const char *device = users[cursor->user].devices[cursor->device].device_id;
+            payload_format_t format = device_payload_format(user, device);
+
+            for (; cursor->kind < (int)(sizeof(kinds) / sizeof(kinds[0])); cursor->kind++) {
+                const sample_kind_info_t *info = sample_kind_info(kinds[cursor->kind]);
+                if (find_metric(user, device, info->sensor_type, info->metric) == NULL) {
+                    continue;
+                }
+                char topic[MQTT_TOPIC_MAX_LEN];
+                char data[64];
+                snprintf(topic, sizeof(topic), "/%s/%s/%s/%s", user, device, info->sensor_type, info->metric);
+                int len = format_sample(data, sizeof(data), format, info->metric, values[cursor->kind],
+                                        info->decimals);
+                if (len > 0 && !mqtt_publish_queued_sample(topic, (const uint8_t *)data, len, record->timestamp)) {
+                    return false;
+                }
+            }
+        }
+    }
+    *cursor = (record_cursor_t){0};
+    return true;
+}
+
+static bool wait_online(void) {
+    int64_t deadline = esp_timer_get_time() + (int64_t)CONFIG_MONITOR_BATCH_ONLINE_TIMEOUT_S * 1000000;
+    while (!(mqtt_connected && user_count > 0)) {
+        if (esp_timer_get_time() > deadline) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(BATCH_POLL_MS));
+    }
+    vTaskDelay(pdMS_TO_TICKS(BATCH_REGISTRY_SETTLE_MS)); // Urządzenia i metryki po użytkownikach
+    return true;
+}
+
+static void publish_batch(void) {
+    int64_t deadline = esp_timer_get_time() + (int64_t)BATCH_PUBLISH_TIMEOUT_MS * 1000;
+    uint16_t sent = 0;
+    uint32_t wake_sum = 0, wake_max = 0;
+    record_cursor_t cursor = {0};
+    while (sent < ring.count && esp_timer_get_time() < deadline) {
+        const batch_record_t *record = batch_ring_at(&ring, sent);
+        if (!publish_record(record, &cursor)) {
+            if (!mqtt_connected) {
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(BATCH_POLL_MS)); // Outbox pełny - czekaj na potwierdzenia
+            continue;
+        }
+        ESP_LOGI(TAG, "Rekord %u: czas %lu, pobudka %u ms", sent, (unsigned long)record->timestamp, record->wake_ms);
+        wake_sum += record->wake_ms;
+        if (record->wake_ms > wake_max) {
+            wake_max = record->wake_ms;
+        }
+        sent++;
+    }
+
+    // Rekordy są usuwane z pamięci RTC dopiero po potwierdzeniu wszystkich publikacji przez brokera
+    while (esp_mqtt_client_get_outbox_size(client_handle) > 0 && esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(BATCH_POLL_MS));
+    }
+    if (esp_mqtt_client_get_outbox_size(client_handle) > 0) {
+        ESP_LOGW(TAG, "Outbox nie został opróżniony - rekordy zostaną wysłane ponownie.");
+        return;
+    }
+    ESP_LOGI(TAG, "Wysłano %u/%u rekordów (nadpisane przed wysłaniem: %lu), pobudka śr. %lu ms, max %lu ms",
+             sent, ring.count, ring.dropped, sent ? (unsigned long)(wake_sum / sent) : 0UL, wake_max);
+    batch_ring_consume(&ring, sent);
+    ring.dropped = 0;
+}
+
+static void batch_logger_task(void *arg) {
+    if (wait_online()) {
+        publish_batch();
+    } else {
+        ESP_LOGW(TAG, "Brak połączenia z brokerem w %d s - rekordy pozostają w pamięci RTC.",
+                 CONFIG_MONITOR_BATCH_ONLINE_TIMEOUT_S);
+    }
+    ring.wakes = 0;
+
+    // Tryb konfiguracji (podwójne kliknięcie w czasie pełnego startu) wstrzymuje usypianie
+    while (is_config_mode) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+    mqtt_stop();
+    ESP_LOGI(TAG, "Deep sleep na %d s.", CONFIG_MONITOR_BATCH_WAKE_INTERVAL_S);
+    enter_deep_sleep(NULL);
+}
+
+void batch_logger_start(void) {
+    task_table_create(TASK_BATCH_LOGGER, batch_logger_task, NULL);
+}
+
+#else
+
+void batch_logger_wake(void) {
+}
+
+void batch_logger_start(void) {
+}
+
+#endif
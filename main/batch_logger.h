@@ -0,0 +1,28 @@
+/**
+ * @file batch_logger.h
+ * Tryb rejestratora dla zasilania bateryjnego (CONFIG_MONITOR_BATCH_LOGGER).
+ *
+ * Układ budzi się z deep sleep co CONFIG_MONITOR_BATCH_WAKE_INTERVAL_S, wykonuje
+ * pomiar BMP280 (tryb wymuszony) i światła, dopisuje rekord do pierścienia w pamięci
+ * RTC (batch_ring.h) i od razu zasypia - bez Wi-Fi, BLE, NVS i parsowania JSON.
+ * Co CONFIG_MONITOR_BATCH_PUBLISH_EVERY pobudkę (oraz po włączeniu zasilania
+ * i pobudce przyciskiem) następuje pełny start: Wi-Fi, MQTT, publikacja
+ * wszystkich rekordów ze znacznikami czasu i ponowny deep sleep.
+ */
+#ifndef BATCH_LOGGER_H
+#define BATCH_LOGGER_H
+
+/**
+ * Wywoływana na początku app_main(). Przy pobudce z timera wykonuje pomiar
+ * i - jeśli to nie pobudka z publikacją - usypia układ (nie wraca).
+ * Bez CONFIG_MONITOR_BATCH_LOGGER nic nie robi.
+ */
+void batch_logger_wake(void);
+
+/**
+ * Uruchamia task publikujący zebrane rekordy po połączeniu z brokerem,
+ * a następnie usypiający układ. Wywołać po inicjalizacji MQTT.
+ */
+void batch_logger_start(void);
+
+#endif // BATCH_LOGGER_H
@@ -0,0 +1,49 @@
+#include "batch_ring.h"
+#include <string.h>
+
+bool batch_ring_valid(const batch_ring_t *ring) {
+    return ring->magic == BATCH_RING_MAGIC && ring->capacity == BATCH_RING_CAPACITY &&
+           ring->head < BATCH_RING_CAPACITY && ring->count <= BATCH_RING_CAPACITY;
+}
+
+void batch_ring_reset(batch_ring_t *ring) {
+    memset(ring, 0, sizeof(*ring));
+    ring->magic = BATCH_RING_MAGIC;
+    ring->capacity = BATCH_RING_CAPACITY;
+}
+
+batch_record_t *batch_ring_push(batch_ring_t *ring) {
+    uint16_t slot;
+    if (ring->count == BATCH_RING_CAPACITY) {
+        slot = ring->head;
+        ring->head = (uint16_t)((ring->head + 1) % BATCH_RING_CAPACITY);
+        ring->dropped++;
+    } else {
+        slot = (uint16_t)((ring->head + ring->count) % BATCH_RING_CAPACITY);
+        ring->count++;
+    }
+    memset(&ring->records[slot], 0, sizeof(ring->records[slot]));
+    return &ring->records[slot];
+}
+
+batch_record_t *batch_ring_last(batch_ring_t *ring) {
+    if (ring->count == 0) {
+        return NULL;
+    }
+    return &ring->records[(ring->head + ring->count - 1) % BATCH_RING_CAPACITY];
+}
+
+const batch_record_t *batch_ring_at(const batch_ring_t *ring, uint16_t index) {
+    if (index >= ring->count) {
+        return NULL;
+    }
+    return &ring->records[(ring->head + index) % BATCH_RING_CAPACITY];
+}
+
+void batch_ring_consume(batch_ring_t *ring, uint16_t n) {
+    if (n > ring->count) {
+        n = ring->count;
+    }
+    ring->head = (uint16_t)((ring->head + n) % BATCH_RING_CAPACITY);
+    ring->count -= n;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file batch_ring.h
+ * Pierścień próbek trybu rejestratora, przechowywany w pamięci RTC między
+ * pobudkami z deep sleep.
+ *
+ * Pamięć RTC przetrwa deep sleep, ale nie zmianę firmware'u - nagłówek z numerem
+ * formatu i pojemnością pozwala wykryć pierścień zapisany przez inną wersję
+ * (albo niezainicjowany) i zacząć od pustego. Pełny pierścień traci najstarszy rekord.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef BATCH_RING_H
+#define BATCH_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef BATCH_RING_CAPACITY
+#define BATCH_RING_CAPACITY 128 // 2 KB z 8 KB pamięci RTC SLOW
+#endif
+
+#define BATCH_RING_MAGIC 0x42524731u // "BRG1" - zmienić przy zmianie batch_record_t
+
+typedef struct {
+    uint32_t timestamp;  ///< Czas pomiaru (time(), 0 - zegar niezsynchronizowany)
+    float temperature;   ///< °C
+    float pressure;      ///< hPa
+    uint16_t light;      ///< lux
+    uint16_t wake_ms;    ///< Czas od pobudki do ponownego zaśnięcia
+} batch_record_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t capacity;
+    uint16_t head;      ///< Indeks najstarszego rekordu
+    uint16_t count;
+    uint16_t wakes;     ///< Pobudki od ostatniej publikacji
+    uint32_t dropped;   ///< Rekordy nadpisane przed publikacją
+    batch_record_t records[BATCH_RING_CAPACITY];
+} batch_ring_t;
+
+/** Czy pierścień ma poprawny nagłówek (zapisany przez tę wersję firmware'u). */
+bool batch_ring_valid(const batch_ring_t *ring);
+
+/** Zeruje pierścień i zapisuje nagłówek. */
+void batch_ring_reset(batch_ring_t *ring);
+
+/**
+ * Rezerwuje miejsce na nowy rekord (przy pełnym pierścieniu - w miejscu najstarszego).
+ * @return Wyzerowany rekord do wypełnienia.
+ */
+batch_record_t *batch_ring_push(batch_ring_t *ring);
+
+/** Ostatnio dodany rekord albo NULL, gdy pierścień jest pusty. */
+batch_record_t *batch_ring_last(batch_ring_t *ring);
+
+/** Rekord o indeksie liczonym od najstarszego albo NULL. */
+const batch_record_t *batch_ring_at(const batch_ring_t *ring, uint16_t index);
+
+/** Usuwa n najstarszych rekordów (po ich wysłaniu). */
+void batch_ring_consume(batch_ring_t *ring, uint16_t n);
+
+#endif // BATCH_RING_H
@@ -10,8 +10,10 @@
 #include "esp_bt_main.h"
 #include "esp_gatt_common_api.h"
 #include "esp_log.h"
+#include "binlog.h"
 #include "freertos/FreeRTOS.h"
 #include "ble_sensor.h"
+#include "sensors.h"
 
 #define GATTC_TAG "GATTC"
 
@@ -31,8 +33,6 @@ uint16_t battery_service_start_handle = 0;
 uint16_t battery_service_end_handle = 0;
 
 
-float current_temperature_ble = 0.0; // Przechowuje odczytaną temperaturę
-float current_humidity_ble = 0.0;    // Przechowuje odczytaną wilgotność
 bool ble_connected = false;
 
 static bool is_scanning = false;
@@ -386,21 +386,23 @@ void gattc_profile_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc
             }
             break;
 
-        // Odbieranie danych z powiadomień od serwera 
+        // Odbieranie danych z powiadomień od serwera (tylko migawka - na szynę trafiają odczyty zlecone w sensors_read_ble)
         case ESP_GATTC_NOTIFY_EVT:
-        ESP_LOGI(GATTC_TAG, "Received notification for handle: %d", p_data->notify.handle);
+        BINLOGI(GATTC_TAG, "Received notification for handle: %d", p_data->notify.handle);
             if (p_data->notify.handle == gattc_profile.char_handle) { // Sprawdzenie, do której charakterystyki należy powiadomienie
                 // Przetwarzanie danych
                 int16_t raw_temp = (p_data->notify.value[1] << 8) | p_data->notify.value[0];
-                current_temperature_ble = raw_temp / 10.0;
-                ESP_LOGI(GATTC_TAG, "Received notification: Temperature: %.2f°C", current_temperature_ble);
+                float temperature = raw_temp / 10.0;
+                BINLOGI(GATTC_TAG, "Received notification: Temperature: %.2f°C", temperature);
+                sensors_set_latest(SAMPLE_KIND_TEMPERATURE_BLE, temperature);
             } else if (p_data->notify.handle == humidity_char_handle) {
                 int16_t raw_hum = (p_data->notify.value[1] << 8) | p_data->notify.value[0];
-                current_humidity_ble = raw_hum / 100.0;
-                ESP_LOGI(GATTC_TAG, "Received notification: Humidity: %.2f%%", current_humidity_ble);
+                float humidity = raw_hum / 100.0;
+                BINLOGI(GATTC_TAG, "Received notification: Humidity: %.2f%%", humidity);
+                sensors_set_latest(SAMPLE_KIND_HUMIDITY_BLE, humidity);
             } else if (p_data->notify.handle == battery_char_handle) {
                 uint8_t battery_level = p_data->notify.value[0];
-                ESP_LOGI(GATTC_TAG, "Received notification: Battery Level: %d%%", battery_level);
+                BINLOGI(GATTC_TAG, "Received notification: Battery Level: %d%%", battery_level);
             }
             break;
 
@@ -418,14 +420,16 @@ void gattc_profile_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc
                 // Sprawdzenie, czy odczyt dotyczy charakterystyki temperatury
                 if (param->read.handle == gattc_profile.char_handle) {
                     int16_t raw_temp = (param->read.value[1] << 8) | param->read.value[0];
-                    current_temperature_ble = raw_temp / 10.0;
-                    ESP_LOGI(GATTC_TAG, "Read temperature: %.2f°C", current_temperature_ble);
+                    float temperature = raw_temp / 10.0;
+                    BINLOGI(GATTC_TAG, "Read temperature: %.2f°C", temperature);
+                    sensors_post(SAMPLE_KIND_TEMPERATURE_BLE, temperature);
                 }
                 // Sprawdzenie, czy odczyt dotyczy charakterystyki wilgotności
                 else if (param->read.handle == humidity_char_handle) {
                     int16_t raw_hum = (param->read.value[1] << 8) | param->read.value[0];
-                    current_humidity_ble = raw_hum / 100.0;
-                    ESP_LOGI(GATTC_TAG, "Read humidity: %.2f%%", current_humidity_ble);
+                    float humidity = raw_hum / 100.0;
+                    BINLOGI(GATTC_TAG, "Read humidity: %.2f%%", humidity);
+                    sensors_post(SAMPLE_KIND_HUMIDITY_BLE, humidity);
                 }
             } else {
                 ESP_LOGE(GATTC_TAG, "Read characteristic failed, status = %d", param->read.status);
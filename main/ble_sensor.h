@@ -17,9 +17,6 @@
 #include <stdbool.h>
 #include "esp_err.h"
 
-// Deklaracje zmiennych globalnych dla temperatury i wilgotności
-extern float current_temperature_ble;
-extern float current_humidity_ble;
 extern bool ble_connected;
 
 void esp_gap_cb(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
@@ -0,0 +1,108 @@
+#include "boot.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "boot";
+
+#define PHASE_BIT(phase) ((EventBits_t)1 << (phase))
+
+static StaticEventGroup_t events_buffer;
+static EventGroupHandle_t events;
+static boot_phase_time_t timeline[BOOT_PHASE_COUNT];
+static portMUX_TYPE timeline_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_BASE] = "base",
+    [BOOT_PHASE_WIFI_START] = "wifi_start",
+    [BOOT_PHASE_WIFI_IP] = "wifi_ip",
+    [BOOT_PHASE_SENSORS] = "sensors",
+    [BOOT_PHASE_HTTP] = "http",
+    [BOOT_PHASE_BLE] = "ble",
+    [BOOT_PHASE_MQTT] = "mqtt",
+    [BOOT_PHASE_FIRST_PUBLISH] = "first_publish",
+};
+
+void boot_init(void) {
+    if (events == NULL) {
+        events = xEventGroupCreateStatic(&events_buffer);
+    }
+}
+
+void boot_phase_start(boot_phase_t phase) {
+    if (phase >= BOOT_PHASE_COUNT) {
+        return;
+    }
+    uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+    taskENTER_CRITICAL(&timeline_mux);
+    if (!timeline[phase].started) {
+        timeline[phase].started = true;
+        timeline[phase].start_ms = now;
+    }
+    taskEXIT_CRITICAL(&timeline_mux);
+}
+
+void boot_phase_done(boot_phase_t phase) {
+    // Szybka ścieżka bez sekcji krytycznej - wywoływana m.in. przy każdej publikacji
+    if (phase >= BOOT_PHASE_COUNT || timeline[phase].done) {
+        return;
+    }
+    uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+    bool first = false;
+    taskENTER_CRITICAL(&timeline_mux);
+    if (!timeline[phase].done) {
+        if (!timeline[phase].started) {
+            timeline[phase].started = true;
+            timeline[phase].start_ms = now;
+        }
+        timeline[phase].done = true;
+        timeline[phase].end_ms = now;
+        first = true;
+    }
+    taskEXIT_CRITICAL(&timeline_mux);
+    if (first && events != NULL) {
+        xEventGroupSetBits(events, PHASE_BIT(phase));
+    }
+}
+
+bool boot_phase_is_done(boot_phase_t phase) {
+    return phase < BOOT_PHASE_COUNT && timeline[phase].done;
+}
+
+bool boot_wait(boot_phase_t phase, TickType_t timeout) {
+    if (boot_phase_is_done(phase)) {
+        return true;
+    }
+    if (events == NULL) {
+        return false;
+    }
+    EventBits_t bits = xEventGroupWaitBits(events, PHASE_BIT(phase), pdFALSE, pdTRUE, timeout);
+    return (bits & PHASE_BIT(phase)) != 0;
+}
+
+void boot_get_timeline(boot_phase_time_t out[BOOT_PHASE_COUNT]) {
+    taskENTER_CRITICAL(&timeline_mux);
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        out[i] = timeline[i];
+    }
+    taskEXIT_CRITICAL(&timeline_mux);
+}
+
+const char *boot_phase_name(boot_phase_t phase) {
+    return phase < BOOT_PHASE_COUNT ? phase_names[phase] : "";
+}
+
+void boot_log_timeline(void) {
+    boot_phase_time_t copy[BOOT_PHASE_COUNT];
+    boot_get_timeline(copy);
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (copy[i].done) {
+            ESP_LOGI(TAG, "%-13s %6lu -> %6lu ms (%lu ms)", phase_names[i], copy[i].start_ms, copy[i].end_ms,
+                     copy[i].end_ms - copy[i].start_ms);
+        } else if (copy[i].started) {
+            ESP_LOGI(TAG, "%-13s %6lu -> (w toku)", phase_names[i], copy[i].start_ms);
+        } else {
+            ESP_LOGI(TAG, "%-13s (pominięta)", phase_names[i]);
+        }
+    }
+}
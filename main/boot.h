@@ -0,0 +1,65 @@
+/**
+ * @file boot.h
+ * Równoległy start układu i oś czasu faz startu.
+ *
+ * app_main uruchamia niezależne gałęzie jednocześnie: skojarzenie z siecią Wi-Fi
+ * (w tle sterownika), inicjalizację I2C i czujników (kolejka prac na APP_CPU)
+ * oraz serwer HTTP i stos BLE (app_main na PRO_CPU). Zależności między gałęziami
+ * wyrażają bity grupy zdarzeń zamiast stałych opóźnień - np. sensor_data_task
+ * czeka na zakończenie BOOT_PHASE_SENSORS przed pierwszym pomiarem, a klient MQTT
+ * startuje dopiero po IP_EVENT_STA_GOT_IP.
+ *
+ * Każda faza zapisuje czas początku i końca (ms od startu aplikacji, esp_timer).
+ * Po pierwszej wiadomości przekazanej klientowi MQTT oś czasu jest logowana
+ * i publikowana na /system/<mac>/boot (system_stats.h).
+ */
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    BOOT_PHASE_BASE = 0,        ///< NVS, szyna próbek, kolejki, stos TCP/IP, GPIO
+    BOOT_PHASE_WIFI_START,      ///< Sterownik Wi-Fi: esp_wifi_init() ... esp_wifi_start()
+    BOOT_PHASE_WIFI_IP,         ///< Skojarzenie i DHCP: do IP_EVENT_STA_GOT_IP
+    BOOT_PHASE_SENSORS,         ///< I2C, BMP280, fotorezystor
+    BOOT_PHASE_HTTP,
+    BOOT_PHASE_BLE,             ///< Kontroler BT, Bluedroid i rozpoczęcie skanowania
+    BOOT_PHASE_MQTT,            ///< mqtt_initialize() ... MQTT_EVENT_CONNECTED
+    BOOT_PHASE_FIRST_PUBLISH,   ///< Start sensor_data_task ... pierwsza wiadomość przekazana klientowi
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+typedef struct {
+    uint32_t start_ms;
+    uint32_t end_ms;
+    bool started;
+    bool done;
+} boot_phase_time_t;
+
+/** Tworzy grupę zdarzeń faz - na samym początku app_main. */
+void boot_init(void);
+
+/** Początek fazy (tylko pierwsze wywołanie jest zapisywane). */
+void boot_phase_start(boot_phase_t phase);
+
+/** Koniec fazy - ustawia jej bit i budzi czekających (tylko pierwsze wywołanie jest zapisywane). */
+void boot_phase_done(boot_phase_t phase);
+
+bool boot_phase_is_done(boot_phase_t phase);
+
+/** Czeka na koniec fazy. @return false po upływie timeout. */
+bool boot_wait(boot_phase_t phase, TickType_t timeout);
+
+/** Kopia osi czasu faz. */
+void boot_get_timeline(boot_phase_time_t timeline[BOOT_PHASE_COUNT]);
+
+/** Klucz fazy w raporcie ("wifi_ip", "first_publish"...). */
+const char *boot_phase_name(boot_phase_t phase);
+
+/** Loguje czas każdej fazy. */
+void boot_log_timeline(void);
+
+#endif // BOOT_H
@@ -0,0 +1,147 @@
+#include "cbor_writer.h"
+#include <string.h>
+
+#define CBOR_MAJOR_UINT 0
+#define CBOR_MAJOR_NINT 1
+#define CBOR_MAJOR_TEXT 3
+#define CBOR_MAJOR_ARRAY 4
+#define CBOR_MAJOR_MAP 5
+#define CBOR_MAJOR_SIMPLE 7
+
+#define CBOR_HALF 25
+#define CBOR_SINGLE 26
+
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->overflow = false;
+}
+
+size_t cbor_writer_finish(const cbor_writer_t *w) {
+    return w->overflow ? 0 : w->len;
+}
+
+static uint8_t *reserve(cbor_writer_t *w, size_t n) {
+    if (w->overflow || w->cap - w->len < n) {
+        w->overflow = true;
+        return NULL;
+    }
+    uint8_t *p = w->buf + w->len;
+    w->len += n;
+    return p;
+}
+
+// Nagłówek elementu: typ główny + argument w najkrótszej postaci
+static void write_head(cbor_writer_t *w, uint8_t major, uint64_t arg) {
+    uint8_t type = (uint8_t)(major << 5);
+    uint8_t *p;
+
+    if (arg < 24) {
+        if ((p = reserve(w, 1))) p[0] = type | (uint8_t)arg;
+    } else if (arg <= 0xFF) {
+        if ((p = reserve(w, 2))) {
+            p[0] = type | 24;
+            p[1] = (uint8_t)arg;
+        }
+    } else if (arg <= 0xFFFF) {
+        if ((p = reserve(w, 3))) {
+            p[0] = type | 25;
+            p[1] = (uint8_t)(arg >> 8);
+            p[2] = (uint8_t)arg;
+        }
+    } else if (arg <= 0xFFFFFFFFu) {
+        if ((p = reserve(w, 5))) {
+            p[0] = type | 26;
+            for (int i = 0; i < 4; i++) p[1 + i] = (uint8_t)(arg >> (24 - 8 * i));
+        }
+    } else {
+        if ((p = reserve(w, 9))) {
+            p[0] = type | 27;
+            for (int i = 0; i < 8; i++) p[1 + i] = (uint8_t)(arg >> (56 - 8 * i));
+        }
+    }
+}
+
+void cbor_write_map(cbor_writer_t *w, size_t pairs) {
+    write_head(w, CBOR_MAJOR_MAP, pairs);
+}
+
+void cbor_write_array(cbor_writer_t *w, size_t items) {
+    write_head(w, CBOR_MAJOR_ARRAY, items);
+}
+
+void cbor_write_uint(cbor_writer_t *w, uint64_t value) {
+    write_head(w, CBOR_MAJOR_UINT, value);
+}
+
+void cbor_write_int(cbor_writer_t *w, int64_t value) {
+    if (value >= 0) {
+        write_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    } else {
+        write_head(w, CBOR_MAJOR_NINT, (uint64_t)(-1 - value));
+    }
+}
+
+void cbor_write_text(cbor_writer_t *w, const char *text) {
+    size_t n = strlen(text);
+    write_head(w, CBOR_MAJOR_TEXT, n);
+    uint8_t *p = reserve(w, n);
+    if (p) memcpy(p, text, n);
+}
+
+// Zamiana na half bez utraty precyzji; false, gdy wartość wymaga single
+static bool float_to_half(uint32_t bits, uint16_t *half) {
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int32_t exp = (int32_t)((bits >> 23) & 0xFF);
+    uint32_t mant = bits & 0x7FFFFF;
+
+    if (exp == 0xFF) {
+        if (mant != 0) return false; // NaN z ładunkiem - zostaje single
+        *half = sign | 0x7C00;
+        return true;
+    }
+    if (exp == 0 && mant == 0) {
+        *half = sign;
+        return true;
+    }
+    if (exp == 0) {
+        return false; // subnormalne single są poza zakresem half
+    }
+
+    int32_t e = exp - 127;
+    if (e >= -14 && e <= 15) {
+        if (mant & 0x1FFF) return false;
+        *half = sign | (uint16_t)((e + 15) << 10) | (uint16_t)(mant >> 13);
+        return true;
+    }
+    if (e >= -24 && e < -14) {
+        // Subnormalna half: mantysa z jawną jedynką przesunięta w prawo
+        uint32_t full = mant | 0x800000;
+        uint32_t shift = (uint32_t)(13 + (-14 - e));
+        if (full & ((1u << shift) - 1)) return false;
+        *half = sign | (uint16_t)(full >> shift);
+        return true;
+    }
+    return false;
+}
+
+void cbor_write_float(cbor_writer_t *w, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint8_t *p;
+    uint16_t half;
+    if (float_to_half(bits, &half)) {
+        if ((p = reserve(w, 3))) {
+            p[0] = (CBOR_MAJOR_SIMPLE << 5) | CBOR_HALF;
+            p[1] = (uint8_t)(half >> 8);
+            p[2] = (uint8_t)half;
+        }
+        return;
+    }
+    if ((p = reserve(w, 5))) {
+        p[0] = (CBOR_MAJOR_SIMPLE << 5) | CBOR_SINGLE;
+        for (int i = 0; i < 4; i++) p[1 + i] = (uint8_t)(bits >> (24 - 8 * i));
+    }
+}
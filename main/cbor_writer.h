@@ -0,0 +1,50 @@
+/**
+ * @file cbor_writer.h
+ * Strumieniowy koder CBOR (RFC 8949) do bufora podanego przez wywołującego.
+ *
+ * Koder nie alokuje pamięci i nie używa printf. Przepełnienie bufora jest
+ * zapamiętywane w stanie - wystarczy sprawdzić wynik cbor_writer_finish()
+ * po zapisaniu wszystkich elementów.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool overflow; ///< Bufor okazał się za mały
+} cbor_writer_t;
+
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t cap);
+
+/**
+ * @return Długość zakodowanych danych lub 0 przy przepełnieniu bufora.
+ */
+size_t cbor_writer_finish(const cbor_writer_t *w);
+
+/** Nagłówek mapy o podanej liczbie par klucz-wartość. */
+void cbor_write_map(cbor_writer_t *w, size_t pairs);
+
+/** Nagłówek tablicy o podanej liczbie elementów. */
+void cbor_write_array(cbor_writer_t *w, size_t items);
+
+void cbor_write_uint(cbor_writer_t *w, uint64_t value);
+void cbor_write_int(cbor_writer_t *w, int64_t value);
+
+/** Ciąg tekstowy (UTF-8) zakończony zerem. */
+void cbor_write_text(cbor_writer_t *w, const char *text);
+
+/**
+ * Liczba zmiennoprzecinkowa: half (3 B), gdy wartość da się zapisać bez straty,
+ * w przeciwnym wypadku single (5 B).
+ */
+void cbor_write_float(cbor_writer_t *w, float value);
+
+#endif // CBOR_WRITER_H
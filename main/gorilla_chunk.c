@@ -0,0 +1,235 @@
+#include "gorilla_chunk.h"
+#include <string.h>
+
+#define NO_WINDOW 0xFF
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int count_leading(uint32_t x) {
+    int n = 0;
+    while (n < 32 && !(x & (0x80000000u >> n))) n++;
+    return n;
+}
+
+static int count_trailing(uint32_t x) {
+    int n = 0;
+    while (n < 32 && !(x & (1u << n))) n++;
+    return n;
+}
+
+// Zapis do strumienia; bajty są nadpisywane w całości, więc wycofana próbka nie zostawia śladów
+static bool write_bits(gorilla_chunk_t *chunk, uint32_t value, int bits) {
+    uint8_t *stream = chunk->buf + GORILLA_CHUNK_HEADER_SIZE;
+    size_t stream_cap = (chunk->cap - GORILLA_CHUNK_HEADER_SIZE) * 8;
+    if (chunk->bit_len + bits > stream_cap) {
+        return false;
+    }
+
+    while (bits > 0) {
+        size_t byte = chunk->bit_len / 8;
+        int used = chunk->bit_len % 8;
+        int n = 8 - used < bits ? 8 - used : bits;
+        uint8_t part = (uint8_t)((value >> (bits - n)) & ((1u << n) - 1));
+        uint8_t keep = used ? (uint8_t)(stream[byte] & (0xFF << (8 - used))) : 0;
+        stream[byte] = keep | (uint8_t)(part << (8 - used - n));
+        chunk->bit_len += n;
+        bits -= n;
+    }
+    return true;
+}
+
+static bool write_timestamp(gorilla_chunk_t *chunk, int64_t dod) {
+    if (dod == 0) {
+        return write_bits(chunk, 0, 1);
+    }
+    if (dod >= -64 && dod <= 63) {
+        return write_bits(chunk, 0x2, 2) && write_bits(chunk, (uint32_t)dod & 0x7F, 7);
+    }
+    if (dod >= -256 && dod <= 255) {
+        return write_bits(chunk, 0x6, 3) && write_bits(chunk, (uint32_t)dod & 0x1FF, 9);
+    }
+    if (dod >= -2048 && dod <= 2047) {
+        return write_bits(chunk, 0xE, 4) && write_bits(chunk, (uint32_t)dod & 0xFFF, 12);
+    }
+    return write_bits(chunk, 0xF, 4) && write_bits(chunk, (uint32_t)dod, 32);
+}
+
+static bool write_value(gorilla_chunk_t *chunk, uint32_t bits) {
+    uint32_t x = bits ^ chunk->prev_value;
+    if (x == 0) {
+        return write_bits(chunk, 0, 1);
+    }
+
+    int leading = count_leading(x);
+    int trailing = count_trailing(x);
+    if (leading > 31) leading = 31;
+
+    if (chunk->prev_leading != NO_WINDOW && leading >= chunk->prev_leading && trailing >= chunk->prev_trailing) {
+        int meaningful = 32 - chunk->prev_leading - chunk->prev_trailing;
+        return write_bits(chunk, 0x2, 2) && write_bits(chunk, x >> chunk->prev_trailing, meaningful);
+    }
+
+    int meaningful = 32 - leading - trailing;
+    if (!write_bits(chunk, 0x3, 2) || !write_bits(chunk, (uint32_t)leading, 5) ||
+        !write_bits(chunk, (uint32_t)(meaningful - 1), 5) || !write_bits(chunk, x >> trailing, meaningful)) {
+        return false;
+    }
+    chunk->prev_leading = (uint8_t)leading;
+    chunk->prev_trailing = (uint8_t)trailing;
+    return true;
+}
+
+void gorilla_chunk_init(gorilla_chunk_t *chunk, uint8_t *buf, size_t cap, uint8_t flags) {
+    memset(chunk, 0, sizeof(*chunk));
+    chunk->buf = buf;
+    chunk->cap = cap;
+    chunk->flags = flags;
+    chunk->prev_leading = NO_WINDOW;
+}
+
+bool gorilla_chunk_append(gorilla_chunk_t *chunk, uint32_t timestamp, float value) {
+    if (chunk->cap < GORILLA_CHUNK_HEADER_SIZE || chunk->count == UINT16_MAX ||
+        (chunk->count > 0 && timestamp < chunk->prev_ts)) {
+        return false;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    if (chunk->count == 0) {
+        if (!write_bits(chunk, bits, 32)) {
+            return false;
+        }
+        chunk->first_ts = timestamp;
+    } else {
+        gorilla_chunk_t saved = *chunk;
+        int64_t delta = (int64_t)timestamp - chunk->prev_ts;
+        if (!write_timestamp(chunk, delta - chunk->prev_delta) || !write_value(chunk, bits)) {
+            *chunk = saved;
+            return false;
+        }
+        chunk->prev_delta = delta;
+    }
+
+    chunk->prev_ts = timestamp;
+    chunk->prev_value = bits;
+    chunk->count++;
+    return true;
+}
+
+size_t gorilla_chunk_finish(gorilla_chunk_t *chunk) {
+    if (chunk->count == 0) {
+        return 0;
+    }
+    chunk->buf[0] = GORILLA_CHUNK_MAGIC;
+    chunk->buf[1] = GORILLA_CHUNK_VERSION;
+    chunk->buf[2] = chunk->flags;
+    put_u16(chunk->buf + 3, chunk->count);
+    put_u32(chunk->buf + 5, chunk->first_ts);
+    return GORILLA_CHUNK_HEADER_SIZE + (chunk->bit_len + 7) / 8;
+}
+
+static bool read_bits(gorilla_reader_t *reader, int bits, uint32_t *out) {
+    if (reader->bit_pos + bits > reader->bit_cap) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < bits; i++) {
+        size_t pos = reader->bit_pos++;
+        value = (value << 1) | ((reader->buf[pos / 8] >> (7 - pos % 8)) & 1);
+    }
+    *out = value;
+    return true;
+}
+
+// Rozszerzenie znaku pola o podanej szerokości
+static int64_t sign_extend(uint32_t value, int bits) {
+    if (bits == 32) {
+        return (int32_t)value;
+    }
+    return (value & (1u << (bits - 1))) ? (int64_t)value - (1 << bits) : (int64_t)value;
+}
+
+bool gorilla_reader_init(gorilla_reader_t *reader, const uint8_t *buf, size_t len) {
+    if (len < GORILLA_CHUNK_HEADER_SIZE || buf[0] != GORILLA_CHUNK_MAGIC || buf[1] != GORILLA_CHUNK_VERSION) {
+        return false;
+    }
+    memset(reader, 0, sizeof(*reader));
+    reader->buf = buf + GORILLA_CHUNK_HEADER_SIZE;
+    reader->bit_cap = (len - GORILLA_CHUNK_HEADER_SIZE) * 8;
+    reader->flags = buf[2];
+    reader->count = get_u16(buf + 3);
+    reader->ts = get_u32(buf + 5);
+    reader->leading = NO_WINDOW;
+    return true;
+}
+
+bool gorilla_reader_next(gorilla_reader_t *reader, uint32_t *timestamp, float *value) {
+    if (reader->read >= reader->count) {
+        return false;
+    }
+
+    uint32_t bit;
+    if (reader->read == 0) {
+        if (!read_bits(reader, 32, &reader->value)) return false;
+    } else {
+        // Delta-of-delta czasu: liczba jedynek prefiksu wybiera szerokość pola
+        static const int widths[] = { 0, 7, 9, 12, 32 };
+        int ones = 0;
+        while (ones < 4) {
+            if (!read_bits(reader, 1, &bit)) return false;
+            if (!bit) break;
+            ones++;
+        }
+        int64_t dod = 0;
+        if (ones > 0) {
+            uint32_t raw;
+            if (!read_bits(reader, widths[ones], &raw)) return false;
+            dod = sign_extend(raw, widths[ones]);
+        }
+        reader->delta += dod;
+        reader->ts = (uint32_t)(reader->ts + reader->delta);
+
+        // XOR wartości
+        if (!read_bits(reader, 1, &bit)) return false;
+        if (bit) {
+            if (!read_bits(reader, 1, &bit)) return false;
+            if (bit) {
+                uint32_t leading, length;
+                if (!read_bits(reader, 5, &leading) || !read_bits(reader, 5, &length)) return false;
+                if (leading + length + 1 > 32) return false;
+                reader->leading = (uint8_t)leading;
+                reader->trailing = (uint8_t)(32 - leading - (length + 1));
+            } else if (reader->leading == NO_WINDOW) {
+                return false;
+            }
+            uint32_t meaningful;
+            int width = 32 - reader->leading - reader->trailing;
+            if (!read_bits(reader, width, &meaningful)) return false;
+            reader->value ^= (uint32_t)((uint64_t)meaningful << reader->trailing);
+        }
+    }
+
+    reader->read++;
+    *timestamp = reader->ts;
+    memcpy(value, &reader->value, sizeof(*value));
+    return true;
+}
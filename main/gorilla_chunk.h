@@ -0,0 +1,96 @@
+/**
+ * @file gorilla_chunk.h
+ * Kompresja serii próbek jednej metryki do paczki (chunk) w stylu Gorilla
+ * (Facebook, VLDB 2015): znaczniki czasu jako delta-of-delta, wartości float
+ * jako XOR z poprzednią wartością.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ *
+ * Układ (nagłówek little-endian, strumień bitów od najstarszego bitu):
+ *   nagłówek: magic 'G' (1 B) | wersja (1 B) | flagi (1 B) | liczba próbek (2 B)
+ *             | czas pierwszej próbki (4 B, s)
+ *   próbka 1: wartość - 32 bity
+ *   próbka n: delta-of-delta czasu | XOR wartości
+ *
+ *   delta-of-delta D:  0 -> '0'
+ *                      [-64, 63] -> '10' + 7 bitów
+ *                      [-256, 255] -> '110' + 9 bitów
+ *                      [-2048, 2047] -> '1110' + 12 bitów
+ *                      pozostałe -> '1111' + 32 bity
+ *   XOR X:  0 -> '0'
+ *           bity znaczące w oknie poprzedniej wartości -> '10' + bity okna
+ *           w przeciwnym wypadku -> '11' + zera wiodące (5 bitów)
+ *                                   + długość - 1 (5 bitów) + bity znaczące
+ */
+#ifndef GORILLA_CHUNK_H
+#define GORILLA_CHUNK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define GORILLA_CHUNK_MAGIC 0x47 // 'G'
+#define GORILLA_CHUNK_VERSION 1
+#define GORILLA_CHUNK_HEADER_SIZE 9
+
+#define GORILLA_CHUNK_FLAG_INTEGER 0x01 // Wartości całkowite (np. odczyt ADC)
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t bit_len;         ///< Zapisane bity strumienia (za nagłówkiem)
+    uint16_t count;         ///< Liczba próbek w paczce
+    uint8_t flags;
+    uint32_t first_ts;
+    uint32_t prev_ts;
+    int64_t prev_delta;
+    uint32_t prev_value;    ///< Bity poprzedniej wartości float
+    uint8_t prev_leading;   ///< Okno bitów znaczących poprzedniego XOR
+    uint8_t prev_trailing;
+} gorilla_chunk_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t bit_cap;
+    size_t bit_pos;
+    uint16_t count;         ///< Liczba próbek w paczce
+    uint16_t read;          ///< Liczba odczytanych próbek
+    uint8_t flags;
+    uint32_t ts;
+    int64_t delta;
+    uint32_t value;
+    uint8_t leading;
+    uint8_t trailing;
+} gorilla_reader_t;
+
+/**
+ * Przygotowuje pustą paczkę w buforze wywołującego.
+ * @param cap Rozmiar bufora (razem z nagłówkiem).
+ */
+void gorilla_chunk_init(gorilla_chunk_t *chunk, uint8_t *buf, size_t cap, uint8_t flags);
+
+/**
+ * Dopisuje próbkę. Znaczniki czasu nie mogą maleć.
+ * @return false, gdy próbka nie mieści się w buforze - paczka pozostaje bez zmian.
+ */
+bool gorilla_chunk_append(gorilla_chunk_t *chunk, uint32_t timestamp, float value);
+
+/**
+ * Uzupełnia nagłówek.
+ * @return Rozmiar paczki w bajtach (0 dla pustej paczki).
+ */
+size_t gorilla_chunk_finish(gorilla_chunk_t *chunk);
+
+/**
+ * Sprawdza nagłówek i przygotowuje odczyt.
+ * @return false, gdy dane nie są paczką w obsługiwanej wersji.
+ */
+bool gorilla_reader_init(gorilla_reader_t *reader, const uint8_t *buf, size_t len);
+
+/**
+ * Odczytuje kolejną próbkę.
+ * @return false po ostatniej próbce lub gdy strumień jest urwany.
+ */
+bool gorilla_reader_next(gorilla_reader_t *reader, uint32_t *timestamp, float *value);
+
+#endif // GORILLA_CHUNK_H
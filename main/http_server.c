@@ -1,3 +1,4 @@
+#include <string.h>
 #include "http_server.h"
 #include "esp_http_server.h"
 #include "wifi_station.h"
@@ -10,6 +11,11 @@
 #include "bmp280.h"
 #include "../../v5.3.1/esp-idf/components/json/cJSON/cJSON.h"
 #include "nvs.h"
+#include "esp_timer.h"
+#include "sensors.h"
+#include "payload_writer.h"
+#include "task_table.h"
+#include "latency_trace.h"
 
 
 static const char *TAG = "HTTP_SERVER";
@@ -25,7 +31,8 @@ httpd_handle_t start_webserver(void) {
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.stack_size = 8192;           
-    config.max_uri_handlers = 10;      
+    config.max_uri_handlers = 12;      
+    config.core_id = task_table_httpd_core(); // Obsługa sieci na PRO_CPU
     config.recv_wait_timeout = 10;     // Timeout na odbiór danych 
     config.send_wait_timeout = 10;     // Timeout na wysyłanie danych
     config.lru_purge_enable = true;    // Automatyczne zwalnianie zasobów
@@ -62,7 +69,7 @@ void stop_webserver(httpd_handle_t *server) {
 static esp_err_t handle_confirm_wifi(httpd_req_t *req) {
     vTaskDelay(pdMS_TO_TICKS(2000));
     ESP_LOGI("HTTP", "Potwierdzenie połączenia w trybie AP");
-    xTaskNotify(config_task_handle, 2, eSetValueWithoutOverwrite); // Przełącz na tryb STA
+    request_station_mode(); // Przełącz na tryb STA
     httpd_resp_send(req, "ESP32 przełącza się na tryb STA", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
@@ -144,6 +151,39 @@ void register_endpoints(httpd_handle_t server) {
     };
     httpd_register_uri_handler(server, &bmp280_config_post);
 
+    httpd_uri_t intervals_get = {
+        .uri       = "/intervals",
+        .method    = HTTP_GET,
+        .handler   = handle_intervals_get,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &intervals_get);
+
+    httpd_uri_t intervals_post = {
+        .uri       = "/intervals",
+        .method    = HTTP_POST,
+        .handler   = handle_intervals_post,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &intervals_post);
+
+
+    httpd_uri_t readings_get = {
+        .uri       = "/readings",
+        .method    = HTTP_GET,
+        .handler   = handle_readings_get,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &readings_get);
+
+    httpd_uri_t trace_get = {
+        .uri       = "/trace",
+        .method    = HTTP_GET,
+        .handler   = handle_trace_get,
+        .user_ctx  = NULL
+    };
+    httpd_register_uri_handler(server, &trace_get);
+
 
     httpd_uri_t switch_to_sta_endpoint = {
         .uri       = "/switch_to_sta",
@@ -222,7 +262,7 @@ esp_err_t handle_set_wifi_post(httpd_req_t *req) {
         httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
 
         // Powiadomienie o przełączeniu na tryb Station
-        xTaskNotify(config_task_handle, 2, eSetValueWithoutOverwrite);
+        request_station_mode();
 
         return ESP_OK;
     } else {
@@ -234,7 +274,7 @@ esp_err_t handle_set_wifi_post(httpd_req_t *req) {
 
 
 esp_err_t handle_switch_to_config(httpd_req_t *req) {
-    xTaskNotify(config_task_handle, 1, eSetValueWithoutOverwrite); // Przełączenie do trybu AP
+    request_config_mode(); // Przełączenie do trybu AP
 
     httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, "{\"message\":\"Przełączono do trybu konfiguracji. Połącz się z siecią ESP32.\"}");
@@ -266,6 +306,114 @@ esp_err_t handle_bmp280_config_get(httpd_req_t *req) {
 }
 
 
+// Interwały pomiarów w sekundach dla poszczególnych czujników
+// {"bmp280": {"temperature": {"value": 21.53, "age_ms": 1200}, ...}, ...}
+esp_err_t handle_readings_get(httpd_req_t *req) {
+    sensor_readings_t readings;
+    sensors_get_readings(&readings);
+    uint32_t now = (uint32_t)(esp_timer_get_time() / 1000);
+
+    char response[384];
+    payload_writer_t w;
+    payload_writer_init(&w, response, sizeof(response));
+    payload_begin_object(&w);
+    const char *open_sensor = NULL;
+    for (int kind = 0; kind < SAMPLE_KIND_COUNT; kind++) {
+        if (!(readings.valid & SAMPLE_KIND_BIT(kind))) {
+            continue;
+        }
+        // Rodzaje tego samego czujnika sąsiadują w sample_kind_t
+        const sample_kind_info_t *info = sample_kind_info(kind);
+        if (open_sensor == NULL || strcmp(open_sensor, info->sensor_type) != 0) {
+            if (open_sensor != NULL) {
+                payload_end_object(&w);
+            }
+            payload_key(&w, info->sensor_type);
+            payload_begin_object(&w);
+            open_sensor = info->sensor_type;
+        }
+        payload_key(&w, info->metric);
+        payload_begin_object(&w);
+        payload_key(&w, "value");
+        payload_fixed(&w, readings.values[kind], info->decimals);
+        payload_key(&w, "age_ms");
+        payload_uint(&w, now - readings.updated_ms[kind]);
+        payload_end_object(&w);
+    }
+    if (open_sensor != NULL) {
+        payload_end_object(&w);
+    }
+    payload_end_object(&w);
+    if (payload_writer_finish(&w) == 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Response too large");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
+}
+
+esp_err_t handle_intervals_get(httpd_req_t *req) {
+
+    char response[128];
+    snprintf(response, sizeof(response),
+             "{"
+             "\"bmp280\": %lu,"
+             "\"photoresistor\": %lu,"
+             "\"ble\": %lu"
+             "}",
+             get_sampling_interval(SAMPLE_SOURCE_BMP280),
+             get_sampling_interval(SAMPLE_SOURCE_LIGHT),
+             get_sampling_interval(SAMPLE_SOURCE_BLE));
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, response, HTTPD_RESP_USE_STRLEN);
+    return ESP_OK;
+}
+
+
+esp_err_t handle_intervals_post(httpd_req_t *req) {
+
+    char buf[128];
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) {
+            httpd_resp_send_408(req);
+        }
+        return ESP_FAIL;
+    }
+    buf[ret] = '\0';
+    ESP_LOGI(TAG, "Received POST data: %s", buf);
+
+    if (apply_sampling_intervals_json(buf) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Niepoprawna wartość");
+        return ESP_FAIL;
+    }
+
+    return handle_intervals_get(req);
+}
+
+
+static esp_err_t send_trace_chunk(void *arg, const void *data, size_t len) {
+    return httpd_resp_send_chunk((httpd_req_t *)arg, (const char *)data, (ssize_t)len);
+}
+
+/* Zrzut bufora śledzenia opóźnień (tools/trace_decode.py) */
+esp_err_t handle_trace_get(httpd_req_t *req) {
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"trace.bin\"");
+    esp_err_t err = latency_trace_dump(send_trace_chunk, req);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Śledzenie opóźnień wyłączone");
+        return ESP_OK;
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+
 esp_err_t handle_bmp280_config_post(httpd_req_t *req) {
     
     char buf[256];
@@ -351,7 +499,7 @@ esp_err_t handle_bmp280_config_post(httpd_req_t *req) {
 //     ESP_LOGI("HTTP_SERVER", "Przełączanie do trybu Station (STA)");
 
 //     // Powiadom task o przejściu na tryb STA
-//     xTaskNotify(config_task_handle, 2, eSetValueWithoutOverwrite);
+//     request_station_mode();
 
 //     // Odpowiedź dla klienta
 //     httpd_resp_set_type(req, "application/json");
@@ -364,7 +512,7 @@ esp_err_t handle_switch_to_station(httpd_req_t *req) {
     ESP_LOGI("HTTP_SERVER", "Przełączanie do trybu Station (STA)");
 
     // Powiadom task o przejściu na tryb STA
-    xTaskNotify(config_task_handle, 2, eSetValueWithoutOverwrite);
+    request_station_mode();
 
     // Poczekaj, aż Wi-Fi w STA nawiąże połączenie
     EventBits_t wifi_bits = xEventGroupWaitBits(wifi_event_group, 1, pdFALSE, pdTRUE, pdMS_TO_TICKS(10000));
@@ -8,16 +8,23 @@
 
 extern bool is_config_mode;
 extern httpd_handle_t server;
-extern TaskHandle_t config_task_handle;
 extern bool config_completed;
 
 
+// Przełączenie trybu pracy (kolejka prac - można wywołać z handlera HTTP i callbacku timera)
+void request_config_mode(void);
+void request_station_mode(void);
+
 httpd_handle_t start_webserver(void);
 void stop_webserver(httpd_handle_t *server);
 void register_endpoints(httpd_handle_t server);
 esp_err_t handle_set_wifi_post(httpd_req_t *req);
 esp_err_t handle_bmp280_config_post(httpd_req_t *req);
 esp_err_t handle_bmp280_config_get(httpd_req_t *req);
+esp_err_t handle_intervals_get(httpd_req_t *req);
+esp_err_t handle_intervals_post(httpd_req_t *req);
+esp_err_t handle_readings_get(httpd_req_t *req);
+esp_err_t handle_trace_get(httpd_req_t *req);
 
 esp_err_t handle_switch_to_station(httpd_req_t *req);
 void save_bmp280_config_to_nvs(bmp280_config_t *config);
@@ -0,0 +1,345 @@
+#include "json_reader.h"
+#include <string.h>
+#include <stdlib.h>
+
+typedef struct {
+    json_reader_t *reader;
+    size_t pos;
+} parser_t;
+
+static void skip_whitespace(parser_t *p) {
+    const char *s = p->reader->json;
+    while (p->pos < p->reader->len &&
+           (s[p->pos] == ' ' || s[p->pos] == '\t' || s[p->pos] == '\n' || s[p->pos] == '\r')) {
+        p->pos++;
+    }
+}
+
+static int add_token(parser_t *p, json_token_type_t type, size_t start) {
+    json_reader_t *r = p->reader;
+    if (r->count >= JSON_READER_MAX_TOKENS) {
+        return -1;
+    }
+    json_token_t *t = &r->tokens[r->count];
+    t->type = type;
+    t->start = (uint16_t)start;
+    t->end = (uint16_t)start;
+    t->next = (uint16_t)(r->count + 1);
+    return r->count++;
+}
+
+static bool is_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool parse_string(parser_t *p) {
+    const char *s = p->reader->json;
+    size_t len = p->reader->len;
+    int index = add_token(p, JSON_TOKEN_STRING, ++p->pos); // za cudzysłowem
+    if (index < 0) {
+        return false;
+    }
+
+    while (p->pos < len) {
+        unsigned char c = (unsigned char)s[p->pos];
+        if (c == '"') {
+            p->reader->tokens[index].end = (uint16_t)p->pos++;
+            return true;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c == '\\') {
+            if (++p->pos >= len) return false;
+            char e = s[p->pos];
+            if (e == 'u') {
+                if (p->pos + 4 >= len) return false;
+                for (int i = 1; i <= 4; i++) {
+                    if (!is_hex(s[p->pos + i])) return false;
+                }
+                p->pos += 4;
+            } else if (!strchr("\"\\/bfnrt", e)) {
+                return false;
+            }
+        }
+        p->pos++;
+    }
+    return false;
+}
+
+static bool parse_primitive(parser_t *p) {
+    const char *s = p->reader->json;
+    size_t len = p->reader->len;
+    size_t start = p->pos;
+    int index = add_token(p, JSON_TOKEN_PRIMITIVE, start);
+    if (index < 0) {
+        return false;
+    }
+
+    static const char *literals[] = { "true", "false", "null" };
+    for (int i = 0; i < 3; i++) {
+        size_t n = strlen(literals[i]);
+        if (len - start >= n && memcmp(s + start, literals[i], n) == 0) {
+            p->pos += n;
+            p->reader->tokens[index].end = (uint16_t)p->pos;
+            return true;
+        }
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    if (p->pos < len && s[p->pos] == '-') p->pos++;
+    if (p->pos >= len || !is_digit(s[p->pos])) return false;
+    if (s[p->pos] == '0') {
+        p->pos++;
+    } else {
+        while (p->pos < len && is_digit(s[p->pos])) p->pos++;
+    }
+    if (p->pos < len && s[p->pos] == '.') {
+        p->pos++;
+        if (p->pos >= len || !is_digit(s[p->pos])) return false;
+        while (p->pos < len && is_digit(s[p->pos])) p->pos++;
+    }
+    if (p->pos < len && (s[p->pos] == 'e' || s[p->pos] == 'E')) {
+        p->pos++;
+        if (p->pos < len && (s[p->pos] == '+' || s[p->pos] == '-')) p->pos++;
+        if (p->pos >= len || !is_digit(s[p->pos])) return false;
+        while (p->pos < len && is_digit(s[p->pos])) p->pos++;
+    }
+    p->reader->tokens[index].end = (uint16_t)p->pos;
+    return true;
+}
+
+static bool parse_value(parser_t *p, int depth);
+
+// Obiekt lub tablica; dla obiektu każdy element to para: klucz (string) i wartość
+static bool parse_container(parser_t *p, int depth, bool object) {
+    const char *s = p->reader->json;
+    char close = object ? '}' : ']';
+    if (depth >= JSON_READER_MAX_DEPTH) {
+        return false;
+    }
+    int index = add_token(p, object ? JSON_TOKEN_OBJECT : JSON_TOKEN_ARRAY, p->pos++);
+    if (index < 0) {
+        return false;
+    }
+
+    skip_whitespace(p);
+    if (p->pos < p->reader->len && s[p->pos] == close) {
+        p->pos++;
+    } else {
+        while (1) {
+            if (object) {
+                if (p->pos >= p->reader->len || s[p->pos] != '"' || !parse_string(p)) return false;
+                skip_whitespace(p);
+                if (p->pos >= p->reader->len || s[p->pos] != ':') return false;
+                p->pos++;
+            }
+            if (!parse_value(p, depth + 1)) return false;
+            skip_whitespace(p);
+            if (p->pos >= p->reader->len) return false;
+            if (s[p->pos] == ',') {
+                p->pos++;
+                skip_whitespace(p);
+                continue;
+            }
+            if (s[p->pos] != close) return false;
+            p->pos++;
+            break;
+        }
+    }
+
+    p->reader->tokens[index].end = (uint16_t)p->pos;
+    p->reader->tokens[index].next = (uint16_t)p->reader->count;
+    return true;
+}
+
+static bool parse_value(parser_t *p, int depth) {
+    skip_whitespace(p);
+    if (p->pos >= p->reader->len) {
+        return false;
+    }
+    char c = p->reader->json[p->pos];
+    if (c == '{') return parse_container(p, depth, true);
+    if (c == '[') return parse_container(p, depth, false);
+    if (c == '"') return parse_string(p);
+    return parse_primitive(p);
+}
+
+// Czy obiekt najwyższego poziomu ma dwa pola o tym samym kluczu (porównanie bez rozwijania \)
+static bool has_duplicate_keys(const json_reader_t *reader) {
+    for (int i = 1; i < reader->count; i = reader->tokens[i + 1].next) {
+        const json_token_t *a = &reader->tokens[i];
+        for (int j = reader->tokens[i + 1].next; j < reader->count; j = reader->tokens[j + 1].next) {
+            const json_token_t *b = &reader->tokens[j];
+            if (a->end - a->start == b->end - b->start &&
+                memcmp(reader->json + a->start, reader->json + b->start, a->end - a->start) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool json_reader_parse(json_reader_t *reader, const char *json, size_t len) {
+    reader->json = json;
+    reader->len = len;
+    reader->count = 0;
+    if (!json || len > UINT16_MAX) {
+        return false;
+    }
+
+    parser_t p = { .reader = reader, .pos = 0 };
+    skip_whitespace(&p);
+    if (p.pos >= len || json[p.pos] != '{' || !parse_value(&p, 0)) {
+        reader->count = 0;
+        return false;
+    }
+    skip_whitespace(&p);
+    if (p.pos != len || has_duplicate_keys(reader)) {
+        reader->count = 0; // dane za obiektem albo niejednoznaczne pole
+        return false;
+    }
+    return true;
+}
+
+// Token wartości pola obiektu najwyższego poziomu (klucze porównywane bez rozwijania \)
+static const json_token_t *find_value(const json_reader_t *reader, const char *key) {
+    if (reader->count == 0) {
+        return NULL;
+    }
+    size_t key_len = strlen(key);
+    int i = 1;
+    while (i + 1 < reader->count && i < reader->tokens[0].next) {
+        const json_token_t *k = &reader->tokens[i];
+        const json_token_t *v = &reader->tokens[i + 1];
+        if ((size_t)(k->end - k->start) == key_len && memcmp(reader->json + k->start, key, key_len) == 0) {
+            return v;
+        }
+        i = v->next;
+    }
+    return NULL;
+}
+
+bool json_reader_has(const json_reader_t *reader, const char *key) {
+    return find_value(reader, key) != NULL;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return c - 'A' + 10;
+}
+
+static uint32_t read_hex4(const char *s) {
+    return (uint32_t)(hex_value(s[0]) << 12 | hex_value(s[1]) << 8 | hex_value(s[2]) << 4 | hex_value(s[3]));
+}
+
+bool json_reader_string(const json_reader_t *reader, const char *key, char *out, size_t cap) {
+    const json_token_t *t = find_value(reader, key);
+    if (!t || t->type != JSON_TOKEN_STRING || cap == 0) {
+        return false;
+    }
+
+    const char *s = reader->json;
+    size_t n = 0;
+    for (size_t i = t->start; i < t->end; i++) {
+        char buf[4];
+        size_t len = 1;
+        buf[0] = s[i];
+
+        if (s[i] == '\\') {
+            char e = s[++i];
+            switch (e) {
+                case 'b': buf[0] = '\b'; break;
+                case 'f': buf[0] = '\f'; break;
+                case 'n': buf[0] = '\n'; break;
+                case 'r': buf[0] = '\r'; break;
+                case 't': buf[0] = '\t'; break;
+                case 'u': {
+                    uint32_t cp = read_hex4(s + i + 1);
+                    i += 4;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        // Para surogatów UTF-16
+                        if (i + 6 >= t->end || s[i + 1] != '\\' || s[i + 2] != 'u') return false;
+                        uint32_t low = read_hex4(s + i + 3);
+                        if (low < 0xDC00 || low > 0xDFFF) return false;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        return false;
+                    }
+                    if (cp == 0) return false; // zero kończyłoby tekst
+                    if (cp < 0x80) {
+                        buf[0] = (char)cp;
+                    } else if (cp < 0x800) {
+                        buf[0] = (char)(0xC0 | (cp >> 6));
+                        buf[1] = (char)(0x80 | (cp & 0x3F));
+                        len = 2;
+                    } else if (cp < 0x10000) {
+                        buf[0] = (char)(0xE0 | (cp >> 12));
+                        buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                        buf[2] = (char)(0x80 | (cp & 0x3F));
+                        len = 3;
+                    } else {
+                        buf[0] = (char)(0xF0 | (cp >> 18));
+                        buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                        buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                        buf[3] = (char)(0x80 | (cp & 0x3F));
+                        len = 4;
+                    }
+                    break;
+                }
+                default: buf[0] = e; break; // " \ /
+            }
+        }
+
+        if (n + len >= cap) {
+            return false;
+        }
+        memcpy(out + n, buf, len);
+        n += len;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+bool json_reader_number(const json_reader_t *reader, const char *key, double *out) {
+    const json_token_t *t = find_value(reader, key);
+    if (!t || t->type != JSON_TOKEN_PRIMITIVE) {
+        return false;
+    }
+    char c = reader->json[t->start];
+    if (c != '-' && !is_digit(c)) {
+        return false; // true / false / null
+    }
+
+    char buf[32];
+    size_t len = t->end - t->start;
+    if (len >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, reader->json + t->start, len);
+    buf[len] = '\0';
+    *out = strtod(buf, NULL);
+    return true;
+}
+
+bool json_reader_bool(const json_reader_t *reader, const char *key, bool *out) {
+    const json_token_t *t = find_value(reader, key);
+    if (!t || t->type != JSON_TOKEN_PRIMITIVE) {
+        return false;
+    }
+    if (reader->json[t->start] == 't') {
+        *out = true;
+        return true;
+    }
+    if (reader->json[t->start] == 'f') {
+        *out = false;
+        return true;
+    }
+    return false;
+}
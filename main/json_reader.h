@@ -0,0 +1,69 @@
+/**
+ * @file json_reader.h
+ * Ograniczony czytnik JSON dla komunikatów sterujących (/system/...).
+ *
+ * Tekst jest dzielony na tokeny zapisywane w tablicy o stałym rozmiarze
+ * (bez alokacji pamięci), a pola obiektu najwyższego poziomu są kopiowane
+ * prosto do buforów wywołującego. Dane wejściowe nie muszą być zakończone zerem.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define JSON_READER_MAX_TOKENS 32 // Komunikaty sterujące mają do kilkunastu pól
+#define JSON_READER_MAX_DEPTH 8
+
+typedef enum {
+    JSON_TOKEN_OBJECT = 0,
+    JSON_TOKEN_ARRAY,
+    JSON_TOKEN_STRING,    ///< Zakres bez cudzysłowów, sekwencje \ nierozwinięte
+    JSON_TOKEN_PRIMITIVE  ///< Liczba, true, false lub null
+} json_token_type_t;
+
+typedef struct {
+    uint8_t type;     ///< json_token_type_t
+    uint16_t start;   ///< Początek w tekście
+    uint16_t end;     ///< Koniec (bez znaku kończącego)
+    uint16_t next;    ///< Indeks tokenu za tym elementem (z zawartością)
+} json_token_t;
+
+typedef struct {
+    const char *json;
+    size_t len;
+    json_token_t tokens[JSON_READER_MAX_TOKENS];
+    int count;
+} json_reader_t;
+
+/**
+ * Dzieli tekst na tokeny. Najwyższy poziom musi być obiektem.
+ * @return false dla niepoprawnego JSON, zbyt wielu tokenów, zbyt dużego
+ *         zagnieżdżenia, powtórzonego klucza w obiekcie najwyższego poziomu
+ *         albo tekstu dłuższego niż 65535 B.
+ */
+bool json_reader_parse(json_reader_t *reader, const char *json, size_t len);
+
+/** Czy obiekt najwyższego poziomu ma pole o podanym kluczu (dowolnego typu). */
+bool json_reader_has(const json_reader_t *reader, const char *key);
+
+/**
+ * Kopiuje wartość tekstową pola (z rozwinięciem sekwencji \) i kończy ją zerem.
+ * @return false, gdy pola nie ma, nie jest tekstem albo nie mieści się w buforze.
+ */
+bool json_reader_string(const json_reader_t *reader, const char *key, char *out, size_t cap);
+
+/**
+ * @return false, gdy pola nie ma albo nie jest liczbą.
+ */
+bool json_reader_number(const json_reader_t *reader, const char *key, double *out);
+
+/**
+ * @return false, gdy pola nie ma albo nie jest wartością true/false.
+ */
+bool json_reader_bool(const json_reader_t *reader, const char *key, bool *out);
+
+#endif // JSON_READER_H
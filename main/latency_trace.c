@@ -0,0 +1,209 @@
+#include "latency_trace.h"
+#include "sdkconfig.h"
+
+#if CONFIG_MONITOR_LATENCY_TRACE
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+
+// Histogram etapu: czas od poprzedniego zarejestrowanego etapu tego samego łańcucha
+static const char *const stage_keys[TRACE_STAGE_COUNT] = {
+    [TRACE_STAGE_ACQUIRE] = "acquire",  // Od przerwania READ_GPIO
+    [TRACE_STAGE_ENCODE] = "encode",    // Od pomiaru: kolejka szyny i formatowanie
+    [TRACE_STAGE_ENQUEUE] = "enqueue",  // Przekazanie klientowi MQTT (z zapisem do gniazda dla aliasów QoS 0)
+    [TRACE_STAGE_SEND] = "send",        // Oczekiwanie w outboxie
+    [TRACE_STAGE_ACK] = "ack",          // Od wysłania (bez mqtts:// - od przekazania) do potwierdzenia
+};
+
+// Zerowe gniazda i licznik są poprawnym stanem początkowym - punkt śledzenia może paść przed app_main
+static trace_slot_t slots[portNUM_PROCESSORS][CONFIG_MONITOR_LATENCY_TRACE_RECORDS];
+static trace_ring_t rings[portNUM_PROCESSORS] = {
+    { .slots = slots[0], .capacity = CONFIG_MONITOR_LATENCY_TRACE_RECORDS },
+#if portNUM_PROCESSORS > 1
+    { .slots = slots[1], .capacity = CONFIG_MONITOR_LATENCY_TRACE_RECORDS },
+#endif
+};
+static trace_hist_t stage_hist[TRACE_STAGE_COUNT];
+static trace_hist_t total_hist;           // Od pomiaru do potwierdzenia
+static trace_chains_t samples;            // Klucz: numer próbki
+static trace_chains_t messages;           // Klucz: msg_id
+static atomic_uint trigger_us;            // Czas ostatniego przerwania + 1; 0 - brak
+static trace_record_t dump_records[CONFIG_MONITOR_LATENCY_TRACE_RECORDS];
+
+static void record(uint32_t time_us, trace_stage_t stage, uint32_t id, uint16_t msg_id) {
+    int core = xPortGetCoreID();
+    trace_ring_write(&rings[core], time_us, stage, id, msg_id, (uint8_t)core);
+}
+
+uint32_t latency_trace_now(void) {
+    return (uint32_t)esp_timer_get_time();
+}
+
+void latency_trace_trigger(void) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    atomic_store_explicit(&trigger_us, now + 1, memory_order_relaxed);
+    record(now, TRACE_STAGE_TRIGGER, 0, 0);
+}
+
+void latency_trace_acquire(uint32_t seq, uint32_t time_us) {
+    record(time_us, TRACE_STAGE_ACQUIRE, seq, 0);
+    uint32_t trigger = atomic_exchange_explicit(&trigger_us, 0, memory_order_relaxed);
+    if (trigger != 0) {
+        trace_hist_add(&stage_hist[TRACE_STAGE_ACQUIRE], time_us - (trigger - 1));
+    }
+    trace_chain_info_t info = {
+        .start_us = time_us,
+        .last_us = time_us,
+        .first_stage = TRACE_STAGE_ACQUIRE,
+        .last_stage = TRACE_STAGE_ACQUIRE,
+    };
+    trace_chain_open(&samples, seq, &info);
+}
+
+void latency_trace_encode(uint32_t seq, latency_trace_chain_t *chain) {
+    uint32_t now = latency_trace_now();
+    record(now, TRACE_STAGE_ENCODE, seq, 0);
+    trace_chain_info_t info;
+    chain->seq = seq;
+    chain->encoded_us = now;
+    chain->acquired = trace_chain_get(&samples, seq, &info); // Próbka może iść do kilku urządzeń - bez zamykania
+    chain->acquired_us = chain->acquired ? info.start_us : now;
+    if (chain->acquired) {
+        trace_hist_add(&stage_hist[TRACE_STAGE_ENCODE], now - info.start_us);
+    }
+}
+
+void latency_trace_enqueue(const latency_trace_chain_t *chain, int msg_id) {
+    uint32_t now = latency_trace_now();
+    record(now, TRACE_STAGE_ENQUEUE, chain->seq, msg_id > 0 ? (uint16_t)msg_id : 0);
+    trace_hist_add(&stage_hist[TRACE_STAGE_ENQUEUE], now - chain->encoded_us);
+    if (msg_id > 0) {
+        trace_chain_info_t info = {
+            .start_us = chain->acquired_us,
+            .last_us = now,
+            .first_stage = chain->acquired ? TRACE_STAGE_ACQUIRE : TRACE_STAGE_ENCODE,
+            .last_stage = TRACE_STAGE_ENQUEUE,
+        };
+        trace_chain_open(&messages, (uint32_t)msg_id, &info);
+    }
+}
+
+void latency_trace_send(const char *buffer, int len) {
+    uint16_t msg_id;
+    if (len <= 0 || !trace_mqtt_publish_id((const uint8_t *)buffer, (size_t)len, &msg_id)) {
+        return;
+    }
+    uint32_t now = latency_trace_now();
+    record(now, TRACE_STAGE_SEND, 0, msg_id);
+    trace_chain_info_t info;
+    // Ponowienia (DUP) nie zmieniają łańcucha - liczy się pierwsze wysłanie
+    if (trace_chain_get(&messages, msg_id, &info) && info.last_stage == TRACE_STAGE_ENQUEUE &&
+        trace_chain_advance(&messages, msg_id, now, TRACE_STAGE_SEND)) {
+        trace_hist_add(&stage_hist[TRACE_STAGE_SEND], now - info.last_us);
+    }
+}
+
+void latency_trace_ack(int msg_id) {
+    if (msg_id <= 0) {
+        return;
+    }
+    uint32_t now = latency_trace_now();
+    record(now, TRACE_STAGE_ACK, 0, (uint16_t)msg_id);
+    trace_chain_info_t info;
+    if (trace_chain_close(&messages, (uint32_t)msg_id, &info)) {
+        trace_hist_add(&stage_hist[TRACE_STAGE_ACK], now - info.last_us);
+        if (info.first_stage == TRACE_STAGE_ACQUIRE) {
+            trace_hist_add(&total_hist, now - info.start_us);
+        }
+    }
+}
+
+static void write_hist(payload_writer_t *w, const char *key, trace_hist_t *hist) {
+    uint32_t counts[TRACE_HIST_BUCKETS];
+    uint32_t total = trace_hist_take(hist, counts);
+    if (total == 0) {
+        return;
+    }
+    int last = TRACE_HIST_BUCKETS - 1;
+    while (counts[last] == 0) {
+        last--;
+    }
+    payload_key(w, key);
+    payload_begin_object(w);
+    payload_key(w, "n");
+    payload_uint(w, total);
+    payload_key(w, "p50");
+    payload_uint(w, trace_hist_percentile(counts, 500));
+    payload_key(w, "p99");
+    payload_uint(w, trace_hist_percentile(counts, 990));
+    payload_key(w, "hist");
+    payload_begin_array(w);
+    for (int i = 0; i <= last; i++) {
+        payload_item(w);
+        payload_uint(w, counts[i]);
+    }
+    payload_end_array(w);
+    payload_end_object(w);
+}
+
+void latency_trace_write_stats(payload_writer_t *w) {
+    payload_key(w, "latency");
+    payload_begin_object(w);
+    for (int stage = TRACE_STAGE_ACQUIRE; stage < TRACE_STAGE_COUNT; stage++) {
+        write_hist(w, stage_keys[stage], &stage_hist[stage]);
+    }
+    write_hist(w, "total", &total_hist);
+    payload_end_object(w);
+}
+
+esp_err_t latency_trace_dump(latency_trace_write_fn_t write, void *arg) {
+    latency_trace_dump_header_t header = {
+        .magic = LATENCY_TRACE_DUMP_MAGIC,
+        .version = LATENCY_TRACE_DUMP_VERSION,
+        .record_size = sizeof(trace_record_t),
+        .now_us = latency_trace_now(),
+        .core_count = portNUM_PROCESSORS,
+        .capacity = CONFIG_MONITOR_LATENCY_TRACE_RECORDS,
+    };
+    esp_err_t err = write(arg, &header, sizeof(header));
+    for (int core = 0; core < portNUM_PROCESSORS && err == ESP_OK; core++) {
+        uint32_t count = trace_ring_snapshot(&rings[core], dump_records, CONFIG_MONITOR_LATENCY_TRACE_RECORDS);
+        err = write(arg, &count, sizeof(count));
+        if (err == ESP_OK && count > 0) {
+            err = write(arg, dump_records, count * sizeof(trace_record_t));
+        }
+    }
+    return err;
+}
+
+#else
+
+void latency_trace_trigger(void) {
+}
+
+uint32_t latency_trace_now(void) {
+    return 0;
+}
+
+void latency_trace_acquire(uint32_t seq, uint32_t time_us) {
+}
+
+void latency_trace_encode(uint32_t seq, latency_trace_chain_t *chain) {
+}
+
+void latency_trace_enqueue(const latency_trace_chain_t *chain, int msg_id) {
+}
+
+void latency_trace_send(const char *buffer, int len) {
+}
+
+void latency_trace_ack(int msg_id) {
+}
+
+void latency_trace_write_stats(payload_writer_t *w) {
+}
+
+esp_err_t latency_trace_dump(latency_trace_write_fn_t write, void *arg) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file latency_trace.h
+ * Śledzenie opóźnień od pomiaru (lub przerwania READ_GPIO) do potwierdzenia brokera.
+ *
+ * Punkty śledzenia (trace_buffer.h) trafiają do bufora rdzenia, na którym wykonał się
+ * punkt, ze znacznikiem esp_timer. Etapy jednej próbki łączy numer z szyny próbek,
+ * a etapy wiadomości - msg_id klienta MQTT:
+ *
+ *   TRIGGER (ISR) -> ACQUIRE -> ENCODE -> ENQUEUE -> SEND (tylko mqtts://) -> ACK (QoS 1 i 2)
+ *
+ * Czas między kolejnymi etapami i od pomiaru do potwierdzenia trafia do histogramów,
+ * publikowanych w raporcie /system/<mac>/stats ("latency", system_stats.h) i zerowanych
+ * po każdym raporcie. Wiadomości QoS 0 kończą się na ENQUEUE; wysłanie z outboxa jest
+ * widoczne (SEND) tylko w transporcie mqtts:// (mqtt_tls.c).
+ *
+ * Zrzut bufora (GET /trace, format poniżej) dekoduje tools/trace_decode.py.
+ * Bez CONFIG_MONITOR_LATENCY_TRACE funkcje są puste.
+ */
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "payload_writer.h"
+#include "trace_buffer.h"
+
+#define LATENCY_TRACE_DUMP_MAGIC 0x4352544C // "LTRC"
+#define LATENCY_TRACE_DUMP_VERSION 1
+
+/**
+ * Zrzut (little endian): nagłówek, a po nim dla każdego rdzenia liczba zapisów (uint32_t)
+ * i tyle zapisów trace_record_t (16 B: time_us, id, seq, msg_id, stage, core) od najstarszego.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t now_us;        ///< Czas zrzutu - do rozwinięcia przepełnień time_us
+    uint16_t core_count;
+    uint16_t capacity;      ///< Zapisów w buforze każdego rdzenia
+} latency_trace_dump_header_t;
+
+/** Odbiorca kolejnych części zrzutu. */
+typedef esp_err_t (*latency_trace_write_fn_t)(void *arg, const void *data, size_t len);
+
+/** Łańcuch jednej publikacji próbki - od ENCODE do ENQUEUE. */
+typedef struct {
+    uint32_t seq;
+    uint32_t acquired_us;
+    uint32_t encoded_us;
+    bool acquired;          ///< Znany czas pomiaru (łańcuch próbki nie został nadpisany)
+} latency_trace_chain_t;
+
+/** Przerwanie wyzwalające pomiar; następny ACQUIRE mierzy czas od przerwania. */
+void latency_trace_trigger(void);
+
+/** Czas do przekazania latency_trace_acquire() - pobrany przed publikacją na szynę. */
+uint32_t latency_trace_now(void);
+
+/** Próbka seq opublikowana na szynie; time_us - czas pomiaru. */
+void latency_trace_acquire(uint32_t seq, uint32_t time_us);
+
+/** Dane wiadomości dla próbki seq gotowe. */
+void latency_trace_encode(uint32_t seq, latency_trace_chain_t *chain);
+
+/** Wiadomość przekazana klientowi (msg_id > 0 - QoS 1 i 2, czeka na potwierdzenie). */
+void latency_trace_enqueue(const latency_trace_chain_t *chain, int msg_id);
+
+/** Dane zapisywane do gniazda brokera (transport MQTT); rozpoznaje nagłówek PUBLISH. */
+void latency_trace_send(const char *buffer, int len);
+
+/** MQTT_EVENT_PUBLISHED. */
+void latency_trace_ack(int msg_id);
+
+/** Histogramy etapów od poprzedniego wywołania jako klucz "latency" raportu. */
+void latency_trace_write_stats(payload_writer_t *w);
+
+/** Zrzuca bufory wszystkich rdzeni (wywoływać z jednego taska - wspólny bufor kopii). */
+esp_err_t latency_trace_dump(latency_trace_write_fn_t write, void *arg);
+
+#endif // LATENCY_TRACE_H
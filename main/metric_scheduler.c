@@ -0,0 +1,115 @@
+#include "metric_scheduler.h"
+
+// a przed b z uwzględnieniem przepełnienia licznika
+static bool due_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+static void swap_entries(scheduler_t *sched, uint16_t a, uint16_t b) {
+    scheduler_entry_t tmp = sched->heap[a];
+    sched->heap[a] = sched->heap[b];
+    sched->heap[b] = tmp;
+    sched->position[sched->heap[a].id] = a;
+    sched->position[sched->heap[b].id] = b;
+}
+
+static void sift_up(scheduler_t *sched, uint16_t i) {
+    while (i > 0) {
+        uint16_t parent = (i - 1) / 2;
+        if (!due_before(sched->heap[i].due_ms, sched->heap[parent].due_ms)) {
+            break;
+        }
+        swap_entries(sched, i, parent);
+        i = parent;
+    }
+}
+
+static void sift_down(scheduler_t *sched, uint16_t i) {
+    while (1) {
+        uint16_t left = 2 * i + 1;
+        uint16_t right = left + 1;
+        uint16_t smallest = i;
+        if (left < sched->count && due_before(sched->heap[left].due_ms, sched->heap[smallest].due_ms)) {
+            smallest = left;
+        }
+        if (right < sched->count && due_before(sched->heap[right].due_ms, sched->heap[smallest].due_ms)) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        swap_entries(sched, i, smallest);
+        i = smallest;
+    }
+}
+
+void scheduler_init(scheduler_t *sched, scheduler_entry_t *heap, uint16_t *position, uint16_t capacity) {
+    sched->heap = heap;
+    sched->position = position;
+    sched->count = 0;
+    sched->capacity = capacity;
+    for (uint16_t i = 0; i < capacity; i++) {
+        position[i] = SCHEDULER_NO_ENTRY;
+    }
+}
+
+bool scheduler_add(scheduler_t *sched, uint16_t id, uint32_t interval_ms, uint32_t first_due_ms) {
+    if (id >= sched->capacity || sched->position[id] != SCHEDULER_NO_ENTRY ||
+        sched->count >= sched->capacity || interval_ms == 0) {
+        return false;
+    }
+    uint16_t i = sched->count++;
+    sched->heap[i].due_ms = first_due_ms;
+    sched->heap[i].interval_ms = interval_ms;
+    sched->heap[i].id = id;
+    sched->position[id] = i;
+    sift_up(sched, i);
+    return true;
+}
+
+bool scheduler_set_interval(scheduler_t *sched, uint16_t id, uint32_t interval_ms, uint32_t now_ms) {
+    if (id >= sched->capacity || sched->position[id] == SCHEDULER_NO_ENTRY || interval_ms == 0) {
+        return false;
+    }
+    uint16_t i = sched->position[id];
+    scheduler_entry_t *entry = &sched->heap[i];
+
+    uint32_t last_run = entry->due_ms - entry->interval_ms;
+    uint32_t due = last_run + interval_ms;
+    if (due_before(now_ms + interval_ms, due)) {
+        due = now_ms + interval_ms;
+    }
+    bool earlier = due_before(due, entry->due_ms);
+    entry->due_ms = due;
+    entry->interval_ms = interval_ms;
+
+    if (earlier) {
+        sift_up(sched, i);
+    } else {
+        sift_down(sched, i);
+    }
+    return true;
+}
+
+bool scheduler_pop_due(scheduler_t *sched, uint32_t now_ms, uint16_t *id) {
+    if (sched->count == 0 || due_before(now_ms, sched->heap[0].due_ms)) {
+        return false;
+    }
+    scheduler_entry_t *top = &sched->heap[0];
+    *id = top->id;
+
+    top->due_ms += top->interval_ms;
+    if (!due_before(now_ms, top->due_ms)) {
+        top->due_ms = now_ms + top->interval_ms; // pominięcie zaległych wykonań
+    }
+    sift_down(sched, 0);
+    return true;
+}
+
+uint32_t scheduler_time_until_next(const scheduler_t *sched, uint32_t now_ms) {
+    if (sched->count == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t due = sched->heap[0].due_ms;
+    return due_before(now_ms, due) ? due - now_ms : 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file metric_scheduler.h
+ * Harmonogram pomiarów oparty na kopcu minimalnym terminów (min-heap).
+ *
+ * Każdy wpis ma identyfikator, interwał i najbliższy termin wykonania. Pobranie
+ * zaległego wpisu i jego ponowne zaplanowanie kosztuje O(log n), więc harmonogram
+ * obsługuje setki metryk z jednego taska. Pamięć przekazuje wywołujący - moduł
+ * nie alokuje i nie zależy od ESP-IDF.
+ *
+ * Czas jest liczony w ms na liczniku 32-bitowym; porównania uwzględniają przepełnienie.
+ */
+#ifndef METRIC_SCHEDULER_H
+#define METRIC_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHEDULER_NO_ENTRY 0xFFFF
+
+typedef struct {
+    uint32_t due_ms;      ///< Najbliższy termin wykonania
+    uint32_t interval_ms; ///< Okres
+    uint16_t id;          ///< Identyfikator wpisu (indeks w tablicy pozycji)
+} scheduler_entry_t;
+
+typedef struct {
+    scheduler_entry_t *heap; ///< Kopiec wpisów (rozmiar: capacity)
+    uint16_t *position;      ///< Pozycja wpisu w kopcu wg id (rozmiar: capacity)
+    uint16_t count;
+    uint16_t capacity;
+} scheduler_t;
+
+/**
+ * Inicjalizuje pusty harmonogram.
+ * @param heap Tablica na co najmniej capacity wpisów.
+ * @param position Tablica na co najmniej capacity pozycji (id < capacity).
+ */
+void scheduler_init(scheduler_t *sched, scheduler_entry_t *heap, uint16_t *position, uint16_t capacity);
+
+/**
+ * Dodaje wpis z pierwszym terminem first_due_ms.
+ * @return false, gdy id jest poza zakresem, już istnieje lub interwał wynosi 0.
+ */
+bool scheduler_add(scheduler_t *sched, uint16_t id, uint32_t interval_ms, uint32_t first_due_ms);
+
+/**
+ * Zmienia interwał wpisu. Nowy termin to ostatnie wykonanie + nowy interwał,
+ * ale nie później niż now_ms + interval_ms.
+ */
+bool scheduler_set_interval(scheduler_t *sched, uint16_t id, uint32_t interval_ms, uint32_t now_ms);
+
+/**
+ * Pobiera wpis, którego termin minął, i planuje jego następne wykonanie.
+ * Terminy liczone są od poprzedniego terminu (bez dryfu); jeśli opóźnienie
+ * przekracza interwał, zaległe wykonania są pomijane.
+ * @return true i id wpisu, jeśli jakiś termin minął.
+ */
+bool scheduler_pop_due(scheduler_t *sched, uint32_t now_ms, uint16_t *id);
+
+/**
+ * Czas do najbliższego terminu (0, jeśli termin minął; UINT32_MAX dla pustego harmonogramu).
+ */
+uint32_t scheduler_time_until_next(const scheduler_t *sched, uint32_t now_ms);
+
+#endif // METRIC_SCHEDULER_H
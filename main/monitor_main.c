@@ -10,6 +10,7 @@
 #include "esp_log.h"
 #include "sdkconfig.h"
 #include "esp_netif.h"
+#include "esp_event.h"
 #include "esp_task_wdt.h"
 #include "esp_http_client.h"
 #include "wifi_station.h"
@@ -29,6 +30,16 @@
 #include "ble_sensor.h"
 #include "esp_bt.h"
 #include "esp_sleep.h"
+#include "telemetry_queue.h"
+#include "sensors.h"
+#include "work_queue.h"
+#include "task_table.h"
+#include "power.h"
+#include "batch_logger.h"
+#include "alerts.h"
+#include "latency_trace.h"
+#include "binlog.h"
+#include "boot.h"
 
 
 #define BLINK_GPIO 2
@@ -37,6 +48,7 @@
 
 
 static bool led_state = false;  // stan diody ON/OFF
+static esp_timer_handle_t status_led_timer; // Miganie diody bez połączenia Wi-Fi
 bool is_config_mode = false;
 extern httpd_handle_t server;
 bool is_measuring = false;
@@ -47,7 +59,7 @@ static const uint32_t double_click_timeout_ms = 500; // 500 ms na podwójne klik
 
 portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 
-TaskHandle_t config_task_handle = NULL;
+static void read_gpio_work(void *arg);
 
 
 /* Przyciski */
@@ -65,9 +77,23 @@ void gpio_init(void) {
     gpio_config(&io_conf);
 }
 
+// Przyciski mają przerwanie poziomem, bo zbocze nie budzi układu z light sleep. Po naciśnięciu
+// przerwanie czeka na puszczenie (poziom wysoki) i odwrotnie - ISR działa jak na opadającym zboczu
+static bool IRAM_ATTR button_pressed(gpio_num_t pin) {
+    if (gpio_get_level(pin) == 0) {
+        gpio_set_intr_type(pin, GPIO_INTR_HIGH_LEVEL);
+        return true;
+    }
+    gpio_set_intr_type(pin, GPIO_INTR_LOW_LEVEL);
+    return false;
+}
+
 // Obsługa przerwania dla przycisku 
 static void IRAM_ATTR button_isr_handler(void* arg) {
     static uint32_t last_interrupt_time = 0;
+    if (!button_pressed(BUTTON_GPIO_PIN)) {
+        return;
+    }
     uint32_t current_interrupt_time = xTaskGetTickCountFromISR();
 
     if ((current_interrupt_time - last_interrupt_time) > pdMS_TO_TICKS(200)) { // przynajmniej 200 ms
@@ -87,6 +113,9 @@ static void IRAM_ATTR button_isr_handler(void* arg) {
 
 void IRAM_ATTR read_gpio_isr_handler(void* arg) {
     static uint32_t last_interrupt_time = 0;
+    if (!button_pressed(READ_GPIO)) {
+        return;
+    }
     uint32_t current_interrupt_time = xTaskGetTickCountFromISR();
 
     // Sprawdź, czy przerwanie jest wyzwalane rzadziej niż co 200 ms
@@ -95,9 +124,12 @@ void IRAM_ATTR read_gpio_isr_handler(void* arg) {
 
         if (!is_measuring) {
             is_measuring = true;
+            latency_trace_trigger(); // Początek łańcucha: przerwanie -> pomiar -> publikacja
             BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-            vTaskNotifyGiveFromISR(config_task_handle, &xHigherPriorityTaskWoken);
-            portYIELD_FROM_ISR();
+            if (!work_queue_post_from_isr(WORK_PRIORITY_NORMAL, read_gpio_work, NULL, "read_gpio", &xHigherPriorityTaskWoken)) {
+                is_measuring = false;
+            }
+            portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
         }
     }
 
@@ -106,7 +138,17 @@ void IRAM_ATTR read_gpio_isr_handler(void* arg) {
 
 
 
-// Wykrywanie kliknięć przycisku (pojedyncze lub podwójne) 
+// Pomiar na żądanie (pojedyncze kliknięcie)
+static void measure_now_work(void *arg) {
+    esp_wifi_start();
+    connect_to_wifi();
+
+    // Pomiar wymuszony; próbki publikuje sensor_data_task
+    sensors_read_all(true);
+}
+
+// Wykrywanie kliknięć przycisku (pojedyncze lub podwójne). Callback działa w tasku esp_timer,
+// więc niczego nie wykonuje sam - prace trafiają do kolejki (work_queue.h)
 void button_timer_callback(void* arg) {
     uint32_t clicks;
 
@@ -118,46 +160,15 @@ void button_timer_callback(void* arg) {
     if (clicks == 1) {
         // Obsługa pojedynczego kliknięcia
         if(!is_config_mode) {
-            esp_wifi_start();
-            connect_to_wifi();
-            bmp280_set_mode(BMP280_FORCED_MODE);
-            while (bmp280_is_measuring()) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-            }
-            bmp280_read_data(&current_temperature_bmp280, &current_pressure_bmp280);
-            current_pressure_bmp280 /= 100.0; // Konwersja ciśnienia na hPa
-            ESP_LOGI("BMP280", "Temperatura: %.2f °C, Ciśnienie: %.2f hPa", current_temperature_bmp280, current_pressure_bmp280);
-
-            // Wykonanie pomiaru światła
-            light_sensor_read(&current_light);
-            ESP_LOGI("LIGHT", "Światło: %d lux", current_light);
-
-            // Publikacja MQTT
-            for (int i = 0; i < user_count; i++) {
-                for (int j = 0; j < users[i].device_count; j++) {
-                    // Wykonaj pomiary i publikuj dane
-                    publish_bmp280_data(users[i].user_id, users[i].devices[j].device_id);
-                    publish_light_sensor_data(users[i].user_id, users[i].devices[j].device_id);
-                    publish_ble_data(users[i].user_id, users[i].devices[j].device_id);
-                }
-            }
+            work_queue_post(WORK_PRIORITY_NORMAL, measure_now_work, NULL, "measure_now");
         } else { // wyjście z trybu konfiguracji
-            xTaskNotify(config_task_handle, 2, eSetValueWithoutOverwrite);
+            request_station_mode();
         }
 
     } else if (clicks == 2) {
         // Obsługa podwójnego kliknięcia
         if (!is_config_mode) {
-            is_config_mode = true;
-            mqtt_stop();
-            if (server != NULL) stop_webserver(&server);
-
-            ESP_LOGI("CONFIG", "Przełączanie do trybu konfiguracji...");
-            gpio_set_level(BLINK_GPIO, 1);
-            esp_wifi_stop();
-            vTaskDelay(pdMS_TO_TICKS(500));
-            wifi_init_ap();
-            server = start_webserver();
+            request_config_mode();
         }
     }
 }
@@ -165,7 +176,7 @@ void button_timer_callback(void* arg) {
 // Konfiguracja przycisku 
 void configure_button() {
     gpio_config_t io_conf = {
-        .intr_type = GPIO_INTR_NEGEDGE, // Zmiana z wysokiego na niski
+        .intr_type = GPIO_INTR_LOW_LEVEL, // Naciśnięcie (zob. button_pressed)
         .mode = GPIO_MODE_INPUT,        // Pin jako wejście
         .pin_bit_mask = (1ULL << BUTTON_GPIO_PIN), // Przesunięcie bitu odpowiadającego pinowi przycisku
         .pull_down_en = 0,
@@ -174,6 +185,7 @@ void configure_button() {
     gpio_config(&io_conf);
 
     gpio_isr_handler_add(BUTTON_GPIO_PIN, button_isr_handler, NULL);
+    gpio_wakeup_enable(BUTTON_GPIO_PIN, GPIO_INTR_LOW_LEVEL);
 
     // Inicjalizacja timera
     const esp_timer_create_args_t timer_args = {
@@ -183,68 +195,73 @@ void configure_button() {
     esp_timer_create(&timer_args, &button_timer);
 }
 
-/* Nasłuchuje na powiadomienia z systemu i przełącza między trybem AP i STA */
-void config_mode_task(void* arg) {
-    uint32_t notify_value;
-    while (1) {
-        // Oczekiwanie na powiadomienie
-        if (xTaskNotifyWait(0, ULONG_MAX, &notify_value, portMAX_DELAY) == pdTRUE) {
-            if (notify_value == 1) { // Przejście do trybu konfiguracji
-                if (!is_config_mode) {
-                    is_config_mode = true;
-                    ESP_LOGI("CONFIG", "Przełączanie do trybu konfiguracji...");
-                    mqtt_stop();
-                    if (server != NULL) {
-                        stop_webserver(&server);
-                    }
-                    
-                    gpio_set_level(BLINK_GPIO, 1);
-                    esp_wifi_stop();
-                    vTaskDelay(pdMS_TO_TICKS(500));
-                    
-                    wifi_init_ap();
-                    server = start_webserver();
-                    if (server == NULL) {
-                        ESP_LOGE("CONFIG", "Nie udało się uruchomić serwera HTTP.");
-                    } else {
-                        ESP_LOGI("CONFIG", "Tryb AP uruchomiony.");
-                    }
-    
-                }
-            } else if (notify_value == 2) { // Przejście do trybu station
-
-                if (is_config_mode) {
-                    is_config_mode = false;
-                    
-                    ESP_LOGI("CONFIG", "MQTT zatrzymane przed przejściem do STA.");
-                    mqtt_stop();
-                    
-                    if (server != NULL) {
-                        stop_webserver(&server);
-                    }
-                    gpio_set_level(BLINK_GPIO, 0);
-                    esp_wifi_stop();
-                    vTaskDelay(pdMS_TO_TICKS(500));
-
-                    esp_netif_t *ap_netif = esp_netif_get_handle_from_ifkey("WIFI_AP_DEF");
-                    if (ap_netif) {
-                        esp_netif_destroy(ap_netif);
-                    }
-
-                    wifi_init_sta();
-                    vTaskDelay(pdMS_TO_TICKS(200));
-                    connect_to_wifi();
-                    vTaskDelay(pdMS_TO_TICKS(200));
-                    mqtt_initialize();
-                }
-            }
-        }
+/* Przełączanie między trybem AP i STA - wykonywane przez task roboczy kolejki prac */
+static void config_mode_work(void *arg) {
+    if (is_config_mode) {
+        return;
     }
+    is_config_mode = true;
+    power_lock_acquire(POWER_LOCK_CONFIG); // AP i serwer HTTP bez light sleep
+    ESP_LOGI("CONFIG", "Przełączanie do trybu konfiguracji...");
+    mqtt_stop();
+    if (server != NULL) {
+        stop_webserver(&server);
+    }
+
+    esp_timer_stop(status_led_timer);
+    gpio_set_level(BLINK_GPIO, 1); // stałe światło
+    esp_wifi_stop();
+    vTaskDelay(pdMS_TO_TICKS(500));
+
+    wifi_init_ap();
+    server = start_webserver();
+    if (server == NULL) {
+        ESP_LOGE("CONFIG", "Nie udało się uruchomić serwera HTTP.");
+    } else {
+        ESP_LOGI("CONFIG", "Tryb AP uruchomiony.");
+    }
+}
+
+static void station_mode_work(void *arg) {
+    if (!is_config_mode) {
+        return;
+    }
+    is_config_mode = false;
+    power_lock_release(POWER_LOCK_CONFIG);
+
+    ESP_LOGI("CONFIG", "MQTT zatrzymane przed przejściem do STA.");
+    mqtt_stop();
+
+    if (server != NULL) {
+        stop_webserver(&server);
+    }
+    gpio_set_level(BLINK_GPIO, 0);
+    esp_wifi_stop();
+    vTaskDelay(pdMS_TO_TICKS(500));
+
+    esp_netif_t *ap_netif = esp_netif_get_handle_from_ifkey("WIFI_AP_DEF");
+    if (ap_netif) {
+        esp_netif_destroy(ap_netif);
+    }
+
+    wifi_init_sta();
+    vTaskDelay(pdMS_TO_TICKS(200));
+    connect_to_wifi();
+    vTaskDelay(pdMS_TO_TICKS(200));
+    mqtt_initialize();
+}
+
+void request_config_mode(void) {
+    work_queue_post(WORK_PRIORITY_HIGH, config_mode_work, NULL, "config_mode");
+}
+
+void request_station_mode(void) {
+    work_queue_post(WORK_PRIORITY_HIGH, station_mode_work, NULL, "station_mode");
 }
 
 void configure_read_gpio() {
     gpio_config_t io_conf = {
-        .intr_type = GPIO_INTR_NEGEDGE, // Przerwanie przy opadającym zboczu
+        .intr_type = GPIO_INTR_LOW_LEVEL, // Naciśnięcie (zob. button_pressed)
         .mode = GPIO_MODE_INPUT,        // Pin jako wejście
         .pin_bit_mask = (1ULL << READ_GPIO), // Przypisanie GPIO_NUM_13
         .pull_down_en = 0,
@@ -253,43 +270,19 @@ void configure_read_gpio() {
     gpio_config(&io_conf);
 
     gpio_isr_handler_add(READ_GPIO, read_gpio_isr_handler, NULL);
+    gpio_wakeup_enable(READ_GPIO, GPIO_INTR_LOW_LEVEL);
 }
 
 
 
-void read_gpio_task(void* arg) {
-    while (1) {
-        // Czekaj na powiadomienie
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-
-        ESP_LOGI("READ", "Rozpoczynanie pomiaru czujników...");
-
-        // Wykonaj pomiar temperatury i ciśnienia z BMP280
-        float temperature, pressure;
-        bmp280_read_data(&temperature, &pressure);
-        pressure /= 100.0; // Konwersja ciśnienia na hPa
-        ESP_LOGI("BMP280", "Temperatura: %.2f °C, Ciśnienie: %.2f hPa", temperature, pressure);
-
-        // Wykonaj pomiar światła
-        int light_level = 0;
-        light_sensor_read(&light_level);
-        ESP_LOGI("LIGHT", "Poziom światła: %d lux", light_level);
-
-        // Odczyt danych BLE, jeśli są dostępne
-        if (ble_connected) {
-            esp_err_t ble_status = read_ble_data();
-            if (ble_status == ESP_OK) {
-                ESP_LOGI("BLE", "Temperatura BLE: %.2f °C, Wilgotność BLE: %.2f%%", 
-                         current_temperature_ble, current_humidity_ble);
-            } else {
-                ESP_LOGW("BLE", "Nie udało się odczytać danych BLE.");
-            }
-        }
+// Pomiar wyzwolony przez READ_GPIO
+static void read_gpio_work(void *arg) {
+    BINLOGI("READ", "Rozpoczynanie pomiaru czujników...");
+    sensors_read_all(false);
 
-        // Zakończenie pomiaru
-        is_measuring = false;
-        ESP_LOGI("READ", "Pomiary zakończone.");
-    }
+    // Zakończenie pomiaru
+    is_measuring = false;
+    BINLOGI("READ", "Pomiary zakończone.");
 }
 
 
@@ -297,11 +290,37 @@ void read_gpio_task(void* arg) {
 
 /* Diody */
 
+static void status_led_toggle(void *arg) {
+    gpio_set_level(BLINK_GPIO, led_state);
+    led_state = !led_state;
+}
+
+// Dioda miga co 0.5 s tylko bez połączenia Wi-Fi - timer nie budzi układu, gdy sieć działa
+static void status_led_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        if (!is_config_mode && !esp_timer_is_active(status_led_timer)) {
+            esp_timer_start_periodic(status_led_timer, 500 * 1000);
+        }
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        esp_timer_stop(status_led_timer);
+        gpio_set_level(BLINK_GPIO, 0); // Wyłączona dioda gdy jest połączenie
+    }
+}
+
 // Konfigurowanie pinu do diody 
 static void configure_led(void)
 {
     gpio_reset_pin(BLINK_GPIO);  // Reset pinu
     gpio_set_direction(BLINK_GPIO, GPIO_MODE_OUTPUT);  // Ustawienie pinu jako wyjście  
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &status_led_toggle,
+        .name = "status_led"
+    };
+    esp_timer_create(&timer_args, &status_led_timer);
+    esp_timer_start_periodic(status_led_timer, 500 * 1000); // Do pierwszego połączenia
+    esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, status_led_event_handler, NULL);
+    esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, status_led_event_handler, NULL);
 }
 
 // Włączenie diody 
@@ -314,43 +333,27 @@ void led_off(int led_gpio) {
     gpio_set_level(led_gpio, 0);
 }
 
-// Task migania diodą 
-void led_blink_task(void *pvParameter)
-{
-    while (1) {
-        if (is_config_mode) {
-            gpio_set_level(BLINK_GPIO, 1); // stałe światło
-        } else if (!wifi_connected) {
-            gpio_set_level(BLINK_GPIO, led_state);
-            led_state = !led_state;
-            vTaskDelay(500 / portTICK_PERIOD_MS);  // Miga co 0.5 s
-        } else {
-            gpio_set_level(BLINK_GPIO, 0); // Wyłączona dioda gdy jest połączenie
-            vTaskDelay(1000 / portTICK_PERIOD_MS);  // Sprawdzaj co 1 s
-        }
-     //   esp_task_wdt_reset();
-    }
-}
+// Alarmy progowe (diody i zdarzenia MQTT) sprawdzane przy każdej próbce z szyny - alerts.h
+#define MONITOR_QUEUE_LEN 16
 
-// Monitorowanie temperatury i światła, sprawdzenie czy włączyć diody
 void monitor_conditions_task(void *pvParameters) {
+    static sample_subscriber_t samples;
+    static sample_t ring[MONITOR_QUEUE_LEN];
+    sensors_subscribe(&samples, ring, MONITOR_QUEUE_LEN, SAMPLE_KIND_ALL,
+                      sensors_notify_task, xTaskGetCurrentTaskHandle());
+    alerts_init(xTaskGetCurrentTaskHandle());
+
     while (1) {
-        // Sprawdź temperaturę
-        if (current_temperature_bmp280 < min_temperature_threshold || current_temperature_bmp280 > max_temperature_threshold) {
-           // ESP_LOGI("MONITOR", "Temperature out of range: %.2f°C", current_temperature_bmp280);
-            led_on(LED1_GPIO);
-        } else {
-            led_off(LED1_GPIO);
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, ULONG_MAX, &bits, portMAX_DELAY);
+        if (bits & ALERTS_RULES_BIT) {
+            alerts_compile(); // Nowe progi obowiązują od razu od tej próbki
         }
 
-        // Sprawdź światło
-        if (current_light < min_light_threshold || current_light > max_light_threshold) {
-           // ESP_LOGI("MONITOR", "Light out of range: %d lux", current_light);
-            led_on(LED2_GPIO);
-        } else {
-            led_off(LED2_GPIO);
+        sample_t sample;
+        while (sensors_pop(&samples, &sample)) {
+            alerts_process(&sample);
         }
-        vTaskDelay(pdMS_TO_TICKS(5000)); 
     }
 }
 
@@ -364,8 +367,19 @@ bmp280_config_t bmp280_default_config = {
     .mode = BMP280_SLEEP_MODE
 };
 
-/* Zapis domyślnej konfiguracji MQTT */
+/* Zapis domyślnej konfiguracji MQTT - tylko gdy w NVS nie ma jeszcze brokera,
+   żeby nie nadpisać konfiguracji zapisanej przez /set_mqtt */
 void save_default_mqtt_config() {
+    nvs_handle_t nvs_handle;
+    size_t broker_len = 0;
+    if (nvs_open("mqtt_config", NVS_READONLY, &nvs_handle) == ESP_OK) {
+        esp_err_t err = nvs_get_str(nvs_handle, "broker", NULL, &broker_len);
+        nvs_close(nvs_handle);
+        if (err == ESP_OK) {
+            return;
+        }
+    }
+
     const char* default_broker = "mqtt://192.168.57.30";
     int default_port = 1883;
     const char* default_user = "username";
@@ -429,9 +443,61 @@ esp_err_t ble_initialize() {
 
 
 
+// Gałąź startu na APP_CPU (kolejka prac): magistrala I2C i czujniki
+static void boot_sensors_work(void *arg) {
+    boot_phase_start(BOOT_PHASE_SENSORS);
+    i2c_master_init();
+    if (bmp280_init() != ESP_OK) { // Reset czujnika czeka na jego gotowość (bmp280_reset)
+        ESP_LOGE("MAIN", "Inicjalizacja BMP280 nie powiodła się.");
+    }
+    load_bmp280_config_from_nvs(&bmp280_default_config);
+    bmp280_apply_config(&bmp280_default_config);
+    light_sensor_init();
+    boot_phase_done(BOOT_PHASE_SENSORS); // Także po błędzie - pomiary zgłoszą błędy odczytu
+}
+
+// Gałąź startu na PRO_CPU (razem ze stosem Bluedroid): kontroler BT i skanowanie
+static void boot_ble(void) {
+    boot_phase_start(BOOT_PHASE_BLE);
+    esp_err_t ret = ble_initialize();
+    if (ret != ESP_OK) {
+        ESP_LOGE("MAIN", "Błąd inicjalizacji BLE: %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGI("MAIN", "BLE zainicjalizowane pomyślnie.");
+
+    if (esp_ble_gap_is_scanning()) {
+        ESP_LOGW("BLE", "Skanowanie BLE już aktywne. Zatrzymuję...");
+        esp_ble_gap_stop_scanning();
+    }
+    esp_err_t scan_ret = esp_ble_gap_start_scanning(60);
+    if (scan_ret != ESP_OK) {
+        ESP_LOGE("BLE", "Nie udało się rozpocząć skanowania BLE: %s", esp_err_to_name(scan_ret));
+        return;
+    }
+    ESP_LOGI("BLE", "Skanowanie BLE rozpoczęte.");
+    boot_phase_done(BOOT_PHASE_BLE);
+}
+
+/*
+ * Start układu (boot.h): po fazie podstawowej niezależne gałęzie działają równolegle -
+ * skojarzenie Wi-Fi w tle sterownika, I2C i czujniki w kolejce prac na APP_CPU, serwer
+ * HTTP i BLE w app_main na PRO_CPU. MQTT startuje z IP_EVENT_STA_GOT_IP (wifi_station.c),
+ * a sensor_data_task czeka na koniec inicjalizacji czujników.
+ */
 void app_main(void) {
     esp_err_t ret;
 
+    boot_init();
+    boot_phase_start(BOOT_PHASE_BASE);
+
+    // Tryb rejestratora: pobudka z timera kończy się pomiarem i deep sleep (bez NVS, Wi-Fi i BLE)
+    batch_logger_wake();
+
+    // Dziennik binarny przed pierwszymi pomiarami - logi gorących ścieżek wypisuje log_drain
+    binlog_init();
+    task_table_create(TASK_LOG_DRAIN, binlog_drain_task, NULL);
+
     // Inicjalizacja NVS
     ESP_LOGI("MAIN", "Rozpoczynam inicjalizację NVS...");
     ret = nvs_flash_init();
@@ -442,11 +508,38 @@ void app_main(void) {
     }
     ESP_LOGI("MAIN", "NVS zainicjalizowane pomyślnie.");
 
+    // Konfiguracja brokera przed startem Wi-Fi - klienta MQTT uruchamia już zdarzenie uzyskania IP
+    save_default_mqtt_config();
+
+    // Szyna próbek przed pierwszym odbiorcą i pierwszym pomiarem
+    sensors_init_bus();
+
+    // Light sleep i blokady zarządzania energią - przed taskami, które je trzymają
+    if (power_init() != ESP_OK) {
+        ESP_LOGW("MAIN", "Zarządzanie energią niedostępne. Układ nie będzie usypiany.");
+    }
+
+    // Kolejka próbek na czas braku połączenia z brokerem
+    ESP_LOGI("MAIN", "Inicjalizacja kolejki telemetrii...");
+    if (telemetry_queue_init(mqtt_publish_queued_sample) != ESP_OK) {
+        ESP_LOGW("MAIN", "Kolejka telemetrii niedostępna. Próbki bez połączenia będą tracone.");
+    }
+
     // Inicjalizacja TCP/IP i systemu zdarzeń
     ESP_LOGI("MAIN", "Inicjalizacja stosu TCP/IP i systemu zdarzeń...");
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
+    // Kolejka prac dla przerwań i callbacków timerów - przed konfiguracją przycisków
+    ESP_LOGI("MAIN", "Uruchamianie kolejki prac...");
+    ESP_ERROR_CHECK(work_queue_start());
+
+    // Gałąź I2C i czujników - pierwsza praca w kolejce, przed pomiarami na żądanie
+    ESP_LOGI("MAIN", "Inicjalizacja magistrali I2C i czujników (w tle)...");
+    if (!work_queue_post(WORK_PRIORITY_HIGH, boot_sensors_work, NULL, "boot_sensors")) {
+        boot_sensors_work(NULL);
+    }
+
     // Inicjalizacja GPIO, przycisków i LED
     ESP_LOGI("MAIN", "Inicjalizacja GPIO i przycisków...");
     ESP_ERROR_CHECK(gpio_install_isr_service(ESP_INTR_FLAG_LEVEL3));
@@ -455,113 +548,44 @@ void app_main(void) {
     configure_read_gpio();
     configure_led();
 
+    // Task monitorowania warunków subskrybuje szynę przed pierwszą próbką - progi diod wczytane przed kompilacją reguł
+    load_light_range_from_nvs(&min_light_threshold, &max_light_threshold);
+    load_temperature_range_from_nvs(&min_temperature_threshold, &max_temperature_threshold);
+    ESP_LOGI("MAIN", "Tworzenie taska monitorującego warunki środowiskowe...");
+    task_table_create(TASK_MONITOR_CONDITIONS, monitor_conditions_task, NULL);
+    boot_phase_done(BOOT_PHASE_BASE);
 
-
-    // Inicjalizacja Wi-Fi
+    // Gałąź Wi-Fi: skojarzenie i DHCP trwają w tle, IP_EVENT_STA_GOT_IP uruchamia MQTT
     ESP_LOGI("MAIN", "Inicjalizacja Wi-Fi...");
+    boot_phase_start(BOOT_PHASE_WIFI_START);
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     wifi_init_sta();
-
-    // Rozpoczęcie połączenia Wi-Fi
     ESP_LOGI("MAIN", "Łączenie z siecią Wi-Fi...");
     connect_to_wifi();
-
-    // Inicjalizacja magistrali I2C i czujników
-    ESP_LOGI("MAIN", "Inicjalizacja magistrali I2C i czujników...");
-    i2c_master_init();
-    vTaskDelay(pdMS_TO_TICKS(100));
-    bmp280_init();
-    load_bmp280_config_from_nvs(&bmp280_default_config);
-    bmp280_apply_config(&bmp280_default_config);
-    light_sensor_init();
-
-    // Utworzenie taska do zarządzania trybami pracy
-    ESP_LOGI("MAIN", "Tworzenie taska do zarządzania trybami pracy...");
-    xTaskCreate(config_mode_task, "config_mode_task", 4096, NULL, 4, &config_task_handle);
-
-    vTaskDelay(pdMS_TO_TICKS(500));
-
-    ESP_LOGI("MAIN", "Tworzenie taska do obsługi pomiarów...");
-    xTaskCreate(read_gpio_task, "read_gpio_task", 4096, NULL, 5, &config_task_handle);
-
+    boot_phase_done(BOOT_PHASE_WIFI_START);
+    boot_phase_start(BOOT_PHASE_WIFI_IP);
 
     // Uruchomienie serwera HTTP
     ESP_LOGI("MAIN", "Uruchamianie serwera HTTP...");
+    boot_phase_start(BOOT_PHASE_HTTP);
     server = start_webserver();
     if (server == NULL) {
         ESP_LOGE("MAIN", "Nie udało się uruchomić serwera HTTP.");
     } else {
         ESP_LOGI("MAIN", "Serwer HTTP uruchomiony pomyślnie.");
+        boot_phase_done(BOOT_PHASE_HTTP);
     }
 
-    
+    // Publikacja rekordów z pamięci RTC i powrót do deep sleep (tryb rejestratora)
+    batch_logger_start();
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
-
-
-///
-    ESP_LOGI("MEMORY", "Wolna pamięć heap: %ld bytes", esp_get_free_heap_size());
-    UBaseType_t uxHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-    ESP_LOGI("MEMORY", "Minimalna pamięć stosu dla taska: %d bytes", uxHighWaterMark);
-///
-
-    // Sprawdzenie połączenia Wi-Fi i inicjalizacja MQTT
-    if (wifi_connected) {
-        ESP_LOGI("MAIN", "Inicjalizacja MQTT...");
-        initialize_mqtt_mutex();
-
-        ESP_LOGI("MEMORY", "Wolna pamięć heap: %ld bytes", esp_get_free_heap_size());
-        UBaseType_t uxHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-        ESP_LOGI("MEMORY", "Minimalna pamięć stosu dla taska: %d bytes", uxHighWaterMark);
-
-        vTaskDelay(pdMS_TO_TICKS(500));
-        save_default_mqtt_config();
-        vTaskDelay(pdMS_TO_TICKS(500));
-        ESP_LOGI("MEMORY", "Wolna pamięć heap: %ld bytes", esp_get_free_heap_size());
-        uxHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-        ESP_LOGI("MEMORY", "Minimalna pamięć stosu dla taska: %d bytes", uxHighWaterMark);
-
-        mqtt_initialize();
-
-        ESP_LOGI("MEMORY", "Wolna pamięć heap: %ld bytes", esp_get_free_heap_size());
-        uxHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-        ESP_LOGI("MEMORY", "Minimalna pamięć stosu dla taska: %d bytes", uxHighWaterMark);
-
-    } else {
-        ESP_LOGE("MAIN", "Wi-Fi nie jest połączone. Inicjalizacja MQTT pominięta.");
-    }
-
-    // Utworzenie taska monitorowania warunków
-    ESP_LOGI("MAIN", "Tworzenie taska monitorującego warunki środowiskowe...");
-    xTaskCreate(&monitor_conditions_task, "monitor_conditions_task", 8192, NULL, 3, NULL);
-
-    load_light_range_from_nvs(&min_light_threshold, &max_light_threshold);
-    load_temperature_range_from_nvs(&min_temperature_threshold, &max_temperature_threshold);
-
-
-    ESP_LOGI("MAIN", "Inicjalizacja zakończona pomyślnie.");
-
-
-    // Inicjalizacja BLE
+    // Gałąź BLE - w czasie skojarzenia Wi-Fi i inicjalizacji czujników
     ESP_LOGI("MAIN", "Inicjalizacja BLE...");
-    ret = ble_initialize();
-    if (ret != ESP_OK) {
-        ESP_LOGE("MAIN", "Błąd inicjalizacji BLE: %s", esp_err_to_name(ret));
-    } else {
-        ESP_LOGI("MAIN", "BLE zainicjalizowane pomyślnie.");
-    }
+    boot_ble();
 
-    // Rozpoczęcie skanowania BLE
-    if (esp_ble_gap_is_scanning()) {
-        ESP_LOGW("BLE", "Skanowanie BLE już aktywne. Zatrzymuję...");
-        esp_ble_gap_stop_scanning();
-    }
-    esp_err_t scan_ret = esp_ble_gap_start_scanning(60);
-    if (scan_ret != ESP_OK) {
-        ESP_LOGE("BLE", "Nie udało się rozpocząć skanowania BLE: %s", esp_err_to_name(scan_ret));
-    } else {
-        ESP_LOGI("BLE", "Skanowanie BLE rozpoczęte.");
-    }
+    ESP_LOGI("MAIN", "Inicjalizacja zakończona pomyślnie.");
+    ESP_LOGI("MEMORY", "Wolna pamięć heap: %ld bytes", esp_get_free_heap_size());
+    ESP_LOGI("MEMORY", "Minimalna pamięć stosu dla taska: %d bytes", uxTaskGetStackHighWaterMark(NULL));
 }
@@ -2,9 +2,12 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <math.h>
+#include <float.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <limits.h>
+#include "sdkconfig.h"
 #include "esp_wifi.h"
 #include "esp_system.h"
 #include "http_server.h"
@@ -21,16 +24,43 @@
 #include "mqtt_publisher.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "light_sensor.h"
 #include "mqtt_client.h"
 #include "ble_sensor.h"
 #include "light_sensor.h"
-#include "../../v5.3.1/esp-idf/components/json/cJSON/cJSON.h"
+#include "telemetry_queue.h"
+#include "esp_timer.h"
+#include "metric_scheduler.h"
+#include "cbor_writer.h"
+#include "gorilla_chunk.h"
+#include "payload_writer.h"
+#include "json_reader.h"
+#include "mqtt_reassembly.h"
+#include "mqtt_tls.h"
+#include "sensors.h"
+#include "work_queue.h"
+#include "task_table.h"
+#include "power.h"
+#include "alerts.h"
+#include "system_stats.h"
+#include "latency_trace.h"
+#include "binlog.h"
+#include "boot.h"
 
 
 static const char *TAG = "mqtt_client";
 
+#define SCHEDULE_STATS SAMPLE_SOURCE_COUNT            // Wpis harmonogramu dla logu statystyk
+#define SCHEDULE_SYSTEM_STATS (SAMPLE_SOURCE_COUNT + 1) // Raport /system/<mac>/stats
+#define SCHEDULE_CHUNK_FLUSH (SAMPLE_SOURCE_COUNT + 2)  // Wysyłka starych paczek "chunk"
+#define SCHEDULE_ENTRY_COUNT (SAMPLE_SOURCE_COUNT + 3)
+#define STATS_LOG_INTERVAL_MS 30000
+#define SCHEDULE_MAX_WAIT_MS (60 * 60 * 1000) // pdMS_TO_TICKS() przepełnia się dla dłuższych czasów
+#define TEMPERATURE_RANGE_LIMIT 1000.0        // °C - progi spoza +-limitu są odrzucane
+#define LIGHT_RANGE_MAX 1000000               // lx
+
 user_t users[5];    // Maksymalnie 5 użytkowników
 int user_count = 0; 
 
@@ -55,123 +85,194 @@ SemaphoreHandle_t mqtt_mutex = NULL;
 
 static SemaphoreHandle_t clients_mutex = NULL;
 
+// Wstrzymywanie tasków produkujących próbki (zamiast ich usuwania) przy zatrzymaniu klienta
+#define PRODUCERS_RUN_BIT BIT0  // Taski mogą mierzyć i publikować
+#define PRODUCERS_IDLE_BIT BIT1 // sensor_data_task czeka w punkcie pauzy
+#define PRODUCERS_PAUSE_TIMEOUT_MS 3000
+static EventGroupHandle_t producer_events = NULL;
+
+// Pomiar czasu od odzyskania sieci do pierwszej publikacji (chroniony publish_stats_mux)
+static int64_t network_up_us = 0;
+static bool awaiting_first_publish = false;
+static uint32_t heap_baseline = 0; // Wolny heap przy pierwszym połączeniu
+
+static esp_transport_handle_t tls_transport = NULL; // Transport mqtts:// (należy do klienta)
+
+// Interwały pomiarów w sekundach (indeks: sample_source_t)
+static volatile uint32_t sampling_interval_s[SAMPLE_SOURCE_COUNT] = {
+    [SAMPLE_SOURCE_BMP280] = 300,
+    [SAMPLE_SOURCE_LIGHT] = 10,
+    [SAMPLE_SOURCE_BLE] = 60,
+};
+
+static mqtt_publish_stats_t publish_stats = {0};
+
+#if MQTT_USE_PROTOCOL_V5
+/*
+- Alias = indeks w tablicy + 1. Przypisanie tematu do aliasu nie zmienia się do restartu,
+  więc ten sam numer nigdy nie wskazuje dwóch różnych tematów, także po ponownym połączeniu.
+- Aliasy dostają tylko publikacje QoS 0. Wiadomość QoS 1 może zostać ponowiona w nowym
+  połączeniu, w którym broker nie zna jeszcze aliasu.
+- Pierwsza publikacja w połączeniu niesie pełny temat i alias, kolejne - pusty temat i alias.
+- Publikacje z aliasem idą bezpośrednio (esp_mqtt_client_publish), a nie przez outbox.
+  QoS 0 nie jest zapisywane w outboxie, więc wiadomość z pustym tematem nigdy nie
+  przeczeka ponownego połączenia - broker odrzuciłby ją (protocol error) i rozłączył
+  klienta, a przy backpressure powtarzałoby się to w pętli. Pierwsza publikacja z pełnym
+  tematem też idzie bezpośrednio, żeby kolejna z pustym tematem jej nie wyprzedziła.
+- Zapis do gniazda może trwać, więc producenci czekają na topic_alias_mutex najwyżej
+  MQTT_ALIAS_LOCK_TIMEOUT_MS; potem próbka trafia do kolejki w flashu, jak przy
+  zajętym mutexie w tasku MQTT. Publikacje bez aliasu idą przez outbox jak dotąd.
+*/
+static struct {
+    char topic[MQTT_TOPIC_MAX_LEN];
+    uint32_t connection; // Połączenie, w którym broker poznał alias (0 - jeszcze nie)
+} topic_aliases[MQTT_TOPIC_ALIAS_MAX];
+static int topic_alias_count = 0;
+static volatile uint32_t alias_connection = 0;          // Numer bieżącego połączenia
+static volatile int alias_limit = MQTT_TOPIC_ALIAS_MAX; // Aliasy przyjmowane przez broker
+static SemaphoreHandle_t topic_alias_mutex = NULL;      // Para set_publish_property + publish
+static TaskHandle_t mqtt_event_task = NULL;             // Task klienta MQTT (trzyma blokadę API)
+#endif
+static portMUX_TYPE publish_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool outbox_backpressure = false;
+
 void initialize_global_mutexes() {
+    if (clients_mutex != NULL) {
+        return;
+    }
     clients_mutex = xSemaphoreCreateMutex();
     if (clients_mutex == NULL) {
         ESP_LOGE(TAG, "Nie udało się utworzyć globalnego mutexa.");
     }
 }
 
+static void handle_system_message(const char *topic, const char *data) {
+    if (strcmp(topic, "/system/settings/temp_range") == 0) {
+        apply_temperature_range_json(data);
+    } else if (strcmp(topic, "/system/settings/light_range") == 0) {
+        apply_light_range_json(data);
+    } else if (strcmp(topic, "/system/add_client") == 0) {
+        ESP_LOGI(TAG, "Dodawanie klienta: %s", data);
+        handle_add_user(data);
+    } else if (strcmp(topic, "/system/add_device") == 0) {
+        ESP_LOGI(TAG, "Dodawanie urządzenia: %s", data);
+        handle_add_device(data);
+    } else if (strcmp(topic, "/system/add_sensor") == 0) {
+        ESP_LOGI(TAG, "Dodawanie czujnika: %s", data);
+        handle_add_sensor(data);
+    } else if (strcmp(topic, "/system/add_metric") == 0) {
+        ESP_LOGI(TAG, "Dodawanie metryki: %s", data);
+        handle_add_metric(data);
+    } else if (strcmp(topic, "/system/settings/report") == 0) {
+        ESP_LOGI(TAG, "Konfiguracja raportowania: %s", data);
+        handle_report_config(data);
+    } else if (strcmp(topic, "/system/settings/alert") == 0) {
+        ESP_LOGI(TAG, "Konfiguracja alarmu: %s", data);
+        handle_alert_config(data);
+    } else if (strcmp(topic, "/system/settings/intervals") == 0) {
+        ESP_LOGI(TAG, "Konfiguracja interwałów: %s", data);
+        apply_sampling_intervals_json(data);
+    } else {
+        ESP_LOGW(TAG, "Nieobsługiwany temat: %s", topic);
+    }
+}
+
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
     esp_mqtt_event_handle_t event = event_data;
-    ESP_LOGI("MQTT_EVENT", "MQTT Event ID: %ld", event_id);
+    BINLOGI("MQTT_EVENT", "MQTT Event ID: %ld", event_id);
+#if MQTT_USE_PROTOCOL_V5
+    mqtt_event_task = xTaskGetCurrentTaskHandle();
+#endif
 
     switch ((esp_mqtt_event_id_t)event_id) {
         case MQTT_EVENT_CONNECTED:
-            ESP_LOGI("MQTT_EVENT", "Połączono z brokerem MQTT.");
-
+            ESP_LOGI("MQTT_EVENT", "Połączono z brokerem MQTT (sesja %s).", event->session_present ? "wznowiona" : "nowa");
+
+            // We wznowionej sesji broker pamięta subskrypcje i kolejkuje wiadomości QoS 1. Pusty rejestr
+            // (restart, pobudka z deep sleep) wymaga ponownej subskrypcji - broker wyśle zachowane /system/add_*
+            if (!event->session_present || user_count == 0) {
+                esp_mqtt_client_subscribe(client_handle, "/system/add_client", 1);
+                esp_mqtt_client_subscribe(client_handle, "/system/add_device", 1);
+                esp_mqtt_client_subscribe(client_handle, "/system/add_metric", 1);
+                esp_mqtt_client_subscribe(client_handle, "/system/add_sensor", 1);
+
+                esp_mqtt_client_subscribe(client_handle, "/system/settings/temp_range", 1);
+                esp_mqtt_client_subscribe(client_handle, "/system/settings/light_range", 1);
+                esp_mqtt_client_subscribe(client_handle, "/system/settings/report", 1);
+                esp_mqtt_client_subscribe(client_handle, "/system/settings/alert", 1);
+                esp_mqtt_client_subscribe(client_handle, "/system/settings/intervals", 1);
+            }
 
-            esp_mqtt_client_subscribe(client_handle, "/system/add_client", 1);
-            esp_mqtt_client_subscribe(client_handle, "/system/add_device", 1);
-            esp_mqtt_client_subscribe(client_handle, "/system/add_metric", 1);
-            esp_mqtt_client_subscribe(client_handle, "/system/add_sensor", 1);
-            
-            esp_mqtt_client_subscribe(client_handle, "/system/settings/temp_range", 1);
-            esp_mqtt_client_subscribe(client_handle, "/system/settings/light_range", 1);
+            uint32_t free_heap = esp_get_free_heap_size();
+            taskENTER_CRITICAL(&publish_stats_mux);
+            if (heap_baseline == 0) {
+                heap_baseline = free_heap;
+            } else {
+                publish_stats.reconnects++;
+                publish_stats.heap_delta_bytes = (int32_t)(free_heap - heap_baseline);
+            }
+            taskEXIT_CRITICAL(&publish_stats_mux);
+#if MQTT_USE_PROTOCOL_V5
+            // Nowe połączenie - broker nie zna żadnego aliasu
+            alias_limit = MQTT_TOPIC_ALIAS_MAX;
+            alias_connection++;
+#endif
             mqtt_connected = true;
+            boot_phase_done(BOOT_PHASE_MQTT);
+
+            // Wysłanie próbek zebranych podczas braku połączenia
+            telemetry_queue_notify_online();
 
             break;
 
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGI("MQTT_EVENT", "Rozłączono z brokerem MQTT.");
             mqtt_connected = false;
+            reassembly_reset(); // Reszta przerwanej wiadomości już nie przyjdzie
+#if MQTT_USE_PROTOCOL_V5
+            alias_connection++;
+#endif
             break;
 
         case MQTT_EVENT_SUBSCRIBED:
-            ESP_LOGI("MQTT_EVENT", "Subskrypcja zakończona sukcesem, msg_id=%d", event->msg_id);
+            BINLOGI("MQTT_EVENT", "Subskrypcja zakończona sukcesem, msg_id=%d", event->msg_id);
             break;
 
         case MQTT_EVENT_UNSUBSCRIBED:
-            ESP_LOGI("MQTT_EVENT", "Odsubskrybowano, msg_id=%d", event->msg_id);
+            BINLOGI("MQTT_EVENT", "Odsubskrybowano, msg_id=%d", event->msg_id);
             break;
 
         case MQTT_EVENT_PUBLISHED:
-            ESP_LOGI("MQTT_EVENT", "Wiadomość opublikowana, msg_id=%d", event->msg_id);
+            BINLOGI("MQTT_EVENT", "Wiadomość opublikowana, msg_id=%d", event->msg_id);
+            latency_trace_ack(event->msg_id);
+            // Outbox się zwolnił - wznowienie wysyłania próbek odłożonych podczas backpressure
+            if (outbox_backpressure && esp_mqtt_client_get_outbox_size(client_handle) < MQTT_OUTBOX_HIGH_WATERMARK / 2) {
+                outbox_backpressure = false;
+                telemetry_queue_notify_online();
+            }
             break;
 
-       case MQTT_EVENT_DATA:
-            ESP_LOGI("MQTT_EVENT", "Odebrano wiadomość.");
-            ESP_LOGI("MQTT_EVENT", "Temat: %.*s", event->topic_len, event->topic);
-            ESP_LOGI("MQTT_EVENT", "Dane: %.*s", event->data_len, event->data);
-
-            char topic[128];
-            snprintf(topic, sizeof(topic), "%.*s", event->topic_len, event->topic);
-            char data[256];
-            snprintf(data, sizeof(data), "%.*s", event->data_len, event->data);
-
-
-            if (strncmp(event->topic, "/system/settings/temp_range", event->topic_len) == 0) {
-                cJSON *root = cJSON_Parse(event->data);
-                if (!root) {
-                    ESP_LOGE(TAG, "Błąd parsowania JSON dla temp_range.");
-                    return;
-                }
-                cJSON *min_temp = cJSON_GetObjectItem(root, "min_temperature");
-                cJSON *max_temp = cJSON_GetObjectItem(root, "max_temperature");
-                if (cJSON_IsNumber(min_temp) && cJSON_IsNumber(max_temp)) {
-                    min_temperature_threshold = min_temp->valueint;
-                    max_temperature_threshold = max_temp->valueint;
-                    save_temperature_range_to_nvs(min_temperature_threshold, max_temperature_threshold);
-                ESP_LOGI(TAG, "Zakres temperatury zapisany: Min=%f, Max=%f", min_temperature_threshold, max_temperature_threshold);
-                } else {
-                    ESP_LOGE(TAG, "Nieprawidłowe dane w JSON dla temp_range.");
-                }
-
-                cJSON_Delete(root);
-
-            } else if (strncmp(event->topic, "/system/settings/light_range", event->topic_len) == 0) {
-                cJSON *root = cJSON_Parse(event->data);
-                if (!root) {
-                    ESP_LOGE(TAG, "Błąd parsowania JSON dla light_range.");
-                    return;
-                }
-
-                cJSON *min_light = cJSON_GetObjectItem(root, "min_light");
-                cJSON *max_light = cJSON_GetObjectItem(root, "max_light");
-
-                if (cJSON_IsNumber(min_light) && cJSON_IsNumber(max_light)) {
-                    min_light_threshold = min_light->valueint;
-                    max_light_threshold = max_light->valueint;
-                    
-                    save_light_range_to_nvs(min_light_threshold, max_light_threshold);
-                    ESP_LOGI(TAG, "Zakres światła zapisany: Min=%d, Max=%d", min_light_threshold, max_light_threshold);
-                } else {
-                    ESP_LOGE(TAG, "Nieprawidłowe dane w JSON dla light_range.");
-                }
-
-                cJSON_Delete(root);
+        case MQTT_EVENT_DATA: {
+            // Duże wiadomości przychodzą w kilku zdarzeniach - przetwarzana jest dopiero całość
+            reassembly_message_t *message = NULL;
+            reassembly_result_t result = reassembly_feed(event->msg_id, event->topic, event->topic_len,
+                                                         event->data, event->data_len,
+                                                         event->current_data_offset, event->total_data_len, &message);
+            if (result == REASSEMBLY_PENDING) {
+                break;
             }
-
-
-
-            else if (strcmp(topic, "/system/add_client") == 0) {
-                ESP_LOGI(TAG, "Dodawanie klienta: %s", data);
-                handle_add_user(data);
-            } else if (strcmp(topic, "/system/add_device") == 0) {
-                ESP_LOGI(TAG, "Dodawanie urządzenia: %s", data);
-                handle_add_device(data);
-            } else if (strcmp(topic, "/system/add_sensor") == 0) {
-                ESP_LOGI(TAG, "Dodawanie czujnika: %s", data);
-                handle_add_sensor(data);
-            } else if (strcmp(topic, "/system/add_metric") == 0) {
-                ESP_LOGI(TAG, "Dodawanie metryki: %s", data);
-                handle_add_metric(data);
-            } 
-            
-            else {
-                ESP_LOGW(TAG, "Nieobsługiwany temat: %s", topic);
+            if (result == REASSEMBLY_DROPPED) {
+                ESP_LOGW("MQTT_EVENT", "Odrzucono fragment wiadomości (msg_id=%d, offset=%d, rozmiar=%d).",
+                         event->msg_id, event->current_data_offset, event->total_data_len);
+                break;
             }
+
+            BINLOGI("MQTT_EVENT", "Odebrano wiadomość, temat: %s", message->topic);
+            BINLOGI("MQTT_EVENT", "Dane: %s", message->data); // Obcinane do BINLOG_STR_MAX znaków
+            handle_system_message(message->topic, message->data);
+            reassembly_release(message);
             break;
+        }
 
 
         case MQTT_EVENT_ERROR:
@@ -179,214 +280,691 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             break;
 
         default:
-            ESP_LOGI("MQTT_EVENT", "Inne zdarzenie: %ld", event_id);
+            BINLOGI("MQTT_EVENT", "Inne zdarzenie: %ld", event_id);
             break;
     }
 }
 
 
-void publish_data_for_all_clients() {
-    ESP_LOGI("MQTT", "Rozpoczynam publikację danych dla wszystkich klientów...");
+static uint32_t now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
 
-    for (int i = 0; i < user_count; i++) {
-        for (int j = 0; j < users[i].device_count; j++) {
-            for (int k = 0; k < users[i].devices[j].sensor_count; k++) {
-                for (int m = 0; m < users[i].devices[j].sensors[k].metric_count; m++) {
-                    char topic[128];
-                    generate_mqtt_topic(
-                        topic, sizeof(topic),
-                        users[i].user_id,
-                        users[i].devices[j].device_id,
-                        users[i].devices[j].sensors[k].sensor_type,
-                        users[i].devices[j].sensors[k].metrics[m].metric
-                    );
-
-                    char value[128];
-                    if (strcmp(users[i].devices[j].sensors[k].sensor_type, "bmp280") == 0) {
-                        // Dane z BMP280
-                        float temperature, pressure;
-                        bmp280_read_data(&temperature, &pressure);
-                        pressure /= 100.0; // Konwersja do hPa
-
-                        if (strcmp(users[i].devices[j].sensors[k].metrics[m].metric, "temperature") == 0) {
-                            snprintf(value, sizeof(value), "{\"temperature\": %.2f}", temperature);
-                        } else if (strcmp(users[i].devices[j].sensors[k].metrics[m].metric, "pressure") == 0) {
-                            snprintf(value, sizeof(value), "{\"pressure\": %.2f}", pressure);
-                        }
-                    } else if (strcmp(users[i].devices[j].sensors[k].sensor_type, "photoresistor") == 0) {
-                        // Dane z fotorezystora
-                        int light_level = 0;
-                        light_sensor_read(&light_level);
-                        snprintf(value, sizeof(value), "{\"light\": %d}", light_level);
-                    } else if (strcmp(users[i].devices[j].sensors[k].sensor_type, "ble") == 0) {
-                        // Dane z BLE
-                        if (strcmp(users[i].devices[j].sensors[k].metrics[m].metric, "temperature") == 0) {
-                            snprintf(value, sizeof(value), "{\"temperature\": %.2f}", current_temperature_ble);
-                        } else if (strcmp(users[i].devices[j].sensors[k].metrics[m].metric, "humidity") == 0) {
-                            snprintf(value, sizeof(value), "{\"humidity\": %.2f}", current_humidity_ble);
-                        }
-                    }
+// Report-by-exception: czy wartość metryki należy wysłać
+static bool should_report(const char *user, const char *device, const char *sensor_type, const char *metric, float value) {
+    metric_t *entry = find_metric(user, device, sensor_type, metric);
+    if (!entry) {
+        return true; // metryka spoza rejestru - bez filtrowania
+    }
+    return report_filter_should_publish(&entry->report, value, now_ms());
+}
 
-                    safe_publish(client_handle, topic, value);
-                }
-            }
+void initialize_mqtt_mutex() {
+    if (mqtt_mutex != NULL) {
+        return;
+    }
+    mqtt_mutex = xSemaphoreCreateMutex();
+    if (mqtt_mutex == NULL) {
+        ESP_LOGE(TAG, "Błąd przy tworzeniu mutexa MQTT.");
+    }
+}
+
+/* Publikacja bez blokowania: wiadomość trafia do outboxa klienta, a wysyła ją task MQTT
+   (poza QoS 0 z aliasem - patrz opis topic_aliases) */
+#define MQTT_ENQUEUE_BUSY (-2)
+#define MQTT_ALIAS_LOCK_TIMEOUT_MS 50 // Maks. czekanie producenta na publikację z aliasem
+
+#if MQTT_USE_PROTOCOL_V5
+// Numer aliasu dla tematu (1..MQTT_TOPIC_ALIAS_MAX) lub 0, gdy tablica jest pełna (wymaga topic_alias_mutex)
+static int topic_alias_get(const char *topic) {
+    for (int i = 0; i < topic_alias_count; i++) {
+        if (strcmp(topic_aliases[i].topic, topic) == 0) {
+            return i + 1;
         }
     }
+    if (topic_alias_count >= MQTT_TOPIC_ALIAS_MAX || strlen(topic) >= MQTT_TOPIC_MAX_LEN) {
+        return 0;
+    }
+    strcpy(topic_aliases[topic_alias_count].topic, topic);
+    topic_aliases[topic_alias_count].connection = 0;
+    return ++topic_alias_count;
+}
+#endif
+
+static int mqtt_enqueue(const char *topic, const char *data, int len, int qos) {
+#if MQTT_USE_PROTOCOL_V5
+    // Właściwości publikacji są wspólne dla klienta - ustawienie i publikacja muszą być atomowe.
+    // Task MQTT trzyma blokadę API klienta, więc nie może czekać na mutex (zakleszczenie).
+    bool in_mqtt_task = xTaskGetCurrentTaskHandle() == mqtt_event_task;
+    TickType_t wait = in_mqtt_task ? 0 : pdMS_TO_TICKS(MQTT_ALIAS_LOCK_TIMEOUT_MS);
+    if (xSemaphoreTake(topic_alias_mutex, wait) != pdTRUE) {
+        return MQTT_ENQUEUE_BUSY;
+    }
 
-    ESP_LOGI(TAG, "Publikacja danych zakończona.");
+    esp_mqtt5_publish_property_config_t property = {0};
+    int alias = qos == 0 ? topic_alias_get(topic) : 0;
+    if (alias > alias_limit) {
+        alias = 0;
+    }
+    property.topic_alias = alias;
+    if (esp_mqtt5_client_set_publish_property(client_handle, &property) != ESP_OK && alias > 0) {
+        // Broker przyjmuje mniej aliasów (Topic Alias Maximum z CONNACK)
+        alias_limit = alias - 1;
+        alias = 0;
+        property.topic_alias = 0;
+        esp_mqtt5_client_set_publish_property(client_handle, &property);
+    }
+
+    // Numer połączenia czytany tuż przed wyborem tematu - pusty tylko dla aliasu znanego
+    // brokerowi w bieżącym połączeniu
+    uint32_t connection = alias_connection;
+    const char *wire_topic = topic;
+    if (alias > 0 && topic_aliases[alias - 1].connection == connection) {
+        wire_topic = "";
+    }
+    int msg_id;
+    if (alias > 0) {
+        // QoS 0 bez outboxa - bez połączenia wiadomość jest odrzucana, a nie odkładana
+        msg_id = esp_mqtt_client_publish(client_handle, wire_topic, data, len, qos, 0);
+    } else {
+        msg_id = esp_mqtt_client_enqueue(client_handle, wire_topic, data, len, qos, 0, true);
+    }
+    if (msg_id >= 0 && alias > 0 && alias_connection == connection) {
+        topic_aliases[alias - 1].connection = connection;
+    }
+
+    xSemaphoreGive(topic_alias_mutex);
+    return msg_id;
+#else
+    return esp_mqtt_client_enqueue(client_handle, topic, data, len, qos, 0, true);
+#endif
 }
 
+// msg_id - identyfikator nadany przez klienta (0 dla QoS 0), gdy wynik to ESP_OK
+static esp_err_t publish_async(const char *topic, const char *data, int len, int qos, int *msg_id_out) {
+    if (!client_handle || !mqtt_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int outbox = esp_mqtt_client_get_outbox_size(client_handle);
+    taskENTER_CRITICAL(&publish_stats_mux);
+    publish_stats.outbox_bytes = outbox;
+    if (outbox > publish_stats.outbox_peak_bytes) {
+        publish_stats.outbox_peak_bytes = outbox;
+    }
+    taskEXIT_CRITICAL(&publish_stats_mux);
+
+    // Backpressure - broker nie nadąża, nie zwiększaj kolejki
+    if (outbox > MQTT_OUTBOX_HIGH_WATERMARK) {
+        outbox_backpressure = true;
+        taskENTER_CRITICAL(&publish_stats_mux);
+        publish_stats.rejected++;
+        taskEXIT_CRITICAL(&publish_stats_mux);
+        return ESP_ERR_NO_MEM;
+    }
+    if (outbox_backpressure) {
+        // Opróżnianie kolejki czeka na zwolnienie outboxa - obudź je, zanim zrobi to MQTT_EVENT_PUBLISHED
+        outbox_backpressure = false;
+        telemetry_queue_notify_online();
+    }
+
+    int64_t start = esp_timer_get_time();
+    int msg_id = mqtt_enqueue(topic, data, len, qos);
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - start);
+    if (msg_id == MQTT_ENQUEUE_BUSY) {
+        return ESP_ERR_TIMEOUT;
+    }
 
+    taskENTER_CRITICAL(&publish_stats_mux);
+    if (msg_id < 0) {
+        publish_stats.failed++;
+    } else {
+        if (awaiting_first_publish) {
+            awaiting_first_publish = false;
+            publish_stats.last_reconnect_ms = (uint32_t)((esp_timer_get_time() - network_up_us) / 1000);
+            if (publish_stats.last_reconnect_ms > publish_stats.max_reconnect_ms) {
+                publish_stats.max_reconnect_ms = publish_stats.last_reconnect_ms;
+            }
+        }
+        publish_stats.enqueued++;
+        publish_stats.last_latency_us = latency;
+        publish_stats.total_latency_us += latency;
+        if (latency > publish_stats.max_latency_us) {
+            publish_stats.max_latency_us = latency;
+        }
+    }
+    taskEXIT_CRITICAL(&publish_stats_mux);
 
-void initialize_mqtt_mutex() {
-    mqtt_mutex = xSemaphoreCreateMutex();
-    if (mqtt_mutex == NULL) {
-        ESP_LOGE(TAG, "Błąd przy tworzeniu mutexa MQTT.");
+    if (msg_id_out != NULL) {
+        *msg_id_out = msg_id;
     }
+    return msg_id < 0 ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t mqtt_publish_async(const char *topic, const char *data, int len, int qos) {
+    return publish_async(topic, data, len, qos, NULL);
+}
+
+bool mqtt_publish_backpressure(void) {
+    return outbox_backpressure;
+}
+
+void mqtt_get_publish_stats(mqtt_publish_stats_t *stats) {
+    taskENTER_CRITICAL(&publish_stats_mux);
+    *stats = publish_stats;
+    taskEXIT_CRITICAL(&publish_stats_mux);
 }
 
 void safe_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data) {
-    if (!client || !topic || !data) {
+    safe_publish_qos(client, topic, data, 1);
+}
+
+void safe_publish_qos(esp_mqtt_client_handle_t client, const char *topic, const char *data, int qos) {
+    safe_publish_data(client, topic, data, data ? (int)strlen(data) : 0, qos);
+}
+
+// Jak safe_publish_data(); zwraca msg_id wiadomości przekazanej klientowi albo -1
+static int publish_data(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos) {
+    if (!topic || !data || len <= 0) {
         ESP_LOGE("MQTT", "Nieprawidłowe parametry w safe_publish.");
-        return;
+        return -1;
     }
 
-    if (!mqtt_connected) {
-        ESP_LOGE("MQTT", "MQTT nie jest połączony.");
-        return;
+    int msg_id = -1;
+    esp_err_t err = client ? publish_async(topic, data, len, qos, &msg_id) : ESP_ERR_INVALID_STATE;
+    if (err == ESP_OK) {
+        boot_phase_done(BOOT_PHASE_FIRST_PUBLISH); // Koniec osi czasu startu (tylko pierwsza wiadomość)
+        return msg_id;
     }
 
-    if (mqtt_mutex == NULL) {
-        ESP_LOGE("MQTT", "Mutex MQTT nie został poprawnie zainicjalizowany.");
-        return;
+    if (err == ESP_ERR_INVALID_STATE || err == ESP_ERR_NO_MEM || err == ESP_ERR_TIMEOUT) {
+        // Brak połączenia lub pełny outbox - próbka trafia do kolejki w pamięci flash
+        if (telemetry_queue_append(topic, (const uint8_t *)data, len) != ESP_OK) {
+            ESP_LOGE("MQTT", "Nie można wysłać ani zakolejkować próbki: %s", topic);
+        } else if (err == ESP_ERR_TIMEOUT) {
+            telemetry_queue_notify_online(); // klient zajęty - wyślij z taska kolejki
+        }
+    } else {
+        ESP_LOGE("MQTT", "Błąd publikacji na temat %s", topic);
     }
+    return -1;
+}
 
-    // Zablokuj mutex
-    if (xSemaphoreTake(mqtt_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        esp_err_t err = esp_mqtt_client_publish(client, topic, data, 0, 1, 0);
-        if (err == ESP_OK) {
-            ESP_LOGI("MQTT", "Pomyślnie opublikowano dane na temat: %s", topic);
-        } else {
-            //ESP_LOGE("MQTT", "Błąd publikacji na temat %s: %s", topic, esp_err_to_name(err));
+// Dane binarne (CBOR) mogą zawierać bajty zerowe - długość podawana jawnie
+void safe_publish_data(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos) {
+    publish_data(client, topic, data, len, qos);
+}
+
+bool mqtt_publish_queued_sample(const char *topic, const uint8_t *payload, size_t payload_len, uint32_t timestamp) {
+    if (!client_handle || !mqtt_connected) {
+        return false;
+    }
+
+    char data[TELEMETRY_MAX_PAYLOAD_LEN + 32];
+    int len;
+    // Dopisanie czasu pomiaru do JSON-a lub mapy CBOR, o ile zegar był zsynchronizowany (po 2020-01-01)
+    bool synced = timestamp > 1577836800;
+    if (synced && payload_len >= 2 && payload[0] == '{' && payload[payload_len - 1] == '}') {
+        len = snprintf(data, sizeof(data), "%.*s, \"ts\": %lu}", (int)(payload_len - 1), (const char *)payload, (unsigned long)timestamp);
+    } else if (synced && payload_len >= 1 && payload[0] >= 0xA0 && payload[0] < 0xB7) {
+        // Mapa CBOR z krótką liczbą par - dopisanie pary "ts" i zwiększenie licznika
+        cbor_writer_t w;
+        memcpy(data, payload, payload_len);
+        data[0] = (char)(payload[0] + 1);
+        cbor_writer_init(&w, (uint8_t *)data + payload_len, sizeof(data) - payload_len);
+        cbor_write_text(&w, "ts");
+        cbor_write_uint(&w, timestamp);
+        size_t ts_len = cbor_writer_finish(&w);
+        if (ts_len == 0) {
+            data[0] = (char)payload[0]; // brak miejsca - próbka bez czasu
         }
-        xSemaphoreGive(mqtt_mutex);
+        len = (int)(payload_len + ts_len);
+    } else if (payload_len <= sizeof(data)) {
+        memcpy(data, payload, payload_len); // CBOR może zawierać bajty zerowe
+        len = (int)payload_len;
     } else {
-        ESP_LOGE("MQTT", "Nie udało się zablokować mutexa MQTT.");
+        len = -1;
     }
+    if (len < 0 || len >= (int)sizeof(data)) {
+        return true; // nie da się wysłać - pomiń próbkę
+    }
+
+    // Przy pełnym outboxie opróżnianie jest wstrzymywane do zwolnienia miejsca (MQTT_EVENT_PUBLISHED)
+    return mqtt_publish_async(topic, data, len, 1) == ESP_OK;
 }
 
+#define CHUNK_POOL_SIZE 8      // Metryki jednocześnie buforowane w trybie "chunk"
+#define CHUNK_MAX_SAMPLES 60   // Próbek na paczkę (np. 10 min przy odczycie co 10 s)
+#define CHUNK_BUFFER_SIZE 256  // Mieści się w rekordzie kolejki telemetrii
+#define CHUNK_MAX_AGE_MS (15 * 60 * 1000) // Najstarsza próbka czeka najwyżej tyle (BMP280 co 300 s: 3 próbki)
+#define CHUNK_FLUSH_CHECK_MS 60000        // Sprawdzanie wieku paczek - także bez nowych próbek (deadband)
+
+// Paczki próbek w trybie "chunk" - używane wyłącznie z sensor_data_task
+static struct {
+    char topic[MQTT_TOPIC_MAX_LEN];
+    int qos;
+    gorilla_chunk_t chunk;
+    uint32_t first_ms;     // Czas dopisania pierwszej próbki (now_ms)
+    uint8_t buf[CHUNK_BUFFER_SIZE];
+} chunk_pool[CHUNK_POOL_SIZE];
+static int chunk_pool_count = 0;
+
+static void chunk_flush(int slot) {
+    size_t len = gorilla_chunk_finish(&chunk_pool[slot].chunk);
+    if (len > 0) {
+        safe_publish_data(client_handle, chunk_pool[slot].topic, (const char *)chunk_pool[slot].buf, len, chunk_pool[slot].qos);
+    }
+    gorilla_chunk_init(&chunk_pool[slot].chunk, chunk_pool[slot].buf, sizeof(chunk_pool[slot].buf), chunk_pool[slot].chunk.flags);
+}
 
+// Wysyła paczki starsze niż CHUNK_MAX_AGE_MS (all - wszystkie niepuste, np. przed zatrzymaniem publikacji)
+static void chunk_flush_expired(bool all) {
+    uint32_t now = now_ms();
+    for (int i = 0; i < chunk_pool_count; i++) {
+        if (chunk_pool[i].chunk.count > 0 && (all || now - chunk_pool[i].first_ms >= CHUNK_MAX_AGE_MS)) {
+            chunk_flush(i);
+        }
+    }
+}
 
-void mqtt_stop() {
-    if (mqtt_connected) {
-        esp_mqtt_client_disconnect(client_handle);
+// Dopisuje próbkę do paczki tematu; false, gdy w puli nie ma miejsca na nowy temat
+static bool chunk_add_sample(const char *topic, int qos, float value, bool integer) {
+    int slot = -1;
+    for (int i = 0; i < chunk_pool_count; i++) {
+        if (strcmp(chunk_pool[i].topic, topic) == 0) {
+            slot = i;
+            break;
+        }
     }
+    if (slot < 0) {
+        if (chunk_pool_count >= CHUNK_POOL_SIZE || strlen(topic) >= MQTT_TOPIC_MAX_LEN) {
+            return false;
+        }
+        slot = chunk_pool_count++;
+        strcpy(chunk_pool[slot].topic, topic);
+        gorilla_chunk_init(&chunk_pool[slot].chunk, chunk_pool[slot].buf, sizeof(chunk_pool[slot].buf),
+                           integer ? GORILLA_CHUNK_FLAG_INTEGER : 0);
+    }
+    chunk_pool[slot].qos = qos;
 
+    uint32_t timestamp = (uint32_t)time(NULL);
+    if (!gorilla_chunk_append(&chunk_pool[slot].chunk, timestamp, value)) {
+        // Paczka pełna (albo zegar cofnięty po synchronizacji) - wyślij i zacznij nową
+        chunk_flush(slot);
+        gorilla_chunk_append(&chunk_pool[slot].chunk, timestamp, value);
+    }
+    if (chunk_pool[slot].chunk.count == 1) {
+        chunk_pool[slot].first_ms = now_ms();
+    }
+    if (chunk_pool[slot].chunk.count >= CHUNK_MAX_SAMPLES ||
+        now_ms() - chunk_pool[slot].first_ms >= CHUNK_MAX_AGE_MS) {
+        chunk_flush(slot);
+    }
+    return true;
+}
 
+// Czeka, aż sensor_data_task dojdzie do punktu pauzy (kończy bieżący pomiar, nie jest przerywany)
+static void pause_producers(void) {
+    if (producer_events == NULL) {
+        return;
+    }
+    xEventGroupClearBits(producer_events, PRODUCERS_RUN_BIT);
     if (sensor_data_task_handle != NULL) {
-        vTaskDelete(sensor_data_task_handle);
-        sensor_data_task_handle = NULL;
+        xTaskNotify(sensor_data_task_handle, 1, eSetBits);
+        EventBits_t bits = xEventGroupWaitBits(producer_events, PRODUCERS_IDLE_BIT, pdFALSE, pdTRUE,
+                                               pdMS_TO_TICKS(PRODUCERS_PAUSE_TIMEOUT_MS));
+        if (!(bits & PRODUCERS_IDLE_BIT)) {
+            ESP_LOGW(TAG, "sensor_data_task nie wstrzymał się w czasie %d ms.", PRODUCERS_PAUSE_TIMEOUT_MS);
+        }
     }
-    if (ble_data_task_handle != NULL) {
-        vTaskDelete(ble_data_task_handle);
-        ble_data_task_handle = NULL;
+}
+
+// Punkt pauzy w pętli taska produkującego próbki
+static void wait_while_paused(void) {
+    if ((xEventGroupGetBits(producer_events) & PRODUCERS_RUN_BIT) == 0) {
+        // Klient jest jeszcze połączony (mqtt_stop() czeka na ten punkt); bez połączenia
+        // paczki trafiają do kolejki w pamięci flash
+        chunk_flush_expired(true);
+        ESP_LOGI(TAG, "Publikacja wstrzymana.");
+        xEventGroupSetBits(producer_events, PRODUCERS_IDLE_BIT);
+        xEventGroupWaitBits(producer_events, PRODUCERS_RUN_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+        xEventGroupClearBits(producer_events, PRODUCERS_IDLE_BIT);
+        ESP_LOGI(TAG, "Publikacja wznowiona.");
+    }
+}
+
+/* Zatrzymuje klienta (np. przed trybem konfiguracji). Klient nie jest niszczony, a taski
+   nie są usuwane - mqtt_initialize() uruchamia ten sam klient ponownie. */
+void mqtt_stop() {
+    if (!mqtt_initialized) {
+        return;
     }
+    pause_producers();
 
     if (client_handle != NULL) {
-        if (mqtt_mutex != NULL) {
-            xSemaphoreTake(mqtt_mutex, portMAX_DELAY); // Zabezpiecz przed użyciem w innych taskach
-        }
+        xSemaphoreTake(mqtt_mutex, portMAX_DELAY);
 
+        if (mqtt_connected) {
+            esp_mqtt_client_disconnect(client_handle);
+        }
         esp_err_t err = esp_mqtt_client_stop(client_handle);
         if (err == ESP_OK) {
             ESP_LOGI(TAG, "Pomyślnie zatrzymano klienta MQTT.");
         } else {
-            ESP_LOGE(TAG, "Błąd przy tworzeniu klienta MQTT: %s", esp_err_to_name(err));
+            ESP_LOGE(TAG, "Błąd przy zatrzymywaniu klienta MQTT: %s", esp_err_to_name(err));
         }
 
-        err = esp_mqtt_client_destroy(client_handle);
-        if (err == ESP_OK) {
-            ESP_LOGI(TAG, "Pomyślnie zniszczono klienta MQTT.");
-        } else {
-            ESP_LOGE(TAG, "Błąd przy niszczeniu klienta MQTT: %s", esp_err_to_name(err));
-        }
+        xSemaphoreGive(mqtt_mutex);
+    }
+    mqtt_connected = false;
+    mqtt_initialized = false;
+}
 
-        client_handle = NULL;
+void mqtt_notify_network_up(void) {
+    taskENTER_CRITICAL(&publish_stats_mux);
+    network_up_us = esp_timer_get_time();
+    awaiting_first_publish = true;
+    taskEXIT_CRITICAL(&publish_stats_mux);
 
-        if (mqtt_mutex != NULL) {
-            xSemaphoreGive(mqtt_mutex); // Zwolnij mutex
-        }
-    } 
+    // Klient czeka na kolejną próbę połączenia (reconnect_timeout_ms) - próba od razu
+    if (client_handle != NULL && mqtt_initialized) {
+        esp_mqtt_client_reconnect(client_handle);
+    }
 }
 
-void publish_bmp280_data(const char *user, const char *device) {
-    float temperature, pressure;
-    bmp280_read_data(&temperature, &pressure);
-    pressure /= 100.0;
+// Publikacja jednej wartości metryki w formacie wybranym dla urządzenia
+static void publish_metric_sample(const char *user, const char *device, const char *sensor_type, const char *metric,
+                                  const sample_t *sample, int decimals) {
+    if (!should_report(user, device, sensor_type, metric, sample->value)) {
+        return;
+    }
 
-    char temperature_topic[100], pressure_topic[100];
-    snprintf(temperature_topic, sizeof(temperature_topic), "/%s/%s/bmp280/temperature", user, device);
-    snprintf(pressure_topic, sizeof(pressure_topic), "/%s/%s/bmp280/pressure", user, device);
+    char topic[MQTT_TOPIC_MAX_LEN];
+    snprintf(topic, sizeof(topic), "/%s/%s/%s/%s", user, device, sensor_type, metric);
+    int qos = metric_qos(user, device, sensor_type, metric);
+    payload_format_t format = device_payload_format(user, device);
 
-    char temperature_data[50], pressure_data[50];
-    snprintf(temperature_data, sizeof(temperature_data), "{\"temperature\": %.2f}", temperature);
-    snprintf(pressure_data, sizeof(pressure_data), "{\"pressure\": %.2f}", pressure);
+    if (format == PAYLOAD_FORMAT_CHUNK && chunk_add_sample(topic, qos, sample->value, decimals == 0)) {
+        return;
+    }
 
-    safe_publish(client_handle, temperature_topic, temperature_data);
-    safe_publish(client_handle, pressure_topic, pressure_data);
+    char data[64];
+    int len = format_sample(data, sizeof(data), format, metric, sample->value, decimals);
+    latency_trace_chain_t chain;
+    latency_trace_encode(sample->seq, &chain);
+    int msg_id = publish_data(client_handle, topic, data, len, qos);
+    if (msg_id >= 0) {
+        latency_trace_enqueue(&chain, msg_id);
+    }
 }
-void publish_light_sensor_data(const char *user, const char *device) {
-    int light_level;
-    light_sensor_read(&light_level);
 
-    char light_topic[100];
-    snprintf(light_topic, sizeof(light_topic), "/%s/%s/photoresistor/light", user, device);
+#define MQTT_SAMPLE_QUEUE_LEN 16 // Próbki z szyny czekające na publikację (m.in. w czasie pauzy)
 
-    char light_data[50];
-    snprintf(light_data, sizeof(light_data), "{\"light\": %d}", light_level);
+static sample_subscriber_t mqtt_samples;
+static sample_t mqtt_sample_ring[MQTT_SAMPLE_QUEUE_LEN];
 
-    safe_publish(client_handle, light_topic, light_data);
+// Publikacja próbek z szyny dla wszystkich urządzeń; zwraca liczbę próbek
+static int publish_pending_samples(void) {
+    sample_t sample;
+    int count = 0;
+    while (sensors_pop(&mqtt_samples, &sample)) {
+        count++;
+        const sample_kind_info_t *info = sample_kind_info(sample.kind);
+        if (!info) {
+            continue;
+        }
+        for (int i = 0; i < user_count; i++) {
+            for (int j = 0; j < users[i].device_count; j++) {
+                publish_metric_sample(users[i].user_id, users[i].devices[j].device_id,
+                                      info->sensor_type, info->metric, &sample, info->decimals);
+            }
+        }
+    }
+    return count;
 }
 
-void publish_ble_data(const char *user, const char *device) {
-    if (ble_connected) {
-        esp_err_t ble_status = read_ble_data();
-        if (ble_status == ESP_OK) {
-            char temperature_topic[100], humidity_topic[100];
-            snprintf(temperature_topic, sizeof(temperature_topic), "/%s/%s/ble/temperature", user, device);
-            snprintf(humidity_topic, sizeof(humidity_topic), "/%s/%s/ble/humidity", user, device);
+// Czas cyklu pomiarów i publikacji - porównanie kosztu logowania (CONFIG_MONITOR_BINLOG)
+static void record_cycle_time(uint32_t cycle_us) {
+    taskENTER_CRITICAL(&publish_stats_mux);
+    publish_stats.cycles++;
+    publish_stats.last_cycle_us = cycle_us;
+    publish_stats.total_cycle_us += cycle_us;
+    if (cycle_us > publish_stats.max_cycle_us) {
+        publish_stats.max_cycle_us = cycle_us;
+    }
+    taskEXIT_CRITICAL(&publish_stats_mux);
+}
 
-            char temperature_data[50], humidity_data[50];
-            snprintf(temperature_data, sizeof(temperature_data), "{\"temperature\": %.2f}", current_temperature_ble);
-            snprintf(humidity_data, sizeof(humidity_data), "{\"humidity\": %.2f}", current_humidity_ble);
 
-            safe_publish(client_handle, temperature_topic, temperature_data);
-            safe_publish(client_handle, humidity_topic, humidity_data);
-        }
+static void log_publish_stats(void) {
+    mqtt_publish_stats_t stats;
+    mqtt_get_publish_stats(&stats);
+    ESP_LOGI(TAG, "Outbox: %d B (max %d B), enqueue: ost. %lu us, max %lu us, śr. %lu us, odrzucone: %lu",
+             stats.outbox_bytes, stats.outbox_peak_bytes, stats.last_latency_us, stats.max_latency_us,
+             stats.enqueued ? (unsigned long)(stats.total_latency_us / stats.enqueued) : 0UL, stats.rejected);
+
+    uint32_t published, suppressed;
+    report_get_totals(&published, &suppressed);
+    ESP_LOGI(TAG, "Report-by-exception: wysłane %lu, pominięte %lu (%.1f%%)", published, suppressed,
+             report_filter_suppression_ratio(published, suppressed) * 100.0f);
+    ESP_LOGI(TAG, "Ponowne połączenia: %lu, sieć -> publikacja: ost. %lu ms, max %lu ms, zmiana heapu: %ld B",
+             stats.reconnects, stats.last_reconnect_ms, stats.max_reconnect_ms, (long)stats.heap_delta_bytes);
+    ESP_LOGI(TAG, "Cykl pomiarów i publikacji: ost. %lu us, max %lu us, śr. %lu us (%lu cykli)",
+             stats.last_cycle_us, stats.max_cycle_us,
+             stats.cycles ? (unsigned long)(stats.total_cycle_us / stats.cycles) : 0UL, stats.cycles);
+    ESP_LOGI(TAG, "Szyna próbek: dostarczone %lu, utracone %lu, max w kolejce %u/%d",
+             mqtt_samples.delivered, mqtt_samples.dropped, mqtt_samples.max_depth, MQTT_SAMPLE_QUEUE_LEN);
+    work_queue_log_stats();
+    task_table_log_stats();
+    power_log_stats();
+
+    if (tls_transport != NULL) {
+        mqtt_tls_stats_t tls;
+        mqtt_tls_get_stats(&tls);
+        ESP_LOGI(TAG, "TLS: pełne %lu (ost. %lu ms, heap %lu B), wznowione %lu (ost. %lu ms, heap %lu B), błędy %lu",
+                 tls.full_handshakes, tls.last_full_ms, tls.full_heap_peak,
+                 tls.resumed_handshakes, tls.last_resumed_ms, tls.resumed_heap_peak, tls.failed_handshakes);
     }
 }
 
+// Pomiar jednego źródła - próbki trafiają na szynę, a publikuje je publish_pending_samples()
+static void run_sample_source(uint16_t source) {
+    switch (source) {
+        case SAMPLE_SOURCE_BMP280:
+            sensors_read_bmp280(false);
+            break;
+        case SAMPLE_SOURCE_LIGHT:
+            sensors_read_light();
+            break;
+        case SAMPLE_SOURCE_BLE:
+            sensors_read_ble(); // Odpowiedzi BLE dotrą później z powiadomieniem
+            break;
+    }
+}
 
 void sensor_data_task(void *pvParameters) {
-    esp_mqtt_client_handle_t client = (esp_mqtt_client_handle_t) pvParameters;
+    boot_phase_start(BOOT_PHASE_FIRST_PUBLISH);
+    // Klient MQTT startuje zaraz po uzyskaniu IP - czujniki mogą być jeszcze inicjalizowane
+    boot_wait(BOOT_PHASE_SENSORS, portMAX_DELAY);
 
     bmp280_config_t config;
     load_bmp280_config_from_nvs(&config); // Wczytaj tryb BMP280 z konfiguracji
+    bool boot_reported = false;
+
+    // Wpisy harmonogramu: źródła pomiarów + okresowy log statystyk i raport stanu układu
+    scheduler_entry_t heap[SCHEDULE_ENTRY_COUNT];
+    uint16_t position[SCHEDULE_ENTRY_COUNT];
+    scheduler_t sched;
+    scheduler_init(&sched, heap, position, SCHEDULE_ENTRY_COUNT);
+
+    uint32_t now = now_ms();
+    for (int source = 0; source < SAMPLE_SOURCE_COUNT; source++) {
+        scheduler_add(&sched, source, sampling_interval_s[source] * 1000, now);
+    }
+    scheduler_add(&sched, SCHEDULE_STATS, STATS_LOG_INTERVAL_MS, now + STATS_LOG_INTERVAL_MS);
+    scheduler_add(&sched, SCHEDULE_CHUNK_FLUSH, CHUNK_FLUSH_CHECK_MS, now + CHUNK_FLUSH_CHECK_MS);
+#if CONFIG_MONITOR_STATS_INTERVAL_S > 0
+    scheduler_add(&sched, SCHEDULE_SYSTEM_STATS, CONFIG_MONITOR_STATS_INTERVAL_S * 1000,
+                  now + CONFIG_MONITOR_STATS_INTERVAL_S * 1000);
+#endif
+
+    // Odbiorca wszystkich próbek: z harmonogramu, z przycisku, z READ_GPIO i z odpowiedzi BLE
+    sensors_subscribe(&mqtt_samples, mqtt_sample_ring, MQTT_SAMPLE_QUEUE_LEN, SAMPLE_KIND_ALL,
+                      sensors_notify_task, xTaskGetCurrentTaskHandle());
 
     while (1) {
-        if (config.mode == BMP280_NORMAL_MODE) {
-            // Automatyczna publikacja danych w trybie NORMAL
-            for (int i = 0; i < user_count; i++) {
-                for (int j = 0; j < users[i].device_count; j++) {
-                    publish_bmp280_data(users[i].user_id, users[i].devices[j].device_id);
-                    publish_light_sensor_data(users[i].user_id, users[i].devices[j].device_id);
-                    publish_ble_data(users[i].user_id, users[i].devices[j].device_id);
-                }
+        wait_while_paused(); // Zaległe terminy po pauzie są wykonywane raz (scheduler_pop_due)
+
+        // Pełna częstotliwość tylko na czas pomiarów i kolejkowania publikacji
+        power_lock_acquire(POWER_LOCK_SENSORS);
+        uint16_t id;
+        uint32_t cycle_us = 0; // Bez raportów statystyk
+        while (scheduler_pop_due(&sched, now_ms(), &id)) {
+            if (id == SCHEDULE_STATS) {
+                log_publish_stats();
+            } else if (id == SCHEDULE_SYSTEM_STATS) {
+                system_stats_publish(&mqtt_samples);
+            } else if (id == SCHEDULE_CHUNK_FLUSH) {
+                chunk_flush_expired(false);
+            } else if (config.mode == BMP280_NORMAL_MODE) {
+                // Automatyczna publikacja danych w trybie NORMAL
+                int64_t start = esp_timer_get_time();
+                run_sample_source(id);
+                cycle_us += (uint32_t)(esp_timer_get_time() - start);
+            }
+        }
+
+        int64_t start = esp_timer_get_time();
+        if (publish_pending_samples() > 0 || cycle_us > 0) {
+            record_cycle_time(cycle_us + (uint32_t)(esp_timer_get_time() - start));
+        }
+        if (!boot_reported && boot_phase_is_done(BOOT_PHASE_FIRST_PUBLISH)) {
+            boot_reported = system_stats_publish_boot() == ESP_OK; // Przy braku połączenia - w następnym cyklu
+            if (boot_reported) {
+                boot_log_timeline();
+            }
+        }
+        power_lock_release(POWER_LOCK_SENSORS);
+
+        // Czekaj do najbliższego terminu albo nowych próbek; pozostałe bity oznaczają zmianę interwałów
+        // Dłuższe oczekiwanie w kawałkach - po przebudzeniu harmonogram nie ma nic do zrobienia
+        uint32_t wait_ms = scheduler_time_until_next(&sched, now_ms());
+        if (wait_ms > SCHEDULE_MAX_WAIT_MS) {
+            wait_ms = SCHEDULE_MAX_WAIT_MS;
+        }
+        uint32_t bits = 0;
+        if (xTaskNotifyWait(0, ULONG_MAX, &bits, pdMS_TO_TICKS(wait_ms)) == pdTRUE && (bits & ~SENSORS_NOTIFY_BIT)) {
+            now = now_ms();
+            for (int source = 0; source < SAMPLE_SOURCE_COUNT; source++) {
+                scheduler_set_interval(&sched, source, sampling_interval_s[source] * 1000, now);
             }
         }
+    }
+}
+
+const char *sample_source_name(sample_source_t source) {
+    static const char *names[SAMPLE_SOURCE_COUNT] = { "bmp280", "photoresistor", "ble" };
+    return source < SAMPLE_SOURCE_COUNT ? names[source] : "";
+}
 
-        vTaskDelay(pdMS_TO_TICKS(30000)); // 30 sekund
+uint32_t get_sampling_interval(sample_source_t source) {
+    return source < SAMPLE_SOURCE_COUNT ? sampling_interval_s[source] : 0;
+}
+
+esp_err_t set_sampling_interval(sample_source_t source, uint32_t interval_s) {
+    if (source >= SAMPLE_SOURCE_COUNT || interval_s < SAMPLING_INTERVAL_MIN_S || interval_s > SAMPLING_INTERVAL_MAX_S) {
+        return ESP_ERR_INVALID_ARG;
     }
+    sampling_interval_s[source] = interval_s;
+    if (sensor_data_task_handle != NULL) {
+        xTaskNotify(sensor_data_task_handle, 1, eSetBits); // przeplanowanie
+    }
+    return ESP_OK;
+}
+
+// JSON: {"bmp280": 300, "photoresistor": 10, "ble": 60} - interwały w sekundach.
+// Harmonogram ma jeden wpis na źródło (jeden odczyt BMP280 daje temperaturę i ciśnienie),
+// więc klucze metryk ("temperature", "bmp280/pressure") są odrzucane, a nie pomijane.
+esp_err_t apply_sampling_intervals_json(const char *data) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
+        ESP_LOGE(TAG, "Błąd parsowania JSON dla intervals: %s", data);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int kind = 0; kind < SAMPLE_KIND_COUNT; kind++) {
+        const sample_kind_info_t *info = sample_kind_info(kind);
+        char key[48];
+        snprintf(key, sizeof(key), "%s/%s", info->sensor_type, info->metric);
+        if (json_reader_has(&reader, info->metric) || json_reader_has(&reader, key)) {
+            ESP_LOGE(TAG, "Interwał ustawia się dla źródła (%s), nie dla metryki %s", info->sensor_type, key);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    // Najpierw sprawdzenie wszystkich pól - błędny komunikat nie zmienia żadnego interwału
+    uint32_t intervals[SAMPLE_SOURCE_COUNT];
+    bool present[SAMPLE_SOURCE_COUNT] = {0};
+    for (int source = 0; source < SAMPLE_SOURCE_COUNT; source++) {
+        if (!json_reader_has(&reader, sample_source_name(source))) {
+            continue;
+        }
+        double interval;
+        if (!json_reader_number(&reader, sample_source_name(source), &interval) ||
+            !(interval >= SAMPLING_INTERVAL_MIN_S && interval <= SAMPLING_INTERVAL_MAX_S)) {
+            ESP_LOGE(TAG, "Nieprawidłowy interwał dla %s", sample_source_name(source));
+            return ESP_ERR_INVALID_ARG;
+        }
+        intervals[source] = (uint32_t)interval;
+        present[source] = true;
+    }
+
+    for (int source = 0; source < SAMPLE_SOURCE_COUNT; source++) {
+        if (present[source]) {
+            set_sampling_interval(source, intervals[source]);
+        }
+    }
+    save_sampling_intervals_to_nvs();
+    ESP_LOGI(TAG, "Interwały pomiarów: bmp280=%lu s, photoresistor=%lu s, ble=%lu s",
+             sampling_interval_s[SAMPLE_SOURCE_BMP280], sampling_interval_s[SAMPLE_SOURCE_LIGHT], sampling_interval_s[SAMPLE_SOURCE_BLE]);
+    return ESP_OK;
+}
+
+void save_sampling_intervals_to_nvs() {
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open("settings", NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE("NVS", "Błąd otwierania NVS: %s", esp_err_to_name(err));
+        return;
+    }
+
+    nvs_set_u32(nvs_handle, "int_bmp280", sampling_interval_s[SAMPLE_SOURCE_BMP280]);
+    nvs_set_u32(nvs_handle, "int_light", sampling_interval_s[SAMPLE_SOURCE_LIGHT]);
+    nvs_set_u32(nvs_handle, "int_ble", sampling_interval_s[SAMPLE_SOURCE_BLE]);
+
+    err = nvs_commit(nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE("NVS", "Błąd zapisu interwałów: %s", esp_err_to_name(err));
+    }
+    nvs_close(nvs_handle);
+}
+
+void load_sampling_intervals_from_nvs() {
+    nvs_handle_t nvs_handle;
+    if (nvs_open("settings", NVS_READONLY, &nvs_handle) != ESP_OK) {
+        ESP_LOGW("NVS", "Brak zapisanych interwałów pomiarów, użyto domyślnych.");
+        return;
+    }
+
+    const char *keys[SAMPLE_SOURCE_COUNT] = { "int_bmp280", "int_light", "int_ble" };
+    for (int source = 0; source < SAMPLE_SOURCE_COUNT; source++) {
+        uint32_t value;
+        if (nvs_get_u32(nvs_handle, keys[source], &value) == ESP_OK &&
+            value >= SAMPLING_INTERVAL_MIN_S && value <= SAMPLING_INTERVAL_MAX_S) {
+            sampling_interval_s[source] = value;
+        }
+    }
+    nvs_close(nvs_handle);
 }
 
 
@@ -395,11 +973,57 @@ void sensor_data_task(void *pvParameters) {
 void set_temperature_range(float min_temp, float max_temp) {
     min_temperature_threshold = min_temp;
     max_temperature_threshold = max_temp;
+    alerts_rules_changed();
 }
 
 void set_light_range(int min_light, int max_light) {
     min_light_threshold = min_light;
     max_light_threshold = max_light;
+    alerts_rules_changed();
+}
+
+// Liczba z pola w zakresie [min, max]. Rzutowanie wartości spoza zakresu typu docelowego
+// (np. 1e30 na int albo 1e300 na float) jest niezdefiniowane, więc sprawdzenie idzie przed nim.
+static bool read_number_in_range(const json_reader_t *reader, const char *key, double min, double max, double *out) {
+    return json_reader_number(reader, key, out) && *out >= min && *out <= max;
+}
+
+// JSON: {"min_temperature": 0.5, "max_temperature": 40}
+void apply_temperature_range_json(const char *data) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
+        ESP_LOGE(TAG, "Błąd parsowania JSON dla temp_range.");
+        return;
+    }
+
+    double min_temp, max_temp;
+    if (read_number_in_range(&reader, "min_temperature", -TEMPERATURE_RANGE_LIMIT, TEMPERATURE_RANGE_LIMIT, &min_temp) &&
+        read_number_in_range(&reader, "max_temperature", -TEMPERATURE_RANGE_LIMIT, TEMPERATURE_RANGE_LIMIT, &max_temp)) {
+        set_temperature_range((float)min_temp, (float)max_temp);
+        save_temperature_range_to_nvs(min_temperature_threshold, max_temperature_threshold);
+        ESP_LOGI(TAG, "Zakres temperatury zapisany: Min=%f, Max=%f", min_temperature_threshold, max_temperature_threshold);
+    } else {
+        ESP_LOGE(TAG, "Nieprawidłowe dane w JSON dla temp_range.");
+    }
+}
+
+// JSON: {"min_light": 0, "max_light": 900}
+void apply_light_range_json(const char *data) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
+        ESP_LOGE(TAG, "Błąd parsowania JSON dla light_range.");
+        return;
+    }
+
+    double min_light, max_light;
+    if (read_number_in_range(&reader, "min_light", 0, LIGHT_RANGE_MAX, &min_light) &&
+        read_number_in_range(&reader, "max_light", 0, LIGHT_RANGE_MAX, &max_light)) {
+        set_light_range((int)min_light, (int)max_light);
+        save_light_range_to_nvs(min_light_threshold, max_light_threshold);
+        ESP_LOGI(TAG, "Zakres światła zapisany: Min=%d, Max=%d", min_light_threshold, max_light_threshold);
+    } else {
+        ESP_LOGE(TAG, "Nieprawidłowe dane w JSON dla light_range.");
+    }
 }
 
 void restart_mqtt_client() {
@@ -431,6 +1055,7 @@ void mqtt_initialize(void) {
         ESP_LOGW(TAG, "MQTT już zainicjalizowany.");
         return;
     }
+    boot_phase_start(BOOT_PHASE_MQTT);
     initialize_global_mutexes();
     initialize_mqtt_mutex();
     if (mqtt_mutex == NULL) {
@@ -454,49 +1079,80 @@ void mqtt_initialize(void) {
         .broker.address.uri = broker,
         .broker.address.port = port,
         .credentials.username = user,
-    .credentials.authentication.password = password,
+        .credentials.authentication.password = password,
         .network.timeout_ms = 20000,
         .session.keepalive = 240, 
+        .session.disable_clean_session = true, // Trwała sesja - subskrypcje i QoS 1 przetrwają rozłączenie
+        .outbox.limit = MQTT_OUTBOX_LIMIT_BYTES,
+#if MQTT_USE_PROTOCOL_V5
+        .session.protocol_ver = MQTT_PROTOCOL_V_5,
+#endif
     };
 
+    // mqtts:// - własny transport TLS, który przy ponownym połączeniu wznawia sesję TLS
+    if (strncmp(broker, MQTT_TLS_SCHEME, strlen(MQTT_TLS_SCHEME)) == 0) {
+        if (port == 1883) {
+            port = MQTT_TLS_DEFAULT_PORT; // Domyślny port z konfiguracji dla mqtt://
+            mqtt_cfg.broker.address.port = port;
+        }
+        if (tls_transport == NULL) {
+            tls_transport = mqtt_tls_transport_create();
+            mqtt_tls_benchmark_start(broker, port); // Własne zadanie - nie blokuje handlera zdarzeń IP
+        }
+        mqtt_cfg.network.transport = tls_transport;
+    }
+
+#if MQTT_USE_PROTOCOL_V5
+    if (topic_alias_mutex == NULL) {
+        topic_alias_mutex = xSemaphoreCreateMutex();
+    }
+#endif
+    if (producer_events == NULL) {
+        producer_events = xEventGroupCreate();
+    }
+
     ESP_LOGI(TAG, "MQTT broker: %s", mqtt_cfg.broker.address.uri);
     ESP_LOGI(TAG, "MQTT port: %ld", mqtt_cfg.broker.address.port);
     ESP_LOGI(TAG, "MQTT username: %s", mqtt_cfg.credentials.username ? mqtt_cfg.credentials.username : "NULL");
     ESP_LOGI(TAG, "MQTT password: %s", mqtt_cfg.credentials.authentication.password ? "SET" : "NULL");
 
-
-
-    client_handle = esp_mqtt_client_init(&mqtt_cfg);
+    // Jeden klient na cały czas działania: przy utracie Wi-Fi łączy się ponownie sam,
+    // a po mqtt_stop() dostaje tylko nową konfigurację brokera
     if (client_handle == NULL) {
-        ESP_LOGE(TAG, "Failed to initialize MQTT client.");
+        client_handle = esp_mqtt_client_init(&mqtt_cfg);
+        if (client_handle == NULL) {
+            ESP_LOGE(TAG, "Failed to initialize MQTT client.");
+            return;
+        }
+        esp_mqtt_client_register_event(client_handle, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+    } else if (esp_mqtt_set_config(client_handle, &mqtt_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "Nie udało się zaktualizować konfiguracji klienta MQTT.");
         return;
     }
 
-    esp_mqtt_client_register_event(client_handle, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+#if MQTT_USE_PROTOCOL_V5
+    // W MQTT v5 sesja bez session expiry wygasa w chwili rozłączenia
+    esp_mqtt5_connection_property_config_t connect_property = {
+        .session_expiry_interval = MQTT_SESSION_EXPIRY_S,
+    };
+    esp_mqtt5_client_set_connect_property(client_handle, &connect_property);
+#endif
 
     esp_err_t err = esp_mqtt_client_start(client_handle);
-    if (err == ESP_OK) {
-        ESP_LOGI(TAG, "MQTT client started successfully.");
-        xTaskCreate(sensor_data_task, "sensor_data_task", 10240, (void*) client_handle, 5, &sensor_data_task_handle);
-      
-    } else {
+    if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start MQTT client: %s", esp_err_to_name(err));
-        client_handle = NULL;
+        return;
     }
+    ESP_LOGI(TAG, "MQTT client started successfully.");
 
-
+    xEventGroupSetBits(producer_events, PRODUCERS_RUN_BIT);
+    if (sensor_data_task_handle == NULL) {
+        load_sampling_intervals_from_nvs();
+        sensor_data_task_handle = task_table_create(TASK_SENSOR_DATA, sensor_data_task, (void*) client_handle);
+    }
 
     mqtt_initialized = true;
-
-
-    // Subskrypcja na temat
-    esp_mqtt_client_subscribe(client_handle, "/system/add_client", 1);
-    esp_mqtt_client_subscribe(client_handle, "/system/add_device", 1);
-    esp_mqtt_client_subscribe(client_handle, "/system/add_metric", 1);
-    esp_mqtt_client_subscribe(client_handle, "/system/add_sensor", 1);
-    
-    esp_mqtt_client_subscribe(client_handle, "/system/settings/temp_range", 1);
-    esp_mqtt_client_subscribe(client_handle, "/system/settings/light_range", 1);
+    // Subskrypcje są wysyłane w MQTT_EVENT_CONNECTED
 }
 
 
@@ -535,6 +1191,7 @@ int add_device(const char *user_id, const char *device_id) {
             }
             strncpy(users[i].devices[users[i].device_count].device_id, device_id, sizeof(users[i].devices[users[i].device_count].device_id) - 1);
             users[i].devices[users[i].device_count].sensor_count = 0;
+            users[i].devices[users[i].device_count].payload_format = PAYLOAD_FORMAT_JSON;
             users[i].device_count++;
             ESP_LOGI(TAG, "Dodano urządzenie: %s do użytkownika: %s", device_id, user_id);
             return 0;
@@ -567,6 +1224,25 @@ int add_sensor(const char *user_id, const char *device_id, const char *sensor_ty
     return -1;
 }
 
+// Domyślne progi zmian - poniżej rozdzielczości prezentowanej w panelu
+static void default_report_config(const char *metric, report_config_t *config) {
+    config->deadband = 0.0f;
+    config->deadband_percent = false;
+    config->min_interval_ms = 0;
+    config->max_interval_ms = REPORT_DEFAULT_HEARTBEAT_MS;
+
+    if (strcmp(metric, "temperature") == 0) {
+        config->deadband = 0.1f;  // °C
+    } else if (strcmp(metric, "pressure") == 0) {
+        config->deadband = 0.1f;  // hPa
+    } else if (strcmp(metric, "humidity") == 0) {
+        config->deadband = 0.5f;  // %
+    } else if (strcmp(metric, "light") == 0) {
+        config->deadband = 5.0f;  // % ostatniej wartości
+        config->deadband_percent = true;
+    }
+}
+
 int add_metric(const char *user_id, const char *device_id, const char *sensor_type, const char *metric) {
     for (int i = 0; i < user_count; i++) {
         if (strcmp(users[i].user_id, user_id) == 0) {
@@ -578,7 +1254,14 @@ int add_metric(const char *user_id, const char *device_id, const char *sensor_ty
                                 ESP_LOGE("MQTT", "Maksymalna liczba metryk osiągnięta.");
                                 return -1;
                             }
-                            strncpy(users[i].devices[j].sensors[k].metrics[users[i].devices[j].sensors[k].metric_count].metric, metric, sizeof(users[i].devices[j].sensors[k].metrics[users[i].devices[j].sensors[k].metric_count].metric) - 1);
+                            metric_t *entry = &users[i].devices[j].sensors[k].metrics[users[i].devices[j].sensors[k].metric_count];
+                            strncpy(entry->metric, metric, sizeof(entry->metric) - 1);
+                            // Fotorezystor publikuje najczęściej - QoS 0 wystarcza
+                            entry->qos = strcmp(sensor_type, "photoresistor") == 0 ? 0 : 1;
+                            report_config_t report_config;
+                            default_report_config(metric, &report_config);
+                            report_filter_init(&entry->report, &report_config);
+                            entry->alert.enabled = false;
                             users[i].devices[j].sensors[k].metric_count++;
                             ESP_LOGI("MQTT", "Dodano metrykę: %s do sensora: %s", metric, sensor_type);
                             return 0;
@@ -593,6 +1276,78 @@ int add_metric(const char *user_id, const char *device_id, const char *sensor_ty
 }
 
 
+device_t *find_device(const char *user_id, const char *device_id) {
+    for (int i = 0; i < user_count; i++) {
+        if (strcmp(users[i].user_id, user_id) != 0) continue;
+        for (int j = 0; j < users[i].device_count; j++) {
+            if (strcmp(users[i].devices[j].device_id, device_id) == 0) {
+                return &users[i].devices[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+payload_format_t device_payload_format(const char *user_id, const char *device_id) {
+    device_t *device = find_device(user_id, device_id);
+    return device ? device->payload_format : PAYLOAD_FORMAT_JSON;
+}
+
+// Dane próbki: JSON lub CBOR z nazwą metryki albo sama liczba (nazwa wynika z tematu)
+int format_sample(char *buf, size_t len, payload_format_t format, const char *metric, float value, int decimals) {
+    if (format == PAYLOAD_FORMAT_CBOR) {
+        // {metric: value} - liczby całkowite jako int, pozostałe jako half/single
+        cbor_writer_t w;
+        cbor_writer_init(&w, (uint8_t *)buf, len);
+        cbor_write_map(&w, 1);
+        cbor_write_text(&w, metric);
+        if (decimals == 0) {
+            cbor_write_int(&w, (int64_t)value);
+        } else {
+            cbor_write_float(&w, value);
+        }
+        return (int)cbor_writer_finish(&w);
+    }
+
+    // Bez printf dla float - wynik identyczny jak "%.*f"
+    payload_writer_t w;
+    payload_writer_init(&w, buf, len);
+    if (format == PAYLOAD_FORMAT_NUMERIC) {
+        payload_fixed(&w, value, decimals);
+    } else {
+        payload_begin_object(&w);
+        payload_key(&w, metric);
+        payload_fixed(&w, value, decimals);
+        payload_end_object(&w);
+    }
+    return (int)payload_writer_finish(&w);
+}
+
+metric_t *find_metric(const char *user_id, const char *device_id, const char *sensor_type, const char *metric) {
+    for (int i = 0; i < user_count; i++) {
+        if (strcmp(users[i].user_id, user_id) != 0) continue;
+        for (int j = 0; j < users[i].device_count; j++) {
+            if (strcmp(users[i].devices[j].device_id, device_id) != 0) continue;
+            for (int k = 0; k < users[i].devices[j].sensor_count; k++) {
+                if (strcmp(users[i].devices[j].sensors[k].sensor_type, sensor_type) != 0) continue;
+                for (int m = 0; m < users[i].devices[j].sensors[k].metric_count; m++) {
+                    if (strcmp(users[i].devices[j].sensors[k].metrics[m].metric, metric) == 0) {
+                        return &users[i].devices[j].sensors[k].metrics[m];
+                    }
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+int metric_qos(const char *user_id, const char *device_id, const char *sensor_type, const char *metric) {
+    metric_t *entry = find_metric(user_id, device_id, sensor_type, metric);
+    if (entry) {
+        return entry->qos;
+    }
+    return strcmp(sensor_type, "photoresistor") == 0 ? 0 : 1;
+}
 
 void publish_all_metrics(const char *user_id, const char *device_id) {
     for (int i = 0; i < user_count; i++) {
@@ -647,7 +1402,7 @@ void generate_mqtt_topic(char *topic, size_t topic_size, const char *user_id, co
     // Formatuj temat MQTT
     
     snprintf(topic, topic_size, "user/%s/%s/%s/%s", user_id, device_id, sensor_type, metric);
-    ESP_LOGI(TAG, "Generowany temat MQTT: %s", topic);
+    BINLOGI(TAG, "Generowany temat MQTT: %s", topic);
 
 }
 
@@ -662,26 +1417,23 @@ void subscribe_all_users() {
 
 void handle_add_user(const char *data) {
     ESP_LOGI(TAG, "Przetwarzanie add_user: %s", data);
-    cJSON *root = cJSON_Parse(data);
-    if (!root) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
         ESP_LOGE(TAG, "Błąd parsowania JSON dla add_user: %s", data);
         return;
     }
 
-    const cJSON *user_id = cJSON_GetObjectItem(root, "user_id");
-    if (!cJSON_IsString(user_id)) {
+    char user_id[MQTT_ID_MAX_LEN];
+    if (!json_reader_string(&reader, "user_id", user_id, sizeof(user_id))) {
         ESP_LOGE(TAG, "Nieprawidłowy format JSON dla add_user: brak user_id");
-        cJSON_Delete(root);
         return;
     }
 
-    if (add_user(user_id->valuestring) == 0) {
-        ESP_LOGI(TAG, "Dodano użytkownika: %s", user_id->valuestring);
+    if (add_user(user_id) == 0) {
+        ESP_LOGI(TAG, "Dodano użytkownika: %s", user_id);
     } else {
-        ESP_LOGE(TAG, "Nie udało się dodać użytkownika: %s", user_id->valuestring);
+        ESP_LOGE(TAG, "Nie udało się dodać użytkownika: %s", user_id);
     }
-
-    cJSON_Delete(root);
 }
 
 
@@ -689,84 +1441,215 @@ void handle_add_user(const char *data) {
 void handle_add_device(const char *data) {
     ESP_LOGI(TAG, "Przetwarzanie add_device: %s", data);
 
-    cJSON *root = cJSON_Parse(data);
-    if (!root) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
         ESP_LOGE(TAG, "Błąd parsowania JSON dla add_device: %s", data);
         return;
     }
 
-    const cJSON *user_id = cJSON_GetObjectItem(root, "user_id");
-    const cJSON *device_id = cJSON_GetObjectItem(root, "device_id");
-
-    if (!cJSON_IsString(user_id) || !cJSON_IsString(device_id)) {
+    char user_id[MQTT_ID_MAX_LEN], device_id[MQTT_ID_MAX_LEN];
+    if (!json_reader_string(&reader, "user_id", user_id, sizeof(user_id)) ||
+        !json_reader_string(&reader, "device_id", device_id, sizeof(device_id))) {
         ESP_LOGE(TAG, "Nieprawidłowy format JSON w add_device.");
-        cJSON_Delete(root);
         return;
     }
 
-    if (add_device(user_id->valuestring, device_id->valuestring) == 0) {
-        ESP_LOGI(TAG, "Dodano urządzenie: %s dla użytkownika: %s", device_id->valuestring, user_id->valuestring);
+    if (add_device(user_id, device_id) == 0) {
+        ESP_LOGI(TAG, "Dodano urządzenie: %s dla użytkownika: %s", device_id, user_id);
+
+        // Opcjonalny format danych: "json" (domyślny), "numeric", "cbor" lub "chunk"
+        char payload_format[16];
+        device_t *device = find_device(user_id, device_id);
+        if (device && json_reader_string(&reader, "payload_format", payload_format, sizeof(payload_format))) {
+            if (strcmp(payload_format, "numeric") == 0) {
+                device->payload_format = PAYLOAD_FORMAT_NUMERIC;
+            } else if (strcmp(payload_format, "cbor") == 0) {
+                device->payload_format = PAYLOAD_FORMAT_CBOR;
+            } else if (strcmp(payload_format, "chunk") == 0) {
+                device->payload_format = PAYLOAD_FORMAT_CHUNK;
+            } else {
+                device->payload_format = PAYLOAD_FORMAT_JSON;
+            }
+            ESP_LOGI(TAG, "Format danych urządzenia %s: %s", device_id, payload_format);
+        }
     } else {
         ESP_LOGE(TAG, "Nie udało się dodać urządzenia.");
     }
-
-    cJSON_Delete(root);
 }
 
 
 void handle_add_sensor(const char *data) {
-    cJSON *root = cJSON_Parse(data);
-    if (!root) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
         ESP_LOGE(TAG, "Błąd parsowania JSON dla add_sensor: %s", data);
         return;
     }
 
-    const cJSON *user_id = cJSON_GetObjectItem(root, "user_id");
-    const cJSON *device_id = cJSON_GetObjectItem(root, "device_id");
-    const cJSON *sensor_type = cJSON_GetObjectItem(root, "sensor_id");
-
-    if (!cJSON_IsString(user_id) || !cJSON_IsString(device_id) || !cJSON_IsString(sensor_type)) {
+    char user_id[MQTT_ID_MAX_LEN], device_id[MQTT_ID_MAX_LEN], sensor_type[MQTT_ID_MAX_LEN];
+    if (!json_reader_string(&reader, "user_id", user_id, sizeof(user_id)) ||
+        !json_reader_string(&reader, "device_id", device_id, sizeof(device_id)) ||
+        !json_reader_string(&reader, "sensor_id", sensor_type, sizeof(sensor_type))) {
         ESP_LOGE(TAG, "Nieprawidłowy format JSON dla add_sensor");
-        cJSON_Delete(root);
         return;
     }
 
-    if (add_sensor(user_id->valuestring, device_id->valuestring, sensor_type->valuestring) == 0) {
-        ESP_LOGI(TAG, "Dodano czujnik: %s do urządzenia: %s użytkownika: %s", sensor_type->valuestring, device_id->valuestring, user_id->valuestring);
+    if (add_sensor(user_id, device_id, sensor_type) == 0) {
+        ESP_LOGI(TAG, "Dodano czujnik: %s do urządzenia: %s użytkownika: %s", sensor_type, device_id, user_id);
+    } else {
+        ESP_LOGE(TAG, "Nie udało się dodać czujnika: %s", sensor_type);
+    }
+}
+
+
+// Opcjonalne pola: deadband, deadband_percent, min_interval i max_interval (w sekundach)
+static void apply_report_config(metric_t *entry, const json_reader_t *reader) {
+    report_config_t *config = &entry->report.config;
+
+    double deadband, min_interval, max_interval;
+    bool deadband_percent;
+    if (read_number_in_range(reader, "deadband", 0, FLT_MAX, &deadband)) {
+        config->deadband = (float)deadband;
+    }
+    if (json_reader_bool(reader, "deadband_percent", &deadband_percent)) {
+        config->deadband_percent = deadband_percent;
+    }
+    if (json_reader_number(reader, "min_interval", &min_interval) && min_interval >= 0 && min_interval <= UINT32_MAX / 1000) {
+        config->min_interval_ms = (uint32_t)min_interval * 1000;
+    }
+    if (json_reader_number(reader, "max_interval", &max_interval) && max_interval >= 0 && max_interval <= UINT32_MAX / 1000) {
+        config->max_interval_ms = (uint32_t)max_interval * 1000;
+    }
+}
+
+// Opcjonalne pola: alert_min, alert_max, alert_hysteresis, alert_debounce (liczba próbek).
+// Alarm jest włączony, gdy podano choć jeden próg; "alert": false go wyłącza
+static bool apply_alert_config(metric_t *entry, const json_reader_t *reader) {
+    alert_config_t *alert = &entry->alert;
+    double low, high, hysteresis, debounce;
+    bool enabled;
+    bool has_low = read_number_in_range(reader, "alert_min", -FLT_MAX, FLT_MAX, &low);
+    bool has_high = read_number_in_range(reader, "alert_max", -FLT_MAX, FLT_MAX, &high);
+
+    if (json_reader_bool(reader, "alert", &enabled) && !enabled) {
+        alert->enabled = false;
+        return true;
+    }
+    if (!has_low && !has_high) {
+        return false;
+    }
+    alert->enabled = true;
+    alert->low = has_low ? (float)low : NAN;
+    alert->high = has_high ? (float)high : NAN;
+    alert->hysteresis = read_number_in_range(reader, "alert_hysteresis", 0, FLT_MAX, &hysteresis) ? (float)hysteresis : 0;
+    alert->debounce = json_reader_number(reader, "alert_debounce", &debounce) && debounce >= 1 && debounce <= 255 ? (uint8_t)debounce : 1;
+    return true;
+}
+
+// Pola identyfikujące metrykę, wspólne dla add_metric, report i alert (bufory po MQTT_ID_MAX_LEN)
+static bool read_metric_path(const json_reader_t *reader, char *user_id, char *device_id, char *sensor_type, char *metric) {
+    return json_reader_string(reader, "user_id", user_id, MQTT_ID_MAX_LEN) &&
+           json_reader_string(reader, "device_id", device_id, MQTT_ID_MAX_LEN) &&
+           json_reader_string(reader, "sensor_id", sensor_type, MQTT_ID_MAX_LEN) &&
+           json_reader_string(reader, "metric_id", metric, MQTT_ID_MAX_LEN);
+}
+
+void handle_report_config(const char *data) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
+        ESP_LOGE(TAG, "Błąd parsowania JSON dla report: %s", data);
+        return;
+    }
+
+    char user_id[MQTT_ID_MAX_LEN], device_id[MQTT_ID_MAX_LEN], sensor_type[MQTT_ID_MAX_LEN], metric[MQTT_ID_MAX_LEN];
+    if (!read_metric_path(&reader, user_id, device_id, sensor_type, metric)) {
+        ESP_LOGE(TAG, "Nieprawidłowy format JSON dla report");
+        return;
+    }
+
+    metric_t *entry = find_metric(user_id, device_id, sensor_type, metric);
+    if (entry) {
+        apply_report_config(entry, &reader);
+        ESP_LOGI(TAG, "Raportowanie %s/%s: deadband=%.2f%s, min=%lu ms, max=%lu ms", sensor_type, metric,
+                 entry->report.config.deadband, entry->report.config.deadband_percent ? "%" : "",
+                 entry->report.config.min_interval_ms, entry->report.config.max_interval_ms);
     } else {
-        ESP_LOGE(TAG, "Nie udało się dodać czujnika: %s", sensor_type->valuestring);
+        ESP_LOGE(TAG, "Nie znaleziono metryki: %s", metric);
+    }
+}
+
+void handle_alert_config(const char *data) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
+        ESP_LOGE(TAG, "Błąd parsowania JSON dla alert: %s", data);
+        return;
+    }
+
+    char user_id[MQTT_ID_MAX_LEN], device_id[MQTT_ID_MAX_LEN], sensor_type[MQTT_ID_MAX_LEN], metric[MQTT_ID_MAX_LEN];
+    if (!read_metric_path(&reader, user_id, device_id, sensor_type, metric)) {
+        ESP_LOGE(TAG, "Nieprawidłowy format JSON dla alert");
+        return;
     }
 
-    cJSON_Delete(root);
+    metric_t *entry = find_metric(user_id, device_id, sensor_type, metric);
+    if (!entry) {
+        ESP_LOGE(TAG, "Nie znaleziono metryki: %s", metric);
+    } else if (apply_alert_config(entry, &reader)) {
+        ESP_LOGI(TAG, "Alarm %s/%s: %s, min=%.2f, max=%.2f, histereza=%.2f, debounce=%u", sensor_type, metric,
+                 entry->alert.enabled ? "włączony" : "wyłączony", entry->alert.low, entry->alert.high,
+                 entry->alert.hysteresis, entry->alert.debounce);
+        alerts_rules_changed();
+    } else {
+        ESP_LOGE(TAG, "Alarm %s/%s: brak progów (alert_min / alert_max).", sensor_type, metric);
+    }
 }
 
+void report_get_totals(uint32_t *published, uint32_t *suppressed) {
+    *published = 0;
+    *suppressed = 0;
+    for (int i = 0; i < user_count; i++) {
+        for (int j = 0; j < users[i].device_count; j++) {
+            for (int k = 0; k < users[i].devices[j].sensor_count; k++) {
+                for (int m = 0; m < users[i].devices[j].sensors[k].metric_count; m++) {
+                    *published += users[i].devices[j].sensors[k].metrics[m].report.published;
+                    *suppressed += users[i].devices[j].sensors[k].metrics[m].report.suppressed;
+                }
+            }
+        }
+    }
+}
 
 void handle_add_metric(const char *data) {
-    cJSON *root = cJSON_Parse(data);
-    if (!root) {
+    json_reader_t reader;
+    if (!json_reader_parse(&reader, data, strlen(data))) {
         ESP_LOGE(TAG, "Błąd parsowania JSON dla add_metric: %s", data);
         return;
     }
 
-    const cJSON *user_id = cJSON_GetObjectItem(root, "user_id");
-    const cJSON *device_id = cJSON_GetObjectItem(root, "device_id");
-    const cJSON *sensor_type = cJSON_GetObjectItem(root, "sensor_id");
-    const cJSON *metric = cJSON_GetObjectItem(root, "metric_id");
-
-    if (!cJSON_IsString(user_id) || !cJSON_IsString(device_id) || !cJSON_IsString(sensor_type) || !cJSON_IsString(metric)) {
+    char user_id[MQTT_ID_MAX_LEN], device_id[MQTT_ID_MAX_LEN], sensor_type[MQTT_ID_MAX_LEN], metric[MQTT_ID_MAX_LEN];
+    if (!read_metric_path(&reader, user_id, device_id, sensor_type, metric)) {
         ESP_LOGE(TAG, "Nieprawidłowy format JSON dla add_metric");
-        cJSON_Delete(root);
         return;
     }
 
-    if (add_metric(user_id->valuestring, device_id->valuestring, sensor_type->valuestring, metric->valuestring) == 0) {
+    if (add_metric(user_id, device_id, sensor_type, metric) == 0) {
         ESP_LOGI(TAG, "Dodano metrykę: %s do czujnika: %s urządzenia: %s użytkownika: %s",
-                 metric->valuestring, sensor_type->valuestring, device_id->valuestring, user_id->valuestring);
+                 metric, sensor_type, device_id, user_id);
+
+        // Opcjonalny QoS i parametry raportowania metryki
+        double qos;
+        metric_t *entry = find_metric(user_id, device_id, sensor_type, metric);
+        if (entry && json_reader_number(&reader, "qos", &qos) && qos >= 0 && qos <= 2) {
+            entry->qos = (int)qos;
+        }
+        if (entry) {
+            apply_report_config(entry, &reader);
+            if (apply_alert_config(entry, &reader)) {
+                alerts_rules_changed();
+            }
+        }
     } else {
-        ESP_LOGE(TAG, "Nie udało się dodać metryki: %s", metric->valuestring);
+        ESP_LOGE(TAG, "Nie udało się dodać metryki: %s", metric);
     }
-
-    cJSON_Delete(root);
 }
 
 void save_light_range_to_nvs(int min_light, int max_light) {
@@ -1,7 +1,10 @@
 #include "mqtt_client.h"
+#include "sdkconfig.h"
 #ifndef MQTT_CLIENT_H
 #define MQTT_CLIENT_H
 
+#include "report_filter.h"
+
 
 
 
@@ -10,24 +13,70 @@
 #define MAX_SENSORS 5
 #define MAX_METRICS 6
 
+#define MQTT_OUTBOX_LIMIT_BYTES (16 * 1024)    // Maksymalny rozmiar outboxa klienta MQTT
+#define MQTT_OUTBOX_HIGH_WATERMARK (12 * 1024) // Powyżej tej wartości publikacje są odrzucane (backpressure)
+#define REPORT_DEFAULT_HEARTBEAT_MS (15 * 60 * 1000) // Wymuszona publikacja niezmienionej wartości
+
+#if CONFIG_MONITOR_MQTT_V5
+#define MQTT_USE_PROTOCOL_V5 1       // MQTT v5 z aliasami tematów (menuconfig)
+#else
+#define MQTT_USE_PROTOCOL_V5 0
+#endif
+#define MQTT_TOPIC_ALIAS_MAX 10       // Domyślny max_topic_alias w mosquitto
+#define MQTT_TOPIC_MAX_LEN 100
+#define MQTT_ID_MAX_LEN 50            // Identyfikatory w rejestrze: użytkownik, urządzenie, czujnik, metryka
+#define MQTT_SESSION_EXPIRY_S 3600    // Broker przechowuje sesję (subskrypcje, QoS 1) przez godzinę
+
+#define SAMPLING_INTERVAL_MIN_S 1
+#define SAMPLING_INTERVAL_MAX_S (24 * 60 * 60)
+
+// Źródła pomiarów planowane niezależnie przez harmonogram
+typedef enum {
+    SAMPLE_SOURCE_BMP280 = 0,
+    SAMPLE_SOURCE_LIGHT,
+    SAMPLE_SOURCE_BLE,
+    SAMPLE_SOURCE_COUNT
+} sample_source_t;
+
+// Alarm progowy metryki (threshold_engine.h) - zdarzenia na /user/device/<sensor>/<metric>/alert
+typedef struct {
+    bool enabled;
+    float low;        // NAN - bez dolnego progu
+    float high;       // NAN - bez górnego progu
+    float hysteresis;
+    uint8_t debounce; // Kolejne próbki potrzebne do zmiany stanu
+} alert_config_t;
+
 typedef struct {
-    char metric[50]; // Nazwa metryki
+    char metric[MQTT_ID_MAX_LEN]; // Nazwa metryki
+    uint8_t qos;     // QoS publikacji (0 dla metryk o dużej częstotliwości)
+    report_state_t report; // Deadband, interwały i ostatnio opublikowana wartość
+    alert_config_t alert;  // Alarm progowy (domyślnie wyłączony)
 } metric_t;
 
 typedef struct {
-    char sensor_type[50]; // Typ sensora
+    char sensor_type[MQTT_ID_MAX_LEN]; // Typ sensora
     metric_t metrics[MAX_METRICS]; // Metryki sensora
     int metric_count; // Liczba metryk
 } sensor_t;
 
+// Format danych publikowanych przez urządzenie
+typedef enum {
+    PAYLOAD_FORMAT_JSON = 0, // {"temperature": 21.53}
+    PAYLOAD_FORMAT_NUMERIC,  // 21.53 - nazwa metryki wynika z tematu
+    PAYLOAD_FORMAT_CBOR,     // {"temperature": 21.53} w CBOR (RFC 8949)
+    PAYLOAD_FORMAT_CHUNK,    // Paczki próbek (gorilla_chunk.h); pojedyncze próbki jako JSON
+} payload_format_t;
+
 typedef struct {
-    char device_id[50]; // ID urządzenia
+    char device_id[MQTT_ID_MAX_LEN]; // ID urządzenia
     sensor_t sensors[MAX_SENSORS]; // Sensory urządzenia
     int sensor_count; // Liczba sensorów
+    payload_format_t payload_format; // Format publikowanych danych
 } device_t;
 
 typedef struct {
-    char user_id[50]; // ID użytkownika
+    char user_id[MQTT_ID_MAX_LEN]; // ID użytkownika
     device_t devices[MAX_DEVICES]; // Urządzenia użytkownika
     int device_count; // Liczba urządzeń
 } user_t;
@@ -35,6 +84,26 @@ typedef struct {
 extern user_t users[MAX_USERS]; // Lista użytkowników
 extern int user_count; // Liczba użytkowników
 
+// Statystyki asynchronicznej ścieżki publikacji
+typedef struct {
+    uint32_t enqueued;            // Wiadomości przekazane do outboxa
+    uint32_t rejected;            // Odrzucone z powodu zapełnienia outboxa
+    uint32_t failed;              // Błędy esp_mqtt_client_enqueue
+    uint32_t last_latency_us;     // Czas ostatniego enqueue
+    uint32_t max_latency_us;      // Najdłuższy czas enqueue
+    uint64_t total_latency_us;    // Suma czasów enqueue (do średniej)
+    int outbox_bytes;             // Ostatnio odczytany rozmiar outboxa
+    int outbox_peak_bytes;        // Największy zaobserwowany rozmiar outboxa
+    uint32_t reconnects;          // Ponowne połączenia z brokerem
+    uint32_t last_reconnect_ms;   // Od odzyskania sieci do pierwszej publikacji
+    uint32_t max_reconnect_ms;
+    int32_t heap_delta_bytes;     // Wolny heap po ostatnim połączeniu względem pierwszego
+    uint32_t cycles;              // Cykle sensor_data_task z pomiarem lub publikacją próbek
+    uint32_t last_cycle_us;       // Czas pomiarów i publikacji w ostatnim cyklu (z logowaniem)
+    uint32_t max_cycle_us;
+    uint64_t total_cycle_us;
+} mqtt_publish_stats_t;
+
 
 
 
@@ -46,6 +115,8 @@ typedef struct {
 
 extern TaskHandle_t sensor_data_task_handle;
 extern esp_mqtt_client_handle_t client_handle;
+extern bool mqtt_initialized;
+extern bool mqtt_connected;
 extern float min_temperature_threshold;
 extern float max_temperature_threshold;
 extern int min_light_threshold;
@@ -53,10 +124,13 @@ extern int max_light_threshold;
 
 void mqtt_initialize(void);
 void mqtt_stop();
+void mqtt_notify_network_up(void); // Wi-Fi odzyskało adres IP
 void initialize_mqtt_mutex();
 void ble_data_task(void *pvParameters);
 void set_temperature_range(float min_temp, float max_temp);
 void set_light_range(int min_light, int max_light);
+void apply_temperature_range_json(const char *data);
+void apply_light_range_json(const char *data);
 void monitor_conditions_task(void *pvParameters);
 void restart_mqtt_client();
 
@@ -64,8 +138,6 @@ void restart_mqtt_client();
 int add_client(const char *user_id, const char *device_id, const char *topics[], int topic_count);
 void remove_client(const char *user_id, const char *device_id);
 
-void publish_data_for_all_clients();
-
 typedef void (*mqtt_handler_t)(const char *topic, const char *data);
 void generate_mqtt_topic(char *topic, size_t topic_size, const char *user_id, const char *device_id, const char *sensor_type, const char *metric);
 
@@ -73,6 +145,16 @@ void handle_add_user(const char *data);
 void handle_add_device(const char *data) ;
 void handle_add_sensor(const char *data);
 void handle_add_metric(const char *data);
+void handle_report_config(const char *data);
+void handle_alert_config(const char *data);
+
+const char *sample_source_name(sample_source_t source);
+uint32_t get_sampling_interval(sample_source_t source);
+esp_err_t set_sampling_interval(sample_source_t source, uint32_t interval_s);
+esp_err_t apply_sampling_intervals_json(const char *data);
+void save_sampling_intervals_to_nvs();
+void load_sampling_intervals_from_nvs();
+void report_get_totals(uint32_t *published, uint32_t *suppressed);
 
 
 
@@ -82,15 +164,22 @@ int add_sensor(const char *user_id, const char *device_id, const char *sensor_ty
 int add_metric(const char *user_id, const char *device_id, const char *sensor_type, const char *metric);
 
 void safe_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data);
+void safe_publish_qos(esp_mqtt_client_handle_t client, const char *topic, const char *data, int qos);
+void safe_publish_data(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos);
+esp_err_t mqtt_publish_async(const char *topic, const char *data, int len, int qos);
+bool mqtt_publish_backpressure(void);
+void mqtt_get_publish_stats(mqtt_publish_stats_t *stats);
+metric_t *find_metric(const char *user_id, const char *device_id, const char *sensor_type, const char *metric);
+device_t *find_device(const char *user_id, const char *device_id);
+int format_sample(char *buf, size_t len, payload_format_t format, const char *metric, float value, int decimals);
+payload_format_t device_payload_format(const char *user_id, const char *device_id);
+int metric_qos(const char *user_id, const char *device_id, const char *sensor_type, const char *metric);
+bool mqtt_publish_queued_sample(const char *topic, const uint8_t *payload, size_t payload_len, uint32_t timestamp);
 
 void publish_all_metrics(const char *user_id, const char *device_id);
 void subscribe_all_topics(const char *user_id);
 void subscribe_all_users();
 
-void publish_ble_data(const char *user, const char *device);
-void publish_light_sensor_data(const char *user, const char *device);
-void publish_bmp280_data(const char *user, const char *device);
-
 void save_light_range_to_nvs(int min_light, int max_light);
 void save_temperature_range_to_nvs(float min_temp, float max_temp);
 void load_light_range_from_nvs(int *min_light, int *max_light);
@@ -0,0 +1,157 @@
+#include "mqtt_reassembly.h"
+#include <string.h>
+
+enum {
+    SLOT_FREE = 0,
+    SLOT_FILLING,
+    SLOT_COMPLETE
+};
+
+typedef struct {
+    reassembly_message_t message; // Pierwsze pole - release() zamienia wskaźnik z powrotem na slot
+    size_t capacity;
+    size_t received;
+    size_t total;
+    uint32_t started;             // Kolejny numer początku wiadomości (najmniejszy = najstarsza)
+    int msg_id;
+    uint8_t state;
+} slot_t;
+
+// Bufory kolejnych klas jeden za drugim; +1 B na zero kończące w każdym slocie
+static char storage[REASSEMBLY_SMALL_SIZE * REASSEMBLY_SMALL_SLOTS + REASSEMBLY_MEDIUM_SIZE * REASSEMBLY_MEDIUM_SLOTS +
+                    REASSEMBLY_LARGE_SIZE * REASSEMBLY_LARGE_SLOTS + REASSEMBLY_SLOT_COUNT];
+static slot_t slots[REASSEMBLY_SLOT_COUNT]; // Posortowane rosnąco wg pojemności
+static bool initialized = false;
+static uint32_t sequence = 0;
+static reassembly_stats_t stats;
+
+static void init_slots(void) {
+    char *p = storage;
+    for (int i = 0; i < REASSEMBLY_SLOT_COUNT; i++) {
+        size_t capacity = i < REASSEMBLY_SMALL_SLOTS ? REASSEMBLY_SMALL_SIZE
+                        : i < REASSEMBLY_SMALL_SLOTS + REASSEMBLY_MEDIUM_SLOTS ? REASSEMBLY_MEDIUM_SIZE
+                        : REASSEMBLY_LARGE_SIZE;
+        slots[i].message.data = p;
+        slots[i].capacity = capacity;
+        slots[i].state = SLOT_FREE;
+        p += capacity + 1;
+    }
+    initialized = true;
+}
+
+// Najmniejszy wolny bufor mieszczący wiadomość, a gdy brak - najstarsza niedokończona wiadomość
+static slot_t *take_slot(size_t total_len) {
+    slot_t *oldest = NULL;
+    for (int i = 0; i < REASSEMBLY_SLOT_COUNT; i++) {
+        slot_t *slot = &slots[i];
+        if (slot->capacity < total_len) {
+            continue;
+        }
+        if (slot->state == SLOT_FREE) {
+            return slot;
+        }
+        if (slot->state == SLOT_FILLING && (!oldest || (int32_t)(slot->started - oldest->started) < 0)) {
+            oldest = slot;
+        }
+    }
+    if (oldest) {
+        stats.evicted++;
+    }
+    return oldest;
+}
+
+static slot_t *find_filling(int msg_id, size_t offset, size_t total_len) {
+    for (int i = 0; i < REASSEMBLY_SLOT_COUNT; i++) {
+        slot_t *slot = &slots[i];
+        if (slot->state == SLOT_FILLING && slot->msg_id == msg_id && slot->total == total_len && slot->received == offset) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+reassembly_result_t reassembly_feed(int msg_id, const char *topic, size_t topic_len,
+                                    const char *data, size_t data_len, size_t offset, size_t total_len,
+                                    reassembly_message_t **out) {
+    if (!initialized) {
+        init_slots();
+    }
+
+    slot_t *slot;
+    if (offset == 0) {
+        if (total_len > REASSEMBLY_LARGE_SIZE) {
+            stats.too_large++;
+            return REASSEMBLY_DROPPED;
+        }
+        // Początek wiadomości o tym samym msg_id kończy poprzednią (np. QoS 0 ma zawsze msg_id 0)
+        for (int i = 0; i < REASSEMBLY_SLOT_COUNT; i++) {
+            if (slots[i].state == SLOT_FILLING && slots[i].msg_id == msg_id) {
+                slots[i].state = SLOT_FREE;
+                stats.evicted++;
+            }
+        }
+        slot = take_slot(total_len);
+        if (!slot) {
+            stats.no_buffer++;
+            return REASSEMBLY_DROPPED;
+        }
+
+        if (topic_len >= sizeof(slot->message.topic)) {
+            topic_len = sizeof(slot->message.topic) - 1;
+        }
+        memcpy(slot->message.topic, topic, topic_len);
+        slot->message.topic[topic_len] = '\0';
+        slot->msg_id = msg_id;
+        slot->total = total_len;
+        slot->received = 0;
+        slot->started = ++sequence;
+        slot->state = SLOT_FILLING;
+    } else {
+        slot = find_filling(msg_id, offset, total_len);
+        if (!slot) {
+            stats.broken++;
+            return REASSEMBLY_DROPPED;
+        }
+    }
+
+    if (data_len > slot->total - slot->received) {
+        slot->state = SLOT_FREE;
+        stats.broken++;
+        return REASSEMBLY_DROPPED;
+    }
+    if (data_len > 0) {
+        memcpy(slot->message.data + slot->received, data, data_len);
+        slot->received += data_len;
+    }
+    if (slot->received < slot->total) {
+        return REASSEMBLY_PENDING;
+    }
+
+    slot->message.data[slot->total] = '\0';
+    slot->message.len = slot->total;
+    slot->state = SLOT_COMPLETE;
+    stats.completed++;
+    if (offset > 0) {
+        stats.fragmented++;
+    }
+    *out = &slot->message;
+    return REASSEMBLY_COMPLETE;
+}
+
+void reassembly_release(reassembly_message_t *message) {
+    if (message) {
+        ((slot_t *)message)->state = SLOT_FREE;
+    }
+}
+
+void reassembly_reset(void) {
+    for (int i = 0; i < REASSEMBLY_SLOT_COUNT; i++) {
+        if (slots[i].state == SLOT_FILLING) {
+            slots[i].state = SLOT_FREE;
+        }
+    }
+}
+
+void reassembly_get_stats(reassembly_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file mqtt_reassembly.h
+ * Składanie wiadomości MQTT dzielonych przez klienta na fragmenty.
+ *
+ * Wiadomość większa niż bufor odbiorczy klienta przychodzi jako kilka zdarzeń
+ * MQTT_EVENT_DATA (current_data_offset / total_data_len); temat ma tylko pierwsze.
+ * Fragmenty są kopiowane do bufora z puli o stałych klasach rozmiaru (512 B, 1 KB,
+ * 2 KB), dobieranego po total_data_len - bez malloc dla każdej wiadomości.
+ * Największa klasa odpowiada temu, co potrafią odczytać obsługujące funkcje:
+ * json_reader ma JSON_READER_MAX_TOKENS (do 15 pól), a pola trafiają do buforów
+ * po 50 B, więc dłuższej wiadomości i tak nie da się obsłużyć.
+ *
+ * Broker wysyła wiadomości jedna po drugiej, więc niedokończona wiadomość, po której
+ * zaczęła się nowa, nie zostanie już dokończona - jej bufor może zostać odebrany.
+ * Funkcje wywołuje tylko task klienta MQTT (brak blokad).
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef MQTT_REASSEMBLY_H
+#define MQTT_REASSEMBLY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define REASSEMBLY_TOPIC_MAX_LEN 128
+#define REASSEMBLY_SMALL_SIZE 512
+#define REASSEMBLY_SMALL_SLOTS 4
+#define REASSEMBLY_MEDIUM_SIZE 1024
+#define REASSEMBLY_MEDIUM_SLOTS 2
+#define REASSEMBLY_LARGE_SIZE 2048 // Największa przyjmowana wiadomość
+#define REASSEMBLY_LARGE_SLOTS 1
+#define REASSEMBLY_SLOT_COUNT (REASSEMBLY_SMALL_SLOTS + REASSEMBLY_MEDIUM_SLOTS + REASSEMBLY_LARGE_SLOTS)
+
+typedef enum {
+    REASSEMBLY_PENDING = 0, ///< Fragment przyjęty, wiadomość jeszcze niepełna
+    REASSEMBLY_COMPLETE,    ///< Wiadomość kompletna - po obsłużeniu reassembly_release()
+    REASSEMBLY_DROPPED      ///< Fragment odrzucony (za duża wiadomość, brak bufora, luka)
+} reassembly_result_t;
+
+typedef struct {
+    char topic[REASSEMBLY_TOPIC_MAX_LEN]; ///< Temat z pierwszego fragmentu (skrócony, jeśli dłuższy)
+    char *data;                           ///< Dane zakończone zerem
+    size_t len;
+} reassembly_message_t;
+
+typedef struct {
+    uint32_t completed;   ///< Wiadomości złożone w całości
+    uint32_t fragmented;  ///< W tym dzielone na więcej niż jeden fragment
+    uint32_t too_large;   ///< Odrzucone - większe niż największa klasa
+    uint32_t no_buffer;   ///< Odrzucone - wszystkie bufory klasy zajęte
+    uint32_t broken;      ///< Fragmenty bez początku wiadomości lub poza kolejnością
+    uint32_t evicted;     ///< Niedokończone wiadomości, których bufor odebrano
+} reassembly_stats_t;
+
+/**
+ * Przyjmuje fragment wiadomości.
+ * @param topic Temat (tylko w fragmencie z offset == 0, dla pozostałych ignorowany).
+ * @param out Przy REASSEMBLY_COMPLETE - złożona wiadomość.
+ */
+reassembly_result_t reassembly_feed(int msg_id, const char *topic, size_t topic_len,
+                                    const char *data, size_t data_len, size_t offset, size_t total_len,
+                                    reassembly_message_t **out);
+
+/** Zwalnia bufor złożonej wiadomości. */
+void reassembly_release(reassembly_message_t *message);
+
+/** Porzuca wszystkie niedokończone wiadomości (np. po rozłączeniu). */
+void reassembly_reset(void);
+
+void reassembly_get_stats(reassembly_stats_t *stats);
+
+#endif // MQTT_REASSEMBLY_H
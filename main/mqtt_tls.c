@@ -0,0 +1,283 @@
+#include "mqtt_tls.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_tls.h"
+#include "esp_crt_bundle.h"
+#include "latency_trace.h"
+#include "task_table.h"
+
+static const char *TAG = "mqtt_tls";
+
+typedef struct {
+    esp_tls_t *tls;
+} tls_context_t;
+
+typedef struct {
+    bool resumed;       // Oferowano zapamiętaną sesję
+    uint32_t time_ms;
+    uint32_t heap_peak; // Wolny heap przed uzgodnieniem - minimum w jego trakcie (0 - bez pomiaru)
+} handshake_result_t;
+
+// Sesja z ostatniego udanego uzgodnienia; używana tylko z taska klienta MQTT
+// (pomiar ma własną sesję, więc działa równolegle z klientem)
+static esp_tls_client_session_t *saved_session = NULL;
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_tls_stats_t stats;
+// Minimum wolnego heapu jest globalne - w czasie pomiaru równoległe uzgodnienia pomiaru
+// i klienta mieszałyby się, więc zużycie heapu nie jest wtedy mierzone w ogóle
+static volatile bool benchmark_running = false;
+
+// session - zapamiętana sesja (oferowana przy resume, zastępowana najnowszą po udanym uzgodnieniu)
+// measure_heap - pomiar minimum wolnego heapu (tylko bez innych uzgodnień w tle)
+static esp_tls_t *handshake(const char *host, int port, int timeout_ms, bool resume, bool measure_heap,
+                            esp_tls_client_session_t **session, handshake_result_t *result) {
+    esp_tls_cfg_t cfg = {
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .timeout_ms = timeout_ms,
+        .client_session = resume ? *session : NULL,
+    };
+    result->resumed = cfg.client_session != NULL;
+    result->time_ms = 0;
+    result->heap_peak = 0;
+
+    esp_tls_t *tls = esp_tls_init();
+    if (tls == NULL) {
+        return NULL;
+    }
+
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    if (measure_heap) {
+        heap_caps_monitor_local_minimum_free_size_start();
+    }
+    int64_t start = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(host, strlen(host), port, &cfg, tls);
+    result->time_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    if (measure_heap) {
+        size_t min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+        heap_caps_monitor_local_minimum_free_size_stop();
+        result->heap_peak = free_before > min_free ? (uint32_t)(free_before - min_free) : 0;
+    }
+
+    if (ret != 1) {
+        esp_tls_conn_destroy(tls);
+        return NULL;
+    }
+
+    // Bilet od brokera zmienia się przy każdym połączeniu - zapamiętany zostaje najnowszy
+    esp_tls_client_session_t *latest = esp_tls_get_client_session(tls);
+    if (latest != NULL) {
+        if (*session != NULL) {
+            esp_tls_free_client_session(*session);
+        }
+        *session = latest;
+    }
+    return tls;
+}
+
+static void record_handshake(const handshake_result_t *result, bool ok) {
+    taskENTER_CRITICAL(&stats_mux);
+    if (!ok) {
+        stats.failed_handshakes++;
+    } else if (result->resumed) {
+        stats.resumed_handshakes++;
+        stats.last_resumed_ms = result->time_ms;
+        if (result->heap_peak > stats.resumed_heap_peak) {
+            stats.resumed_heap_peak = result->heap_peak;
+        }
+    } else {
+        stats.full_handshakes++;
+        stats.last_full_ms = result->time_ms;
+        if (result->heap_peak > stats.full_heap_peak) {
+            stats.full_heap_peak = result->heap_peak;
+        }
+    }
+    taskEXIT_CRITICAL(&stats_mux);
+}
+
+static int tls_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms) {
+    tls_context_t *ctx = esp_transport_get_context_data(t);
+    handshake_result_t result;
+
+    ctx->tls = handshake(host, port, timeout_ms, true, !benchmark_running, &saved_session, &result);
+    record_handshake(&result, ctx->tls != NULL);
+    if (ctx->tls == NULL) {
+        if (result.resumed) {
+            mqtt_tls_forget_session(); // Następna próba bez sesji, gdyby to ona była przyczyną
+        }
+        ESP_LOGE(TAG, "Uzgodnienie TLS z %s:%d nie powiodło się.", host, port);
+        return -1;
+    }
+    ESP_LOGI(TAG, "Uzgodnienie TLS (%s): %lu ms, heap: %lu B", result.resumed ? "wznowienie" : "pełne",
+             result.time_ms, result.heap_peak);
+    return 0;
+}
+
+// 1 - gotowe, 0 - przekroczony czas, -1 - błąd
+static int tls_poll(tls_context_t *ctx, int timeout_ms, bool write) {
+    int fd;
+    if (ctx->tls == NULL || esp_tls_get_conn_sockfd(ctx->tls, &fd) != ESP_OK) {
+        return -1;
+    }
+    if (!write && esp_tls_get_bytes_avail(ctx->tls) > 0) {
+        return 1; // Odszyfrowane dane czekają już w buforze mbedTLS
+    }
+
+    fd_set ready, errors;
+    FD_ZERO(&ready);
+    FD_ZERO(&errors);
+    FD_SET(fd, &ready);
+    FD_SET(fd, &errors);
+    struct timeval timeout = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    int ret = select(fd + 1, write ? NULL : &ready, write ? &ready : NULL, &errors, timeout_ms < 0 ? NULL : &timeout);
+    if (ret > 0 && FD_ISSET(fd, &errors)) {
+        return -1;
+    }
+    return ret;
+}
+
+static int tls_poll_read(esp_transport_handle_t t, int timeout_ms) {
+    return tls_poll(esp_transport_get_context_data(t), timeout_ms, false);
+}
+
+static int tls_poll_write(esp_transport_handle_t t, int timeout_ms) {
+    return tls_poll(esp_transport_get_context_data(t), timeout_ms, true);
+}
+
+static int tls_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms) {
+    tls_context_t *ctx = esp_transport_get_context_data(t);
+    int poll = tls_poll(ctx, timeout_ms, false);
+    if (poll <= 0) {
+        return poll; // 0 = ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT
+    }
+    int ret = esp_tls_conn_read(ctx->tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret == 0) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    return ret;
+}
+
+static int tls_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms) {
+    tls_context_t *ctx = esp_transport_get_context_data(t);
+    int poll = tls_poll(ctx, timeout_ms, true);
+    if (poll <= 0) {
+        return poll;
+    }
+    int ret = esp_tls_conn_write(ctx->tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret > 0) {
+        latency_trace_send(buffer, ret); // Wysłanie wiadomości z outboxa (etap SEND)
+    }
+    return ret;
+}
+
+static int tls_close(esp_transport_handle_t t) {
+    tls_context_t *ctx = esp_transport_get_context_data(t);
+    if (ctx->tls != NULL) {
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+    }
+    return 0;
+}
+
+static int tls_destroy(esp_transport_handle_t t) {
+    tls_close(t);
+    free(esp_transport_get_context_data(t));
+    return 0;
+}
+
+esp_transport_handle_t mqtt_tls_transport_create(void) {
+    esp_transport_handle_t t = esp_transport_init();
+    if (t == NULL) {
+        return NULL;
+    }
+    tls_context_t *ctx = calloc(1, sizeof(tls_context_t));
+    if (ctx == NULL) {
+        esp_transport_destroy(t);
+        return NULL;
+    }
+    esp_transport_set_context_data(t, ctx);
+    esp_transport_set_func(t, tls_connect, tls_read, tls_write, tls_close, tls_poll_read, tls_poll_write, tls_destroy);
+    esp_transport_set_default_port(t, MQTT_TLS_DEFAULT_PORT);
+    return t;
+}
+
+void mqtt_tls_forget_session(void) {
+    if (saved_session != NULL) {
+        esp_tls_free_client_session(saved_session);
+        saved_session = NULL;
+    }
+}
+
+void mqtt_tls_get_stats(mqtt_tls_stats_t *out) {
+    taskENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_mux);
+}
+
+#if CONFIG_MONITOR_MQTT_TLS_BENCHMARK_ROUNDS > 0
+static struct {
+    char uri[128];
+    int port;
+} benchmark_target;
+
+static void tls_benchmark_task(void *arg) {
+    mqtt_tls_benchmark(benchmark_target.uri, benchmark_target.port, CONFIG_MONITOR_MQTT_TLS_BENCHMARK_ROUNDS);
+    vTaskDelete(NULL);
+}
+#endif
+
+void mqtt_tls_benchmark_start(const char *uri, int port) {
+#if CONFIG_MONITOR_MQTT_TLS_BENCHMARK_ROUNDS > 0
+    strlcpy(benchmark_target.uri, uri, sizeof(benchmark_target.uri));
+    benchmark_target.port = port;
+    task_table_create(TASK_TLS_BENCHMARK, tls_benchmark_task, NULL); // Tylko raz na uruchomienie
+#else
+    (void)uri;
+    (void)port;
+#endif
+}
+
+void mqtt_tls_benchmark(const char *uri, int port, int rounds) {
+    // Host z adresu mqtts://host[:port][/...]
+    char host[128];
+    const char *start = strncmp(uri, MQTT_TLS_SCHEME, strlen(MQTT_TLS_SCHEME)) == 0 ? uri + strlen(MQTT_TLS_SCHEME) : uri;
+    size_t len = strcspn(start, ":/");
+    if (len == 0 || len >= sizeof(host)) {
+        return;
+    }
+    memcpy(host, start, len);
+    host[len] = '\0';
+
+    esp_tls_client_session_t *session = NULL;
+    benchmark_running = true;
+    for (int resume = 0; resume <= 1; resume++) {
+        uint32_t total_ms = 0;
+        int done = 0;
+        for (int i = 0; i < rounds; i++) {
+            handshake_result_t result;
+            esp_tls_t *tls = handshake(host, port, 10000, resume, false, &session, &result);
+            if (tls == NULL) {
+                continue;
+            }
+            esp_tls_conn_destroy(tls);
+            total_ms += result.time_ms;
+            done++;
+        }
+        ESP_LOGI(TAG, "Pomiar TLS %s:%d, %s: %d/%d udanych, średnio %lu ms", host, port,
+                 resume ? "wznowienie" : "pełne", done, rounds, done ? total_ms / done : 0UL);
+    }
+    benchmark_running = false;
+    if (session != NULL) {
+        esp_tls_free_client_session(session);
+    }
+}
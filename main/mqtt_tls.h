@@ -0,0 +1,58 @@
+/**
+ * @file mqtt_tls.h
+ * Transport TLS dla klienta MQTT (mqtts://) z ponownym użyciem sesji.
+ *
+ * Wbudowany transport SSL klienta MQTT przy każdym ponownym połączeniu wykonuje pełne
+ * uzgodnienie TLS (weryfikacja certyfikatu, wymiana kluczy), co na ESP32 trwa ponad
+ * sekundę. Ten transport zapamiętuje sesję z ostatniego połączenia (bilet sesji lub
+ * ID sesji, CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS) i oferuje ją przy kolejnym -
+ * broker może wtedy wznowić sesję bez kryptografii asymetrycznej.
+ *
+ * Certyfikaty CA pochodzą z pakietu w pamięci flash (esp_crt_bundle). Certyfikat
+ * prywatnego brokera dodaje się przez CONFIG_MBEDTLS_CUSTOM_CERTIFICATE_BUNDLE_PATH.
+ */
+#ifndef MQTT_TLS_H
+#define MQTT_TLS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_transport.h"
+
+#define MQTT_TLS_SCHEME "mqtts://"
+#define MQTT_TLS_DEFAULT_PORT 8883
+
+typedef struct {
+    uint32_t full_handshakes;     ///< Uzgodnienia bez oferowanej sesji
+    uint32_t resumed_handshakes;  ///< Uzgodnienia z oferowaną zapamiętaną sesją
+    uint32_t failed_handshakes;
+    uint32_t last_full_ms;
+    uint32_t last_resumed_ms;
+    uint32_t full_heap_peak;      ///< Największe zużycie heapu podczas pełnego uzgodnienia (B), bez uzgodnień w czasie pomiaru
+    uint32_t resumed_heap_peak;   ///< Jak wyżej, dla wznowienia
+} mqtt_tls_stats_t;
+
+/**
+ * Tworzy transport dla esp_mqtt_client_config_t.network.transport.
+ * Transport należy do klienta MQTT i jest niszczony razem z nim.
+ */
+esp_transport_handle_t mqtt_tls_transport_create(void);
+
+/** Porzuca zapamiętaną sesję - następne połączenie wykona pełne uzgodnienie. */
+void mqtt_tls_forget_session(void);
+
+void mqtt_tls_get_stats(mqtt_tls_stats_t *stats);
+
+/**
+ * Pomiar: rounds pełnych uzgodnień, a potem rounds wznowień z brokerem z adresu uri
+ * (mqtts://host[:port]). Średni czas trafia do logu. Zużycie heapu nie jest mierzone -
+ * monitor minimum wolnego heapu jest globalny, a klient MQTT łączy się w tym samym czasie.
+ */
+void mqtt_tls_benchmark(const char *uri, int port, int rounds);
+
+/**
+ * Uruchamia mqtt_tls_benchmark() z CONFIG_MONITOR_MQTT_TLS_BENCHMARK_ROUNDS w osobnym
+ * zadaniu (raz na uruchomienie). Bez pomiaru w menuconfig nic nie robi.
+ */
+void mqtt_tls_benchmark_start(const char *uri, int port);
+
+#endif // MQTT_TLS_H
@@ -0,0 +1,185 @@
+#include "payload_writer.h"
+#include <string.h>
+
+static const uint32_t pow10_table[FIXED_FORMAT_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000 };
+
+// Cyfry liczby od końca bufora; zwraca wskaźnik na pierwszą cyfrę
+static char *format_u64(char *end, uint64_t value) {
+    // Na ESP32 dzielenie 64-bitowe jest programowe - dla mniejszych liczb wystarczy 32-bitowe
+    while (value > UINT32_MAX) {
+        *--end = (char)('0' + value % 10);
+        value /= 10;
+    }
+    uint32_t v = (uint32_t)value;
+    do {
+        *--end = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    return end;
+}
+
+size_t fixed_format(char *buf, size_t cap, float value, int decimals) {
+    if (decimals < 0 || decimals > FIXED_FORMAT_MAX_DECIMALS) {
+        return 0;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = bits >> 31;
+    uint32_t exp = (bits >> 23) & 0xFF;
+    uint64_t mant = bits & 0x7FFFFF;
+    if (exp == 0xFF) {
+        return 0; // inf / nan nie mają reprezentacji w JSON
+    }
+
+    // value = mant * 2^e
+    int e;
+    if (exp == 0) {
+        e = -149;
+    } else {
+        mant |= 0x800000;
+        e = (int)exp - 150;
+    }
+
+    // Wartość przeskalowana o 10^decimals: mant * 10^d ma najwyżej 38 bitów
+    uint64_t scaled = mant * pow10_table[decimals];
+    uint64_t units;
+    if (e >= 0) {
+        if (e >= 64 || scaled > (UINT64_MAX >> e)) {
+            return 0;
+        }
+        units = scaled << e;
+    } else if (-e >= 64) {
+        units = 0; // mniej niż 2^-26 jednostki - zawsze zaokrąglane w dół
+    } else {
+        int shift = -e;
+        units = scaled >> shift;
+        uint64_t rest = scaled & ((1ull << shift) - 1);
+        uint64_t half = 1ull << (shift - 1);
+        if (rest > half || (rest == half && (units & 1))) {
+            units++;
+        }
+    }
+
+    char tmp[FIXED_FORMAT_MAX_LEN];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    uint32_t divisor = pow10_table[decimals];
+    if (decimals > 0) {
+        uint32_t frac = (uint32_t)(units % divisor);
+        for (int i = 0; i < decimals; i++) {
+            *--p = (char)('0' + frac % 10);
+            frac /= 10;
+        }
+        *--p = '.';
+    }
+    p = format_u64(p, units / divisor);
+    if (negative) {
+        *--p = '-';
+    }
+
+    size_t len = (size_t)(end - p);
+    if (len + 1 > cap) {
+        return 0;
+    }
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return len;
+}
+
+void payload_writer_init(payload_writer_t *w, char *buf, size_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->overflow = cap == 0;
+    w->need_comma = false;
+}
+
+size_t payload_writer_finish(payload_writer_t *w) {
+    if (w->overflow) {
+        return 0;
+    }
+    w->buf[w->len] = '\0';
+    return w->len;
+}
+
+// Zawsze zostawia bajt na zero kończące
+static void append(payload_writer_t *w, const char *data, size_t n) {
+    if (w->overflow || w->cap - w->len <= n) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+}
+
+void payload_begin_object(payload_writer_t *w) {
+    append(w, "{", 1);
+    w->need_comma = false;
+}
+
+void payload_end_object(payload_writer_t *w) {
+    append(w, "}", 1);
+    w->need_comma = true;
+}
+
+void payload_begin_array(payload_writer_t *w) {
+    append(w, "[", 1);
+    w->need_comma = false;
+}
+
+void payload_end_array(payload_writer_t *w) {
+    append(w, "]", 1);
+    w->need_comma = true;
+}
+
+void payload_item(payload_writer_t *w) {
+    if (w->need_comma) {
+        append(w, ", ", 2);
+    }
+    w->need_comma = true;
+}
+
+void payload_key(payload_writer_t *w, const char *key) {
+    if (w->need_comma) {
+        append(w, ", ", 2);
+    }
+    append(w, "\"", 1);
+    append(w, key, strlen(key));
+    append(w, "\": ", 3);
+    w->need_comma = true;
+}
+
+void payload_fixed(payload_writer_t *w, float value, int decimals) {
+    char tmp[FIXED_FORMAT_MAX_LEN];
+    size_t n = fixed_format(tmp, sizeof(tmp), value, decimals);
+    if (n == 0) {
+        append(w, "null", 4);
+    } else {
+        append(w, tmp, n);
+    }
+}
+
+void payload_int(payload_writer_t *w, int32_t value) {
+    char tmp[12];
+    char *end = tmp + sizeof(tmp);
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    char *p = format_u64(end, magnitude);
+    if (value < 0) {
+        *--p = '-';
+    }
+    append(w, p, (size_t)(end - p));
+}
+
+void payload_uint(payload_writer_t *w, uint32_t value) {
+    char tmp[12];
+    char *end = tmp + sizeof(tmp);
+    char *p = format_u64(end, value);
+    append(w, p, (size_t)(end - p));
+}
+
+void payload_string(payload_writer_t *w, const char *value) {
+    append(w, "\"", 1);
+    append(w, value, strlen(value));
+    append(w, "\"", 1);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file payload_writer.h
+ * Formatowanie liczb stałoprzecinkowych i składanie danych JSON bez printf.
+ *
+ * fixed_format() daje wynik identyczny jak snprintf("%.*f") dla wartości float
+ * (zaokrąglenie połówek do parzystej, znak także dla "-0.00"), ale liczy wyłącznie
+ * na liczbach całkowitych: wartość float to m * 2^e, więc m * 10^d jest dokładne
+ * w uint64_t, a zaokrąglenie sprowadza się do przesunięcia z resztą.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef PAYLOAD_WRITER_H
+#define PAYLOAD_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define FIXED_FORMAT_MAX_DECIMALS 4
+#define FIXED_FORMAT_MAX_LEN 24 // Znak, 20 cyfr, kropka i zero kończące
+
+/**
+ * Zapisuje wartość z podaną liczbą miejsc po przecinku (zakończoną zerem).
+ * @return Długość tekstu lub 0, gdy wartość nie jest skończona, nie mieści się
+ *         w uint64_t po przeskalowaniu albo bufor jest za mały.
+ */
+size_t fixed_format(char *buf, size_t cap, float value, int decimals);
+
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;  ///< Bufor okazał się za mały
+    bool need_comma;
+} payload_writer_t;
+
+void payload_writer_init(payload_writer_t *w, char *buf, size_t cap);
+
+/**
+ * Kończy tekst zerem.
+ * @return Długość danych lub 0 przy przepełnieniu bufora.
+ */
+size_t payload_writer_finish(payload_writer_t *w);
+
+void payload_begin_object(payload_writer_t *w);
+void payload_end_object(payload_writer_t *w);
+
+void payload_begin_array(payload_writer_t *w);
+void payload_end_array(payload_writer_t *w);
+
+/** Separator przed kolejnym elementem tablicy (przed pierwszym - nic). */
+void payload_item(payload_writer_t *w);
+
+/** Klucz obiektu; kolejne pary są rozdzielane ", ", po kluczu jest ": ". */
+void payload_key(payload_writer_t *w, const char *key);
+
+/** Wartość stałoprzecinkowa; wartości spoza zakresu fixed_format() jako null. */
+void payload_fixed(payload_writer_t *w, float value, int decimals);
+
+void payload_int(payload_writer_t *w, int32_t value);
+/** Tekst w cudzysłowie, bez escapowania (jak payload_key - tylko stałe nazwy). */
+void payload_string(payload_writer_t *w, const char *value);
+void payload_uint(payload_writer_t *w, uint32_t value);
+
+#endif // PAYLOAD_WRITER_H
@@ -0,0 +1,172 @@
+#include "power.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_sleep.h"
+#include "esp_pm.h"
+
+static const char *TAG = "power";
+
+static portMUX_TYPE power_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static struct {
+    const char *name;
+    esp_pm_lock_type_t type;
+    esp_pm_lock_handle_t handle;
+    uint32_t depth;      // Zagnieżdżenie power_lock_acquire()
+    int64_t since_us;    // Początek bieżącego trzymania
+    uint64_t held_us;    // Suma w bieżącym okresie
+} locks[POWER_LOCK_COUNT] = {
+    // Pomiar i publikacja z pełną częstotliwością - krócej trwają, dłużej można spać
+    [POWER_LOCK_SENSORS] = { "sensors", ESP_PM_CPU_FREQ_MAX },
+    [POWER_LOCK_WORK] = { "work_queue", ESP_PM_CPU_FREQ_MAX },
+    // Punkt dostępowy i serwer HTTP muszą odpowiadać od razu
+    [POWER_LOCK_CONFIG] = { "config_mode", ESP_PM_NO_LIGHT_SLEEP },
+};
+
+static int64_t period_start_us = 0;
+static uint64_t asleep_us = 0;
+static uint32_t sleeps = 0;
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+static int64_t sleep_start_us = 0;
+
+// Wywoływane z taska IDLE przy wyłączonych przerwaniach - tylko zapis czasu
+static esp_err_t IRAM_ATTR light_sleep_enter(int64_t sleep_time_us, void *arg) {
+    sleep_start_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+static esp_err_t IRAM_ATTR light_sleep_exit(int64_t sleep_time_us, void *arg) {
+    // esp_timer jest już skorygowany o czas snu
+    int64_t slept = esp_timer_get_time() - sleep_start_us;
+    portENTER_CRITICAL_ISR(&power_mux);
+    asleep_us += slept;
+    sleeps++;
+    portEXIT_CRITICAL_ISR(&power_mux);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t power_init(void) {
+    period_start_us = esp_timer_get_time();
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_MONITOR_PM_MIN_FREQ_MHZ,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE && CONFIG_MONITOR_LIGHT_SLEEP
+        .light_sleep_enable = true,
+#endif
+    };
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Nie udało się skonfigurować zarządzania energią: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        err = esp_pm_lock_create(locks[i].type, 0, locks[i].name, &locks[i].handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Nie udało się utworzyć blokady %s: %s", locks[i].name, esp_err_to_name(err));
+            return err;
+        }
+    }
+
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    esp_pm_sleep_cbs_register_config_t cbs = {
+        .enter_cb = light_sleep_enter,
+        .exit_cb = light_sleep_exit,
+    };
+    esp_pm_light_sleep_register_cbs(&cbs);
+#endif
+    // Przyciski (przerwanie poziomem) budzą układ z light sleep
+    esp_sleep_enable_gpio_wakeup();
+
+    ESP_LOGI(TAG, "Zarządzanie energią: %d-%d MHz, light sleep %s", pm_config.min_freq_mhz,
+             pm_config.max_freq_mhz, pm_config.light_sleep_enable ? "włączony" : "wyłączony");
+#else
+    ESP_LOGI(TAG, "Zarządzanie energią wyłączone (CONFIG_PM_ENABLE).");
+#endif
+    return ESP_OK;
+}
+
+void power_lock_acquire(power_lock_id_t id) {
+    if (id >= POWER_LOCK_COUNT) {
+        return;
+    }
+    bool first;
+    taskENTER_CRITICAL(&power_mux);
+    first = locks[id].depth++ == 0;
+    if (first) {
+        locks[id].since_us = esp_timer_get_time();
+    }
+    taskEXIT_CRITICAL(&power_mux);
+
+    if (first && locks[id].handle != NULL) {
+        esp_pm_lock_acquire(locks[id].handle);
+    }
+}
+
+void power_lock_release(power_lock_id_t id) {
+    if (id >= POWER_LOCK_COUNT) {
+        return;
+    }
+    bool last = false;
+    taskENTER_CRITICAL(&power_mux);
+    if (locks[id].depth > 0) {
+        last = --locks[id].depth == 0;
+        if (last) {
+            locks[id].held_us += esp_timer_get_time() - locks[id].since_us;
+        }
+    }
+    taskEXIT_CRITICAL(&power_mux);
+
+    if (last && locks[id].handle != NULL) {
+        esp_pm_lock_release(locks[id].handle);
+    }
+}
+
+void power_get_stats(power_stats_t *out) {
+    taskENTER_CRITICAL(&power_mux);
+    int64_t now = esp_timer_get_time();
+    out->elapsed_us = now - period_start_us;
+    out->asleep_us = asleep_us;
+    out->sleeps = sleeps;
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        // Trwające trzymanie liczy się do bieżącego okresu
+        if (locks[i].depth > 0) {
+            locks[i].held_us += now - locks[i].since_us;
+            locks[i].since_us = now;
+        }
+        out->held_us[i] = locks[i].held_us;
+        locks[i].held_us = 0;
+    }
+    period_start_us = now;
+    asleep_us = 0;
+    sleeps = 0;
+    taskEXIT_CRITICAL(&power_mux);
+}
+
+void power_log_stats(void) {
+    power_stats_t s;
+    power_get_stats(&s);
+    if (s.elapsed_us == 0) {
+        return;
+    }
+#if CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+    uint32_t asleep_permille = (uint32_t)(s.asleep_us * 1000 / s.elapsed_us);
+    ESP_LOGI(TAG, "Light sleep: %lu.%lu%% czasu (%lu ms, wejść %lu, śr. %lu ms), czuwanie %lu ms",
+             asleep_permille / 10, asleep_permille % 10, (unsigned long)(s.asleep_us / 1000), s.sleeps,
+             s.sleeps ? (unsigned long)(s.asleep_us / s.sleeps / 1000) : 0UL,
+             (unsigned long)((s.elapsed_us - s.asleep_us) / 1000));
+#endif
+    for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+        if (s.held_us[i] > 0) {
+            uint32_t permille = (uint32_t)(s.held_us[i] * 1000 / s.elapsed_us);
+            ESP_LOGI(TAG, "  Blokada %-12s %lu ms (%lu.%lu%%)", locks[i].name,
+                     (unsigned long)(s.held_us[i] / 1000), permille / 10, permille % 10);
+        }
+    }
+}
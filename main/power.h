@@ -0,0 +1,46 @@
+/**
+ * @file power.h
+ * Automatyczny light sleep (esp_pm + tickless idle) i blokady zarządzania energią.
+ *
+ * Układ zasypia, gdy wszystkie zadania czekają, a budzi go najbliższy termin
+ * (harmonogram pomiarów, esp_timer), Wi-Fi w trybie modem sleep albo przycisk.
+ * Zadania trzymają blokadę tylko w czasie pracy: pomiar i kolejkowanie publikacji,
+ * prace z kolejki prac, tryb konfiguracji (AP i serwer HTTP).
+ */
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    POWER_LOCK_SENSORS = 0, ///< sensor_data_task: pomiary i publikacja
+    POWER_LOCK_WORK,        ///< Task roboczy kolejki prac
+    POWER_LOCK_CONFIG,      ///< Tryb konfiguracji - bez light sleep
+    POWER_LOCK_COUNT
+} power_lock_id_t;
+
+typedef struct {
+    uint64_t elapsed_us;  ///< Czas od poprzedniego odczytu
+    uint64_t asleep_us;   ///< W tym czasie w light sleep
+    uint32_t sleeps;      ///< Liczba wejść w light sleep
+    uint64_t held_us[POWER_LOCK_COUNT]; ///< Czas trzymania każdej blokady
+} power_stats_t;
+
+/**
+ * Konfiguruje esp_pm (częstotliwości i light sleep z menuconfig), tworzy blokady
+ * i włącza wybudzanie z GPIO. Bez CONFIG_PM_ENABLE blokady są pustymi operacjami.
+ */
+esp_err_t power_init(void);
+
+/** Blokady można zagnieżdżać - zwolnienie następuje po ostatnim power_lock_release(). */
+void power_lock_acquire(power_lock_id_t id);
+void power_lock_release(power_lock_id_t id);
+
+/** Statystyki od poprzedniego wywołania (zeruje liczniki okresu). */
+void power_get_stats(power_stats_t *out);
+
+/** Loguje podział czasu czuwanie / light sleep i czas trzymania blokad. */
+void power_log_stats(void);
+
+#endif // POWER_H
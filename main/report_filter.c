@@ -0,0 +1,45 @@
+#include "report_filter.h"
+#include <math.h>
+#include <string.h>
+
+void report_filter_init(report_state_t *state, const report_config_t *config) {
+    memset(state, 0, sizeof(*state));
+    state->config = *config;
+}
+
+bool report_filter_should_publish(report_state_t *state, float value, uint32_t now_ms) {
+    bool publish;
+
+    if (!state->has_last || isnan(value) != isnan(state->last_value)) {
+        publish = true;
+    } else {
+        uint32_t elapsed = now_ms - state->last_publish_ms;
+        const report_config_t *cfg = &state->config;
+
+        if (cfg->max_interval_ms && elapsed >= cfg->max_interval_ms) {
+            publish = true; // heartbeat
+        } else if (elapsed < cfg->min_interval_ms) {
+            publish = false;
+        } else {
+            float threshold = cfg->deadband_percent
+                            ? fabsf(state->last_value) * cfg->deadband / 100.0f
+                            : cfg->deadband;
+            publish = fabsf(value - state->last_value) > threshold;
+        }
+    }
+
+    if (publish) {
+        state->last_value = value;
+        state->last_publish_ms = now_ms;
+        state->has_last = true;
+        state->published++;
+    } else {
+        state->suppressed++;
+    }
+    return publish;
+}
+
+float report_filter_suppression_ratio(uint32_t published, uint32_t suppressed) {
+    uint32_t total = published + suppressed;
+    return total ? (float)suppressed / (float)total : 0.0f;
+}
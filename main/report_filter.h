@@ -0,0 +1,48 @@
+/**
+ * @file report_filter.h
+ * Publikacja "report-by-exception": wartość metryki jest wysyłana tylko wtedy,
+ * gdy zmieniła się o więcej niż deadband, z ograniczeniem minimalnego odstępu
+ * między publikacjami i wymuszonym heartbeatem.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef REPORT_FILTER_H
+#define REPORT_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    float deadband;           ///< Próg zmiany (wartość bezwzględna lub procent)
+    bool deadband_percent;    ///< true - deadband w % ostatnio wysłanej wartości
+    uint32_t min_interval_ms; ///< Minimalny odstęp między publikacjami (0 - brak)
+    uint32_t max_interval_ms; ///< Heartbeat: publikacja wymuszona po tym czasie (0 - wyłączony)
+} report_config_t;
+
+typedef struct {
+    report_config_t config;
+    float last_value;         ///< Ostatnio opublikowana wartość
+    uint32_t last_publish_ms; ///< Czas ostatniej publikacji
+    bool has_last;            ///< Czy cokolwiek zostało już opublikowane
+    uint32_t published;       ///< Liczba publikacji
+    uint32_t suppressed;      ///< Liczba pominiętych próbek
+} report_state_t;
+
+/**
+ * Ustawia konfigurację i zeruje stan filtra.
+ */
+void report_filter_init(report_state_t *state, const report_config_t *config);
+
+/**
+ * Decyduje, czy próbkę należy opublikować, i aktualizuje stan oraz liczniki.
+ * @param now_ms Bieżący czas w ms (dopuszczalne przepełnienie licznika).
+ * @return true, jeśli wartość należy wysłać.
+ */
+bool report_filter_should_publish(report_state_t *state, float value, uint32_t now_ms);
+
+/**
+ * Udział pominiętych próbek (0.0 - 1.0).
+ */
+float report_filter_suppression_ratio(uint32_t published, uint32_t suppressed);
+
+#endif // REPORT_FILTER_H
@@ -0,0 +1,84 @@
+#include "sample_bus.h"
+#include <string.h>
+
+void sample_bus_init(sample_bus_t *bus, sample_bus_fn_t lock, sample_bus_fn_t unlock, void *lock_arg) {
+    memset(bus, 0, sizeof(*bus));
+    bus->lock = lock;
+    bus->unlock = unlock;
+    bus->lock_arg = lock_arg;
+}
+
+bool sample_bus_subscribe(sample_bus_t *bus, sample_subscriber_t *sub, sample_t *ring, uint16_t capacity,
+                          uint32_t kinds, sample_bus_fn_t notify, void *notify_arg) {
+    if (capacity == 0) {
+        return false;
+    }
+    memset(sub, 0, sizeof(*sub));
+    sub->ring = ring;
+    sub->capacity = capacity;
+    sub->kinds = kinds;
+    sub->notify = notify;
+    sub->notify_arg = notify_arg;
+
+    bool added = false;
+    bus->lock(bus->lock_arg);
+    if (bus->subscriber_count < SAMPLE_BUS_MAX_SUBSCRIBERS) {
+        bus->subscribers[bus->subscriber_count++] = sub;
+        added = true;
+    }
+    bus->unlock(bus->lock_arg);
+    return added;
+}
+
+uint32_t sample_bus_publish(sample_bus_t *bus, sample_kind_t kind, float value, uint32_t timestamp_ms) {
+    sample_t sample = {
+        .timestamp_ms = timestamp_ms,
+        .value = value,
+        .kind = (uint8_t)kind,
+    };
+    uint32_t notify_mask = 0;
+
+    bus->lock(bus->lock_arg);
+    sample.seq = ++bus->seq;
+    for (int i = 0; i < bus->subscriber_count; i++) {
+        sample_subscriber_t *sub = bus->subscribers[i];
+        if (!(sub->kinds & SAMPLE_KIND_BIT(kind))) {
+            continue;
+        }
+        if (sub->count == sub->capacity) {
+            // Pełna kolejka - miejsce zwalnia najstarsza próbka
+            sub->head = (uint16_t)((sub->head + 1) % sub->capacity);
+            sub->count--;
+            sub->dropped++;
+        }
+        sub->ring[(sub->head + sub->count) % sub->capacity] = sample;
+        sub->count++;
+        sub->delivered++;
+        if (sub->count > sub->max_depth) {
+            sub->max_depth = sub->count;
+        }
+        notify_mask |= 1u << i;
+    }
+    bus->unlock(bus->lock_arg);
+
+    // Powiadomienia poza blokadą - mogą przełączyć kontekst na odbiorcę
+    for (int i = 0; notify_mask; i++, notify_mask >>= 1) {
+        if ((notify_mask & 1) && bus->subscribers[i]->notify) {
+            bus->subscribers[i]->notify(bus->subscribers[i]->notify_arg);
+        }
+    }
+    return sample.seq;
+}
+
+bool sample_bus_pop(sample_bus_t *bus, sample_subscriber_t *sub, sample_t *out) {
+    bool found = false;
+    bus->lock(bus->lock_arg);
+    if (sub->count > 0) {
+        *out = sub->ring[sub->head];
+        sub->head = (uint16_t)((sub->head + 1) % sub->capacity);
+        sub->count--;
+        found = true;
+    }
+    bus->unlock(bus->lock_arg);
+    return found;
+}
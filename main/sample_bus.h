@@ -0,0 +1,87 @@
+/**
+ * @file sample_bus.h
+ * Wewnętrzna szyna próbek publish/subscribe.
+ *
+ * Producent (odczyt czujnika) publikuje każdą próbkę raz; szyna kopiuje ją do
+ * ograniczonych kolejek subskrybentów, którzy zgłosili zainteresowanie danym rodzajem
+ * próbki. Pełna kolejka traci najstarszą próbkę - wolny odbiorca nie blokuje
+ * producenta ani pozostałych odbiorców.
+ *
+ * Blokada (krótka sekcja krytyczna na czas kopiowania) i powiadamianie odbiorcy
+ * są przekazywane jako funkcje, a pamięć kolejek - przez wywołującego.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef SAMPLE_BUS_H
+#define SAMPLE_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SAMPLE_BUS_MAX_SUBSCRIBERS 6
+
+typedef enum {
+    SAMPLE_KIND_TEMPERATURE_BMP280 = 0, ///< °C
+    SAMPLE_KIND_PRESSURE_BMP280,        ///< hPa
+    SAMPLE_KIND_LIGHT,                  ///< lux
+    SAMPLE_KIND_TEMPERATURE_BLE,        ///< °C
+    SAMPLE_KIND_HUMIDITY_BLE,           ///< %
+    SAMPLE_KIND_COUNT
+} sample_kind_t;
+
+#define SAMPLE_KIND_BIT(kind) (1u << (kind))
+#define SAMPLE_KIND_ALL ((1u << SAMPLE_KIND_COUNT) - 1)
+
+typedef struct {
+    uint32_t timestamp_ms; ///< Czas pomiaru (zegar producenta)
+    uint32_t seq;          ///< Numer kolejny na szynie
+    float value;
+    uint8_t kind;          ///< sample_kind_t
+} sample_t;
+
+typedef void (*sample_bus_fn_t)(void *arg);
+
+typedef struct {
+    sample_t *ring;
+    uint16_t capacity;
+    uint16_t head;          ///< Indeks najstarszej próbki
+    uint16_t count;
+    uint16_t max_depth;     ///< Największe zaobserwowane zapełnienie
+    uint32_t kinds;         ///< Maska SAMPLE_KIND_BIT() subskrybowanych rodzajów
+    uint32_t delivered;
+    uint32_t dropped;       ///< Próbki utracone przy pełnej kolejce
+    sample_bus_fn_t notify; ///< Wywoływana (poza blokadą) po dostarczeniu próbki; może być NULL
+    void *notify_arg;
+} sample_subscriber_t;
+
+typedef struct {
+    sample_subscriber_t *subscribers[SAMPLE_BUS_MAX_SUBSCRIBERS];
+    int subscriber_count;
+    uint32_t seq;
+    sample_bus_fn_t lock;
+    sample_bus_fn_t unlock;
+    void *lock_arg;
+} sample_bus_t;
+
+void sample_bus_init(sample_bus_t *bus, sample_bus_fn_t lock, sample_bus_fn_t unlock, void *lock_arg);
+
+/**
+ * Rejestruje odbiorcę z kolejką na capacity próbek.
+ * @return false, gdy osiągnięto SAMPLE_BUS_MAX_SUBSCRIBERS lub capacity == 0.
+ */
+bool sample_bus_subscribe(sample_bus_t *bus, sample_subscriber_t *sub, sample_t *ring, uint16_t capacity,
+                          uint32_t kinds, sample_bus_fn_t notify, void *notify_arg);
+
+/**
+ * Publikuje próbkę do wszystkich zainteresowanych odbiorców.
+ * @return Numer kolejny próbki.
+ */
+uint32_t sample_bus_publish(sample_bus_t *bus, sample_kind_t kind, float value, uint32_t timestamp_ms);
+
+/**
+ * Pobiera najstarszą próbkę z kolejki odbiorcy.
+ * @return false, gdy kolejka jest pusta.
+ */
+bool sample_bus_pop(sample_bus_t *bus, sample_subscriber_t *sub, sample_t *out);
+
+#endif // SAMPLE_BUS_H
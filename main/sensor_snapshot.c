@@ -0,0 +1,77 @@
+#include "sensor_snapshot.h"
+#include <string.h>
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void sensor_snapshot_init(sensor_snapshot_t *snap, sample_bus_fn_t lock, sample_bus_fn_t unlock, void *lock_arg) {
+    atomic_init(&snap->seq, 0);
+    for (int i = 0; i < SAMPLE_KIND_COUNT; i++) {
+        atomic_init(&snap->values[i], 0);
+        atomic_init(&snap->updated_ms[i], 0);
+    }
+    atomic_init(&snap->valid, 0);
+    atomic_init(&snap->timestamp_ms, 0);
+    atomic_init(&snap->read_retries, 0);
+    snap->lock = lock;
+    snap->unlock = unlock;
+    snap->lock_arg = lock_arg;
+}
+
+void sensor_snapshot_begin(sensor_snapshot_t *snap) {
+    snap->lock(snap->lock_arg);
+    unsigned seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_relaxed);
+    // Licznik nieparzysty musi być widoczny przed pierwszym zmienionym polem
+    atomic_thread_fence(memory_order_release);
+}
+
+void sensor_snapshot_set(sensor_snapshot_t *snap, sample_kind_t kind, float value, uint32_t timestamp_ms) {
+    if (kind >= SAMPLE_KIND_COUNT) {
+        return;
+    }
+    atomic_store_explicit(&snap->values[kind], float_bits(value), memory_order_relaxed);
+    atomic_store_explicit(&snap->updated_ms[kind], timestamp_ms, memory_order_relaxed);
+    unsigned valid = atomic_load_explicit(&snap->valid, memory_order_relaxed);
+    atomic_store_explicit(&snap->valid, valid | SAMPLE_KIND_BIT(kind), memory_order_relaxed);
+    atomic_store_explicit(&snap->timestamp_ms, timestamp_ms, memory_order_relaxed);
+}
+
+void sensor_snapshot_end(sensor_snapshot_t *snap) {
+    unsigned seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_release);
+    snap->unlock(snap->lock_arg);
+}
+
+void sensor_snapshot_read(sensor_snapshot_t *snap, sensor_readings_t *out) {
+    for (;;) {
+        unsigned start = atomic_load_explicit(&snap->seq, memory_order_acquire);
+        if (start & 1) {
+            atomic_fetch_add_explicit(&snap->read_retries, 1, memory_order_relaxed);
+            continue; // Zapis w toku
+        }
+        for (int i = 0; i < SAMPLE_KIND_COUNT; i++) {
+            out->values[i] = bits_float(atomic_load_explicit(&snap->values[i], memory_order_relaxed));
+            out->updated_ms[i] = atomic_load_explicit(&snap->updated_ms[i], memory_order_relaxed);
+        }
+        out->valid = atomic_load_explicit(&snap->valid, memory_order_relaxed);
+        out->timestamp_ms = atomic_load_explicit(&snap->timestamp_ms, memory_order_relaxed);
+
+        // Kopia musi być zakończona przed ponownym odczytem licznika
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&snap->seq, memory_order_relaxed) == start) {
+            out->seq = start / 2;
+            return;
+        }
+        atomic_fetch_add_explicit(&snap->read_retries, 1, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,52 @@
+/**
+ * @file sensor_snapshot.h
+ * Spójny zestaw ostatnich odczytów wszystkich czujników (seqlock).
+ *
+ * Zapis zwiększa licznik do wartości nieparzystej, zmienia pola i kończy wartością
+ * parzystą. Odczyt kopiuje pola bez blokady i powtarza kopię, jeśli licznik był
+ * nieparzysty albo zmienił się w trakcie - czytelnik nigdy nie widzi połowy zapisu
+ * (np. temperatury z nowego pomiaru BMP280 i ciśnienia ze starego) i nigdy nie czeka
+ * na mutex. Zapisujący są szeregowani blokadą przekazaną przy inicjalizacji
+ * (na ESP32 sekcja krytyczna, więc zapis nie jest wywłaszczany w połowie).
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef SENSOR_SNAPSHOT_H
+#define SENSOR_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "sample_bus.h"
+
+typedef struct {
+    float values[SAMPLE_KIND_COUNT];       ///< Indeks: sample_kind_t
+    uint32_t updated_ms[SAMPLE_KIND_COUNT]; ///< Czas pomiaru każdej wartości
+    uint32_t valid;                        ///< SAMPLE_KIND_BIT() rodzajów, które mają już wartość
+    uint32_t timestamp_ms;                 ///< Czas ostatniego zapisu
+    uint32_t seq;                          ///< Liczba zakończonych zapisów
+} sensor_readings_t;
+
+typedef struct {
+    atomic_uint seq; ///< Nieparzysty - zapis w toku
+    // Pola jako słowa atomowe (wartości float jako bity) - kopiowanie w trakcie zapisu nie jest wyścigiem
+    atomic_uint values[SAMPLE_KIND_COUNT];
+    atomic_uint updated_ms[SAMPLE_KIND_COUNT];
+    atomic_uint valid;
+    atomic_uint timestamp_ms;
+    atomic_uint read_retries; ///< Powtórzone kopie (odczyt trafił na zapis)
+    sample_bus_fn_t lock;
+    sample_bus_fn_t unlock;
+    void *lock_arg;
+} sensor_snapshot_t;
+
+void sensor_snapshot_init(sensor_snapshot_t *snap, sample_bus_fn_t lock, sample_bus_fn_t unlock, void *lock_arg);
+
+/** Rozpoczyna zapis; wartości zmienione przed sensor_snapshot_end() są widoczne razem. */
+void sensor_snapshot_begin(sensor_snapshot_t *snap);
+void sensor_snapshot_set(sensor_snapshot_t *snap, sample_kind_t kind, float value, uint32_t timestamp_ms);
+void sensor_snapshot_end(sensor_snapshot_t *snap);
+
+/** Kopiuje spójny zestaw odczytów bez blokady. */
+void sensor_snapshot_read(sensor_snapshot_t *snap, sensor_readings_t *out);
+
+#endif // SENSOR_SNAPSHOT_H
@@ -0,0 +1,149 @@
+#include "sensors.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "bmp280.h"
+#include "light_sensor.h"
+#include "ble_sensor.h"
+#include "latency_trace.h"
+#include "binlog.h"
+
+static const char *TAG = "sensors";
+
+// 2x maks. czas pomiaru z noty katalogowej (oversampling x16 temperatury i ciśnienia: ~75 ms)
+#define BMP280_MEASURE_TIMEOUT_MS 150
+#define BMP280_POLL_MS 10
+
+static sample_bus_t bus;
+static portMUX_TYPE bus_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool bus_ready = false;
+static sensor_snapshot_t snapshot;
+static portMUX_TYPE snapshot_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const sample_kind_info_t kind_info[SAMPLE_KIND_COUNT] = {
+    [SAMPLE_KIND_TEMPERATURE_BMP280] = { "bmp280", "temperature", 2 },
+    [SAMPLE_KIND_PRESSURE_BMP280] = { "bmp280", "pressure", 2 },
+    [SAMPLE_KIND_LIGHT] = { "photoresistor", "light", 0 },
+    [SAMPLE_KIND_TEMPERATURE_BLE] = { "ble", "temperature", 2 },
+    [SAMPLE_KIND_HUMIDITY_BLE] = { "ble", "humidity", 2 },
+};
+
+const sample_kind_info_t *sample_kind_info(sample_kind_t kind) {
+    return kind < SAMPLE_KIND_COUNT ? &kind_info[kind] : NULL;
+}
+
+static void bus_lock(void *arg) {
+    taskENTER_CRITICAL((portMUX_TYPE *)arg);
+}
+
+static void bus_unlock(void *arg) {
+    taskEXIT_CRITICAL((portMUX_TYPE *)arg);
+}
+
+void sensors_notify_task(void *arg) {
+    xTaskNotify((TaskHandle_t)arg, SENSORS_NOTIFY_BIT, eSetBits);
+}
+
+void sensors_init_bus(void) {
+    if (!bus_ready) {
+        sample_bus_init(&bus, bus_lock, bus_unlock, &bus_mux);
+        sensor_snapshot_init(&snapshot, bus_lock, bus_unlock, &snapshot_mux);
+        bus_ready = true;
+    }
+}
+
+bool sensors_subscribe(sample_subscriber_t *sub, sample_t *ring, uint16_t capacity, uint32_t kinds,
+                       sample_bus_fn_t notify, void *arg) {
+    sensors_init_bus();
+    if (!sample_bus_subscribe(&bus, sub, ring, capacity, kinds, notify, arg)) {
+        ESP_LOGE(TAG, "Brak miejsca na kolejnego odbiorcę próbek.");
+        return false;
+    }
+    return true;
+}
+
+bool sensors_pop(sample_subscriber_t *sub, sample_t *out) {
+    return sample_bus_pop(&bus, sub, out);
+}
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// Wartości z jednego pomiaru trafiają do migawki razem, a na szynę jako osobne próbki
+static void post_readings(const sample_kind_t *kinds, const float *values, int count) {
+    if (!bus_ready) {
+        return;
+    }
+    uint32_t now = now_ms();
+    uint32_t trace_us = latency_trace_now(); // Przed publikacją - odbiorca może działać na drugim rdzeniu
+    sensor_snapshot_begin(&snapshot);
+    for (int i = 0; i < count; i++) {
+        sensor_snapshot_set(&snapshot, kinds[i], values[i], now);
+    }
+    sensor_snapshot_end(&snapshot);
+    for (int i = 0; i < count; i++) {
+        latency_trace_acquire(sample_bus_publish(&bus, kinds[i], values[i], now), trace_us);
+    }
+}
+
+void sensors_post(sample_kind_t kind, float value) {
+    post_readings(&kind, &value, 1);
+}
+
+void sensors_set_latest(sample_kind_t kind, float value) {
+    if (bus_ready) {
+        sensor_snapshot_begin(&snapshot);
+        sensor_snapshot_set(&snapshot, kind, value, now_ms());
+        sensor_snapshot_end(&snapshot);
+    }
+}
+
+void sensors_get_readings(sensor_readings_t *out) {
+    sensor_snapshot_read(&snapshot, out);
+}
+
+esp_err_t sensors_read_bmp280(bool forced) {
+    if (forced) {
+        bmp280_set_mode(BMP280_FORCED_MODE);
+        int64_t deadline = esp_timer_get_time() + BMP280_MEASURE_TIMEOUT_MS * 1000;
+        while (bmp280_is_measuring()) {
+            if (esp_timer_get_time() > deadline) {
+                ESP_LOGE(TAG, "BMP280 nie zakończył pomiaru w %d ms.", BMP280_MEASURE_TIMEOUT_MS);
+                return ESP_ERR_TIMEOUT;
+            }
+            vTaskDelay(pdMS_TO_TICKS(BMP280_POLL_MS));
+        }
+    }
+    float temperature, pressure;
+    bmp280_read_data(&temperature, &pressure);
+    pressure /= 100.0; // Konwersja ciśnienia na hPa
+    BINLOGI("BMP280", "Temperatura: %.2f °C, Ciśnienie: %.2f hPa", temperature, pressure);
+
+    const sample_kind_t kinds[] = { SAMPLE_KIND_TEMPERATURE_BMP280, SAMPLE_KIND_PRESSURE_BMP280 };
+    const float values[] = { temperature, pressure };
+    post_readings(kinds, values, 2);
+    return ESP_OK;
+}
+
+void sensors_read_light(void) {
+    int light_level = 0;
+    light_sensor_read(&light_level);
+    BINLOGD("LIGHT", "Światło: %d lux", light_level);
+
+    sensors_post(SAMPLE_KIND_LIGHT, light_level);
+}
+
+void sensors_read_ble(void) {
+    if (!ble_connected) {
+        return;
+    }
+    if (read_ble_data() != ESP_OK) {
+        ESP_LOGW("BLE", "Nie udało się odczytać danych BLE.");
+    }
+}
+
+void sensors_read_all(bool forced) {
+    sensors_read_bmp280(forced);
+    sensors_read_light();
+    sensors_read_ble();
+}
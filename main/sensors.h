@@ -0,0 +1,61 @@
+/**
+ * @file sensors.h
+ * Jedyne miejsce odczytu czujników i szyna próbek (sample_bus.h) urządzenia.
+ *
+ * Przycisk, READ_GPIO i harmonogram pomiarów wywołują te same funkcje sensors_read_*():
+ * odczyt sprzętu odbywa się raz, a próbka trafia na szynę do wszystkich odbiorców
+ * (publikacja MQTT, monitor diod). Ostatnie wartości wszystkich czujników są dostępne
+ * jako spójny zestaw przez sensors_get_readings() (sensor_snapshot.h) - zamiast
+ * niesynchronizowanych zmiennych current_*.
+ */
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "sample_bus.h"
+#include "sensor_snapshot.h"
+
+#define SENSORS_NOTIFY_BIT (1u << 31) // Bit powiadomienia taska odbiorcy (eSetBits)
+
+// Opis rodzaju próbki w rejestrze urządzeń (temat /user/device/<sensor_type>/<metric>)
+typedef struct {
+    const char *sensor_type;
+    const char *metric;
+    int decimals;
+} sample_kind_info_t;
+
+const sample_kind_info_t *sample_kind_info(sample_kind_t kind);
+
+void sensors_init_bus(void);
+
+/**
+ * Rejestruje odbiorcę. notify jest wywoływana w kontekście producenta po dostarczeniu
+ * próbki; taski odbiorców używają sensors_notify_task z uchwytem taska jako arg.
+ * Przy notify == NULL odbiorca opróżnia kolejkę sam.
+ */
+bool sensors_subscribe(sample_subscriber_t *sub, sample_t *ring, uint16_t capacity, uint32_t kinds,
+                       sample_bus_fn_t notify, void *arg);
+/** Ustawia SENSORS_NOTIFY_BIT w wartości powiadomienia taska arg (TaskHandle_t). */
+void sensors_notify_task(void *arg);
+bool sensors_pop(sample_subscriber_t *sub, sample_t *out);
+void sensors_post(sample_kind_t kind, float value);
+/** Aktualizuje tylko migawkę, bez próbki na szynie (np. powiadomienia BLE). */
+void sensors_set_latest(sample_kind_t kind, float value);
+/** Ostatnie odczyty wszystkich czujników; bez blokady, może być wywoływana z każdego taska. */
+void sensors_get_readings(sensor_readings_t *out);
+
+/**
+ * Temperatura i ciśnienie; forced - pomiar wymuszony (BMP280 w trybie FORCED/SLEEP).
+ * @return ESP_ERR_TIMEOUT, gdy pomiar wymuszony się nie kończy - próbki nie trafiają na szynę.
+ */
+esp_err_t sensors_read_bmp280(bool forced);
+void sensors_read_light(void);
+/** Zleca odczyt charakterystyk BLE; próbki trafiają na szynę po nadejściu odpowiedzi. */
+void sensors_read_ble(void);
+void sensors_read_all(bool forced);
+
+#endif // SENSORS_H
@@ -0,0 +1,260 @@
+#include "system_stats.h"
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "binlog.h"
+#include "boot.h"
+#include "i2c_driver.h"
+#include "latency_trace.h"
+#include "mqtt_publisher.h"
+#include "payload_writer.h"
+#include "task_table.h"
+#include "telemetry_queue.h"
+#include "wifi_station.h"
+#include "work_queue.h"
+
+static const char *TAG = "system_stats";
+
+// Bufory statyczne - raport zbierany jest zawsze z tego samego taska
+static task_load_window_t window;
+static task_load_t tasks[TASK_LOAD_MAX];
+static char payload[SYSTEM_STATS_PAYLOAD_MAX];
+static char topic[32];
+
+// /system/<mac>/<name> - bufor wspólny dla raportów (wywoływanych z jednego taska)
+static const char *device_topic(const char *name) {
+    uint8_t mac[6] = {0};
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(topic, sizeof(topic), "/system/%02x%02x%02x%02x%02x%02x/%s",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], name);
+    return topic;
+}
+
+static void write_heap(payload_writer_t *w) {
+    payload_key(w, "heap");
+    payload_begin_object(w);
+    payload_key(w, "free");
+    payload_uint(w, esp_get_free_heap_size());
+    payload_key(w, "min_free");
+    payload_uint(w, esp_get_minimum_free_heap_size());
+    payload_key(w, "largest");
+    payload_uint(w, (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    payload_end_object(w);
+}
+
+static void write_mqtt(payload_writer_t *w) {
+    mqtt_publish_stats_t stats;
+    mqtt_get_publish_stats(&stats);
+    payload_key(w, "mqtt");
+    payload_begin_object(w);
+    payload_key(w, "outbox");
+    payload_int(w, esp_mqtt_client_get_outbox_size(client_handle));
+    payload_key(w, "rejected");
+    payload_uint(w, stats.rejected);
+    payload_key(w, "reconnects");
+    payload_uint(w, stats.reconnects);
+    payload_key(w, "cycle_us");
+    payload_uint(w, stats.cycles ? (uint32_t)(stats.total_cycle_us / stats.cycles) : 0);
+    payload_key(w, "cycle_max_us");
+    payload_uint(w, stats.max_cycle_us);
+    payload_end_object(w);
+}
+
+static void write_log(payload_writer_t *w) {
+#if CONFIG_MONITOR_BINLOG
+    uint32_t written, dropped;
+    binlog_get_stats(&written, &dropped);
+    payload_key(w, "log");
+    payload_begin_object(w);
+    payload_key(w, "records");
+    payload_uint(w, written);
+    payload_key(w, "dropped");
+    payload_uint(w, dropped);
+    payload_end_object(w);
+#endif
+}
+
+static void write_queues(payload_writer_t *w, const sample_subscriber_t *samples) {
+    telemetry_queue_stats_t telemetry;
+    telemetry_queue_get_stats(&telemetry);
+    uint32_t work_max = 0, work_dropped = 0;
+    for (int priority = 0; priority < WORK_PRIORITY_COUNT; priority++) {
+        work_queue_stats_t work;
+        work_queue_get_stats(priority, &work);
+        if (work.max_depth > work_max) {
+            work_max = work.max_depth;
+        }
+        work_dropped += work.dropped;
+    }
+
+    payload_key(w, "queues");
+    payload_begin_object(w);
+    payload_key(w, "samples");
+    payload_uint(w, samples->count);
+    payload_key(w, "samples_max");
+    payload_uint(w, samples->max_depth);
+    payload_key(w, "samples_dropped");
+    payload_uint(w, samples->dropped);
+    payload_key(w, "telemetry_segments");
+    payload_uint(w, telemetry.pending_segments);
+    payload_key(w, "work_max");
+    payload_uint(w, work_max);
+    payload_key(w, "work_dropped");
+    payload_uint(w, work_dropped);
+    payload_end_object(w);
+}
+
+static void write_radio_and_bus(payload_writer_t *w) {
+    wifi_ap_record_t ap;
+    payload_key(w, "wifi");
+    payload_begin_object(w);
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+        payload_key(w, "rssi");
+        payload_int(w, ap.rssi);
+    }
+    wifi_reconnect_stats_t wifi;
+    wifi_get_reconnect_stats(&wifi);
+    uint32_t scan_connects = wifi.connects - wifi.directed_connects;
+    payload_key(w, "attempts");
+    payload_uint(w, wifi.attempts);
+    payload_key(w, "directed");
+    payload_uint(w, wifi.directed_attempts);
+    payload_key(w, "fallbacks");
+    payload_uint(w, wifi.fallbacks);
+    payload_key(w, "connects");
+    payload_uint(w, wifi.connects);
+    payload_key(w, "dhcp_ms");
+    payload_uint(w, wifi.last_dhcp_ms);
+    payload_key(w, "dhcp_max_ms");
+    payload_uint(w, wifi.max_dhcp_ms);
+    payload_key(w, "dhcp_avg_ms");
+    payload_uint(w, wifi.connects ? (uint32_t)(wifi.total_dhcp_ms / wifi.connects) : 0);
+    payload_key(w, "directed_avg_ms");
+    payload_uint(w, wifi.directed_connects ? (uint32_t)(wifi.directed_total_ms / wifi.directed_connects) : 0);
+    payload_key(w, "scan_avg_ms");
+    payload_uint(w, scan_connects ? (uint32_t)(wifi.total_scan_ms / scan_connects) : 0);
+    payload_key(w, "reconnects");
+    payload_uint(w, wifi.reconnects);
+    payload_key(w, "backoff_ms");
+    payload_uint(w, wifi.backoff_ms);
+    payload_key(w, "outages");
+    payload_uint(w, wifi.outages);
+    payload_key(w, "outage_ms");
+    payload_uint(w, wifi.outage_ms);
+    payload_key(w, "outage_last_ms");
+    payload_uint(w, wifi.last_outage_ms);
+    payload_key(w, "outage_max_ms");
+    payload_uint(w, wifi.max_outage_ms);
+    payload_end_object(w);
+
+    uint32_t errors, timeouts;
+    i2c_get_error_counts(&errors, &timeouts);
+    payload_key(w, "i2c");
+    payload_begin_object(w);
+    payload_key(w, "errors");
+    payload_uint(w, errors);
+    payload_key(w, "timeouts");
+    payload_uint(w, timeouts);
+    payload_end_object(w);
+}
+
+static void write_tasks(payload_writer_t *w) {
+    uint16_t core_permille[portNUM_PROCESSORS];
+    int count = task_table_get_load(&window, tasks, TASK_LOAD_MAX, core_permille);
+
+    payload_key(w, "cpu");
+    payload_begin_object(w);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        payload_key(w, core == 0 ? "0" : "1");
+        payload_uint(w, core_permille[core]);
+    }
+    payload_end_object(w);
+
+    payload_key(w, "tasks");
+    payload_begin_object(w);
+    for (int i = 0; i < count; i++) {
+        payload_key(w, tasks[i].name);
+        payload_begin_object(w);
+        payload_key(w, "core");
+        payload_int(w, tasks[i].core);
+        payload_key(w, "cpu");
+        payload_uint(w, tasks[i].permille);
+        payload_key(w, "stack");
+        payload_uint(w, tasks[i].stack_free);
+        payload_end_object(w);
+    }
+    payload_end_object(w);
+}
+
+void system_stats_publish(const sample_subscriber_t *samples) {
+    payload_writer_t w;
+    payload_writer_init(&w, payload, sizeof(payload));
+    if (!mqtt_connected) {
+        // Udziały zadań i histogramy w następnym raporcie liczone od teraz
+        uint16_t core_permille[portNUM_PROCESSORS];
+        task_table_get_load(&window, tasks, TASK_LOAD_MAX, core_permille);
+        latency_trace_write_stats(&w);
+        return;
+    }
+
+    payload_begin_object(&w);
+    payload_key(&w, "uptime");
+    payload_uint(&w, (uint32_t)(esp_timer_get_time() / 1000000));
+    write_heap(&w);
+    write_mqtt(&w);
+    write_queues(&w, samples);
+    write_radio_and_bus(&w);
+    write_log(&w);
+    write_tasks(&w);
+    latency_trace_write_stats(&w);
+    payload_end_object(&w);
+
+    size_t len = payload_writer_finish(&w);
+    if (len == 0) {
+        ESP_LOGW(TAG, "Raport nie mieści się w %d B.", SYSTEM_STATS_PAYLOAD_MAX);
+        return;
+    }
+    esp_err_t err = mqtt_publish_async(device_topic("stats"), payload, (int)len, 0);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Nie wysłano raportu: %s", esp_err_to_name(err));
+    }
+}
+
+esp_err_t system_stats_publish_boot(void) {
+    boot_phase_time_t timeline[BOOT_PHASE_COUNT];
+    boot_get_timeline(timeline);
+
+    payload_writer_t w;
+    payload_writer_init(&w, payload, sizeof(payload));
+    payload_begin_object(&w);
+    payload_key(&w, "reset_reason");
+    payload_int(&w, esp_reset_reason());
+    payload_key(&w, "first_publish_ms");
+    payload_uint(&w, timeline[BOOT_PHASE_FIRST_PUBLISH].end_ms);
+    payload_key(&w, "phases");
+    payload_begin_object(&w);
+    for (int phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        if (!timeline[phase].done) {
+            continue; // Faza pominięta albo nieudana (np. brak BLE)
+        }
+        payload_key(&w, boot_phase_name(phase));
+        payload_begin_array(&w);
+        payload_item(&w);
+        payload_uint(&w, timeline[phase].start_ms);
+        payload_item(&w);
+        payload_uint(&w, timeline[phase].end_ms);
+        payload_end_array(&w);
+    }
+    payload_end_object(&w);
+    payload_end_object(&w);
+
+    size_t len = payload_writer_finish(&w);
+    if (len == 0) {
+        return ESP_ERR_NO_MEM;
+    }
+    return mqtt_publish_async(device_topic("boot"), payload, (int)len, 1);
+}
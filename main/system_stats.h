@@ -0,0 +1,52 @@
+/**
+ * @file system_stats.h
+ * Okresowy raport stanu układu na temat /system/<mac>/stats (MAC interfejsu Wi-Fi STA).
+ *
+ * Raport zawiera obciążenie rdzeni i udział każdego zadania (‰ czasu jednego rdzenia
+ * od poprzedniego raportu), zapas stosu zadań, stan heapu, zapełnienie outboxa MQTT
+ * i kolejek, czas cyklu pomiarów i publikacji, RSSI i czasy łączenia z Wi-Fi (wifi_station.h),
+ * liczniki błędów I2C i dziennika binarnego (binlog.h) oraz histogramy opóźnień (latency_trace.h), np.:
+ *
+ *   {"uptime": 3600, "heap": {"free": 81232, "min_free": 60120, "largest": 45056},
+ *    "mqtt": {"outbox": 0, "rejected": 0, "reconnects": 1, "cycle_us": 5400, "cycle_max_us": 21800},
+ *    "queues": {"samples": 0, "samples_max": 3, "samples_dropped": 0, "telemetry_segments": 0,
+ *               "work_max": 1, "work_dropped": 0},
+ *    "wifi": {"rssi": -61, "attempts": 4, "directed": 3, "fallbacks": 0, "connects": 4, "dhcp_ms": 12,
+ *             "dhcp_max_ms": 1840, "dhcp_avg_ms": 470, "directed_avg_ms": 160, "scan_avg_ms": 2300,
+ *             "reconnects": 3, "backoff_ms": 410, "outages": 2, "outage_ms": 0, "outage_last_ms": 1240,
+ *             "outage_max_ms": 9800},
+ *    "i2c": {"errors": 0, "timeouts": 0}, "log": {"records": 812, "dropped": 0},
+ *    "cpu": {"0": 120, "1": 35},
+ *    "tasks": {"sensor_data_task": {"core": 1, "cpu": 31, "stack": 6120}, ...},
+ *    "latency": {"encode": {"n": 42, "p50": 256, "p99": 2048, "hist": [0, 0, 3, 11, 20, 6, 1, 1]}, ...}}
+ *
+ * Zbieranie nie alokuje pamięci i nie formatuje liczb zmiennoprzecinkowych (payload_writer.h).
+ * Odstęp raportów ustawia się w menuconfig (CONFIG_MONITOR_STATS_INTERVAL_S).
+ */
+#ifndef SYSTEM_STATS_H
+#define SYSTEM_STATS_H
+
+#include "esp_err.h"
+#include "sample_bus.h"
+
+#define SYSTEM_STATS_PAYLOAD_MAX 4096 // 40 zadań z najdłuższymi nazwami: ~2,5 KB, histogramy opóźnień: ~0,7 KB
+
+/**
+ * Zbiera statystyki i publikuje raport (QoS 0, tylko przy połączeniu - raporty
+ * nie trafiają do kolejki telemetrii). Wywoływać z jednego taska.
+ * @param samples Kolejka próbek taska publikującego (zapełnienie i utracone próbki).
+ */
+void system_stats_publish(const sample_subscriber_t *samples);
+
+/**
+ * Publikuje oś czasu startu (boot.h) na /system/<mac>/boot z QoS 1, np.:
+ *
+ *   {"reset_reason": 1, "first_publish_ms": 2870,
+ *    "phases": {"base": [310, 402], "wifi_start": [402, 470], "wifi_ip": [470, 2410], "sensors": [471, 530], ...}}
+ *
+ * Czasy w ms od startu aplikacji; fazy niezakończone są pomijane.
+ * Wywoływać z taska wywołującego system_stats_publish() (wspólny bufor).
+ */
+esp_err_t system_stats_publish_boot(void);
+
+#endif // SYSTEM_STATS_H
@@ -0,0 +1,183 @@
+#include "task_table.h"
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+
+static const char *TAG = "task_table";
+
+typedef struct {
+    const char *name;
+    int core;              // -1 - dowolny rdzeń
+    UBaseType_t priority;
+    uint32_t stack_size;   // W bajtach (StackType_t w ESP-IDF to uint8_t)
+    StackType_t *stack;
+} task_config_t;
+
+static StackType_t sensor_data_stack[CONFIG_MONITOR_SENSOR_DATA_STACK];
+static StackType_t work_queue_stack[CONFIG_MONITOR_WORK_QUEUE_STACK];
+static StackType_t monitor_conditions_stack[CONFIG_MONITOR_CONDITIONS_STACK];
+static StackType_t telemetry_drain_stack[CONFIG_MONITOR_TELEMETRY_DRAIN_STACK];
+#if CONFIG_MONITOR_BATCH_LOGGER
+static StackType_t batch_logger_stack[CONFIG_MONITOR_BATCH_LOGGER_STACK];
+#endif
+#if CONFIG_MONITOR_BINLOG
+static StackType_t log_drain_stack[CONFIG_MONITOR_LOG_DRAIN_STACK];
+#endif
+#if CONFIG_MONITOR_MQTT_TLS_BENCHMARK_ROUNDS > 0
+static StackType_t tls_benchmark_stack[CONFIG_MONITOR_TLS_BENCHMARK_STACK];
+#endif
+
+static const task_config_t task_configs[TASK_COUNT] = {
+    [TASK_SENSOR_DATA] = { "sensor_data_task", CONFIG_MONITOR_SENSOR_DATA_CORE, CONFIG_MONITOR_SENSOR_DATA_PRIORITY,
+                           sizeof(sensor_data_stack), sensor_data_stack },
+    [TASK_WORK_QUEUE] = { "work_queue", CONFIG_MONITOR_WORK_QUEUE_CORE, CONFIG_MONITOR_WORK_QUEUE_PRIORITY,
+                          sizeof(work_queue_stack), work_queue_stack },
+    [TASK_MONITOR_CONDITIONS] = { "monitor_cond", CONFIG_MONITOR_CONDITIONS_CORE, CONFIG_MONITOR_CONDITIONS_PRIORITY,
+                                  sizeof(monitor_conditions_stack), monitor_conditions_stack },
+    [TASK_TELEMETRY_DRAIN] = { "telemetry_drain", CONFIG_MONITOR_TELEMETRY_DRAIN_CORE, CONFIG_MONITOR_TELEMETRY_DRAIN_PRIORITY,
+                               sizeof(telemetry_drain_stack), telemetry_drain_stack },
+#if CONFIG_MONITOR_BATCH_LOGGER
+    [TASK_BATCH_LOGGER] = { "batch_logger", CONFIG_MONITOR_BATCH_LOGGER_CORE, CONFIG_MONITOR_BATCH_LOGGER_PRIORITY,
+                            sizeof(batch_logger_stack), batch_logger_stack },
+#endif
+#if CONFIG_MONITOR_BINLOG
+    [TASK_LOG_DRAIN] = { "log_drain", CONFIG_MONITOR_LOG_DRAIN_CORE, CONFIG_MONITOR_LOG_DRAIN_PRIORITY,
+                         sizeof(log_drain_stack), log_drain_stack },
+#endif
+#if CONFIG_MONITOR_MQTT_TLS_BENCHMARK_ROUNDS > 0
+    [TASK_TLS_BENCHMARK] = { "tls_benchmark", CONFIG_MONITOR_TLS_BENCHMARK_CORE, CONFIG_MONITOR_TLS_BENCHMARK_PRIORITY,
+                             sizeof(tls_benchmark_stack), tls_benchmark_stack },
+#endif
+};
+
+static StaticTask_t task_buffers[TASK_COUNT];
+static TaskHandle_t task_handles[TASK_COUNT];
+
+static BaseType_t core_affinity(int core) {
+#if CONFIG_FREERTOS_UNICORE
+    return 0;
+#elif CONFIG_MONITOR_TASK_AFFINITY
+    return core < 0 ? tskNO_AFFINITY : core;
+#else
+    return tskNO_AFFINITY;
+#endif
+}
+
+TaskHandle_t task_table_create(task_id_t id, TaskFunction_t fn, void *arg) {
+    if (id >= TASK_COUNT) {
+        return NULL;
+    }
+    if (task_handles[id] != NULL) {
+        return task_handles[id];
+    }
+    const task_config_t *cfg = &task_configs[id];
+    if (cfg->stack == NULL) {
+        return NULL; // Zadanie wyłączone w menuconfig
+    }
+    task_handles[id] = xTaskCreateStaticPinnedToCore(fn, cfg->name, cfg->stack_size, arg, cfg->priority,
+                                                     cfg->stack, &task_buffers[id], core_affinity(cfg->core));
+    ESP_LOGI(TAG, "%s: rdzeń %d, priorytet %u, stos %lu B", cfg->name, (int)core_affinity(cfg->core),
+             (unsigned)cfg->priority, cfg->stack_size);
+    return task_handles[id];
+}
+
+BaseType_t task_table_httpd_core(void) {
+    return core_affinity(CONFIG_MONITOR_HTTPD_CORE);
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+// Stan zadań z ostatniego odczytu - task_table_get_load() wywoływana tylko z jednego taska
+static TaskStatus_t task_status[TASK_LOAD_MAX];
+
+static configRUN_TIME_COUNTER_TYPE runtime_delta(const task_load_window_t *window, const TaskStatus_t *status) {
+    for (int i = 0; i < window->count; i++) {
+        if (window->handle[i] == status->xHandle) {
+            return status->ulRunTimeCounter - window->runtime[i];
+        }
+    }
+    return status->ulRunTimeCounter; // Zadanie utworzone od poprzedniego odczytu
+}
+#endif
+
+int task_table_get_load(task_load_window_t *window, task_load_t *tasks, int max_tasks,
+                        uint16_t core_permille[portNUM_PROCESSORS]) {
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        core_permille[core] = 0;
+    }
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(task_status, TASK_LOAD_MAX, &total);
+    if (count == 0) {
+        return 0;
+    }
+    // Czas działania każdego rdzenia w tym okresie; obciążenie = czas poza zadaniem IDLE
+    configRUN_TIME_COUNTER_TYPE elapsed = total - window->total;
+
+    int written = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *status = &task_status[i];
+        uint64_t delta = runtime_delta(window, status);
+        uint32_t permille = elapsed ? (uint32_t)(delta * 1000 / elapsed) : 0;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            if (status->xHandle == xTaskGetIdleTaskHandleForCore(core) && elapsed) {
+                core_permille[core] = permille >= 1000 ? 0 : (uint16_t)(1000 - permille);
+            }
+        }
+        if (written < max_tasks) {
+            task_load_t *task = &tasks[written++];
+            strlcpy(task->name, status->pcTaskName, sizeof(task->name));
+            BaseType_t core = xTaskGetCoreID(status->xHandle);
+            task->core = core == tskNO_AFFINITY ? -1 : (int8_t)core;
+            task->permille = permille > UINT16_MAX ? UINT16_MAX : (uint16_t)permille;
+            task->stack_free = status->usStackHighWaterMark; // StackType_t w ESP-IDF to uint8_t - w bajtach
+        }
+    }
+
+    window->count = count;
+    for (UBaseType_t i = 0; i < count; i++) {
+        window->handle[i] = task_status[i].xHandle;
+        window->runtime[i] = task_status[i].ulRunTimeCounter;
+    }
+    window->total = total;
+    return written;
+#else
+    return 0;
+#endif
+}
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static task_load_window_t log_window;
+static task_load_t log_tasks[TASK_LOAD_MAX];
+
+static void log_load(void) {
+    uint16_t core_permille[portNUM_PROCESSORS];
+    int count = task_table_get_load(&log_window, log_tasks, TASK_LOAD_MAX, core_permille);
+    if (count == 0) {
+        ESP_LOGW(TAG, "Więcej niż %d zadań - statystyki pominięte.", TASK_LOAD_MAX);
+        return;
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        ESP_LOGI(TAG, "Rdzeń %d (%s): obciążenie %u%%", core, core == 0 ? "PRO_CPU" : "APP_CPU",
+                 core_permille[core] / 10);
+    }
+    for (int i = 0; i < count; i++) {
+        const task_load_t *task = &log_tasks[i];
+        if (task->permille >= 5) { // Od 0,5% czasu jednego rdzenia
+            ESP_LOGI(TAG, "  %-16s rdzeń %s: %u.%u%%", task->name,
+                     task->core < 0 ? "*" : (task->core == 0 ? "0" : "1"), task->permille / 10, task->permille % 10);
+        }
+    }
+}
+#endif
+
+void task_table_log_stats(void) {
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    log_load();
+#endif
+    for (int id = 0; id < TASK_COUNT; id++) {
+        if (task_handles[id] != NULL) {
+            ESP_LOGI(TAG, "  %-16s zapas stosu: %u/%lu B", task_configs[id].name,
+                     (unsigned)uxTaskGetStackHighWaterMark(task_handles[id]), task_configs[id].stack_size);
+        }
+    }
+}
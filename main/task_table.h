@@ -0,0 +1,69 @@
+/**
+ * @file task_table.h
+ * Wspólna tabela zadań aplikacji: nazwa, rdzeń, priorytet i statyczny stos.
+ *
+ * Stosy są alokowane statycznie (rozmiar znany przy linkowaniu, brak fragmentacji
+ * heapu przez taski), a rdzenie, priorytety i rozmiary stosów ustawia się w
+ * menuconfig ("Monitor środowiska - zadania"). Stosy Wi-Fi, lwIP, Bluedroid i esp_timer
+ * działają na PRO_CPU (0), zadania pomiarów i publikacji - na APP_CPU (1).
+ */
+#ifndef TASK_TABLE_H
+#define TASK_TABLE_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+typedef enum {
+    TASK_SENSOR_DATA = 0,
+    TASK_WORK_QUEUE,
+    TASK_MONITOR_CONDITIONS,
+    TASK_TELEMETRY_DRAIN,
+    TASK_BATCH_LOGGER,      ///< Tylko z CONFIG_MONITOR_BATCH_LOGGER
+    TASK_LOG_DRAIN,         ///< Tylko z CONFIG_MONITOR_BINLOG
+    TASK_TLS_BENCHMARK,     ///< Tylko z CONFIG_MONITOR_MQTT_TLS_BENCHMARK_ROUNDS > 0
+    TASK_COUNT
+} task_id_t;
+
+/**
+ * Tworzy zadanie z tabeli. Każde zadanie może istnieć tylko raz (stos statyczny) -
+ * ponowne wywołanie zwraca istniejący uchwyt.
+ */
+TaskHandle_t task_table_create(task_id_t id, TaskFunction_t fn, void *arg);
+
+/** Rdzeń dla esp_http_server (httpd_config_t.core_id). */
+BaseType_t task_table_httpd_core(void);
+
+#define TASK_LOAD_MAX 40 // Wszystkie zadania systemu (Wi-Fi, lwIP, BT, esp_timer, aplikacja)
+
+/** Okno pomiaru obciążenia: liczniki czasu działania z poprzedniego odczytu. */
+typedef struct {
+    TaskHandle_t handle[TASK_LOAD_MAX];
+    configRUN_TIME_COUNTER_TYPE runtime[TASK_LOAD_MAX];
+    int count;
+    configRUN_TIME_COUNTER_TYPE total;
+} task_load_window_t;
+
+typedef struct {
+    char name[configMAX_TASK_NAME_LEN];
+    int8_t core;            ///< -1 - dowolny rdzeń
+    uint16_t permille;      ///< Udział w czasie jednego rdzenia od poprzedniego odczytu (‰)
+    uint32_t stack_free;    ///< Najmniejszy zapas stosu od startu zadania (B)
+} task_load_t;
+
+/**
+ * Obciążenie rdzeni i wszystkich zadań systemu od poprzedniego odczytu z tym samym
+ * oknem (pierwszy odczyt - od startu). Bez alokacji; wywoływać z jednego taska.
+ * Bez CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS udziały są zerowe.
+ * @param core_permille Obciążenie rdzeni (‰ czasu poza zadaniem IDLE).
+ * @return Liczba zadań w tasks (0, gdy zadań jest więcej niż TASK_LOAD_MAX).
+ */
+int task_table_get_load(task_load_window_t *window, task_load_t *tasks, int max_tasks,
+                        uint16_t core_permille[portNUM_PROCESSORS]);
+
+/**
+ * Loguje obciążenie każdego rdzenia i udział zadań od poprzedniego wywołania
+ * (wymaga CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS) oraz zapas stosu zadań z tabeli.
+ */
+void task_table_log_stats(void);
+
+#endif // TASK_TABLE_H
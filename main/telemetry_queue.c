@@ -0,0 +1,365 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <dirent.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "nvs.h"
+#include "telemetry_segment.h"
+#include "telemetry_queue.h"
+#include "task_table.h"
+
+static const char *TAG = "telemetry_queue";
+
+/*
+- Segmenty to osobne pliki tq_<sekwencja>.bin, zapisywane wyłącznie przez dopisywanie.
+- Numery sekwencyjne tylko rosną, więc nazwy plików się nie powtarzają, a zwolnione
+  strony SPIFFS są rozkładane po całej partycji (brak nadpisywania w miejscu).
+- Segment jest usuwany w całości dopiero po wysłaniu wszystkich rekordów.
+- Gdy brakuje miejsca, usuwany jest najstarszy segment.
+- Pozycja opróżniania (sekwencja i przesunięcie w najstarszym segmencie) jest zapisywana
+  w NVS po każdej partii, więc po restarcie wysyłanie rusza od pierwszego niewysłanego
+  rekordu. Restart między publikacją a zapisem powtarza co najwyżej jedną partię.
+*/
+
+#define TQ_NVS_NAMESPACE "telemetry"
+#define TQ_NVS_KEY_SEQ "tail_seq"
+#define TQ_NVS_KEY_OFFSET "tail_off"
+
+static struct {
+    bool mounted;
+    SemaphoreHandle_t lock;
+    telemetry_publish_cb_t publish_cb;
+    TaskHandle_t drain_task;
+
+    FILE *head_file;        // Segment, do którego dopisywane są próbki
+    uint32_t head_seq;      // Sekwencja segmentu head (zamknięte segmenty: [tail_seq, head_seq))
+    size_t head_size;
+
+    FILE *tail_file;        // Najstarszy segment, z którego wysyłane są próbki
+    uint32_t tail_seq;
+    long tail_offset;
+    long resume_offset;     // Pozycja z NVS dla segmentu tail_seq (0 - od początku)
+
+    telemetry_queue_stats_t stats;
+} tq;
+
+static uint8_t append_buf[TELEMETRY_RECORD_MAX_SIZE]; // chroniony przez tq.lock
+static uint8_t drain_buf[TELEMETRY_RECORD_MAX_SIZE];  // używany tylko przez task opróżniający
+
+
+static void segment_path(char *path, size_t len, uint32_t seq) {
+    snprintf(path, len, TELEMETRY_QUEUE_BASE_PATH "/tq_%08" PRIx32 ".bin", seq);
+}
+
+static uint32_t telemetry_timestamp(void) {
+    return (uint32_t)time(NULL);
+}
+
+static void save_drain_position(uint32_t seq, long offset) {
+    nvs_handle_t nvs;
+    if (nvs_open(TQ_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    nvs_set_u32(nvs, TQ_NVS_KEY_SEQ, seq);
+    nvs_set_u32(nvs, TQ_NVS_KEY_OFFSET, (uint32_t)offset);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+// Pozycja zapisana przed restartem; pomijana, gdy jej segment został już usunięty
+static void load_drain_position(bool segments_found) {
+    nvs_handle_t nvs;
+    if (nvs_open(TQ_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    uint32_t seq, offset;
+    if (!segments_found) {
+        // Sekwencje zaczną się od nowa - stara pozycja wskazywałaby nowy segment
+        nvs_erase_all(nvs);
+        nvs_commit(nvs);
+    } else if (nvs_get_u32(nvs, TQ_NVS_KEY_SEQ, &seq) == ESP_OK &&
+               nvs_get_u32(nvs, TQ_NVS_KEY_OFFSET, &offset) == ESP_OK &&
+               seq == tq.tail_seq && offset > TELEMETRY_SEGMENT_HEADER_SIZE) {
+        tq.resume_offset = (long)offset;
+        ESP_LOGI(TAG, "Wznowienie opróżniania segmentu %" PRIu32 " od bajtu %" PRIu32, seq, offset);
+    }
+    nvs_close(nvs);
+}
+
+// Usuwa najstarszy segment (wymaga tq.lock)
+static void drop_tail_locked(void) {
+    char path[48];
+    if (tq.tail_file) {
+        fclose(tq.tail_file);
+        tq.tail_file = NULL;
+    }
+    segment_path(path, sizeof(path), tq.tail_seq);
+    remove(path);
+    tq.tail_seq++;
+    tq.tail_offset = 0;
+    tq.resume_offset = 0;
+}
+
+// Zamyka segment head - od tej chwili może być opróżniany (wymaga tq.lock)
+static void seal_head_locked(void) {
+    if (tq.head_file) {
+        fclose(tq.head_file);
+        tq.head_file = NULL;
+        tq.head_seq++;
+        tq.head_size = 0;
+    }
+}
+
+// Otwiera nowy segment head, w razie potrzeby usuwając najstarszy (wymaga tq.lock)
+static esp_err_t open_head_locked(void) {
+    while (tq.head_seq - tq.tail_seq >= TELEMETRY_QUEUE_MAX_SEGMENTS - 1) {
+        ESP_LOGW(TAG, "Kolejka pełna, usuwanie segmentu %" PRIu32, tq.tail_seq);
+        drop_tail_locked();
+        tq.stats.dropped_segments++;
+    }
+
+    char path[48];
+    segment_path(path, sizeof(path), tq.head_seq);
+    tq.head_file = fopen(path, "wb");
+    if (!tq.head_file) {
+        ESP_LOGE(TAG, "Nie udało się utworzyć segmentu %s", path);
+        return ESP_FAIL;
+    }
+
+    uint8_t header[TELEMETRY_SEGMENT_HEADER_SIZE];
+    size_t len = telemetry_segment_header_encode(header, tq.head_seq);
+    if (fwrite(header, 1, len, tq.head_file) != len) {
+        fclose(tq.head_file);
+        tq.head_file = NULL;
+        remove(path);
+        return ESP_FAIL;
+    }
+    tq.head_size = len;
+    tq.stats.bytes_written += len;
+    return ESP_OK;
+}
+
+esp_err_t telemetry_queue_append(const char *topic, const uint8_t *payload, size_t payload_len) {
+    if (!tq.mounted || !topic || !payload) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(tq.lock, portMAX_DELAY);
+
+    size_t len = telemetry_record_encode(append_buf, sizeof(append_buf), telemetry_timestamp(),
+                                         topic, strlen(topic), payload, payload_len);
+    if (len == 0) {
+        xSemaphoreGive(tq.lock);
+        ESP_LOGE(TAG, "Próbka za duża dla kolejki: %s", topic);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (tq.head_file && tq.head_size + len > TELEMETRY_QUEUE_SEGMENT_SIZE) {
+        seal_head_locked();
+    }
+    if (!tq.head_file && open_head_locked() != ESP_OK) {
+        xSemaphoreGive(tq.lock);
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = ESP_OK;
+    if (fwrite(append_buf, 1, len, tq.head_file) != len || fflush(tq.head_file) != 0) {
+        ESP_LOGE(TAG, "Błąd zapisu do segmentu %" PRIu32, tq.head_seq);
+        seal_head_locked(); // niepełny rekord zostanie odrzucony przez CRC
+        err = ESP_FAIL;
+    } else {
+        tq.head_size += len;
+        tq.stats.appended++;
+        tq.stats.bytes_written += len;
+    }
+
+    xSemaphoreGive(tq.lock);
+    return err;
+}
+
+// Czyta kolejny rekord z najstarszego segmentu (wymaga tq.lock)
+static bool read_next_locked(telemetry_record_t *rec, size_t *size) {
+    if (tq.tail_seq == tq.head_seq) {
+        // Nie ma zamkniętych segmentów - zamknij bieżący, żeby móc go wysłać
+        seal_head_locked();
+    }
+
+    while (tq.tail_seq != tq.head_seq) {
+        if (!tq.tail_file) {
+            char path[48];
+            segment_path(path, sizeof(path), tq.tail_seq);
+            tq.tail_file = fopen(path, "rb");
+            uint8_t header[TELEMETRY_SEGMENT_HEADER_SIZE];
+            if (!tq.tail_file ||
+                fread(header, 1, sizeof(header), tq.tail_file) != sizeof(header) ||
+                telemetry_segment_header_decode(header, sizeof(header), NULL) != 0) {
+                ESP_LOGW(TAG, "Pominięto uszkodzony segment %s", path);
+                drop_tail_locked();
+                continue;
+            }
+            tq.tail_offset = TELEMETRY_SEGMENT_HEADER_SIZE;
+            if (tq.resume_offset > 0) {
+                tq.tail_offset = tq.resume_offset;
+                tq.resume_offset = 0;
+            }
+        }
+
+        fseek(tq.tail_file, tq.tail_offset, SEEK_SET);
+        size_t len = fread(drain_buf, 1, TELEMETRY_RECORD_HEADER_SIZE, tq.tail_file);
+        size_t total = len == TELEMETRY_RECORD_HEADER_SIZE ? telemetry_record_size(drain_buf) : 0;
+        if (total > 0) {
+            len += fread(drain_buf + len, 1, total - len, tq.tail_file);
+            if (telemetry_record_decode(drain_buf, len, rec, size) == TELEMETRY_RECORD_OK) {
+                return true;
+            }
+        }
+
+        // Koniec segmentu (lub urwany rekord) - segment jest w całości wysłany
+        drop_tail_locked();
+    }
+    return false;
+}
+
+static int drain_batch(int max_records) {
+    int sent = 0;
+    uint32_t sent_seq = 0;
+    long sent_offset = 0;
+    char topic[TELEMETRY_MAX_TOPIC_LEN + 1];
+
+    while (sent < max_records) {
+        telemetry_record_t rec;
+        size_t size = 0;
+
+        xSemaphoreTake(tq.lock, portMAX_DELAY);
+        bool found = read_next_locked(&rec, &size);
+        uint32_t seq = tq.tail_seq;
+        long offset = tq.tail_offset;
+        xSemaphoreGive(tq.lock);
+
+        if (!found) {
+            break;
+        }
+
+        memcpy(topic, rec.topic, rec.topic_len);
+        topic[rec.topic_len] = '\0';
+        if (!tq.publish_cb(topic, rec.payload, rec.payload_len, rec.timestamp)) {
+            break; // rekord zostaje w kolejce
+        }
+
+        xSemaphoreTake(tq.lock, portMAX_DELAY);
+        if (tq.tail_seq == seq && tq.tail_offset == offset) {
+            tq.tail_offset += size;
+        }
+        sent_seq = tq.tail_seq;
+        sent_offset = tq.tail_offset;
+        tq.stats.drained++;
+        xSemaphoreGive(tq.lock);
+        sent++;
+    }
+
+    if (sent > 0) {
+        save_drain_position(sent_seq, sent_offset);
+    }
+    return sent;
+}
+
+static void telemetry_drain_task(void *pvParameters) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        int total = 0, sent;
+        do {
+            sent = drain_batch(TELEMETRY_QUEUE_DRAIN_BATCH);
+            total += sent;
+            if (sent == TELEMETRY_QUEUE_DRAIN_BATCH) {
+                vTaskDelay(pdMS_TO_TICKS(TELEMETRY_QUEUE_DRAIN_PAUSE_MS));
+            }
+        } while (sent == TELEMETRY_QUEUE_DRAIN_BATCH);
+
+        if (total > 0) {
+            ESP_LOGI(TAG, "Wysłano %d próbek z kolejki.", total);
+        }
+    }
+}
+
+void telemetry_queue_notify_online(void) {
+    if (tq.drain_task) {
+        xTaskNotifyGive(tq.drain_task);
+    }
+}
+
+void telemetry_queue_get_stats(telemetry_queue_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    if (!tq.mounted) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    xSemaphoreTake(tq.lock, portMAX_DELAY);
+    *stats = tq.stats;
+    stats->pending_segments = tq.head_seq - tq.tail_seq + (tq.head_file ? 1 : 0);
+    xSemaphoreGive(tq.lock);
+}
+
+esp_err_t telemetry_queue_init(telemetry_publish_cb_t publish_cb) {
+    if (tq.mounted) {
+        return ESP_OK;
+    }
+
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = TELEMETRY_QUEUE_BASE_PATH,
+        .partition_label = NULL,
+        .max_files = 4,
+        .format_if_mount_failed = true
+    };
+    esp_err_t err = esp_vfs_spiffs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Nie udało się zamontować spiffs: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    tq.lock = xSemaphoreCreateMutex();
+    if (tq.lock == NULL) {
+        ESP_LOGE(TAG, "Nie udało się utworzyć mutexa kolejki.");
+        return ESP_ERR_NO_MEM;
+    }
+    tq.publish_cb = publish_cb;
+
+    // Odtworzenie stanu z segmentów pozostałych po poprzednim uruchomieniu
+    bool found = false;
+    uint32_t min_seq = 0, max_seq = 0;
+    DIR *dir = opendir(TELEMETRY_QUEUE_BASE_PATH);
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            uint32_t seq;
+            if (sscanf(entry->d_name, "tq_%08" SCNx32 ".bin", &seq) != 1) {
+                continue;
+            }
+            if (!found || seq < min_seq) min_seq = seq;
+            if (!found || seq > max_seq) max_seq = seq;
+            found = true;
+        }
+        closedir(dir);
+    }
+    if (found) {
+        tq.tail_seq = min_seq;
+        tq.head_seq = max_seq + 1; // nowe próbki zawsze w nowym segmencie
+    }
+    load_drain_position(found);
+
+    size_t total = 0, used = 0;
+    esp_spiffs_info(NULL, &total, &used);
+    ESP_LOGI(TAG, "Kolejka telemetrii gotowa: %" PRIu32 " segmentów oczekuje, spiffs %u/%u B.",
+             tq.head_seq - tq.tail_seq, (unsigned)used, (unsigned)total);
+
+    tq.mounted = true;
+    tq.drain_task = task_table_create(TASK_TELEMETRY_DRAIN, telemetry_drain_task, NULL);
+    return ESP_OK;
+}
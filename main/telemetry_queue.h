@@ -0,0 +1,60 @@
+/**
+ * @file telemetry_queue.h
+ * Kolejka telemetrii typu store-and-forward w partycji spiffs.
+ *
+ * Gdy klient MQTT nie jest połączony, próbki są dopisywane do segmentów w pamięci flash
+ * (format opisany w telemetry_segment.h). Po ponownym połączeniu z brokerem task
+ * opróżniający wysyła je partiami, od najstarszych.
+ *
+ * Dostarczanie "co najmniej raz": pozycja opróżniania jest zapisywana w NVS po każdej
+ * partii, więc restart w trakcie partii wysyła ponownie najwyżej TELEMETRY_QUEUE_DRAIN_BATCH
+ * próbek. Powtórzone próbki mają ten sam znacznik "ts" co oryginał.
+ */
+#ifndef TELEMETRY_QUEUE_H
+#define TELEMETRY_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define TELEMETRY_QUEUE_BASE_PATH "/spiffs"
+#define TELEMETRY_QUEUE_SEGMENT_SIZE (24 * 1024) // Maksymalny rozmiar segmentu (B)
+#define TELEMETRY_QUEUE_MAX_SEGMENTS 8           // 192 KB z 256 KB - reszta dla GC SPIFFS
+#define TELEMETRY_QUEUE_DRAIN_BATCH 20           // Liczba próbek wysyłanych w jednej partii
+#define TELEMETRY_QUEUE_DRAIN_PAUSE_MS 200       // Przerwa między partiami
+
+/**
+ * Funkcja wysyłająca zapisaną próbkę. Temat jest zakończony zerem.
+ * @return true, jeśli próbka została przekazana do klienta MQTT; false przerywa opróżnianie.
+ */
+typedef bool (*telemetry_publish_cb_t)(const char *topic, const uint8_t *payload, size_t payload_len, uint32_t timestamp);
+
+typedef struct {
+    uint32_t appended;          ///< Próbki zapisane do kolejki
+    uint32_t drained;           ///< Próbki wysłane z kolejki
+    uint32_t dropped_segments;  ///< Najstarsze segmenty usunięte z braku miejsca
+    uint32_t pending_segments;  ///< Segmenty oczekujące na wysłanie
+    uint32_t bytes_written;     ///< Bajty zapisane do flash
+} telemetry_queue_stats_t;
+
+/**
+ * Montuje partycję spiffs, odtwarza stan kolejki z istniejących segmentów
+ * i uruchamia task opróżniający.
+ * @param publish_cb Funkcja wysyłająca próbki po odzyskaniu połączenia.
+ */
+esp_err_t telemetry_queue_init(telemetry_publish_cb_t publish_cb);
+
+/**
+ * Dopisuje próbkę do kolejki (ze znacznikiem czasu pobranym w chwili zapisu).
+ */
+esp_err_t telemetry_queue_append(const char *topic, const uint8_t *payload, size_t payload_len);
+
+/**
+ * Informuje kolejkę, że połączenie z brokerem zostało nawiązane - budzi task opróżniający.
+ */
+void telemetry_queue_notify_online(void);
+
+void telemetry_queue_get_stats(telemetry_queue_stats_t *stats);
+
+#endif // TELEMETRY_QUEUE_H
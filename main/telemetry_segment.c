@@ -0,0 +1,115 @@
+#include "telemetry_segment.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Wersja bitowa bez tablicy - rekordy są krótkie, a tablica zajęłaby 1 KB flash
+uint32_t telemetry_crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+size_t telemetry_segment_header_encode(uint8_t *buf, uint32_t sequence) {
+    put_u32(buf, TELEMETRY_SEGMENT_MAGIC);
+    put_u16(buf + 4, TELEMETRY_SEGMENT_VERSION);
+    put_u16(buf + 6, 0);
+    put_u32(buf + 8, sequence);
+    return TELEMETRY_SEGMENT_HEADER_SIZE;
+}
+
+int telemetry_segment_header_decode(const uint8_t *buf, size_t len, uint32_t *sequence) {
+    if (len < TELEMETRY_SEGMENT_HEADER_SIZE) {
+        return -1;
+    }
+    if (get_u32(buf) != TELEMETRY_SEGMENT_MAGIC || get_u16(buf + 4) != TELEMETRY_SEGMENT_VERSION) {
+        return -1;
+    }
+    if (sequence) {
+        *sequence = get_u32(buf + 8);
+    }
+    return 0;
+}
+
+size_t telemetry_record_size(const uint8_t *header) {
+    uint16_t topic_len = get_u16(header);
+    uint16_t payload_len = get_u16(header + 2);
+    if (topic_len == 0 || topic_len > TELEMETRY_MAX_TOPIC_LEN || payload_len > TELEMETRY_MAX_PAYLOAD_LEN) {
+        return 0;
+    }
+    return TELEMETRY_RECORD_HEADER_SIZE + topic_len + payload_len + TELEMETRY_RECORD_CRC_SIZE;
+}
+
+size_t telemetry_record_encode(uint8_t *buf, size_t cap, uint32_t timestamp,
+                               const char *topic, size_t topic_len,
+                               const uint8_t *payload, size_t payload_len) {
+    if (topic_len == 0 || topic_len > TELEMETRY_MAX_TOPIC_LEN || payload_len > TELEMETRY_MAX_PAYLOAD_LEN) {
+        return 0;
+    }
+    size_t total = TELEMETRY_RECORD_HEADER_SIZE + topic_len + payload_len + TELEMETRY_RECORD_CRC_SIZE;
+    if (total > cap) {
+        return 0;
+    }
+
+    put_u16(buf, (uint16_t)topic_len);
+    put_u16(buf + 2, (uint16_t)payload_len);
+    put_u32(buf + 4, timestamp);
+    memcpy(buf + TELEMETRY_RECORD_HEADER_SIZE, topic, topic_len);
+    memcpy(buf + TELEMETRY_RECORD_HEADER_SIZE + topic_len, payload, payload_len);
+
+    size_t body = total - TELEMETRY_RECORD_CRC_SIZE;
+    put_u32(buf + body, telemetry_crc32(0, buf, body));
+    return total;
+}
+
+telemetry_record_status_t telemetry_record_decode(const uint8_t *buf, size_t len,
+                                                  telemetry_record_t *out, size_t *consumed) {
+    if (len < TELEMETRY_RECORD_HEADER_SIZE) {
+        return TELEMETRY_RECORD_INCOMPLETE;
+    }
+    size_t total = telemetry_record_size(buf);
+    if (total == 0) {
+        return TELEMETRY_RECORD_CORRUPT;
+    }
+    if (len < total) {
+        return TELEMETRY_RECORD_INCOMPLETE;
+    }
+
+    size_t body = total - TELEMETRY_RECORD_CRC_SIZE;
+    if (telemetry_crc32(0, buf, body) != get_u32(buf + body)) {
+        return TELEMETRY_RECORD_CORRUPT;
+    }
+
+    out->topic_len = get_u16(buf);
+    out->payload_len = get_u16(buf + 2);
+    out->timestamp = get_u32(buf + 4);
+    out->topic = (const char *)(buf + TELEMETRY_RECORD_HEADER_SIZE);
+    out->payload = buf + TELEMETRY_RECORD_HEADER_SIZE + out->topic_len;
+    if (consumed) {
+        *consumed = total;
+    }
+    return TELEMETRY_RECORD_OK;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file telemetry_segment.h
+ * Format segmentu kolejki telemetrii (store-and-forward).
+ *
+ * Segment to plik tylko do dopisywania: nagłówek segmentu, a po nim rekordy
+ * z próbkami. Każdy rekord ma własne CRC32, więc urwany zapis (np. zanik zasilania)
+ * kończy odczyt segmentu na ostatnim poprawnym rekordzie.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ *
+ * Układ (little-endian):
+ *   nagłówek: magic (4 B) | wersja (2 B) | zarezerwowane (2 B) | sekwencja (4 B)
+ *   rekord:   długość tematu (2 B) | długość danych (2 B) | znacznik czasu (4 B)
+ *             | temat | dane | CRC32 (4 B, liczone od początku rekordu)
+ */
+#ifndef TELEMETRY_SEGMENT_H
+#define TELEMETRY_SEGMENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TELEMETRY_SEGMENT_MAGIC 0x47535154u // "TQSG"
+#define TELEMETRY_SEGMENT_VERSION 1
+
+#define TELEMETRY_SEGMENT_HEADER_SIZE 12
+#define TELEMETRY_RECORD_HEADER_SIZE 8
+#define TELEMETRY_RECORD_CRC_SIZE 4
+
+#define TELEMETRY_MAX_TOPIC_LEN 128
+#define TELEMETRY_MAX_PAYLOAD_LEN 256
+#define TELEMETRY_RECORD_MAX_SIZE (TELEMETRY_RECORD_HEADER_SIZE + TELEMETRY_MAX_TOPIC_LEN + \
+                                   TELEMETRY_MAX_PAYLOAD_LEN + TELEMETRY_RECORD_CRC_SIZE)
+
+/**
+ * Zdekodowany rekord. Wskaźniki pokazują na bufor przekazany do dekodera
+ * (temat i dane nie są zakończone zerem).
+ */
+typedef struct {
+    uint32_t timestamp;     ///< Czas pobrania próbki (s)
+    const char *topic;      ///< Temat MQTT
+    uint16_t topic_len;
+    const uint8_t *payload; ///< Dane wiadomości
+    uint16_t payload_len;
+} telemetry_record_t;
+
+/**
+ * Wynik dekodowania rekordu.
+ */
+typedef enum {
+    TELEMETRY_RECORD_OK = 0,         ///< Rekord poprawny
+    TELEMETRY_RECORD_INCOMPLETE = 1, ///< Za mało danych w buforze
+    TELEMETRY_RECORD_CORRUPT = 2     ///< Błędne długości lub CRC
+} telemetry_record_status_t;
+
+/**
+ * CRC32 (wielomian 0xEDB88320), zgodne z zlib.
+ * @param crc Poprzednia wartość (0 dla nowego obliczenia).
+ */
+uint32_t telemetry_crc32(uint32_t crc, const uint8_t *data, size_t len);
+
+/**
+ * Zapisuje nagłówek segmentu.
+ * @param buf Bufor o rozmiarze co najmniej TELEMETRY_SEGMENT_HEADER_SIZE.
+ * @param sequence Numer sekwencyjny segmentu.
+ * @return Liczba zapisanych bajtów.
+ */
+size_t telemetry_segment_header_encode(uint8_t *buf, uint32_t sequence);
+
+/**
+ * Sprawdza nagłówek segmentu.
+ * @return 0 gdy nagłówek jest poprawny, -1 w przeciwnym wypadku.
+ */
+int telemetry_segment_header_decode(const uint8_t *buf, size_t len, uint32_t *sequence);
+
+/**
+ * Zwraca rozmiar rekordu na podstawie jego nagłówka (8 bajtów).
+ * @return Pełny rozmiar rekordu lub 0, gdy długości są nieprawidłowe.
+ */
+size_t telemetry_record_size(const uint8_t *header);
+
+/**
+ * Koduje rekord.
+ * @return Liczba zapisanych bajtów lub 0, gdy rekord nie mieści się w buforze
+ *         albo temat/dane są za długie.
+ */
+size_t telemetry_record_encode(uint8_t *buf, size_t cap, uint32_t timestamp,
+                               const char *topic, size_t topic_len,
+                               const uint8_t *payload, size_t payload_len);
+
+/**
+ * Dekoduje rekord z początku bufora.
+ * @param consumed Liczba bajtów zajmowanych przez rekord (dla TELEMETRY_RECORD_OK).
+ */
+telemetry_record_status_t telemetry_record_decode(const uint8_t *buf, size_t len,
+                                                  telemetry_record_t *out, size_t *consumed);
+
+#endif // TELEMETRY_SEGMENT_H
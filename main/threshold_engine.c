@@ -0,0 +1,128 @@
+#include "threshold_engine.h"
+#include <math.h>
+#include <string.h>
+
+int threshold_table_compile(threshold_table_t *table, const threshold_rule_t *rules, int rule_count) {
+    memset(table, 0, sizeof(*table));
+
+    // Sortowanie przez zliczanie: wpisy kanału obok siebie, w kolejności podania reguł
+    for (int channel = 0; channel < THRESHOLD_MAX_CHANNELS; channel++) {
+        table->first[channel] = table->entry_count;
+        for (int i = 0; i < rule_count && table->entry_count < THRESHOLD_MAX_RULES; i++) {
+            const threshold_rule_t *rule = &rules[i];
+            if (rule->channel != channel || (isnan(rule->low) && isnan(rule->high))) {
+                continue;
+            }
+            float hysteresis = isnan(rule->hysteresis) || rule->hysteresis < 0 ? 0 : rule->hysteresis;
+            if (!isnan(rule->low) && !isnan(rule->high) && hysteresis > (rule->high - rule->low) / 2) {
+                hysteresis = (rule->high - rule->low) / 2; // Progi wyjścia nie mogą się minąć
+            }
+            threshold_entry_t *entry = &table->entries[table->entry_count++];
+            entry->enter_low = isnan(rule->low) ? -INFINITY : rule->low;
+            entry->exit_low = entry->enter_low + hysteresis;
+            entry->enter_high = isnan(rule->high) ? INFINITY : rule->high;
+            entry->exit_high = entry->enter_high - hysteresis;
+            entry->id = rule->id;
+            entry->debounce = rule->debounce ? rule->debounce : 1;
+            table->count[channel]++;
+        }
+    }
+    return table->entry_count;
+}
+
+void threshold_table_restore(threshold_table_t *table, const threshold_table_t *previous) {
+    for (int i = 0; i < table->entry_count; i++) {
+        threshold_entry_t *entry = &table->entries[i];
+        for (int j = 0; j < previous->entry_count; j++) {
+            const threshold_entry_t *old = &previous->entries[j];
+            if (old->id == entry->id && old->enter_low == entry->enter_low && old->exit_low == entry->exit_low &&
+                old->enter_high == entry->enter_high && old->exit_high == entry->exit_high &&
+                old->debounce == entry->debounce) {
+                entry->state = old->state;
+                entry->pending = old->pending;
+                entry->pending_count = old->pending_count;
+                break;
+            }
+        }
+    }
+}
+
+// Stan wskazywany przez próbkę; histereza trzyma alarm do przekroczenia progu wyjścia
+static threshold_state_t target_state(const threshold_entry_t *entry, float value) {
+    if (value < entry->enter_low) {
+        return THRESHOLD_STATE_LOW;
+    }
+    if (value > entry->enter_high) {
+        return THRESHOLD_STATE_HIGH;
+    }
+    if (entry->state == THRESHOLD_STATE_LOW && value < entry->exit_low) {
+        return THRESHOLD_STATE_LOW;
+    }
+    if (entry->state == THRESHOLD_STATE_HIGH && value > entry->exit_high) {
+        return THRESHOLD_STATE_HIGH;
+    }
+    return THRESHOLD_STATE_NORMAL;
+}
+
+int threshold_evaluate(threshold_table_t *table, uint8_t channel, float value,
+                       threshold_event_t *events, int max_events) {
+    if (channel >= THRESHOLD_MAX_CHANNELS || isnan(value)) {
+        return 0;
+    }
+    int event_count = 0;
+    threshold_entry_t *entry = &table->entries[table->first[channel]];
+    threshold_entry_t *end = entry + table->count[channel];
+    for (; entry < end; entry++) {
+        threshold_state_t target = target_state(entry, value);
+        if (target == entry->state) {
+            entry->pending_count = 0;
+            continue;
+        }
+        if (target != entry->pending || entry->pending_count == 0) {
+            entry->pending = (uint8_t)target;
+            entry->pending_count = 0;
+        }
+        if (++entry->pending_count < entry->debounce) {
+            continue;
+        }
+
+        threshold_state_t from = (threshold_state_t)entry->state;
+        entry->state = (uint8_t)target;
+        entry->pending_count = 0;
+        if (event_count < max_events) {
+            threshold_event_t *event = &events[event_count++];
+            event->id = entry->id;
+            event->from = (uint8_t)from;
+            event->to = (uint8_t)target;
+            event->value = value;
+            if (target == THRESHOLD_STATE_LOW) {
+                event->threshold = entry->enter_low;
+            } else if (target == THRESHOLD_STATE_HIGH) {
+                event->threshold = entry->enter_high;
+            } else {
+                event->threshold = from == THRESHOLD_STATE_LOW ? entry->exit_low : entry->exit_high;
+            }
+        }
+    }
+    return event_count;
+}
+
+threshold_state_t threshold_rule_state(const threshold_table_t *table, uint16_t id) {
+    for (int i = 0; i < table->entry_count; i++) {
+        if (table->entries[i].id == id) {
+            return (threshold_state_t)table->entries[i].state;
+        }
+    }
+    return THRESHOLD_STATE_NORMAL;
+}
+
+const char *threshold_state_name(threshold_state_t state) {
+    switch (state) {
+        case THRESHOLD_STATE_LOW:
+            return "low";
+        case THRESHOLD_STATE_HIGH:
+            return "high";
+        default:
+            return "normal";
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * @file threshold_engine.h
+ * Reguły progowe z histerezą i eliminacją drgań, sprawdzane przy każdej próbce.
+ *
+ * Reguły są kompilowane do zwartej tablicy: granice wejścia i wyjścia z alarmu
+ * liczone raz (histereza wliczona), wpisy posortowane według kanału, a dla każdego
+ * kanału - zakres wpisów. Próbka sprawdza więc tylko reguły swojego kanału.
+ *
+ * Stan reguły zmienia się dopiero po debounce kolejnych próbkach wskazujących ten
+ * sam nowy stan; każda zmiana stanu jest zwracana jako zdarzenie.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef THRESHOLD_ENGINE_H
+#define THRESHOLD_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define THRESHOLD_MAX_RULES 32
+#define THRESHOLD_MAX_CHANNELS 8
+
+typedef enum {
+    THRESHOLD_STATE_NORMAL = 0,
+    THRESHOLD_STATE_LOW,    ///< Wartość poniżej dolnego progu
+    THRESHOLD_STATE_HIGH,   ///< Wartość powyżej górnego progu
+} threshold_state_t;
+
+typedef struct {
+    uint16_t id;        ///< Identyfikator nadany przez wywołującego (zwracany w zdarzeniach)
+    uint8_t channel;    ///< Kanał próbek (< THRESHOLD_MAX_CHANNELS)
+    uint8_t debounce;   ///< Kolejne próbki potrzebne do zmiany stanu (0 traktowane jak 1)
+    float low;          ///< Alarm poniżej; NAN - bez dolnego progu
+    float high;         ///< Alarm powyżej; NAN - bez górnego progu
+    float hysteresis;   ///< Powrót do normy dopiero przy low + h <= wartość <= high - h
+} threshold_rule_t;
+
+typedef struct {
+    float enter_low;
+    float exit_low;
+    float enter_high;
+    float exit_high;
+    uint16_t id;
+    uint8_t debounce;
+    uint8_t state;      ///< threshold_state_t
+    uint8_t pending;    ///< Kandydat na nowy stan
+    uint8_t pending_count;
+} threshold_entry_t;
+
+typedef struct {
+    threshold_entry_t entries[THRESHOLD_MAX_RULES];
+    uint8_t first[THRESHOLD_MAX_CHANNELS]; ///< Pierwszy wpis kanału
+    uint8_t count[THRESHOLD_MAX_CHANNELS]; ///< Liczba wpisów kanału
+    uint8_t entry_count;
+} threshold_table_t;
+
+typedef struct {
+    uint16_t id;
+    uint8_t from;       ///< threshold_state_t
+    uint8_t to;         ///< threshold_state_t
+    float value;        ///< Próbka, która zmieniła stan
+    float threshold;    ///< Przekroczony próg (przy powrocie do normy - próg wyjścia)
+} threshold_event_t;
+
+/**
+ * Kompiluje reguły do tablicy. Stan wszystkich reguł jest zerowany (NORMAL).
+ * @return Liczba skompilowanych reguł; reguły z nieprawidłowym kanałem, bez żadnego
+ *         progu albo ponad THRESHOLD_MAX_RULES są pomijane.
+ */
+int threshold_table_compile(threshold_table_t *table, const threshold_rule_t *rules, int rule_count);
+
+/**
+ * Przenosi stan reguł z poprzedniej tablicy po ponownej kompilacji: tylko dla
+ * wpisów o tym samym id i identycznych progach (zmienione reguły zaczynają od NORMAL).
+ */
+void threshold_table_restore(threshold_table_t *table, const threshold_table_t *previous);
+
+/**
+ * Sprawdza próbkę kanału względem jego reguł. Wartość NAN nie zmienia stanu.
+ * @param events Tablica na zdarzenia (co najwyżej jedno na regułę kanału).
+ * @return Liczba zapisanych zdarzeń.
+ */
+int threshold_evaluate(threshold_table_t *table, uint8_t channel, float value,
+                       threshold_event_t *events, int max_events);
+
+/** Bieżący stan reguły o danym id (NORMAL, gdy nie istnieje). */
+threshold_state_t threshold_rule_state(const threshold_table_t *table, uint16_t id);
+
+const char *threshold_state_name(threshold_state_t state);
+
+#endif // THRESHOLD_ENGINE_H
@@ -0,0 +1,191 @@
+#include "trace_buffer.h"
+#include <string.h>
+
+void trace_ring_init(trace_ring_t *ring, trace_slot_t *slots, uint32_t capacity) {
+    ring->slots = slots;
+    ring->capacity = capacity;
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&slots[i].seq, 0);
+        atomic_init(&slots[i].time_us, 0);
+        atomic_init(&slots[i].id, 0);
+        atomic_init(&slots[i].meta, 0);
+    }
+    atomic_init(&ring->head, 0);
+}
+
+void trace_ring_write(trace_ring_t *ring, uint32_t time_us, trace_stage_t stage, uint32_t id, uint16_t msg_id,
+                      uint8_t core) {
+    uint32_t n = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    trace_slot_t *slot = &ring->slots[n % ring->capacity];
+    // Numer 0 na czas zapisu - czytelnik nie skopiuje gniazda w połowie zmiany
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&slot->time_us, time_us, memory_order_relaxed);
+    atomic_store_explicit(&slot->id, id, memory_order_relaxed);
+    atomic_store_explicit(&slot->meta, (uint32_t)msg_id | (uint32_t)stage << 16 | (uint32_t)core << 24,
+                          memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, n + 1, memory_order_release);
+}
+
+uint32_t trace_ring_snapshot(trace_ring_t *ring, trace_record_t *out, uint32_t max_records) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t available = head < ring->capacity ? head : ring->capacity;
+    uint32_t count = 0;
+    for (uint32_t n = head - available; n != head && count < max_records; n++) {
+        trace_slot_t *slot = &ring->slots[n % ring->capacity];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq != n + 1) {
+            continue; // Zapis w toku albo gniazdo już nadpisane nowszym zapisem
+        }
+        uint32_t time_us = atomic_load_explicit(&slot->time_us, memory_order_relaxed);
+        uint32_t id = atomic_load_explicit(&slot->id, memory_order_relaxed);
+        uint32_t meta = atomic_load_explicit(&slot->meta, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq) {
+            continue;
+        }
+        out[count++] = (trace_record_t){
+            .time_us = time_us,
+            .id = id,
+            .seq = seq,
+            .msg_id = (uint16_t)meta,
+            .stage = (uint8_t)(meta >> 16),
+            .core = (uint8_t)(meta >> 24),
+        };
+    }
+    return count;
+}
+
+void trace_hist_add(trace_hist_t *hist, uint32_t latency_us) {
+    int bucket = 0;
+    uint32_t limit = TRACE_HIST_FIRST_LIMIT_US;
+    while (bucket < TRACE_HIST_BUCKETS - 1 && latency_us >= limit) {
+        bucket++;
+        limit <<= 1;
+    }
+    atomic_fetch_add_explicit(&hist->counts[bucket], 1, memory_order_relaxed);
+}
+
+uint32_t trace_hist_take(trace_hist_t *hist, uint32_t out[TRACE_HIST_BUCKETS]) {
+    uint32_t total = 0;
+    for (int i = 0; i < TRACE_HIST_BUCKETS; i++) {
+        out[i] = atomic_exchange_explicit(&hist->counts[i], 0, memory_order_relaxed);
+        total += out[i];
+    }
+    return total;
+}
+
+uint32_t trace_hist_bucket_limit(int bucket) {
+    return bucket >= TRACE_HIST_BUCKETS - 1 ? UINT32_MAX : (uint32_t)TRACE_HIST_FIRST_LIMIT_US << bucket;
+}
+
+uint32_t trace_hist_percentile(const uint32_t counts[TRACE_HIST_BUCKETS], uint32_t permille) {
+    uint64_t total = 0;
+    for (int i = 0; i < TRACE_HIST_BUCKETS; i++) {
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    // Najmniejszy przedział, do którego włącznie mieści się permille/1000 próbek (co najmniej jedna)
+    uint64_t rank = (total * permille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < TRACE_HIST_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return trace_hist_bucket_limit(i);
+        }
+    }
+    return UINT32_MAX;
+}
+
+static trace_chain_t *chain_slot(trace_chains_t *table, uint32_t key) {
+    return &table->chains[key % TRACE_CHAINS];
+}
+
+void trace_chain_open(trace_chains_t *table, uint32_t key, const trace_chain_info_t *info) {
+    trace_chain_t *chain = chain_slot(table, key);
+    atomic_store_explicit(&chain->key, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&chain->start_us, info->start_us, memory_order_relaxed);
+    atomic_store_explicit(&chain->last_us, info->last_us, memory_order_relaxed);
+    atomic_store_explicit(&chain->stages, (uint32_t)info->first_stage | (uint32_t)info->last_stage << 8,
+                          memory_order_relaxed);
+    atomic_store_explicit(&chain->key, key + 1, memory_order_release);
+}
+
+// Kopia pól, jeśli przez cały odczyt gniazdo należało do tego klucza
+static bool chain_read(trace_chain_t *chain, uint32_t key, trace_chain_info_t *info) {
+    if (atomic_load_explicit(&chain->key, memory_order_acquire) != key + 1) {
+        return false;
+    }
+    uint32_t start_us = atomic_load_explicit(&chain->start_us, memory_order_relaxed);
+    uint32_t last_us = atomic_load_explicit(&chain->last_us, memory_order_relaxed);
+    uint32_t stages = atomic_load_explicit(&chain->stages, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&chain->key, memory_order_relaxed) != key + 1) {
+        return false;
+    }
+    info->start_us = start_us;
+    info->last_us = last_us;
+    info->first_stage = (uint8_t)stages;
+    info->last_stage = (uint8_t)(stages >> 8);
+    return true;
+}
+
+bool trace_chain_get(trace_chains_t *table, uint32_t key, trace_chain_info_t *info) {
+    return chain_read(chain_slot(table, key), key, info);
+}
+
+bool trace_chain_advance(trace_chains_t *table, uint32_t key, uint32_t now_us, trace_stage_t stage) {
+    trace_chain_t *chain = chain_slot(table, key);
+    uint32_t expected = key + 1;
+    // Gniazdo przejmowane na czas zmiany - równoległy odczyt lub zamknięcie zobaczy brak łańcucha
+    if (!atomic_compare_exchange_strong_explicit(&chain->key, &expected, 0, memory_order_acquire,
+                                                 memory_order_relaxed)) {
+        return false;
+    }
+    uint32_t stages = atomic_load_explicit(&chain->stages, memory_order_relaxed);
+    atomic_store_explicit(&chain->last_us, now_us, memory_order_relaxed);
+    atomic_store_explicit(&chain->stages, (stages & 0xFF) | (uint32_t)stage << 8, memory_order_relaxed);
+    atomic_store_explicit(&chain->key, key + 1, memory_order_release);
+    return true;
+}
+
+bool trace_chain_close(trace_chains_t *table, uint32_t key, trace_chain_info_t *info) {
+    trace_chain_t *chain = chain_slot(table, key);
+    if (!chain_read(chain, key, info)) {
+        return false;
+    }
+    uint32_t expected = key + 1;
+    return atomic_compare_exchange_strong_explicit(&chain->key, &expected, 0, memory_order_relaxed,
+                                                   memory_order_relaxed);
+}
+
+bool trace_mqtt_publish_id(const uint8_t *packet, size_t len, uint16_t *msg_id) {
+    if (len < 2 || (packet[0] >> 4) != 3 || ((packet[0] >> 1) & 0x03) == 0) {
+        return false; // Nie PUBLISH albo QoS 0 (bez identyfikatora)
+    }
+    // Długość pozostałej części: 1-4 bajty po 7 bitów
+    size_t pos = 1;
+    while (pos < len && pos <= 4 && (packet[pos] & 0x80)) {
+        pos++;
+    }
+    if (pos >= len || pos > 4) {
+        return false;
+    }
+    pos++;
+    if (pos + 2 > len) {
+        return false;
+    }
+    size_t topic_len = (size_t)packet[pos] << 8 | packet[pos + 1];
+    pos += 2 + topic_len;
+    if (pos + 2 > len) {
+        return false;
+    }
+    *msg_id = (uint16_t)(packet[pos] << 8 | packet[pos + 1]);
+    return true;
+}
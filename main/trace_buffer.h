@@ -0,0 +1,126 @@
+/**
+ * @file trace_buffer.h
+ * Bufor punktów śledzenia, histogramy opóźnień i tablica otwartych łańcuchów - bez blokad.
+ *
+ * Bufor jest pierścieniem nadpisującym najstarsze zapisy. Miejsce rezerwuje atomowe
+ * zwiększenie licznika, więc zapis może przerwać inny task lub przerwanie na tym samym
+ * rdzeniu, a zapisujący nigdy nie czeka. Pola są słowami atomowymi, a numer zapisu
+ * w gnieździe jest ustawiany na końcu - odczyt pomija gniazda w trakcie zapisu
+ * lub nadpisane w czasie kopiowania.
+ *
+ * Histogram ma przedziały potęg dwójki (w mikrosekundach); liczniki są atomowe,
+ * więc dopisywać może każdy task, a odczyt zeruje je przedział po przedziale.
+ *
+ * Moduł nie zależy od ESP-IDF i może być kompilowany na hoście.
+ */
+#ifndef TRACE_BUFFER_H
+#define TRACE_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+typedef enum {
+    TRACE_STAGE_TRIGGER = 0, ///< Przerwanie wyzwalające pomiar (READ_GPIO)
+    TRACE_STAGE_ACQUIRE,     ///< Próbka na szynie (id - numer próbki)
+    TRACE_STAGE_ENCODE,      ///< Dane wiadomości gotowe (id - numer próbki)
+    TRACE_STAGE_ENQUEUE,     ///< Wiadomość przekazana klientowi MQTT (id - numer próbki, msg_id)
+    TRACE_STAGE_SEND,        ///< PUBLISH zapisany do gniazda (msg_id)
+    TRACE_STAGE_ACK,         ///< Potwierdzenie brokera - MQTT_EVENT_PUBLISHED (msg_id)
+    TRACE_STAGE_COUNT
+} trace_stage_t;
+
+/** Zapis skopiowany z bufora; taki sam układ ma zrzut (latency_trace.h). */
+typedef struct {
+    uint32_t time_us;   ///< Młodsze 32 bity esp_timer_get_time()
+    uint32_t id;        ///< Numer próbki z szyny (0 - brak)
+    uint32_t seq;       ///< Numer zapisu w buforze (od 1) - luki oznaczają nadpisane zapisy
+    uint16_t msg_id;    ///< Identyfikator wiadomości MQTT (0 - brak)
+    uint8_t stage;      ///< trace_stage_t
+    uint8_t core;
+} trace_record_t;
+
+typedef struct {
+    atomic_uint seq;    ///< Numer zapisu; 0 - gniazdo puste lub zapis w toku
+    atomic_uint time_us;
+    atomic_uint id;
+    atomic_uint meta;   ///< msg_id | stage << 16 | core << 24
+} trace_slot_t;
+
+typedef struct {
+    trace_slot_t *slots;
+    uint32_t capacity;
+    atomic_uint head;   ///< Zapisy od inicjalizacji
+} trace_ring_t;
+
+void trace_ring_init(trace_ring_t *ring, trace_slot_t *slots, uint32_t capacity);
+
+/** Dopisuje zapis; można wywołać z przerwania. */
+void trace_ring_write(trace_ring_t *ring, uint32_t time_us, trace_stage_t stage, uint32_t id, uint16_t msg_id,
+                      uint8_t core);
+
+/**
+ * Kopiuje zapisy od najstarszego; pomija gniazda w trakcie zapisu.
+ * @return Liczba skopiowanych zapisów.
+ */
+uint32_t trace_ring_snapshot(trace_ring_t *ring, trace_record_t *out, uint32_t max_records);
+
+#define TRACE_HIST_BUCKETS 20
+#define TRACE_HIST_FIRST_LIMIT_US 16 // Przedział 0: < 16 us, przedział i: < 16 << i us, ostatni - reszta
+
+typedef struct {
+    atomic_uint counts[TRACE_HIST_BUCKETS];
+} trace_hist_t;
+
+void trace_hist_add(trace_hist_t *hist, uint32_t latency_us);
+
+/** Kopiuje liczniki do out i zeruje histogram. @return Suma liczników. */
+uint32_t trace_hist_take(trace_hist_t *hist, uint32_t out[TRACE_HIST_BUCKETS]);
+
+/** Górna granica przedziału (us); UINT32_MAX dla ostatniego. */
+uint32_t trace_hist_bucket_limit(int bucket);
+
+/** Górna granica przedziału, w którym leży dany promil próbek (0 - pusty histogram). */
+uint32_t trace_hist_percentile(const uint32_t counts[TRACE_HIST_BUCKETS], uint32_t permille);
+
+#define TRACE_CHAINS 32 // Łańcuchy otwarte jednocześnie - kolejne nadpisują gniazda (klucz % TRACE_CHAINS)
+
+/** Otwarty łańcuch (próbka lub wiadomość): pierwszy i ostatni zarejestrowany etap. */
+typedef struct {
+    uint32_t start_us;
+    uint32_t last_us;
+    uint8_t first_stage;    ///< trace_stage_t
+    uint8_t last_stage;     ///< trace_stage_t
+} trace_chain_info_t;
+
+typedef struct {
+    atomic_uint key;        ///< Klucz + 1; 0 - gniazdo wolne lub zapis w toku
+    atomic_uint start_us;
+    atomic_uint last_us;
+    atomic_uint stages;     ///< first_stage | last_stage << 8
+} trace_chain_t;
+
+typedef struct {
+    trace_chain_t chains[TRACE_CHAINS];
+} trace_chains_t;
+
+/** Otwiera łańcuch o danym kluczu (nadpisuje łańcuch zajmujący gniazdo). */
+void trace_chain_open(trace_chains_t *table, uint32_t key, const trace_chain_info_t *info);
+
+/** @return false, gdy łańcucha nie ma (zamknięty, nadpisany albo właśnie zmieniany). */
+bool trace_chain_get(trace_chains_t *table, uint32_t key, trace_chain_info_t *info);
+
+/** Zapisuje kolejny etap łańcucha. @return false, gdy łańcucha nie ma. */
+bool trace_chain_advance(trace_chains_t *table, uint32_t key, uint32_t now_us, trace_stage_t stage);
+
+/** Odczytuje i zamyka łańcuch. @return false, gdy łańcucha nie ma. */
+bool trace_chain_close(trace_chains_t *table, uint32_t key, trace_chain_info_t *info);
+
+/**
+ * Identyfikator pakietu z nagłówka MQTT PUBLISH (QoS 1 i 2).
+ * @return false dla innych pakietów, QoS 0 albo niepełnego nagłówka.
+ */
+bool trace_mqtt_publish_id(const uint8_t *packet, size_t len, uint16_t *msg_id);
+
+#endif // TRACE_BUFFER_H
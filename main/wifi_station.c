@@ -1,5 +1,6 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
@@ -8,11 +9,16 @@
 #include "driver/gpio.h"
 #include "wifi_station.h"
 #include "mqtt_publisher.h"
+#include "boot.h"
+#include "work_queue.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_random.h"
 #include <string.h>
 #include <esp_http_server.h>
 #include <freertos/task.h>
+#include "esp_sntp.h"
 
-#define BLINK_GPIO     GPIO_NUM_2  // nr pinu GPIO dla LED
 
 static const char *TAG = "wifi_station";
 
@@ -22,36 +28,366 @@ const int WIFI_FAIL_BIT = BIT1; // nieudana próba
 
 bool wifi_connected = false; 
 
+static esp_netif_t *sta_netif = NULL;
+
+/*
+Szybkie ponowne połączenie: BSSID, kanał i tryb uwierzytelniania ostatniego AP
+zapisane w NVS (klucze "bssid", "channel", "authmode" w przestrzeni "wifi_data").
+Pierwsza próba łączy się bezpośrednio z tym AP na jego kanale (bez skanowania
+wszystkich kanałów); nieudana próba kasuje pamięć AP i łączy się po pełnym skanie.
+*/
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t authmode;
+    bool valid;
+} ap_cache_t;
+
+static ap_cache_t ap_cache = {0};
+static wifi_config_t sta_config = {0};
+static bool attempt_directed = false;   // Bieżąca próba łączy się z zapamiętanym AP
+static bool attempt_pending = false;    // Próba trwa (do IP_EVENT_STA_GOT_IP)
+static int64_t attempt_start_us = 0;
+static int64_t associated_us = 0;
+
+/*
+Ponowne łączenie po rozłączeniu: jednorazowy esp_timer z wykładniczym opóźnieniem
+(CONFIG_MONITOR_WIFI_BACKOFF_MIN_MS, podwajane do CONFIG_MONITOR_WIFI_BACKOFF_MAX_MS)
+losowanym z przedziału [opóźnienie/2, opóźnienie]. Callback timera dodaje tylko pracę
+do kolejki prac; handler zdarzeń nie blokuje. Uzyskanie IP zeruje opóźnienie.
+*/
+#define BACKOFF_MAX_STEP 16
+static esp_timer_handle_t reconnect_timer = NULL;
+static uint8_t backoff_step = 0;
+static bool fallback_pending = false;   // Następna próba: skasować pamięć AP i skanować
+static int64_t outage_start_us = 0;     // Utrata IP (0 - połączenie działa lub pierwsze łączenie)
+
+static wifi_reconnect_stats_t reconnect_stats = {0};
+static portMUX_TYPE reconnect_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/*
+Stan łączenia (ap_cache, sta_config, flagi próby, backoff_step) zmieniają handler zdarzeń
+(task pętli zdarzeń), praca ponownego łączenia i connect_to_wifi() (task kolejki prac,
+app_main). Każda zmiana odbywa się pod state_lock; pod blokadą nie ma zapisów NVS ani
+czekania - najwyżej esp_wifi_set_config() i esp_wifi_connect().
+*/
+static SemaphoreHandle_t state_lock = NULL;
+
+static void state_lock_init(void) {
+    if (state_lock == NULL) {
+        state_lock = xSemaphoreCreateMutex();
+    }
+}
+
+static void lock_state(void) {
+    xSemaphoreTake(state_lock, portMAX_DELAY);
+}
+
+static void unlock_state(void) {
+    xSemaphoreGive(state_lock);
+}
+
+static void load_ap_cache(ap_cache_t *cache) {
+    nvs_handle_t nvs_handle;
+    cache->valid = false;
+    if (nvs_open("wifi_data", NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    size_t len = sizeof(cache->bssid);
+    if (nvs_get_blob(nvs_handle, "bssid", cache->bssid, &len) == ESP_OK && len == sizeof(cache->bssid) &&
+        nvs_get_u8(nvs_handle, "channel", &cache->channel) == ESP_OK &&
+        nvs_get_u8(nvs_handle, "authmode", &cache->authmode) == ESP_OK &&
+        cache->channel >= 1 && cache->channel <= 14) {
+        cache->valid = true;
+    }
+    nvs_close(nvs_handle);
+}
+
+static void save_ap_cache_work(void *arg) {
+    lock_state();
+    ap_cache_t cache = ap_cache;
+    unlock_state();
+    if (!cache.valid) {
+        return; // Pamięć AP skasowana przed zapisem
+    }
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open("wifi_data", NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Nie udało się otworzyć NVS do zapisu danych AP.");
+        return;
+    }
+    nvs_set_blob(nvs_handle, "bssid", cache.bssid, sizeof(cache.bssid));
+    nvs_set_u8(nvs_handle, "channel", cache.channel);
+    nvs_set_u8(nvs_handle, "authmode", cache.authmode);
+    nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+    ESP_LOGI(TAG, "Zapamiętano AP " MACSTR " (kanał %u)", MAC2STR(cache.bssid), cache.channel);
+}
+
+// Kasowanie pamięci AP w NVS - poza state_lock, z pracy kolejki (nie z handlera zdarzeń)
+static void erase_ap_cache_nvs(void) {
+    nvs_handle_t nvs_handle;
+    if (nvs_open("wifi_data", NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        nvs_erase_key(nvs_handle, "bssid");
+        nvs_erase_key(nvs_handle, "channel");
+        nvs_erase_key(nvs_handle, "authmode");
+        nvs_commit(nvs_handle);
+        nvs_close(nvs_handle);
+    }
+}
+
+// Po uzyskaniu IP: zapis AP do NVS tylko przy zmianie (pracą w work_queue, poza taskiem zdarzeń).
+// Wymaga state_lock.
+static void update_ap_cache(void) {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+    if (ap_cache.valid && memcmp(ap_cache.bssid, ap.bssid, sizeof(ap_cache.bssid)) == 0 &&
+        ap_cache.channel == ap.primary && ap_cache.authmode == (uint8_t)ap.authmode) {
+        return;
+    }
+    memcpy(ap_cache.bssid, ap.bssid, sizeof(ap_cache.bssid));
+    ap_cache.channel = ap.primary;
+    ap_cache.authmode = (uint8_t)ap.authmode;
+    ap_cache.valid = true;
+    work_queue_post(WORK_PRIORITY_LOW, save_ap_cache_work, NULL, "wifi_ap_cache");
+}
+
+/*
+Konfiguracja STA dla kolejnej próby. Z zapamiętanym AP: BSSID, kanał i szybkie
+skanowanie tylko tego kanału; próg uwierzytelniania i PMF wymagane dla AP z WPA3,
+żeby bezpośrednie połączenie nie zeszło do słabszego trybu. Bez AP: pełny skan
+i wybór najsilniejszego AP o danym SSID. Wymaga state_lock.
+*/
+static void apply_sta_config(bool directed) {
+    sta_config.sta.bssid_set = directed;
+    if (directed) {
+        memcpy(sta_config.sta.bssid, ap_cache.bssid, sizeof(sta_config.sta.bssid));
+        sta_config.sta.channel = ap_cache.channel;
+        sta_config.sta.scan_method = WIFI_FAST_SCAN;
+        sta_config.sta.threshold.authmode = (wifi_auth_mode_t)ap_cache.authmode;
+        sta_config.sta.pmf_cfg.capable = true;
+        sta_config.sta.pmf_cfg.required = ap_cache.authmode == WIFI_AUTH_WPA3_PSK;
+    } else {
+        memset(sta_config.sta.bssid, 0, sizeof(sta_config.sta.bssid));
+        sta_config.sta.channel = 0;
+        sta_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        sta_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+        sta_config.sta.threshold.authmode = WIFI_AUTH_OPEN;
+        sta_config.sta.pmf_cfg.capable = true;
+        sta_config.sta.pmf_cfg.required = false;
+    }
+    attempt_directed = directed;
+}
+
+// Wymaga state_lock
+static void start_connect_attempt(void) {
+    attempt_start_us = esp_timer_get_time();
+    associated_us = 0;
+    attempt_pending = true;
+    taskENTER_CRITICAL(&reconnect_stats_mux);
+    reconnect_stats.attempts++;
+    if (attempt_directed) {
+        reconnect_stats.directed_attempts++;
+    }
+    taskEXIT_CRITICAL(&reconnect_stats_mux);
+    esp_wifi_connect();
+}
+
+// Wymaga state_lock
+static void record_connected(int64_t now_us) {
+    uint32_t assoc_ms = (uint32_t)((associated_us - attempt_start_us) / 1000);
+    uint32_t dhcp_ms = (uint32_t)((now_us - associated_us) / 1000);
+    uint32_t total_ms = (uint32_t)((now_us - attempt_start_us) / 1000);
+
+    taskENTER_CRITICAL(&reconnect_stats_mux);
+    reconnect_stats.connects++;
+    reconnect_stats.last_assoc_ms = assoc_ms;
+    reconnect_stats.last_dhcp_ms = dhcp_ms;
+    if (dhcp_ms > reconnect_stats.max_dhcp_ms) {
+        reconnect_stats.max_dhcp_ms = dhcp_ms;
+    }
+    reconnect_stats.total_dhcp_ms += dhcp_ms;
+    if (attempt_directed) {
+        reconnect_stats.directed_connects++;
+        reconnect_stats.directed_total_ms += total_ms;
+    } else {
+        reconnect_stats.total_scan_ms += total_ms;
+    }
+    taskEXIT_CRITICAL(&reconnect_stats_mux);
+
+    ESP_LOGI(TAG, "Połączenie %s: asocjacja %lu ms, IP %lu ms (łącznie %lu ms)",
+             attempt_directed ? "bezpośrednie" : "po skanie",
+             (unsigned long)assoc_ms, (unsigned long)dhcp_ms, (unsigned long)total_ms);
+}
+
+void wifi_get_reconnect_stats(wifi_reconnect_stats_t *stats) {
+    int64_t now_us = esp_timer_get_time();
+    taskENTER_CRITICAL(&reconnect_stats_mux);
+    *stats = reconnect_stats;
+    stats->outage_ms = outage_start_us ? (uint32_t)((now_us - outage_start_us) / 1000) : 0;
+    taskEXIT_CRITICAL(&reconnect_stats_mux);
+}
+
+static void reconnect_work(void *arg) {
+    bool erase_cache = false;
+
+    lock_state();
+    if (is_config_mode || wifi_connected) {
+        unlock_state();
+        return;
+    }
+    if (fallback_pending) {
+        fallback_pending = false;
+        erase_cache = ap_cache.valid;
+        ap_cache.valid = false;
+        apply_sta_config(false);
+        esp_wifi_set_config(WIFI_IF_STA, &sta_config);
+    } else if (!attempt_directed && ap_cache.valid) {
+        apply_sta_config(true);
+        esp_wifi_set_config(WIFI_IF_STA, &sta_config);
+    }
+    taskENTER_CRITICAL(&reconnect_stats_mux);
+    reconnect_stats.reconnects++;
+    taskEXIT_CRITICAL(&reconnect_stats_mux);
+    start_connect_attempt();
+    unlock_state();
+
+    if (erase_cache) {
+        erase_ap_cache_nvs();
+    }
+}
+
+static void reconnect_timer_callback(void *arg) {
+    if (!work_queue_post(WORK_PRIORITY_NORMAL, reconnect_work, NULL, "wifi_reconnect")) {
+        // Pełna kolejka - kolejna próba po najkrótszym opóźnieniu
+        esp_timer_start_once(reconnect_timer, (uint64_t)CONFIG_MONITOR_WIFI_BACKOFF_MIN_MS * 1000);
+    }
+}
+
+// Wymaga state_lock
+static void schedule_reconnect(void) {
+    uint32_t delay_ms = (uint32_t)CONFIG_MONITOR_WIFI_BACKOFF_MIN_MS << backoff_step;
+    if (delay_ms > CONFIG_MONITOR_WIFI_BACKOFF_MAX_MS) {
+        delay_ms = CONFIG_MONITOR_WIFI_BACKOFF_MAX_MS;
+    } else if (backoff_step < BACKOFF_MAX_STEP) {
+        backoff_step++;
+    }
+    // Rozrzut: urządzenia rozłączone razem przez restart AP nie łączą się jednocześnie
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+
+    taskENTER_CRITICAL(&reconnect_stats_mux);
+    reconnect_stats.backoff_ms = delay_ms;
+    taskEXIT_CRITICAL(&reconnect_stats_mux);
+
+    esp_timer_stop(reconnect_timer);
+    esp_timer_start_once(reconnect_timer, (uint64_t)delay_ms * 1000);
+    ESP_LOGI(TAG, "Ponowne połączenie za %lu ms", (unsigned long)delay_ms);
+}
+
+// Wymaga state_lock
+static void reset_backoff(int64_t now_us) {
+    backoff_step = 0;
+    esp_timer_stop(reconnect_timer);
+    if (outage_start_us == 0) {
+        return;
+    }
+    uint32_t outage_ms = (uint32_t)((now_us - outage_start_us) / 1000);
+    taskENTER_CRITICAL(&reconnect_stats_mux);
+    outage_start_us = 0;
+    reconnect_stats.outages++;
+    reconnect_stats.last_outage_ms = outage_ms;
+    if (outage_ms > reconnect_stats.max_outage_ms) {
+        reconnect_stats.max_outage_ms = outage_ms;
+    }
+    reconnect_stats.total_outage_ms += outage_ms;
+    taskEXIT_CRITICAL(&reconnect_stats_mux);
+    ESP_LOGI(TAG, "Przerwa w połączeniu: %lu ms", (unsigned long)outage_ms);
+}
+
+#if CONFIG_MONITOR_WIFI_STATIC_IP
+// Stały adres zamiast DHCP; esp_netif zgłasza IP_EVENT_STA_GOT_IP zaraz po asocjacji
+static void apply_static_ip(esp_netif_t *netif) {
+    esp_netif_ip_info_t ip_info = {0};
+    esp_netif_dns_info_t dns = {0};
+
+    if (esp_netif_str_to_ip4(CONFIG_MONITOR_WIFI_STATIC_IP_ADDR, &ip_info.ip) != ESP_OK ||
+        esp_netif_str_to_ip4(CONFIG_MONITOR_WIFI_STATIC_NETMASK, &ip_info.netmask) != ESP_OK ||
+        esp_netif_str_to_ip4(CONFIG_MONITOR_WIFI_STATIC_GW, &ip_info.gw) != ESP_OK) {
+        ESP_LOGE(TAG, "Nieprawidłowy stały adres IP w konfiguracji - pozostaje DHCP.");
+        return;
+    }
+    esp_netif_dhcpc_stop(netif);
+    if (esp_netif_set_ip_info(netif, &ip_info) != ESP_OK) {
+        ESP_LOGE(TAG, "Nie udało się ustawić stałego adresu IP - pozostaje DHCP.");
+        esp_netif_dhcpc_start(netif);
+        return;
+    }
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    if (esp_netif_str_to_ip4(CONFIG_MONITOR_WIFI_STATIC_DNS, &dns.ip.u_addr.ip4) == ESP_OK) {
+        esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns);
+    }
+    ESP_LOGI(TAG, "Stały adres IP: %s", CONFIG_MONITOR_WIFI_STATIC_IP_ADDR);
+}
+#endif
+
+
+/* Synchronizacja zegara - znaczniki czasu próbek w kolejce telemetrii */
+static void start_time_sync(void) {
+    if (esp_sntp_enabled()) {
+        return;
+    }
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, "pool.ntp.org");
+    esp_sntp_init();
+}
 
 /* Event handler dla zdarzeń wifi */
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
-    int led_state=0;
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) { // Tryb STATION się uruchomił
         if(!is_config_mode) {
-            esp_wifi_connect();
+            lock_state();
+            start_connect_attempt();
+            unlock_state();
         }
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        lock_state();
+        associated_us = esp_timer_get_time();
+        unlock_state();
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) { // Rozłączenie 
         
         wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
         ESP_LOGI(TAG, "Rozłączono z Wi-Fi. Powód: %d", event->reason);
+        if (wifi_connected) {
+            taskENTER_CRITICAL(&reconnect_stats_mux);
+            outage_start_us = esp_timer_get_time();
+            taskEXIT_CRITICAL(&reconnect_stats_mux);
+        }
         wifi_connected = false;
-        ESP_LOGI(TAG, "Zatrzymuję MQTT...");
-        mqtt_stop();
+        // Klient MQTT zostaje - sam połączy się ponownie, a próbki trafiają w tym czasie do kolejki
 
+        if (is_config_mode) {
+            return;
+        }
 
-        if (event->reason == WIFI_REASON_AUTH_FAIL) {
+        lock_state();
+        // Zapamiętany AP nie odpowiedział (zmiana kanału, inny AP, inne zabezpieczenia) - pełny skan
+        if (attempt_pending && attempt_directed) {
+            ESP_LOGW(TAG, "Bezpośrednie połączenie nieudane - pełny skan.");
+            taskENTER_CRITICAL(&reconnect_stats_mux);
+            reconnect_stats.fallbacks++;
+            taskEXIT_CRITICAL(&reconnect_stats_mux);
+            fallback_pending = true;
+        } else if (event->reason == WIFI_REASON_AUTH_FAIL) {
+            unlock_state();
             ESP_LOGE(TAG, "Nieprawidłowe hasło. Przerwanie prób łączenia.");
             return;
         }
 
-        if (!is_config_mode) {
-            ESP_LOGI(TAG, "Próba ponownego połączenia z siecią station...");
-            gpio_set_level(BLINK_GPIO, led_state);
-            led_state = !led_state;
-            vTaskDelay(pdMS_TO_TICKS(500));
-            esp_wifi_connect();
-        }
+        schedule_reconnect();
+        unlock_state();
         
     
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) { // Otrzymano adres ip
@@ -60,14 +396,31 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
         char ip_str[16]; 
         esp_ip4addr_ntoa(&event->ip_info.ip, ip_str, sizeof(ip_str)); // Konwersja adresu IP na łańcuch znaków
         ESP_LOGI(TAG, "Uzyskano IP: %s", ip_str);
+        int64_t now_us = esp_timer_get_time();
+        lock_state();
+        reset_backoff(now_us);
+        if (attempt_pending) {
+            attempt_pending = false;
+            if (associated_us != 0) {
+                record_connected(now_us);
+            }
+            update_ap_cache();
+        }
+        unlock_state();
+        boot_phase_done(BOOT_PHASE_WIFI_IP);
+        start_time_sync();
 
         if (!wifi_connected) {  
             wifi_connected = true;
         
             ESP_LOGI(TAG, "Stan wifi_connected zmieniony na: %d", wifi_connected);
-            vTaskDelay(pdMS_TO_TICKS(100));
-            ESP_LOGI(TAG, "Połączono z Wi-Fi. Inicjalizacja MQTT...");
-            mqtt_initialize();
+            if (mqtt_initialized) {
+                ESP_LOGI(TAG, "Połączono z Wi-Fi. Wznawianie połączenia MQTT...");
+                mqtt_notify_network_up();
+            } else {
+                ESP_LOGI(TAG, "Połączono z Wi-Fi. Inicjalizacja MQTT...");
+                mqtt_initialize();
+            }
         }
     }
 }
@@ -84,8 +437,16 @@ void save_wifi_credentials_to_nvs(const char* ssid, const char* password) {
 
     nvs_set_str(nvs_handle, "ssid", ssid);
     nvs_set_str(nvs_handle, "password", password);
+    // Nowa sieć - zapamiętany AP nie jest już aktualny
+    nvs_erase_key(nvs_handle, "bssid");
+    nvs_erase_key(nvs_handle, "channel");
+    nvs_erase_key(nvs_handle, "authmode");
     nvs_commit(nvs_handle);
     nvs_close(nvs_handle);
+    state_lock_init();
+    lock_state();
+    ap_cache.valid = false;
+    unlock_state();
 
     ESP_LOGI("NVS", "Zapisano dane sieci Wi-Fi: SSID=%s", ssid);
 }
@@ -130,14 +491,26 @@ void connect_to_wifi() {
         return;
     }
 
-    wifi_config_t wifi_config = {};
-    strncpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
-    strncpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
-
-    ESP_LOGI(TAG, "Łączenie do Wi-Fi: SSID=%s", ssid);
+    ap_cache_t cache;
+    load_ap_cache(&cache);
+    if (cache.valid) {
+        ESP_LOGI(TAG, "Łączenie do Wi-Fi: SSID=%s, AP " MACSTR " (kanał %u)", ssid,
+                 MAC2STR(cache.bssid), cache.channel);
+    } else {
+        ESP_LOGI(TAG, "Łączenie do Wi-Fi: SSID=%s (pełny skan)", ssid);
+    }
 
+    state_lock_init();
+    lock_state();
+    memset(&sta_config, 0, sizeof(sta_config));
+    strncpy((char *)sta_config.sta.ssid, ssid, sizeof(sta_config.sta.ssid) - 1);
+    strncpy((char *)sta_config.sta.password, password, sizeof(sta_config.sta.password) - 1);
+    ap_cache = cache;
+    fallback_pending = false;
+    apply_sta_config(ap_cache.valid);
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &sta_config));
+    unlock_state();
     ESP_ERROR_CHECK(esp_wifi_start());
 
     ESP_LOGI(TAG, "Konfiguracja Wi-Fi zakończona.");
@@ -156,8 +529,20 @@ void wifi_init_sta(void)
 
     wifi_event_group = xEventGroupCreate(); // Grupa zdarzeń do śledzenia stanu połączenia
 
+    state_lock_init();
+    if (reconnect_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = reconnect_timer_callback,
+            .name = "wifi_reconnect"
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &reconnect_timer));
+    }
+
     
-    esp_netif_create_default_wifi_sta(); // domyślny interfejs sieciowy
+    sta_netif = esp_netif_create_default_wifi_sta(); // domyślny interfejs sieciowy
+#if CONFIG_MONITOR_WIFI_STATIC_IP
+    apply_static_ip(sta_netif);
+#endif
 
 
     esp_event_handler_instance_t instance_any_id;
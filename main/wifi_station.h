@@ -2,6 +2,29 @@
 #define WIFI_STATION_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+/** Próby połączenia z Wi-Fi, czasy od rozpoczęcia próby do uzyskania IP i przerwy w połączeniu. */
+typedef struct {
+    uint32_t attempts;          ///< Wszystkie próby (esp_wifi_connect)
+    uint32_t directed_attempts; ///< Próby z zapamiętanym BSSID i kanałem
+    uint32_t fallbacks;         ///< Nieudane próby bezpośrednie zakończone pełnym skanem
+    uint32_t connects;          ///< Próby zakończone uzyskaniem IP
+    uint32_t directed_connects;
+    uint32_t last_assoc_ms;     ///< Od próby do asocjacji z AP
+    uint32_t last_dhcp_ms;      ///< Od asocjacji do uzyskania IP
+    uint32_t max_dhcp_ms;
+    uint64_t total_dhcp_ms;
+    uint64_t directed_total_ms; ///< Suma czasów próba -> IP dla połączeń bezpośrednich
+    uint64_t total_scan_ms;     ///< Suma czasów próba -> IP dla połączeń po pełnym skanie
+    uint32_t reconnects;        ///< Próby uruchomione przez timer ponownego łączenia
+    uint32_t backoff_ms;        ///< Ostatnie opóźnienie przed próbą (z rozrzutem)
+    uint32_t outages;           ///< Zakończone przerwy (utrata IP -> ponowne IP)
+    uint32_t outage_ms;         ///< Trwająca przerwa (0 - połączenie działa)
+    uint32_t last_outage_ms;
+    uint32_t max_outage_ms;
+    uint64_t total_outage_ms;
+} wifi_reconnect_stats_t;
 
 extern bool wifi_connected; 
 extern bool is_config_mode;
@@ -10,4 +33,5 @@ void wifi_init_sta(void);
 void connect_to_wifi() ;
 void connect_to_wifi_task(void *pvParameter);
 void save_wifi_credentials_to_nvs(const char* ssid, const char* password);
+void wifi_get_reconnect_stats(wifi_reconnect_stats_t *stats);
 #endif
@@ -0,0 +1,161 @@
+#include "work_queue.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "task_table.h"
+#include "power.h"
+
+static const char *TAG = "work_queue";
+
+typedef struct {
+    work_fn_t fn;
+    void *arg;
+    const char *name;
+    uint32_t posted_us;
+} work_item_t;
+
+static StaticQueue_t queue_buffers[WORK_PRIORITY_COUNT];
+static uint8_t queue_storage[WORK_PRIORITY_COUNT][WORK_QUEUE_LENGTH * sizeof(work_item_t)];
+static QueueHandle_t queues[WORK_PRIORITY_COUNT];
+static TaskHandle_t worker_task = NULL;
+
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static work_queue_stats_t stats[WORK_PRIORITY_COUNT];
+
+static const char *priority_names[WORK_PRIORITY_COUNT] = { "wysoki", "normalny", "niski" };
+
+// Wywoływana w sekcji krytycznej
+static void IRAM_ATTR record_post(work_priority_t priority, bool ok, uint32_t depth) {
+    if (!ok) {
+        stats[priority].dropped++;
+        return;
+    }
+    stats[priority].posted++;
+    if (depth > stats[priority].max_depth) {
+        stats[priority].max_depth = depth;
+    }
+}
+
+static void record_run(work_priority_t priority, const work_item_t *item, uint32_t wait_us, uint32_t exec_us) {
+    taskENTER_CRITICAL(&stats_mux);
+    work_queue_stats_t *s = &stats[priority];
+    s->executed++;
+    s->total_exec_us += exec_us;
+    if (wait_us > s->max_wait_us) {
+        s->max_wait_us = wait_us;
+    }
+    if (exec_us > s->max_exec_us) {
+        s->max_exec_us = exec_us;
+        s->slowest = item->name;
+    }
+    taskEXIT_CRITICAL(&stats_mux);
+}
+
+// Pierwsza praca z kolejki o najwyższym priorytecie
+static bool take_next(work_item_t *item, work_priority_t *priority) {
+    for (int p = 0; p < WORK_PRIORITY_COUNT; p++) {
+        if (xQueueReceive(queues[p], item, 0) == pdTRUE) {
+            *priority = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void work_queue_task(void *arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        work_item_t item;
+        work_priority_t priority;
+        power_lock_acquire(POWER_LOCK_WORK);
+        while (take_next(&item, &priority)) {
+            uint32_t start_us = (uint32_t)esp_timer_get_time();
+            item.fn(item.arg);
+            uint32_t end_us = (uint32_t)esp_timer_get_time();
+            record_run(priority, &item, start_us - item.posted_us, end_us - start_us);
+            ESP_LOGD(TAG, "%s: oczekiwanie %lu us, wykonanie %lu us", item.name, start_us - item.posted_us,
+                     end_us - start_us);
+        }
+        power_lock_release(POWER_LOCK_WORK);
+    }
+}
+
+esp_err_t work_queue_start(void) {
+    if (worker_task != NULL) {
+        return ESP_OK;
+    }
+    for (int p = 0; p < WORK_PRIORITY_COUNT; p++) {
+        queues[p] = xQueueCreateStatic(WORK_QUEUE_LENGTH, sizeof(work_item_t), queue_storage[p], &queue_buffers[p]);
+    }
+    worker_task = task_table_create(TASK_WORK_QUEUE, work_queue_task, NULL);
+    if (worker_task == NULL) {
+        ESP_LOGE(TAG, "Nie udało się utworzyć taska roboczego.");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+bool work_queue_post(work_priority_t priority, work_fn_t fn, void *arg, const char *name) {
+    if (worker_task == NULL || priority >= WORK_PRIORITY_COUNT) {
+        return false;
+    }
+    work_item_t item = { .fn = fn, .arg = arg, .name = name, .posted_us = (uint32_t)esp_timer_get_time() };
+    bool ok = xQueueSend(queues[priority], &item, 0) == pdTRUE;
+    uint32_t depth = uxQueueMessagesWaiting(queues[priority]);
+
+    taskENTER_CRITICAL(&stats_mux);
+    record_post(priority, ok, depth);
+    taskEXIT_CRITICAL(&stats_mux);
+
+    if (ok) {
+        xTaskNotifyGive(worker_task);
+    } else {
+        ESP_LOGW(TAG, "Kolejka prac (%s) pełna - pominięto: %s", priority_names[priority], name);
+    }
+    return ok;
+}
+
+bool IRAM_ATTR work_queue_post_from_isr(work_priority_t priority, work_fn_t fn, void *arg, const char *name,
+                                        BaseType_t *higher_priority_task_woken) {
+    if (worker_task == NULL || priority >= WORK_PRIORITY_COUNT) {
+        return false;
+    }
+    work_item_t item = { .fn = fn, .arg = arg, .name = name, .posted_us = (uint32_t)esp_timer_get_time() };
+    bool ok = xQueueSendFromISR(queues[priority], &item, higher_priority_task_woken) == pdTRUE;
+    uint32_t depth = uxQueueMessagesWaitingFromISR(queues[priority]);
+
+    taskENTER_CRITICAL_ISR(&stats_mux);
+    record_post(priority, ok, depth);
+    taskEXIT_CRITICAL_ISR(&stats_mux);
+
+    if (ok) {
+        vTaskNotifyGiveFromISR(worker_task, higher_priority_task_woken);
+    }
+    return ok;
+}
+
+void work_queue_get_stats(work_priority_t priority, work_queue_stats_t *out) {
+    if (priority >= WORK_PRIORITY_COUNT) {
+        return;
+    }
+    taskENTER_CRITICAL(&stats_mux);
+    *out = stats[priority];
+    taskEXIT_CRITICAL(&stats_mux);
+}
+
+void work_queue_log_stats(void) {
+    for (int p = 0; p < WORK_PRIORITY_COUNT; p++) {
+        work_queue_stats_t s;
+        work_queue_get_stats(p, &s);
+        if (s.posted == 0 && s.dropped == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "Priorytet %s: dodane %lu, odrzucone %lu, max w kolejce %lu/%d, max oczekiwanie %lu us, "
+                 "wykonanie śr. %lu us, max %lu us (%s)", priority_names[p], s.posted, s.dropped, s.max_depth,
+                 WORK_QUEUE_LENGTH, s.max_wait_us, s.executed ? (unsigned long)(s.total_exec_us / s.executed) : 0UL,
+                 s.max_exec_us, s.slowest ? s.slowest : "-");
+    }
+}
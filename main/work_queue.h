@@ -0,0 +1,58 @@
+/**
+ * @file work_queue.h
+ * Kolejka prac odroczonych wykonywanych przez jeden task roboczy.
+ *
+ * Przerwania i callbacki esp_timer (wspólny task wszystkich timerów) nie mogą
+ * blokować - zamiast startować Wi-Fi, czekać na BMP280 czy przełączać tryb pracy,
+ * tylko dodają pracę do kolejki. Task roboczy wykonuje prace po kolei, zawsze
+ * najpierw z kolejki o najwyższym priorytecie; w obrębie priorytetu - w kolejności
+ * dodania. Praca może blokować, ale opóźnia wtedy kolejne prace.
+ */
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#define WORK_QUEUE_LENGTH 8 // Prace oczekujące w każdym priorytecie
+
+typedef enum {
+    WORK_PRIORITY_HIGH = 0, ///< Zmiana trybu pracy
+    WORK_PRIORITY_NORMAL,   ///< Pomiary na żądanie
+    WORK_PRIORITY_LOW,
+    WORK_PRIORITY_COUNT
+} work_priority_t;
+
+typedef void (*work_fn_t)(void *arg);
+
+typedef struct {
+    uint32_t posted;
+    uint32_t dropped;       ///< Odrzucone przy pełnej kolejce
+    uint32_t executed;
+    uint32_t max_depth;     ///< Największa liczba oczekujących prac
+    uint32_t max_wait_us;   ///< Najdłuższy czas od dodania do rozpoczęcia
+    uint32_t max_exec_us;   ///< Najdłuższe wykonanie
+    uint64_t total_exec_us;
+    const char *slowest;    ///< Nazwa pracy o najdłuższym wykonaniu
+} work_queue_stats_t;
+
+/** Tworzy kolejki i task roboczy. Wywołać przed włączeniem przerwań, które dodają prace. */
+esp_err_t work_queue_start(void);
+
+/**
+ * Dodaje pracę bez czekania na miejsce w kolejce.
+ * @param name Nazwa do statystyk (literał).
+ * @return false, gdy kolejka jest pełna lub nie została uruchomiona.
+ */
+bool work_queue_post(work_priority_t priority, work_fn_t fn, void *arg, const char *name);
+
+/** Jak work_queue_post(), z procedury obsługi przerwania. */
+bool work_queue_post_from_isr(work_priority_t priority, work_fn_t fn, void *arg, const char *name,
+                              BaseType_t *higher_priority_task_woken);
+
+void work_queue_get_stats(work_priority_t priority, work_queue_stats_t *stats);
+void work_queue_log_stats(void);
+
+#endif // WORK_QUEUE_H
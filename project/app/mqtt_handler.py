@@ -1,4 +1,6 @@
 import json
+import math
+import struct
 from time import sleep
 from paho.mqtt.client import Client
 from app.extensions import socketio
@@ -8,6 +10,9 @@ from app.database import get_user_devices, get_device_sensors, get_sensor_metric
 # Inicjalizacja klienta MQTT
 mqtt_client = Client()
 
+_FLOAT32 = struct.Struct('>f')
+_FLOAT64 = struct.Struct('>d')
+
 # Wczytanie konfiguracji MQTT z pliku
 def load_mqtt_config():
     try:
@@ -34,16 +39,175 @@ def on_connect(client, userdata, flags, rc):
     else:
         print(f"Failed to connect to MQTT broker. Return code: {rc}")
 
+# Dekoder CBOR (RFC 8949) dla danych z urządzeń z payload_format "cbor".
+# Obsługuje typy wysyłane przez cbor_writer.c: liczby, tekst, tablice, mapy i float.
+class CBORDecodeError(ValueError):
+    pass
+
+def _cbor_half(bits):
+    exp = (bits >> 10) & 0x1F
+    mant = bits & 0x3FF
+    if exp == 0:
+        value = math.ldexp(mant, -24)
+    elif exp == 31:
+        value = math.inf if mant == 0 else math.nan
+    else:
+        value = math.ldexp(mant + 1024, exp - 25)
+    return -value if bits & 0x8000 else value
+
+def _cbor_item(buf, pos):
+    initial = buf[pos]
+    major, info = initial >> 5, initial & 0x1F
+    pos += 1
+
+    if major == 7:
+        if info == 25:
+            return _cbor_half(int.from_bytes(buf[pos:pos + 2], 'big')), pos + 2
+        if info == 26:
+            # Zaokrąglenie do precyzji float32, żeby 21.53 nie stało się 21.530000686645508
+            return float('%.7g' % _FLOAT32.unpack_from(buf, pos)[0]), pos + 4
+        if info == 27:
+            return _FLOAT64.unpack_from(buf, pos)[0], pos + 8
+        if info in (20, 21, 22):
+            return (False, True, None)[info - 20], pos
+        raise CBORDecodeError(f"unsupported simple value {info}")
+
+    if info < 24:
+        arg = info
+    elif info <= 27:
+        size = 1 << (info - 24)
+        if pos + size > len(buf):
+            raise CBORDecodeError("truncated")
+        arg = int.from_bytes(buf[pos:pos + size], 'big')
+        pos += size
+    else:
+        raise CBORDecodeError("indefinite length not supported")
+
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major in (2, 3):
+        if pos + arg > len(buf):
+            raise CBORDecodeError("truncated")
+        chunk = bytes(buf[pos:pos + arg])
+        return (chunk if major == 2 else chunk.decode('utf-8')), pos + arg
+    if major == 4:
+        items = []
+        for _ in range(arg):
+            item, pos = _cbor_item(buf, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        result = {}
+        for _ in range(arg):
+            key, pos = _cbor_item(buf, pos)
+            result[key], pos = _cbor_item(buf, pos)
+        return result, pos
+    raise CBORDecodeError(f"unsupported major type {major}")
+
+def decode_cbor(payload):
+    try:
+        value, end = _cbor_item(payload, 0)
+    except (IndexError, struct.error) as e:
+        raise CBORDecodeError("truncated") from e
+    if end != len(payload):
+        raise CBORDecodeError("trailing bytes")
+    return value
+
+# Dekoder paczek próbek (format opisany w main/gorilla_chunk.h):
+# znaczniki czasu jako delta-of-delta, wartości float32 jako XOR z poprzednią.
+GORILLA_CHUNK_MAGIC = 0x47
+GORILLA_CHUNK_VERSION = 1
+GORILLA_CHUNK_FLAG_INTEGER = 0x01
+_GORILLA_HEADER = struct.Struct('<BBBHI')
+_GORILLA_DOD_WIDTHS = (0, 7, 9, 12, 32)
+
+class ChunkDecodeError(ValueError):
+    pass
+
+def decode_chunk(payload):
+    if len(payload) < _GORILLA_HEADER.size:
+        raise ChunkDecodeError("truncated header")
+    magic, version, flags, count, ts = _GORILLA_HEADER.unpack_from(payload)
+    if magic != GORILLA_CHUNK_MAGIC or version != GORILLA_CHUNK_VERSION:
+        raise ChunkDecodeError(f"unsupported chunk version {version}")
+
+    # Cały strumień jako jedna liczba - odczyt bitów przesunięciem zamiast pętli po bitach
+    stream = payload[_GORILLA_HEADER.size:]
+    total = len(stream) * 8
+    bits = int.from_bytes(stream, 'big')
+    pos = 0
+
+    def read(width):
+        nonlocal pos
+        if pos + width > total:
+            raise ChunkDecodeError("truncated stream")
+        pos += width
+        return (bits >> (total - pos)) & ((1 << width) - 1)
+
+    points = []
+    delta = 0
+    leading = trailing = None
+    value = 0
+    for i in range(count):
+        if i == 0:
+            value = read(32)
+        else:
+            ones = 0
+            while ones < 4 and read(1):
+                ones += 1
+            if ones:
+                width = _GORILLA_DOD_WIDTHS[ones]
+                raw = read(width)
+                delta += raw - (1 << width) if raw & (1 << (width - 1)) else raw
+            ts = (ts + delta) & 0xFFFFFFFF
+
+            if read(1):
+                if read(1):
+                    leading = read(5)
+                    length = read(5) + 1
+                    if leading + length > 32:
+                        raise ChunkDecodeError("invalid window")
+                    trailing = 32 - leading - length
+                elif leading is None:
+                    raise ChunkDecodeError("missing window")
+                value ^= read(32 - leading - trailing) << trailing
+
+        number = _FLOAT32.unpack(value.to_bytes(4, 'big'))[0]
+        if flags & GORILLA_CHUNK_FLAG_INTEGER:
+            number = int(number)
+        else:
+            number = float('%.7g' % number)
+        points.append((ts, number))
+    return points
+
+def decode_payload(topic, payload):
+    # Zwraca listę punktów - paczka rozwija się w wiele punktów, pozostałe formaty w jeden.
+    # Paczka zaczyna się od 'G' (0x47), mapa CBOR bajtem 0xA0-0xBF, JSON od '{' lub cyfry.
+    metric = topic.rsplit('/', 1)[-1]
+    if payload and payload[0] == GORILLA_CHUNK_MAGIC:
+        return [{metric: value, 'ts': ts} for ts, value in decode_chunk(payload)]
+    if payload and 0xA0 <= payload[0] <= 0xBF:
+        data = decode_cbor(payload)
+    else:
+        data = json.loads(payload.decode())
+    if isinstance(data, (int, float)):
+        # Format "numeric" - sama wartość, nazwa metryki to ostatni człon tematu
+        data = {metric: data}
+    return [data]
+
 # Funkcja obsługi wiadomości MQTT
 def on_message(client, userdata, msg):
     try:
-        print(f"Message received on topic {msg.topic}: {msg.payload.decode()}")
-        data = json.loads(msg.payload.decode())
+        points = decode_payload(msg.topic, msg.payload)
+        print(f"Message received on topic {msg.topic}: {points if len(points) > 1 else points[0]}")
 
         # Emitowanie wiadomości do frontend-u za pomocą Flask-SocketIO
-        socketio.emit('mqtt_message', {'topic': msg.topic, 'data': data}, namespace='/')
-    except json.JSONDecodeError:
-        print(f"Error decoding message: {msg.payload.decode()}")
+        for data in points:
+            socketio.emit('mqtt_message', {'topic': msg.topic, 'data': data}, namespace='/')
+    except (json.JSONDecodeError, UnicodeDecodeError, CBORDecodeError, ChunkDecodeError):
+        print(f"Error decoding message on topic {msg.topic}: {msg.payload!r}")
 
 # Funkcja konfiguracji klienta MQTT
 def setup_mqtt(user_id=None):
@@ -39,6 +39,60 @@ def set_light_range():
         return jsonify({"message": "Light range updated and published successfully!"}), 200
     return jsonify({"error": "Invalid data"}), 400
 
+# Ustawianie progów raportowania (deadband, interwały) dla metryki
+@config_bp.route('/set_report_config', methods=['POST'])
+def set_report_config():
+    data = request.get_json()
+    required = ['user_id', 'device_id', 'sensor_id', 'metric_id']
+
+    if data and all(data.get(key) is not None for key in required):
+        payload = {key: str(data[key]) for key in required}
+        for key in ['deadband', 'deadband_percent', 'min_interval', 'max_interval']:
+            if data.get(key) is not None:
+                payload[key] = data[key]
+
+        topic = '/system/settings/report'
+        mqtt_client.publish(topic, json.dumps(payload))
+        print(f"Published to {topic}: {payload}")
+        return jsonify({"message": "Report configuration published successfully!"}), 200
+    return jsonify({"error": "Invalid data"}), 400
+
+# Format danych urządzenia: "json", "numeric" (sama wartość), "cbor" (binarny)
+# lub "chunk" (paczki próbek z kompresją delta/XOR)
+@config_bp.route('/set_payload_format', methods=['POST'])
+def set_payload_format():
+    data = request.get_json()
+
+    if data and data.get('user_id') is not None and data.get('device_id') is not None \
+            and data.get('payload_format') in ('json', 'numeric', 'cbor', 'chunk'):
+        topic = '/system/add_device'
+        payload = json.dumps({"user_id": str(data['user_id']), "device_id": str(data['device_id']),
+                              "payload_format": data['payload_format']})
+        mqtt_client.publish(topic, payload)
+        print(f"Published to {topic}: {payload}")
+        return jsonify({"message": "Payload format published successfully!"}), 200
+    return jsonify({"error": "Invalid data"}), 400
+
+# Interwały pomiarów (w sekundach) dla poszczególnych czujników
+@config_bp.route('/set_intervals', methods=['POST'])
+def set_intervals():
+    data = request.get_json()
+    sources = ['bmp280', 'photoresistor', 'ble']
+
+    if data and any(data.get(key) is not None for key in sources):
+        try:
+            payload = {key: int(data[key]) for key in sources if data.get(key) is not None}
+        except (TypeError, ValueError):
+            return jsonify({"error": "Invalid data"}), 400
+        if any(value < 1 or value > 24 * 60 * 60 for value in payload.values()):
+            return jsonify({"error": "Interval must be between 1 s and 24 h"}), 400
+
+        topic = '/system/settings/intervals'
+        mqtt_client.publish(topic, json.dumps(payload))
+        print(f"Published to {topic}: {payload}")
+        return jsonify({"message": "Sampling intervals published successfully!"}), 200
+    return jsonify({"error": "Invalid data"}), 400
+
 
 def load_config(file_path):
     try:
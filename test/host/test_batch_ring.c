@@ -0,0 +1,101 @@
+// Pierścień trybu rejestratora (batch_ring.h): wykrywanie niezainicjowanej pamięci RTC,
+// kolejność rekordów, nadpisywanie najstarszych i częściowe zużycie po publikacji.
+#include "batch_ring.h"
+#include "test_util.h"
+
+static batch_ring_t ring;
+
+static void test_validity(void) {
+    // Pamięć RTC po zimnym starcie ma przypadkową zawartość
+    memset(&ring, 0xa5, sizeof(ring));
+    CHECK(!batch_ring_valid(&ring));
+    batch_ring_reset(&ring);
+    CHECK(batch_ring_valid(&ring));
+    CHECK_EQ(ring.count, 0);
+    CHECK_EQ(ring.dropped, 0);
+    CHECK(batch_ring_last(&ring) == NULL);
+    CHECK(batch_ring_at(&ring, 0) == NULL);
+
+    // Inna wersja formatu lub pojemność
+    ring.magic ^= 1;
+    CHECK(!batch_ring_valid(&ring));
+    batch_ring_reset(&ring);
+    ring.capacity = BATCH_RING_CAPACITY / 2;
+    CHECK(!batch_ring_valid(&ring));
+    batch_ring_reset(&ring);
+    ring.head = BATCH_RING_CAPACITY;
+    CHECK(!batch_ring_valid(&ring));
+    batch_ring_reset(&ring);
+    ring.count = BATCH_RING_CAPACITY + 1;
+    CHECK(!batch_ring_valid(&ring));
+}
+
+static void push(uint32_t timestamp) {
+    batch_record_t *rec = batch_ring_push(&ring);
+    CHECK_EQ(rec->light, 0); // rekord jest wyzerowany
+    rec->timestamp = timestamp;
+    rec->temperature = (float)timestamp / 10.0f;
+    rec->light = (uint16_t)timestamp;
+}
+
+static void test_push_and_wrap(void) {
+    batch_ring_reset(&ring);
+    for (uint32_t i = 1; i <= 10; i++) {
+        push(i);
+    }
+    CHECK_EQ(ring.count, 10);
+    CHECK_EQ(batch_ring_last(&ring)->timestamp, 10);
+    CHECK_EQ(batch_ring_at(&ring, 0)->timestamp, 1);
+    CHECK(batch_ring_at(&ring, 10) == NULL);
+
+    // Uzupełnienie pola ostatniego rekordu (wake_ms po zakończeniu pobudki)
+    batch_ring_last(&ring)->wake_ms = 120;
+    CHECK_EQ(batch_ring_at(&ring, 9)->wake_ms, 120);
+
+    // Przepełnienie: zostaje BATCH_RING_CAPACITY najnowszych
+    for (uint32_t i = 11; i <= BATCH_RING_CAPACITY + 25; i++) {
+        push(i);
+    }
+    CHECK_EQ(ring.count, BATCH_RING_CAPACITY);
+    CHECK_EQ(ring.dropped, 25);
+    CHECK(batch_ring_valid(&ring));
+    for (uint16_t i = 0; i < BATCH_RING_CAPACITY; i++) {
+        CHECK_EQ(batch_ring_at(&ring, i)->timestamp, 26 + i);
+    }
+    CHECK_EQ(batch_ring_last(&ring)->timestamp, BATCH_RING_CAPACITY + 25);
+}
+
+static void test_consume(void) {
+    batch_ring_reset(&ring);
+    for (uint32_t i = 1; i <= BATCH_RING_CAPACITY; i++) {
+        push(i);
+    }
+    // Publikacja części rekordów (np. przerwana po pierwszej paczce)
+    batch_ring_consume(&ring, 40);
+    CHECK_EQ(ring.count, BATCH_RING_CAPACITY - 40);
+    CHECK_EQ(batch_ring_at(&ring, 0)->timestamp, 41);
+
+    // Nowe rekordy po zużyciu trafiają za istniejące, bez utraty
+    for (uint32_t i = 1; i <= 40; i++) {
+        push(1000 + i);
+    }
+    CHECK_EQ(ring.count, BATCH_RING_CAPACITY);
+    CHECK_EQ(ring.dropped, 0);
+    CHECK_EQ(batch_ring_at(&ring, BATCH_RING_CAPACITY - 41)->timestamp, BATCH_RING_CAPACITY);
+    CHECK_EQ(batch_ring_at(&ring, BATCH_RING_CAPACITY - 40)->timestamp, 1001);
+
+    // Zużycie więcej niż jest - pierścień pusty, ale poprawny
+    batch_ring_consume(&ring, UINT16_MAX);
+    CHECK_EQ(ring.count, 0);
+    CHECK(batch_ring_valid(&ring));
+    CHECK(batch_ring_last(&ring) == NULL);
+    push(7);
+    CHECK_EQ(batch_ring_at(&ring, 0)->timestamp, 7);
+}
+
+int main(void) {
+    test_validity();
+    test_push_and_wrap();
+    test_consume();
+    TEST_DONE();
+}
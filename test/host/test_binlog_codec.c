@@ -0,0 +1,137 @@
+// Kodek dziennika binarnego (binlog_codec.h): tekst z binlog_pack() + binlog_format()
+// identyczny z vsnprintf, obcinanie napisów, brakujące argumenty oraz koszt zapisu
+// argumentów w porównaniu z formatowaniem tekstu.
+#include "binlog_codec.h"
+#include "test_util.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <limits.h>
+
+static size_t pack(uint8_t *out, size_t out_size, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    size_t len = binlog_pack(out, out_size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+// Porównuje wpis odtworzony z argumentów binarnych z wynikiem vsnprintf
+__attribute__((format(printf, 2, 3)))
+static void check_like_snprintf(int line, const char *fmt, ...) {
+    uint8_t packed[BINLOG_ARGS_MAX];
+    char ours[256], ref[256];
+    va_list args, copy;
+    va_start(args, fmt);
+    va_copy(copy, args);
+    size_t len = binlog_pack(packed, sizeof(packed), fmt, args);
+    vsnprintf(ref, sizeof(ref), fmt, copy);
+    va_end(copy);
+    va_end(args);
+
+    binlog_format(ours, sizeof(ours), fmt, packed, len);
+    if (strcmp(ours, ref) != 0) {
+        fprintf(stderr, "%s:%d: \"%s\": \"%s\", vsnprintf: \"%s\"\n", __FILE__, line, fmt, ours, ref);
+        test_failures++;
+    }
+}
+
+#define CHECK_LIKE_SNPRINTF(...) check_like_snprintf(__LINE__, __VA_ARGS__)
+
+static void test_conversions(void) {
+    int value = 7;
+    CHECK_LIKE_SNPRINTF("bez argumentów, 100%% gotowe");
+    CHECK_LIKE_SNPRINTF("%d %i %u %o %x %X %c", -42, 17, 4000000000u, 8, 255, 0xabc, 'q');
+    CHECK_LIKE_SNPRINTF("[%5d] [%-5d] [%05d] [%+d] [% d] [%#x] [%#o] [%.3d]", 42, 42, 42, 42, 42, 255, 8, 5);
+    CHECK_LIKE_SNPRINTF("%hhd %hhu %hd %hu", 300, 300, 70000, 70000);
+    CHECK_LIKE_SNPRINTF("%ld %lu %lld %llu %llx", -1234567890L, 4000000000UL, LLONG_MIN, ULLONG_MAX, 0xdeadbeefcafeULL);
+    CHECK_LIKE_SNPRINTF("%zu %zd %jd %ju %td", (size_t)123456, (ptrdiff_t)-5, INTMAX_MIN, UINTMAX_MAX, (ptrdiff_t)-77);
+    CHECK_LIKE_SNPRINTF("%f %.2f %10.3f %-10.1f| %e %E %g %G", 21.53, 1013.25, -0.5, 3.25, 12345.678, 1e-9, 0.0001, 1e20);
+    CHECK_LIKE_SNPRINTF("%a %A %.0f %+.1e", 1.0, -0.1, 2.5, 6.02e23);
+    CHECK_LIKE_SNPRINTF("%s|%10s|%-6s|%.2s|", "bmp280", "lux", "ok", "truncate");
+    CHECK_LIKE_SNPRINTF("%p %p", (void *)&value, (void *)NULL);
+    // Cztery wartości float, jak odczyt czujnika światła
+    CHECK_LIKE_SNPRINTF("Napięcie: %.3f V, rezystancja: %.1f Ohm, lux: %.2f (surowy %d) %f", 1.234f, 10234.5f,
+                        356.78f, 2048, 0.1f);
+    CHECK_LIKE_SNPRINTF("Publikacja: temat=%s, dane=%s, qos=%d, msg_id=%d", "/user1/device1/bmp280/temperature",
+                        "{\"temperature\": 21.53}", 1, 12345);
+}
+
+static void test_long_strings(void) {
+    char long_text[100];
+    memset(long_text, 'a', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+
+    uint8_t packed[BINLOG_ARGS_MAX];
+    char out[128];
+    size_t len = pack(packed, sizeof(packed), "[%s]", long_text);
+    CHECK_EQ(len, 1 + BINLOG_STR_MAX);
+    binlog_format(out, sizeof(out), "[%s]", packed, len);
+    CHECK_EQ(strlen(out), BINLOG_STR_MAX + 2);
+    CHECK_EQ(out[BINLOG_STR_MAX + 1], ']');
+
+    const char *null_text = NULL;
+    len = pack(packed, sizeof(packed), "%s|%s", null_text, "");
+    CHECK_EQ(len, 2);
+    binlog_format(out, sizeof(out), "%s|%s", packed, len);
+    CHECK_STR(out, "(null)|");
+}
+
+static void test_missing_and_invalid(void) {
+    uint8_t packed[BINLOG_ARGS_MAX];
+    char out[128];
+
+    // Argumenty, które się nie zmieściły, są zastępowane przez "?"
+    size_t len = pack(packed, 12, "%d %lld %d %s", 1, 2LL, 3, "x");
+    CHECK_EQ(len, sizeof(int) + sizeof(long long));
+    binlog_format(out, sizeof(out), "%d %lld %d %s", packed, len);
+    CHECK_STR(out, "1 2 ? ?");
+    binlog_format(out, sizeof(out), "a=%d b=%s", packed, 0);
+    CHECK_STR(out, "a=? b=?");
+
+    // Szerokość '*' i %n: reszta ciągu bez zmian, bez pobierania argumentów
+    len = pack(packed, sizeof(packed), "%d %*d %d", 5, 3, 4, 6);
+    CHECK_EQ(len, sizeof(int));
+    binlog_format(out, sizeof(out), "%d %*d %d", packed, len);
+    CHECK_STR(out, "5 %*d %d");
+    binlog_format(out, sizeof(out), "koniec %", packed, 0);
+    CHECK_STR(out, "koniec %");
+
+    // Obcięcie do rozmiaru bufora wyjściowego
+    len = pack(packed, sizeof(packed), "%s=%d", "temperature", 2153);
+    CHECK_EQ(binlog_format(out, 8, "%s=%d", packed, len), 7);
+    CHECK_STR(out, "tempera");
+    CHECK_EQ(binlog_format(out, 14, "%s=%d", packed, len), 13);
+    CHECK_STR(out, "temperature=2");
+    CHECK_EQ(binlog_format(out, 0, "%s=%d", packed, len), 0);
+}
+
+// Koszt w miejscu wywołania: zapis argumentów kontra sformatowanie tekstu
+static void bench_pack(void) {
+    static const char *fmt = "Napięcie: %.3f V, rezystancja: %.1f Ohm, lux: %.2f, ADC %d";
+    const int n = 1000000;
+    uint8_t packed[BINLOG_ARGS_MAX];
+    char text[128];
+    volatile size_t sink = 0;
+
+    double t0 = test_now_s();
+    for (int i = 0; i < n; i++) {
+        sink += pack(packed, sizeof(packed), fmt, 1.234 + i * 1e-6, 10234.5, 356.78, i);
+    }
+    double pack_ns = (test_now_s() - t0) * 1e9 / n;
+
+    t0 = test_now_s();
+    for (int i = 0; i < n; i++) {
+        sink += (size_t)snprintf(text, sizeof(text), fmt, 1.234 + i * 1e-6, 10234.5, 356.78, i);
+    }
+    double format_ns = (test_now_s() - t0) * 1e9 / n;
+    (void)sink;
+    printf("binlog_pack %.1f ns, snprintf %.1f ns (%.1fx)\n", pack_ns, format_ns, format_ns / pack_ns);
+}
+
+int main(void) {
+    test_conversions();
+    test_long_strings();
+    test_missing_and_invalid();
+    bench_pack();
+    TEST_DONE();
+}
@@ -0,0 +1,162 @@
+// Koder CBOR (cbor_writer.h): wektory z RFC 8949, dodatek A, wybór half/single
+// i obsługa przepełnienia bufora.
+#include "cbor_writer.h"
+#include "test_util.h"
+#include <math.h>
+
+static uint8_t buf[64];
+
+#define CHECK_ENCODED(w, ...) do { \
+        static const uint8_t expected_[] = { __VA_ARGS__ }; \
+        CHECK_EQ(cbor_writer_finish(w), sizeof(expected_)); \
+        CHECK_MEM(buf, expected_, sizeof(expected_)); \
+    } while (0)
+
+static cbor_writer_t *fresh(void) {
+    static cbor_writer_t w;
+    memset(buf, 0xee, sizeof(buf));
+    cbor_writer_init(&w, buf, sizeof(buf));
+    return &w;
+}
+
+static void test_integers(void) {
+    cbor_writer_t *w;
+    w = fresh(); cbor_write_uint(w, 0);          CHECK_ENCODED(w, 0x00);
+    w = fresh(); cbor_write_uint(w, 23);         CHECK_ENCODED(w, 0x17);
+    w = fresh(); cbor_write_uint(w, 24);         CHECK_ENCODED(w, 0x18, 0x18);
+    w = fresh(); cbor_write_uint(w, 100);        CHECK_ENCODED(w, 0x18, 0x64);
+    w = fresh(); cbor_write_uint(w, 1000);       CHECK_ENCODED(w, 0x19, 0x03, 0xe8);
+    w = fresh(); cbor_write_uint(w, 1000000);    CHECK_ENCODED(w, 0x1a, 0x00, 0x0f, 0x42, 0x40);
+    w = fresh(); cbor_write_uint(w, 1000000000000ull);
+    CHECK_ENCODED(w, 0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00);
+    w = fresh(); cbor_write_uint(w, UINT64_MAX);
+    CHECK_ENCODED(w, 0x1b, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff);
+    w = fresh(); cbor_write_int(w, 10);          CHECK_ENCODED(w, 0x0a);
+    w = fresh(); cbor_write_int(w, -1);          CHECK_ENCODED(w, 0x20);
+    w = fresh(); cbor_write_int(w, -10);         CHECK_ENCODED(w, 0x29);
+    w = fresh(); cbor_write_int(w, -100);        CHECK_ENCODED(w, 0x38, 0x63);
+    w = fresh(); cbor_write_int(w, -1000);       CHECK_ENCODED(w, 0x39, 0x03, 0xe7);
+    w = fresh(); cbor_write_int(w, INT64_MIN);
+    CHECK_ENCODED(w, 0x3b, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff);
+}
+
+static void test_floats(void) {
+    cbor_writer_t *w;
+    w = fresh(); cbor_write_float(w, 0.0f);      CHECK_ENCODED(w, 0xf9, 0x00, 0x00);
+    w = fresh(); cbor_write_float(w, -0.0f);     CHECK_ENCODED(w, 0xf9, 0x80, 0x00);
+    w = fresh(); cbor_write_float(w, 1.0f);      CHECK_ENCODED(w, 0xf9, 0x3c, 0x00);
+    w = fresh(); cbor_write_float(w, 1.5f);      CHECK_ENCODED(w, 0xf9, 0x3e, 0x00);
+    w = fresh(); cbor_write_float(w, 65504.0f);  CHECK_ENCODED(w, 0xf9, 0x7b, 0xff);
+    w = fresh(); cbor_write_float(w, 5.960464477539063e-8f); CHECK_ENCODED(w, 0xf9, 0x00, 0x01);
+    w = fresh(); cbor_write_float(w, 0.00006103515625f);     CHECK_ENCODED(w, 0xf9, 0x04, 0x00);
+    w = fresh(); cbor_write_float(w, -4.0f);     CHECK_ENCODED(w, 0xf9, 0xc4, 0x00);
+    w = fresh(); cbor_write_float(w, INFINITY);  CHECK_ENCODED(w, 0xf9, 0x7c, 0x00);
+    w = fresh(); cbor_write_float(w, -INFINITY); CHECK_ENCODED(w, 0xf9, 0xfc, 0x00);
+    w = fresh(); cbor_write_float(w, 100000.0f); CHECK_ENCODED(w, 0xfa, 0x47, 0xc3, 0x50, 0x00);
+    w = fresh(); cbor_write_float(w, 3.4028234663852886e+38f);
+    CHECK_ENCODED(w, 0xfa, 0x7f, 0x7f, 0xff, 0xff);
+    // Typowe odczyty czujników nie mieszczą się w half bez straty
+    w = fresh(); cbor_write_float(w, 21.53f);    CHECK_EQ(cbor_writer_finish(w), 5);
+    w = fresh(); cbor_write_float(w, NAN);       CHECK_EQ(cbor_writer_finish(w), 5);
+}
+
+// Wzorcowy dekoder half -> float
+static float half_to_float(uint16_t h) {
+    int exp = (h >> 10) & 0x1f;
+    int mant = h & 0x3ff;
+    float value;
+    if (exp == 0) {
+        value = ldexpf((float)mant, -24);
+    } else if (exp == 31) {
+        value = INFINITY;
+    } else {
+        value = ldexpf((float)(mant + 1024), exp - 25);
+    }
+    return (h & 0x8000) ? -value : value;
+}
+
+// Każda skończona wartość half (i nieskończoności) jest kodowana z powrotem jako ten sam half
+static void test_half_exhaustive(void) {
+    uint32_t mismatches = 0;
+    for (uint32_t h = 0; h <= 0xffff; h++) {
+        if ((h & 0x7c00) == 0x7c00 && (h & 0x3ff)) {
+            continue; // NaN
+        }
+        cbor_writer_t *w = fresh();
+        cbor_write_float(w, half_to_float((uint16_t)h));
+        if (cbor_writer_finish(w) != 3 || buf[0] != 0xf9 || buf[1] != (h >> 8) || buf[2] != (h & 0xff)) {
+            mismatches++;
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+
+    // Wartości pomiędzy sąsiednimi half wymagają single
+    cbor_writer_t *w = fresh();
+    cbor_write_float(w, nextafterf(1.0f, 2.0f));
+    CHECK_EQ(cbor_writer_finish(w), 5);
+    w = fresh();
+    cbor_write_float(w, ldexpf(1.0f, -25)); // poniżej najmniejszej subnormalnej half
+    CHECK_EQ(cbor_writer_finish(w), 5);
+}
+
+static void test_containers(void) {
+    cbor_writer_t *w = fresh();
+    cbor_write_text(w, "");
+    CHECK_ENCODED(w, 0x60);
+    w = fresh();
+    cbor_write_text(w, "IETF");
+    CHECK_ENCODED(w, 0x64, 0x49, 0x45, 0x54, 0x46);
+    w = fresh();
+    cbor_write_text(w, "\xc3\xbc");
+    CHECK_ENCODED(w, 0x62, 0xc3, 0xbc);
+
+    // {"a": 1, "b": [2, 3]}
+    w = fresh();
+    cbor_write_map(w, 2);
+    cbor_write_text(w, "a");
+    cbor_write_uint(w, 1);
+    cbor_write_text(w, "b");
+    cbor_write_array(w, 2);
+    cbor_write_uint(w, 2);
+    cbor_write_uint(w, 3);
+    CHECK_ENCODED(w, 0xa2, 0x61, 0x61, 0x01, 0x61, 0x62, 0x82, 0x02, 0x03);
+
+    w = fresh();
+    cbor_write_array(w, 25);
+    CHECK_ENCODED(w, 0x98, 0x19);
+}
+
+static void test_overflow(void) {
+    // Każdy zbyt mały bufor daje 0 i nie pisze poza cap
+    for (size_t cap = 0; cap < 10; cap++) {
+        uint8_t small[16];
+        memset(small, 0xee, sizeof(small));
+        cbor_writer_t w;
+        cbor_writer_init(&w, small, cap);
+        cbor_write_map(&w, 1);
+        cbor_write_text(&w, "temp");
+        cbor_write_float(&w, 1.5f);
+        CHECK_EQ(cbor_writer_finish(&w), cap == 9 ? 9 : 0);
+        CHECK_EQ(small[cap], 0xee);
+        if (cap < 9) {
+            CHECK(w.overflow);
+        }
+    }
+
+    // Po przepełnieniu kolejne krótsze elementy nie są dopisywane
+    uint8_t small[2];
+    cbor_writer_t w;
+    cbor_writer_init(&w, small, sizeof(small));
+    cbor_write_text(&w, "abc");
+    cbor_write_uint(&w, 1);
+    CHECK_EQ(cbor_writer_finish(&w), 0);
+}
+
+int main(void) {
+    test_integers();
+    test_floats();
+    test_half_exhaustive();
+    test_containers();
+    test_overflow();
+    TEST_DONE();
+}
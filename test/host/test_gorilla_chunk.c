@@ -0,0 +1,235 @@
+// Paczki Gorilla (gorilla_chunk.h): odtworzenie serii bit w bit, skrajne delty i wartości,
+// wycofanie niemieszczącej się próbki, urwany strumień oraz stopień kompresji
+// i przepustowość na seriach podobnych do odczytów czujników.
+#include "gorilla_chunk.h"
+#include "test_util.h"
+#include <math.h>
+
+#define SERIES_LEN 8640          // doba odczytów co 10 s
+#define CHUNK_BUFFER_SIZE 256    // jak w mqtt_publisher.c
+#define CHUNK_MAX_SAMPLES 60
+
+static uint32_t timestamps[SERIES_LEN];
+static float series[3][SERIES_LEN];
+static uint32_t seed = 1;
+
+static double gauss(void) {
+    double u = ((double)test_rand(&seed) + 1.0) / 4294967297.0;
+    double v = ((double)test_rand(&seed) + 1.0) / 4294967297.0;
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// Temperatura z rozdzielczością 0,01 °C, ciśnienie Q24.8 Pa w hPa, jasność z ADC
+static void generate_series(void) {
+    for (uint32_t i = 0; i < SERIES_LEN; i++) {
+        timestamps[i] = 1760000000u + i * 10;
+        if (test_rand(&seed) % 7 == 0) {
+            timestamps[i] += test_rand(&seed) % 3; // sporadyczne opóźnienie odczytu
+        }
+        double hour = i * 10.0 / 3600.0;
+        series[0][i] = roundf((float)(21.5 + 1.5 * sin(2 * M_PI * hour / 24) + 0.02 * gauss()) * 100.0f) / 100.0f;
+        double pa = 101300.0 + 120.0 * sin(2 * M_PI * hour / 30) + 1.5 * gauss();
+        series[1][i] = (float)(round(pa * 256) / 256) / 100.0f;
+        double lux = (hour > 6 && hour < 20) ? 2600.0 * sin(M_PI * (hour - 6) / 14) : 40.0;
+        series[2][i] = (float)(int)fmin(4095.0, fmax(0.0, lux + 25.0 * gauss()));
+    }
+}
+
+// Koduje serię w paczki jak mqtt_publisher.c, każdą dekoduje i porównuje bit w bit.
+// Zwraca łączny rozmiar paczek.
+static size_t roundtrip(const uint32_t *ts, const float *values, size_t n, uint8_t flags,
+                        size_t cap, uint16_t max_samples) {
+    uint8_t buf[1024];
+    size_t total = 0, i = 0;
+    while (i < n) {
+        gorilla_chunk_t chunk;
+        gorilla_chunk_init(&chunk, buf, cap, flags);
+        size_t start = i;
+        while (i < n && chunk.count < max_samples && gorilla_chunk_append(&chunk, ts[i], values[i])) {
+            i++;
+        }
+        CHECK(i > start);
+        if (i == start) {
+            return 0;
+        }
+        size_t len = gorilla_chunk_finish(&chunk);
+        CHECK(len > 0 && len <= cap);
+
+        gorilla_reader_t reader;
+        CHECK(gorilla_reader_init(&reader, buf, len));
+        uint32_t t;
+        float v;
+        size_t k = start;
+        while (gorilla_reader_next(&reader, &t, &v)) {
+            CHECK_EQ(t, ts[k]);
+            CHECK_MEM(&v, &values[k], sizeof(v));
+            k++;
+        }
+        CHECK_EQ(k, i);
+        total += len;
+    }
+    return total;
+}
+
+static void test_header(void) {
+    uint8_t buf[64];
+    gorilla_chunk_t chunk;
+    gorilla_chunk_init(&chunk, buf, sizeof(buf), GORILLA_CHUNK_FLAG_INTEGER);
+    CHECK_EQ(gorilla_chunk_finish(&chunk), 0);
+
+    CHECK(gorilla_chunk_append(&chunk, 0x11223344, 1.0f));
+    size_t len = gorilla_chunk_finish(&chunk);
+    CHECK_EQ(len, GORILLA_CHUNK_HEADER_SIZE + 4);
+    static const uint8_t expected[] = { GORILLA_CHUNK_MAGIC, GORILLA_CHUNK_VERSION, GORILLA_CHUNK_FLAG_INTEGER,
+                                        1, 0, 0x44, 0x33, 0x22, 0x11, 0x3f, 0x80, 0x00, 0x00 };
+    CHECK_MEM(buf, expected, sizeof(expected));
+
+    gorilla_reader_t reader;
+    CHECK(gorilla_reader_init(&reader, buf, len));
+    CHECK_EQ(reader.count, 1);
+    CHECK_EQ(reader.flags, GORILLA_CHUNK_FLAG_INTEGER);
+    CHECK(!gorilla_reader_init(&reader, buf, GORILLA_CHUNK_HEADER_SIZE - 1));
+    buf[0] = 'X';
+    CHECK(!gorilla_reader_init(&reader, buf, len));
+    buf[0] = GORILLA_CHUNK_MAGIC;
+    buf[1] = GORILLA_CHUNK_VERSION + 1;
+    CHECK(!gorilla_reader_init(&reader, buf, len));
+}
+
+static void test_extremes(void) {
+    // Delty z każdego przedziału kodowania, duże przerwy, wartości specjalne
+    static const uint32_t ts[] = { 0, 0, 1, 65, 66, 366, 3366, 103366, 103367, 4000000000u, 4000000000u, 4000000063u };
+    static const float values[] = { 1.0f, -1.0f, NAN, INFINITY, -INFINITY, 0.0f, -0.0f, 1e-45f,
+                                    3.4e38f, 21.53f, 21.53f, -273.15f };
+    CHECK(roundtrip(ts, values, 12, 0, 256, 1000) > 0);
+}
+
+static void test_rollback(void) {
+    // Próbka, która się nie mieści, nie zmienia paczki
+    uint8_t buf[16];
+    gorilla_chunk_t chunk;
+    gorilla_chunk_init(&chunk, buf, sizeof(buf), 0);
+    size_t n = 0;
+    while (gorilla_chunk_append(&chunk, timestamps[n], series[1][n])) {
+        n++;
+    }
+    CHECK(n >= 1);
+    gorilla_chunk_t before = chunk;
+    CHECK(!gorilla_chunk_append(&chunk, timestamps[n], series[1][n]));
+    CHECK_MEM(&chunk, &before, sizeof(chunk));
+    size_t len = gorilla_chunk_finish(&chunk);
+    CHECK(len <= sizeof(buf));
+
+    gorilla_reader_t reader;
+    CHECK(gorilla_reader_init(&reader, buf, len));
+    uint32_t t;
+    float v;
+    size_t k = 0;
+    while (gorilla_reader_next(&reader, &t, &v)) {
+        CHECK(v == series[1][k]);
+        k++;
+    }
+    CHECK_EQ(k, n);
+
+    // Bufor mniejszy niż nagłówek i pierwsza próbka
+    uint8_t tiny[GORILLA_CHUNK_HEADER_SIZE + 3];
+    gorilla_chunk_init(&chunk, tiny, sizeof(tiny), 0);
+    CHECK(!gorilla_chunk_append(&chunk, 1, 1.0f));
+    CHECK_EQ(gorilla_chunk_finish(&chunk), 0);
+}
+
+static void test_truncated(void) {
+    uint8_t buf[CHUNK_BUFFER_SIZE];
+    gorilla_chunk_t chunk;
+    gorilla_chunk_init(&chunk, buf, sizeof(buf), 0);
+    for (int i = 0; i < CHUNK_MAX_SAMPLES; i++) {
+        gorilla_chunk_append(&chunk, timestamps[i], series[0][i]);
+    }
+    size_t len = gorilla_chunk_finish(&chunk);
+
+    // Urwany strumień daje prefiks serii, nigdy odczyt poza buforem ani śmieci
+    for (size_t cut = GORILLA_CHUNK_HEADER_SIZE; cut < len; cut++) {
+        gorilla_reader_t reader;
+        CHECK(gorilla_reader_init(&reader, buf, cut));
+        uint32_t t;
+        float v;
+        int k = 0;
+        while (gorilla_reader_next(&reader, &t, &v)) {
+            CHECK_EQ(t, timestamps[k]);
+            CHECK(v == series[0][k]);
+            k++;
+        }
+        CHECK(k < CHUNK_MAX_SAMPLES);
+    }
+}
+
+static void bench_compression(void) {
+    static const char *names[] = { "temperatura BMP280", "ciśnienie BMP280", "jasność (ADC)" };
+    for (int m = 0; m < 3; m++) {
+        uint8_t flags = m == 2 ? GORILLA_CHUNK_FLAG_INTEGER : 0;
+        size_t bytes = roundtrip(timestamps, series[m], SERIES_LEN, flags, CHUNK_BUFFER_SIZE, CHUNK_MAX_SAMPLES);
+        double ratio = 8.0 * SERIES_LEN / (double)bytes; // surowa próbka: 4 B czasu + 4 B wartości
+        printf("%-20s %.2f B/próbkę, kompresja %.1fx\n", names[m], (double)bytes / SERIES_LEN, ratio);
+        CHECK(ratio > 2.0);
+    }
+
+    static float constant[SERIES_LEN];
+    for (int i = 0; i < SERIES_LEN; i++) {
+        constant[i] = 21.0f;
+    }
+    size_t bytes = roundtrip(timestamps, constant, SERIES_LEN, 0, CHUNK_BUFFER_SIZE, 1000);
+    printf("%-20s %.2f B/próbkę\n", "stała wartość", (double)bytes / SERIES_LEN);
+    CHECK((double)bytes / SERIES_LEN < 1.0);
+}
+
+static void bench_throughput(void) {
+    const int rounds = 100;
+    uint8_t buf[CHUNK_BUFFER_SIZE];
+    gorilla_chunk_t chunk;
+    size_t total = 0;
+
+    double t0 = test_now_s();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < SERIES_LEN;) {
+            gorilla_chunk_init(&chunk, buf, sizeof(buf), 0);
+            while (i < SERIES_LEN && chunk.count < CHUNK_MAX_SAMPLES &&
+                   gorilla_chunk_append(&chunk, timestamps[i], series[0][i])) {
+                i++;
+            }
+            total += gorilla_chunk_finish(&chunk);
+        }
+    }
+    double encode_ns = (test_now_s() - t0) * 1e9 / ((double)rounds * SERIES_LEN);
+
+    gorilla_chunk_init(&chunk, buf, sizeof(buf), 0);
+    for (int i = 0; i < CHUNK_MAX_SAMPLES; i++) {
+        gorilla_chunk_append(&chunk, timestamps[i], series[0][i]);
+    }
+    size_t len = gorilla_chunk_finish(&chunk);
+    volatile float sink = 0;
+    t0 = test_now_s();
+    for (int r = 0; r < rounds * 100; r++) {
+        gorilla_reader_t reader;
+        gorilla_reader_init(&reader, buf, len);
+        uint32_t t;
+        float v;
+        while (gorilla_reader_next(&reader, &t, &v)) {
+            sink += v;
+        }
+    }
+    double decode_ns = (test_now_s() - t0) * 1e9 / ((double)rounds * 100 * CHUNK_MAX_SAMPLES);
+    (void)sink;
+    CHECK(total > 0);
+    printf("kodowanie %.1f ns/próbkę, dekodowanie %.1f ns/próbkę\n", encode_ns, decode_ns);
+}
+
+int main(void) {
+    generate_series();
+    test_header();
+    test_extremes();
+    test_rollback();
+    test_truncated();
+    bench_compression();
+    bench_throughput();
+    TEST_DONE();
+}
@@ -0,0 +1,239 @@
+// Czytnik JSON komunikatów sterujących (json_reader.h): poprawne i błędne dane,
+// rozwijanie sekwencji \, limity oraz deterministyczny fuzzing mutacyjny.
+// Z -DHOST_TESTS_SANITIZE=ON odczyt poza buforem wykrywa AddressSanitizer.
+#include "json_reader.h"
+#include "test_util.h"
+#include <stdlib.h>
+
+static bool parse(json_reader_t *r, const char *json) {
+    return json_reader_parse(r, json, strlen(json));
+}
+
+static void test_fields(void) {
+    json_reader_t r;
+    CHECK(parse(&r, " {\"user_id\": \"user1\", \"n\": -12.5e1, \"b\": true, \"f\": false, \"z\": null,"
+                    " \"nested\": {\"user_id\": \"inner\", \"a\": [1, {\"x\": []}]}, \"last\": 7}\r\n"));
+    char s[32];
+    double d;
+    bool b;
+    CHECK(json_reader_string(&r, "user_id", s, sizeof(s)));
+    CHECK_STR(s, "user1");
+    CHECK(json_reader_number(&r, "n", &d) && d == -125.0);
+    CHECK(json_reader_bool(&r, "b", &b) && b);
+    CHECK(json_reader_bool(&r, "f", &b) && !b);
+    CHECK(json_reader_has(&r, "z"));
+    CHECK(!json_reader_number(&r, "z", &d));
+    CHECK(!json_reader_bool(&r, "z", &b));
+    CHECK(json_reader_number(&r, "last", &d) && d == 7.0);   // za zagnieżdżonym obiektem
+    CHECK(!json_reader_has(&r, "x"));                        // tylko najwyższy poziom
+    CHECK(!json_reader_has(&r, "a"));
+    CHECK(!json_reader_has(&r, "user"));
+    CHECK(!json_reader_string(&r, "n", s, sizeof(s)));       // zły typ
+    CHECK(!json_reader_number(&r, "user_id", &d));
+    CHECK(!json_reader_bool(&r, "nested", &b));
+
+    CHECK(parse(&r, "{}"));
+    CHECK(!json_reader_has(&r, "a"));
+
+    // Dane nie muszą być zakończone zerem
+    static const char unterminated[] = { '{', '"', 'k', '"', ':', '1', '}', 'X' };
+    CHECK(json_reader_parse(&r, unterminated, 7));
+    CHECK(json_reader_number(&r, "k", &d) && d == 1.0);
+    CHECK(!json_reader_parse(&r, unterminated, 8));
+}
+
+static void test_escapes(void) {
+    json_reader_t r;
+    char s[32];
+    CHECK(parse(&r, "{\"s\": \"a\\\"b\\\\c\\/d\\n\\t\"}"));
+    CHECK(json_reader_string(&r, "s", s, sizeof(s)));
+    CHECK_STR(s, "a\"b\\c/d\n\t");
+
+    CHECK(parse(&r, "{\"s\": \"\\u0041\\u00f3\\u20ac\\ud83d\\ude00\"}"));
+    CHECK(json_reader_string(&r, "s", s, sizeof(s)));
+    CHECK_STR(s, "A\xc3\xb3\xe2\x82\xac\xf0\x9f\x98\x80");
+
+    CHECK(parse(&r, "{\"s\": \"\\u0000\"}"));
+    CHECK(!json_reader_string(&r, "s", s, sizeof(s)));     // zero w środku tekstu
+    CHECK(parse(&r, "{\"s\": \"\\udc00\"}"));
+    CHECK(!json_reader_string(&r, "s", s, sizeof(s)));     // samotny surogat
+    CHECK(parse(&r, "{\"s\": \"\\ud800x\"}"));
+    CHECK(!json_reader_string(&r, "s", s, sizeof(s)));
+
+    // Bufor: tekst i zero kończące muszą się zmieścić
+    CHECK(parse(&r, "{\"s\": \"abcd\"}"));
+    CHECK(!json_reader_string(&r, "s", s, 4));
+    CHECK(json_reader_string(&r, "s", s, 5));
+    CHECK_STR(s, "abcd");
+    CHECK(!json_reader_string(&r, "s", s, 0));
+}
+
+static void test_invalid(void) {
+    static const char *invalid[] = {
+        "", " ", "[]", "\"a\"", "1", "{", "}", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "{,}", "{\"a\" 1}",
+        "{a:1}", "{'a':1}", "{\"a\":01}", "{\"a\":1.}", "{\"a\":.5}", "{\"a\":-}", "{\"a\":1e}", "{\"a\":+1}",
+        "{\"a\":tru}", "{\"a\":nul}", "{\"a\":\"\\x\"}", "{\"a\":\"\\u12g4\"}", "{\"a\":\"\\u12\"}",
+        "{\"a\":\"x\ny\"}", "{\"a\":[1 2]}", "{\"a\":[1,]}", "{\"a\":{}}}", "{} {}", "{\"a\":1}x",
+        "{\"a\":\"unterminated}",
+    };
+    json_reader_t r;
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (parse(&r, invalid[i])) {
+            fprintf(stderr, "zaakceptowano niepoprawny JSON: %s\n", invalid[i]);
+            test_failures++;
+        }
+        CHECK(!json_reader_has(&r, "a"));
+    }
+    CHECK(!json_reader_parse(&r, NULL, 0));
+
+    // Powtórzony klucz najwyższego poziomu - niejednoznaczne, który odczytać
+    CHECK(!parse(&r, "{\"a\": 1, \"a\": 2}"));
+    CHECK(!parse(&r, "{\"a\": 1, \"b\": {\"c\": 2}, \"a\": \"x\"}"));
+    CHECK(!parse(&r, "{\"b\": [1], \"a\": 1, \"b\": 2}"));
+    CHECK(parse(&r, "{\"a\": {\"a\": 1}, \"ab\": 2, \"b\": {\"x\": 1, \"y\": 2}}"));
+    CHECK(parse(&r, "{\"x\": {\"k\": 1}, \"y\": {\"k\": 2}}")); // te same klucze w różnych obiektach
+}
+
+static void test_limits(void) {
+    json_reader_t r;
+    char buf[512];
+
+    // Zagnieżdżenie: obiekt najwyższego poziomu + 7 tablic mieści się w limicie
+    CHECK(parse(&r, "{\"a\":[[[[[[[1]]]]]]]}"));
+    CHECK(!parse(&r, "{\"a\":[[[[[[[[1]]]]]]]]}"));
+
+    // Liczba tokenów: obiekt + 15 par = 31, 16 par = 33
+    size_t n = 0;
+    n += (size_t)snprintf(buf + n, sizeof(buf) - n, "{");
+    for (int i = 0; i < 15; i++) {
+        n += (size_t)snprintf(buf + n, sizeof(buf) - n, "%s\"k%d\": %d", i ? ", " : "", i, i);
+    }
+    snprintf(buf + n, sizeof(buf) - n, "}");
+    CHECK(parse(&r, buf));
+    CHECK_EQ(r.count, 31);
+    double d;
+    CHECK(json_reader_number(&r, "k14", &d) && d == 14.0);
+    snprintf(buf + n, sizeof(buf) - n, ", \"k15\": 15}");
+    CHECK(!parse(&r, buf));
+
+    // Tekst dłuższy niż 65535 B
+    size_t big_len = 70000;
+    char *big = malloc(big_len);
+    memset(big, ' ', big_len);
+    memcpy(big, "{\"a\":1}", 7);
+    CHECK(!json_reader_parse(&r, big, big_len));
+    CHECK(json_reader_parse(&r, big, UINT16_MAX));
+    free(big);
+
+    // Liczba za długa dla bufora konwersji
+    CHECK(parse(&r, "{\"n\": 1234567890123456789012345678901234567890}"));
+    CHECK(!json_reader_number(&r, "n", &d));
+}
+
+// Niezmienniki dla dowolnego wyniku parsowania
+static void check_reader(const json_reader_t *r, size_t len) {
+    if (r->count == 0) {
+        return;
+    }
+    CHECK(r->count <= JSON_READER_MAX_TOKENS);
+    CHECK_EQ(r->tokens[0].type, JSON_TOKEN_OBJECT);
+    CHECK_EQ(r->tokens[0].next, r->count);
+    for (int i = 0; i < r->count; i++) {
+        const json_token_t *t = &r->tokens[i];
+        CHECK(t->start <= t->end && t->end <= len);
+        CHECK(t->next > i && t->next <= r->count);
+    }
+    static const char *keys[] = { "user_id", "device_id", "n", "b", "interval", "" };
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        char s[16];
+        double d;
+        bool b;
+        memset(s, 'x', sizeof(s));
+        if (json_reader_string(r, keys[i], s, sizeof(s))) {
+            CHECK(memchr(s, '\0', sizeof(s)) != NULL);
+        }
+        json_reader_number(r, keys[i], &d);
+        json_reader_bool(r, keys[i], &b);
+    }
+}
+
+// Mutacje poprawnych komunikatów: zmiana, wstawienie i usunięcie bajtów, ucięcie.
+// Każde wejście jest kopiowane do bufora dokładnie jego długości.
+static void test_fuzz(void) {
+    static const char *corpus[] = {
+        "{\"user_id\": \"user1\", \"device_id\": \"device1\", \"payload_format\": \"numeric\"}",
+        "{\"bmp280\": 10, \"light\": 2.5e0, \"system\": 60}",
+        "{\"min_temperature\": -10.5, \"max_temperature\": 35, \"b\": false, \"z\": null}",
+        "{\"user_id\": \"\\u017c\\ud83d\\ude00\\\"\", \"a\": [1, [2, {\"b\": {}}], \"x\"]}",
+    };
+    static const char alphabet[] = "{}[]\":,\\/u0123456789abcdefnrtl-+.eE \t\r\n\x01\x7f\xff";
+    uint32_t seed = 0x12345678;
+    uint32_t accepted = 0;
+    const uint32_t iterations = 200000;
+
+    for (uint32_t it = 0; it < iterations; it++) {
+        char work[256];
+        const char *base = corpus[it % (sizeof(corpus) / sizeof(corpus[0]))];
+        size_t len = strlen(base);
+        memcpy(work, base, len);
+
+        int mutations = 1 + (int)(test_rand(&seed) % 4);
+        for (int m = 0; m < mutations && len > 0; m++) {
+            size_t pos = test_rand(&seed) % len;
+            char c = alphabet[test_rand(&seed) % (sizeof(alphabet) - 1)];
+            switch (test_rand(&seed) % 4) {
+                case 0:
+                    work[pos] = c;
+                    break;
+                case 1:
+                    if (len < sizeof(work)) {
+                        memmove(work + pos + 1, work + pos, len - pos);
+                        work[pos] = c;
+                        len++;
+                    }
+                    break;
+                case 2:
+                    memmove(work + pos, work + pos + 1, len - pos - 1);
+                    len--;
+                    break;
+                default:
+                    len = pos;
+                    break;
+            }
+        }
+
+        char *input = malloc(len ? len : 1);
+        memcpy(input, work, len);
+        json_reader_t r;
+        if (json_reader_parse(&r, input, len)) {
+            accepted++;
+        } else {
+            CHECK_EQ(r.count, 0);
+        }
+        check_reader(&r, len);
+        free(input);
+    }
+    // Część mutacji (np. zmiana cyfry) pozostaje poprawnym JSON
+    CHECK(accepted > 0 && accepted < iterations);
+
+    // Każdy właściwy prefiks poprawnego obiektu jest odrzucany
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        size_t len = strlen(corpus[i]);
+        for (size_t cut = 0; cut < len; cut++) {
+            char *input = malloc(cut ? cut : 1);
+            memcpy(input, corpus[i], cut);
+            json_reader_t r;
+            CHECK(!json_reader_parse(&r, input, cut));
+            free(input);
+        }
+    }
+}
+
+int main(void) {
+    test_fields();
+    test_escapes();
+    test_invalid();
+    test_limits();
+    test_fuzz();
+    TEST_DONE();
+}
@@ -0,0 +1,146 @@
+// Harmonogram pomiarów (metric_scheduler.h): kolejność terminów, brak dryfu,
+// zmiana interwału, przepełnienie licznika oraz dokładność i koszt przy setkach metryk.
+#include "metric_scheduler.h"
+#include "test_util.h"
+
+#define CAPACITY 512
+
+static scheduler_entry_t heap[CAPACITY];
+static uint16_t position[CAPACITY];
+
+static void test_add(void) {
+    scheduler_t s;
+    scheduler_init(&s, heap, position, 4);
+    CHECK_EQ(scheduler_time_until_next(&s, 0), UINT32_MAX);
+    CHECK(scheduler_add(&s, 0, 100, 100));
+    CHECK(!scheduler_add(&s, 0, 100, 100)); // id już istnieje
+    CHECK(!scheduler_add(&s, 4, 100, 100)); // id poza zakresem
+    CHECK(!scheduler_add(&s, 1, 0, 100));   // interwał 0
+    CHECK(scheduler_add(&s, 1, 50, 50));
+    CHECK_EQ(s.count, 2);
+    CHECK_EQ(scheduler_time_until_next(&s, 10), 40);
+    CHECK_EQ(scheduler_time_until_next(&s, 70), 0);
+    CHECK(!scheduler_set_interval(&s, 2, 100, 0)); // brak wpisu
+}
+
+static void test_order_and_drift(void) {
+    scheduler_t s;
+    scheduler_init(&s, heap, position, 3);
+    scheduler_add(&s, 0, 300, 300);
+    scheduler_add(&s, 1, 100, 100);
+    scheduler_add(&s, 2, 200, 200);
+
+    uint16_t id;
+    CHECK(!scheduler_pop_due(&s, 99, &id));
+    // Obsługa spóźniona o 30 ms nie przesuwa kolejnych terminów
+    CHECK(scheduler_pop_due(&s, 130, &id));
+    CHECK_EQ(id, 1);
+    CHECK(!scheduler_pop_due(&s, 130, &id));
+    CHECK_EQ(scheduler_time_until_next(&s, 130), 70);
+    CHECK(scheduler_pop_due(&s, 200, &id));
+    CHECK(id == 1 || id == 2);
+    CHECK(scheduler_pop_due(&s, 200, &id));
+    CHECK(id == 1 || id == 2);
+    CHECK(!scheduler_pop_due(&s, 200, &id));
+    CHECK(scheduler_pop_due(&s, 300, &id));
+    CHECK(id == 0 || id == 1);
+
+    // Opóźnienie dłuższe niż interwał: jedno wykonanie, zaległe są pomijane
+    scheduler_init(&s, heap, position, 1);
+    scheduler_add(&s, 0, 100, 100);
+    CHECK(scheduler_pop_due(&s, 1050, &id));
+    CHECK(!scheduler_pop_due(&s, 1050, &id));
+    CHECK_EQ(scheduler_time_until_next(&s, 1050), 100);
+}
+
+static void test_set_interval(void) {
+    scheduler_t s;
+    scheduler_init(&s, heap, position, 2);
+    scheduler_add(&s, 0, 10000, 10000);
+    scheduler_add(&s, 1, 5000, 5000);
+
+    // Skrócenie: ostatnie wykonanie (0) + 1000 ms, ale nie wcześniej niż wynika z teraz
+    CHECK(scheduler_set_interval(&s, 0, 1000, 400));
+    CHECK_EQ(scheduler_time_until_next(&s, 400), 600);
+    uint16_t id;
+    CHECK(scheduler_pop_due(&s, 1000, &id));
+    CHECK_EQ(id, 0);
+
+    // Wydłużenie: termin nie dalej niż now + nowy interwał
+    CHECK(scheduler_set_interval(&s, 1, 60000, 4000));
+    CHECK_EQ(heap[position[1]].due_ms, 60000);
+    CHECK(scheduler_set_interval(&s, 1, 3000, 4000));
+    CHECK_EQ(heap[position[1]].due_ms, 3000); // ostatnie wykonanie (0) + 3000
+    CHECK(scheduler_pop_due(&s, 4000, &id));
+    CHECK_EQ(id, 0); // termin 2000
+    CHECK(scheduler_pop_due(&s, 4000, &id));
+    CHECK_EQ(id, 1);
+}
+
+static void test_wraparound(void) {
+    scheduler_t s;
+    scheduler_init(&s, heap, position, 2);
+    uint32_t start = UINT32_MAX - 150;
+    scheduler_add(&s, 0, 100, start + 100);
+    scheduler_add(&s, 1, 300, start + 300); // termin po przepełnieniu licznika
+
+    uint16_t id;
+    CHECK(scheduler_pop_due(&s, start + 100, &id));
+    CHECK_EQ(id, 0);
+    CHECK(scheduler_pop_due(&s, start + 200, &id)); // 49 ms po przepełnieniu
+    CHECK_EQ(id, 0);
+    CHECK_EQ(scheduler_time_until_next(&s, start + 200), 100);
+    CHECK(scheduler_pop_due(&s, start + 300, &id));
+    CHECK(scheduler_pop_due(&s, start + 300, &id));
+    CHECK(!scheduler_pop_due(&s, start + 300, &id));
+}
+
+// Symulacja godziny pracy z taktem 10 ms: każde wykonanie metryki musi wypaść
+// nie później niż takt po terminie, a liczba wykonań odpowiada interwałom
+static void bench_many_metrics(uint16_t count) {
+    static uint32_t interval[CAPACITY], next_due[CAPACITY], runs[CAPACITY];
+    const uint32_t tick = 10, duration = 3600000;
+    const uint32_t start = UINT32_MAX - 600000; // przepełnienie w trakcie symulacji
+
+    scheduler_t s;
+    scheduler_init(&s, heap, position, count);
+    for (uint16_t i = 0; i < count; i++) {
+        interval[i] = 1000 + (uint32_t)(i * 37) % 59000;
+        next_due[i] = start + interval[i];
+        runs[i] = 0;
+        CHECK(scheduler_add(&s, i, interval[i], next_due[i]));
+    }
+
+    uint32_t max_late = 0, total = 0;
+    double t0 = test_now_s();
+    for (uint32_t t = start; t != start + duration; t += tick) {
+        uint16_t id;
+        while (scheduler_pop_due(&s, t, &id)) {
+            uint32_t late = t - next_due[id];
+            if (late > max_late) {
+                max_late = late;
+            }
+            next_due[id] += interval[id];
+            runs[id]++;
+            total++;
+        }
+    }
+    double elapsed = test_now_s() - t0;
+
+    CHECK(max_late < tick);
+    for (uint16_t i = 0; i < count; i++) {
+        CHECK_EQ(runs[i], (duration - tick) / interval[i]);
+    }
+    printf("%u metryk: %u wykonań, max opóźnienie %u ms (takt %u ms), %.0f ns/wykonanie\n",
+           count, total, max_late, tick, elapsed * 1e9 / total);
+}
+
+int main(void) {
+    test_add();
+    test_order_and_drift();
+    test_set_interval();
+    test_wraparound();
+    bench_many_metrics(100);
+    bench_many_metrics(500);
+    TEST_DONE();
+}
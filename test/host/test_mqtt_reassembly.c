@@ -0,0 +1,192 @@
+// Składanie wiadomości MQTT z fragmentów (mqtt_reassembly.h): podział na dowolne
+// kawałki, przeplatanie wiadomości, luki, przepełnienie puli i liczniki.
+#include "mqtt_reassembly.h"
+#include "test_util.h"
+
+static char message[REASSEMBLY_LARGE_SIZE + 16];
+static reassembly_stats_t before;
+
+static void fill_message(size_t len, uint32_t seed) {
+    for (size_t i = 0; i < len; i++) {
+        message[i] = (char)('a' + test_rand(&seed) % 26);
+    }
+}
+
+static void stats_begin(void) {
+    reassembly_get_stats(&before);
+}
+
+// Przyrost liczników od stats_begin()
+static reassembly_stats_t stats_delta(void) {
+    reassembly_stats_t s;
+    reassembly_get_stats(&s);
+    s.completed -= before.completed;
+    s.fragmented -= before.fragmented;
+    s.too_large -= before.too_large;
+    s.no_buffer -= before.no_buffer;
+    s.broken -= before.broken;
+    s.evicted -= before.evicted;
+    return s;
+}
+
+// Podaje wiadomość w kawałkach o rozmiarze chunk; zwraca wynik ostatniego fragmentu
+static reassembly_result_t feed_split(int msg_id, const char *topic, size_t len, size_t chunk,
+                                      reassembly_message_t **out) {
+    reassembly_result_t result = REASSEMBLY_DROPPED;
+    size_t offset = 0;
+    do {
+        size_t n = len - offset < chunk ? len - offset : chunk;
+        result = reassembly_feed(msg_id, topic, offset == 0 ? strlen(topic) : 0,
+                                 message + offset, n, offset, len, out);
+        offset += n;
+        if (result != REASSEMBLY_PENDING) {
+            break;
+        }
+    } while (offset < len);
+    return result;
+}
+
+static void test_single_fragment(void) {
+    stats_begin();
+    reassembly_message_t *msg = NULL;
+    CHECK_EQ(reassembly_feed(0, "/system/ping", 12, "{}", 2, 0, 2, &msg), REASSEMBLY_COMPLETE);
+    CHECK(msg != NULL);
+    CHECK_STR(msg->topic, "/system/ping");
+    CHECK_STR(msg->data, "{}");
+    CHECK_EQ(msg->len, 2);
+    reassembly_release(msg);
+
+    // Pusta wiadomość
+    CHECK_EQ(reassembly_feed(0, "t", 1, NULL, 0, 0, 0, &msg), REASSEMBLY_COMPLETE);
+    CHECK_EQ(msg->len, 0);
+    CHECK_STR(msg->data, "");
+    reassembly_release(msg);
+    CHECK_EQ(stats_delta().completed, 2);
+    CHECK_EQ(stats_delta().fragmented, 0);
+}
+
+// Każdy rozmiar fragmentu i każda klasa bufora daje wiadomość identyczną z wysłaną
+static void test_split_sizes(void) {
+    static const size_t sizes[] = { 1, 511, 512, 513, 1024, 1025, 1500, REASSEMBLY_LARGE_SIZE };
+    static const size_t chunks[] = { 1, 7, 100, 511, 1024, 4096 };
+    stats_begin();
+    uint32_t expected = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+            fill_message(sizes[s], (uint32_t)(s * 31 + c + 1));
+            reassembly_message_t *msg = NULL;
+            CHECK_EQ(feed_split((int)(s * 10 + c), "/user1/device1/config", sizes[s], chunks[c], &msg),
+                     REASSEMBLY_COMPLETE);
+            if (msg) {
+                CHECK_EQ(msg->len, sizes[s]);
+                CHECK_MEM(msg->data, message, sizes[s]);
+                CHECK_EQ(msg->data[sizes[s]], '\0');
+                CHECK_STR(msg->topic, "/user1/device1/config");
+                reassembly_release(msg);
+            }
+            if (chunks[c] < sizes[s]) {
+                expected++;
+            }
+        }
+    }
+    CHECK_EQ(stats_delta().fragmented, expected);
+}
+
+static void test_interleaved(void) {
+    // Dwie wiadomości QoS 1 przeplatane fragment po fragmencie
+    static char a[900], b[900];
+    memset(a, 'A', sizeof(a));
+    memset(b, 'B', sizeof(b));
+    reassembly_message_t *msg = NULL;
+    CHECK_EQ(reassembly_feed(1, "a", 1, a, 300, 0, sizeof(a), &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(reassembly_feed(2, "b", 1, b, 300, 0, sizeof(b), &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(reassembly_feed(1, NULL, 0, a + 300, 300, 300, sizeof(a), &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(reassembly_feed(2, NULL, 0, b + 300, 300, 300, sizeof(b), &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(reassembly_feed(2, NULL, 0, b + 600, 300, 600, sizeof(b), &msg), REASSEMBLY_COMPLETE);
+    CHECK_STR(msg->topic, "b");
+    CHECK_MEM(msg->data, b, sizeof(b));
+    reassembly_message_t *first = msg;
+    CHECK_EQ(reassembly_feed(1, NULL, 0, a + 600, 300, 600, sizeof(a), &msg), REASSEMBLY_COMPLETE);
+    CHECK_STR(msg->topic, "a");
+    CHECK_MEM(msg->data, a, sizeof(a));
+    CHECK(msg != first);
+    reassembly_release(first);
+    reassembly_release(msg);
+}
+
+static void test_broken(void) {
+    reassembly_message_t *msg = NULL;
+    fill_message(1000, 5);
+    stats_begin();
+
+    // Fragment bez początku wiadomości
+    CHECK_EQ(reassembly_feed(7, NULL, 0, message + 100, 100, 100, 1000, &msg), REASSEMBLY_DROPPED);
+    // Luka: po fragmencie 0-99 przychodzi 200-299
+    CHECK_EQ(reassembly_feed(7, "t", 1, message, 100, 0, 1000, &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(reassembly_feed(7, NULL, 0, message + 200, 100, 200, 1000, &msg), REASSEMBLY_DROPPED);
+    // Inna długość całkowita przy tym samym msg_id
+    CHECK_EQ(reassembly_feed(7, NULL, 0, message + 100, 100, 100, 999, &msg), REASSEMBLY_DROPPED);
+    // Fragment wychodzi poza zadeklarowaną długość - wiadomość porzucona
+    CHECK_EQ(reassembly_feed(7, NULL, 0, message + 100, 950, 100, 1000, &msg), REASSEMBLY_DROPPED);
+    CHECK_EQ(reassembly_feed(7, NULL, 0, message + 100, 100, 100, 1000, &msg), REASSEMBLY_DROPPED);
+    CHECK_EQ(stats_delta().broken, 5);
+
+    // Nowy początek z tym samym msg_id (QoS 0) zastępuje niedokończoną wiadomość
+    CHECK_EQ(reassembly_feed(0, "old", 3, message, 100, 0, 1000, &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(feed_split(0, "new", 1000, 300, &msg), REASSEMBLY_COMPLETE);
+    CHECK_STR(msg->topic, "new");
+    reassembly_release(msg);
+    CHECK_EQ(stats_delta().evicted, 1);
+
+    // Za duża wiadomość
+    CHECK_EQ(reassembly_feed(8, "t", 1, message, 10, 0, REASSEMBLY_LARGE_SIZE + 1, &msg), REASSEMBLY_DROPPED);
+    CHECK_EQ(stats_delta().too_large, 1);
+
+    // Temat dłuższy niż bufor jest skracany
+    static char long_topic[300];
+    memset(long_topic, 't', sizeof(long_topic));
+    CHECK_EQ(reassembly_feed(9, long_topic, sizeof(long_topic), "x", 1, 0, 1, &msg), REASSEMBLY_COMPLETE);
+    CHECK_EQ(strlen(msg->topic), REASSEMBLY_TOPIC_MAX_LEN - 1);
+    reassembly_release(msg);
+}
+
+static void test_pool(void) {
+    reassembly_message_t *held[REASSEMBLY_SLOT_COUNT];
+    reassembly_message_t *msg = NULL;
+    fill_message(REASSEMBLY_LARGE_SIZE, 9);
+    reassembly_reset();
+    stats_begin();
+
+    // Złożone, jeszcze nieobsłużone wiadomości zajmują wszystkie bufory
+    for (int i = 0; i < REASSEMBLY_SLOT_COUNT; i++) {
+        CHECK_EQ(reassembly_feed(100 + i, "t", 1, message, 10, 0, 10, &held[i]), REASSEMBLY_COMPLETE);
+    }
+    CHECK_EQ(reassembly_feed(200, "t", 1, message, 10, 0, 10, &msg), REASSEMBLY_DROPPED);
+    CHECK_EQ(stats_delta().no_buffer, 1);
+    for (int i = 0; i < REASSEMBLY_SLOT_COUNT; i++) {
+        reassembly_release(held[i]);
+    }
+
+    // Mała wiadomość trafia do najmniejszej klasy; duża może zająć tylko bufor 2 KB
+    CHECK_EQ(reassembly_feed(300, "t", 1, message, 100, 0, 1500, &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(reassembly_feed(301, "t", 1, message, 100, 0, 1800, &msg), REASSEMBLY_PENDING);
+    CHECK_EQ(stats_delta().evicted, 1); // najstarsza niedokończona wiadomość traci bufor
+    CHECK_EQ(reassembly_feed(300, NULL, 0, message + 100, 1400, 100, 1500, &msg), REASSEMBLY_DROPPED);
+    CHECK_EQ(feed_split(301, "t", 1800, 1800, &msg), REASSEMBLY_COMPLETE);
+    reassembly_release(msg);
+
+    // Po rozłączeniu niedokończone wiadomości są porzucane
+    CHECK_EQ(reassembly_feed(400, "t", 1, message, 100, 0, 1000, &msg), REASSEMBLY_PENDING);
+    reassembly_reset();
+    CHECK_EQ(reassembly_feed(400, NULL, 0, message + 100, 900, 100, 1000, &msg), REASSEMBLY_DROPPED);
+    reassembly_release(NULL);
+}
+
+int main(void) {
+    test_single_fragment();
+    test_split_sizes();
+    test_interleaved();
+    test_broken();
+    test_pool();
+    TEST_DONE();
+}
@@ -0,0 +1,176 @@
+// Składanie danych bez printf (payload_writer.h): fixed_format() bajt w bajt jak
+// snprintf("%.*f") na całym zakresie float, struktura JSON, przepełnienie i koszt.
+#include "payload_writer.h"
+#include "test_util.h"
+#include <math.h>
+
+static long compared, mismatches;
+
+static void compare_with_snprintf(float value, int decimals) {
+    char ours[FIXED_FORMAT_MAX_LEN], ref[400];
+    size_t len = fixed_format(ours, sizeof(ours), value, decimals);
+    if (len == 0) {
+        // Poza zakresem wolno odmówić tylko dla NaN, nieskończoności i wartości >= 2^64 po przeskalowaniu
+        if (isfinite(value) && fabsf(value) < 1e15f) {
+            fprintf(stderr, "fixed_format(%a, %d) == 0\n", (double)value, decimals);
+            mismatches++;
+        }
+        return;
+    }
+    snprintf(ref, sizeof(ref), "%.*f", decimals, (double)value);
+    compared++;
+    if (strcmp(ours, ref) != 0 || len != strlen(ref)) {
+        if (mismatches++ < 10) {
+            fprintf(stderr, "fixed_format(%a, %d) == \"%s\", snprintf: \"%s\"\n", (double)value, decimals, ours, ref);
+        }
+    }
+}
+
+static void compare_bits(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    for (int d = 0; d <= FIXED_FORMAT_MAX_DECIMALS; d++) {
+        compare_with_snprintf(value, d);
+    }
+}
+
+static void test_fixed_format_vs_snprintf(void) {
+    // Cały zakres wzorców bitowych z krokiem liczby pierwszej
+    for (uint64_t bits = 0; bits <= 0xFFFFFFFFull; bits += 4099) {
+        compare_bits((uint32_t)bits);
+    }
+    // Gęsto w zakresach czujników: temperatura, wilgotność, ciśnienie (hPa), ADC
+    static const float lo[] = { -40.0f, 0.0f, 300.0f, 0.0f };
+    static const float hi[] = { 85.0f, 100.0f, 1100.0f, 4095.0f };
+    for (int r = 0; r < 4; r++) {
+        for (float v = lo[r]; v <= hi[r]; v += 0.0009765625f * (1 + r)) {
+            compare_with_snprintf(v, 2);
+            compare_with_snprintf(nextafterf(v, INFINITY), 2);
+        }
+    }
+    // Remisy (x.xx5, połówki) i małe wartości w pobliżu zera
+    for (int i = -100000; i <= 100000; i++) {
+        compare_with_snprintf((float)i / 1000.0f, 2);
+        compare_with_snprintf((float)i * 0.005f, 2);
+        compare_with_snprintf((float)i / 8.0f, 0);
+        compare_with_snprintf((float)i / 8.0f, 2);
+    }
+    static const float special[] = { 0.0f, -0.0f, -0.001f, 0.005f, 0.015f, 2.5f, 3.5f, 1e-45f, -1e-45f,
+                                     0.125f, 0.375f, 1e14f, -1e14f, 18446742974197923840.0f };
+    for (size_t i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        for (int d = 0; d <= FIXED_FORMAT_MAX_DECIMALS; d++) {
+            compare_with_snprintf(special[i], d);
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+    CHECK(compared > 5000000);
+}
+
+static void test_fixed_format_limits(void) {
+    char buf[FIXED_FORMAT_MAX_LEN];
+    CHECK_EQ(fixed_format(buf, sizeof(buf), NAN, 2), 0);
+    CHECK_EQ(fixed_format(buf, sizeof(buf), INFINITY, 2), 0);
+    CHECK_EQ(fixed_format(buf, sizeof(buf), 3e38f, 2), 0);
+    CHECK_EQ(fixed_format(buf, sizeof(buf), 1.0f, FIXED_FORMAT_MAX_DECIMALS + 1), 0);
+    CHECK_EQ(fixed_format(buf, sizeof(buf), 1.0f, -1), 0);
+
+    // Bufor dokładnie na tekst i zero kończące
+    CHECK_EQ(fixed_format(buf, 6, -1.25f, 2), 5);
+    CHECK_STR(buf, "-1.25");
+    CHECK_EQ(fixed_format(buf, 5, -1.25f, 2), 0);
+}
+
+static void test_json(void) {
+    char buf[128];
+    payload_writer_t w;
+    payload_writer_init(&w, buf, sizeof(buf));
+    payload_begin_object(&w);
+    payload_key(&w, "temperature");
+    payload_fixed(&w, 21.53f, 2);
+    payload_key(&w, "ts");
+    payload_uint(&w, 4294967295u);
+    payload_key(&w, "min");
+    payload_int(&w, INT32_MIN);
+    payload_key(&w, "bad");
+    payload_fixed(&w, NAN, 2);
+    payload_key(&w, "list");
+    payload_begin_array(&w);
+    payload_item(&w);
+    payload_int(&w, 0);
+    payload_item(&w);
+    payload_string(&w, "bmp280");
+    payload_end_array(&w);
+    payload_end_object(&w);
+    const char *expected = "{\"temperature\": 21.53, \"ts\": 4294967295, \"min\": -2147483648, "
+                           "\"bad\": null, \"list\": [0, \"bmp280\"]}";
+    CHECK_EQ(payload_writer_finish(&w), strlen(expected));
+    CHECK_STR(buf, expected);
+
+    // Wynik format_sample() dla JSON jest identyczny z dawnym snprintf
+    char ref[64];
+    for (int i = 0; i < 3000; i++) {
+        float value = 15.0f + (float)i * 0.0137f;
+        payload_writer_init(&w, buf, sizeof(buf));
+        payload_begin_object(&w);
+        payload_key(&w, "temperature");
+        payload_fixed(&w, value, 2);
+        payload_end_object(&w);
+        payload_writer_finish(&w);
+        snprintf(ref, sizeof(ref), "{\"temperature\": %.2f}", (double)value);
+        CHECK_STR(buf, ref);
+    }
+}
+
+static void test_overflow(void) {
+    static const char *expected = "{\"pressure\": 1013.25}";
+    size_t full = strlen(expected);
+    for (size_t cap = 1; cap <= full + 1; cap++) {
+        char buf[32];
+        memset(buf, 'x', sizeof(buf));
+        payload_writer_t w;
+        payload_writer_init(&w, buf, cap);
+        payload_begin_object(&w);
+        payload_key(&w, "pressure");
+        payload_fixed(&w, 1013.25f, 2);
+        payload_end_object(&w);
+        size_t len = payload_writer_finish(&w);
+        CHECK_EQ(len, cap == full + 1 ? full : 0);
+        CHECK_EQ(buf[cap], 'x');
+    }
+}
+
+static void bench_vs_snprintf(void) {
+    const int n = 1000000;
+    char buf[64];
+    volatile size_t sink = 0;
+
+    double t0 = test_now_s();
+    for (int i = 0; i < n; i++) {
+        payload_writer_t w;
+        payload_writer_init(&w, buf, sizeof(buf));
+        payload_begin_object(&w);
+        payload_key(&w, "temperature");
+        payload_fixed(&w, 15.0f + (float)(i % 3000) * 0.0137f, 2);
+        payload_end_object(&w);
+        sink += payload_writer_finish(&w);
+    }
+    double ours = (test_now_s() - t0) * 1e9 / n;
+
+    t0 = test_now_s();
+    for (int i = 0; i < n; i++) {
+        sink += (size_t)snprintf(buf, sizeof(buf), "{\"temperature\": %.2f}", (double)(15.0f + (float)(i % 3000) * 0.0137f));
+    }
+    double ref = (test_now_s() - t0) * 1e9 / n;
+    (void)sink;
+    printf("payload_writer %.1f ns, snprintf %.1f ns (%.1fx), porównano %ld wartości\n",
+           ours, ref, ref / ours, compared);
+}
+
+int main(void) {
+    test_fixed_format_vs_snprintf();
+    test_fixed_format_limits();
+    test_json();
+    test_overflow();
+    bench_vs_snprintf();
+    TEST_DONE();
+}
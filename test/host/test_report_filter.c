@@ -0,0 +1,101 @@
+// Filtr "report-by-exception" (report_filter.h): deadband, odstępy, heartbeat, NaN.
+#include "report_filter.h"
+#include "test_util.h"
+#include <math.h>
+
+static void test_absolute_deadband(void) {
+    report_state_t st;
+    report_filter_init(&st, &(report_config_t){ .deadband = 0.5f });
+
+    CHECK(report_filter_should_publish(&st, 20.0f, 0));   // pierwsza próbka zawsze
+    CHECK(!report_filter_should_publish(&st, 20.4f, 10));
+    CHECK(!report_filter_should_publish(&st, 19.5f, 20)); // równe progowi - bez publikacji
+    CHECK(report_filter_should_publish(&st, 20.6f, 30));
+    // Odniesieniem jest ostatnio wysłana wartość, nie ostatnia próbka (brak dryfu)
+    CHECK(!report_filter_should_publish(&st, 21.0f, 40));
+    CHECK(report_filter_should_publish(&st, 21.2f, 50));
+    CHECK_EQ(st.published, 3);
+    CHECK_EQ(st.suppressed, 3);
+    CHECK(st.last_value == 21.2f);
+}
+
+static void test_percent_deadband(void) {
+    report_state_t st;
+    report_filter_init(&st, &(report_config_t){ .deadband = 1.0f, .deadband_percent = true });
+
+    CHECK(report_filter_should_publish(&st, 1000.0f, 0));
+    CHECK(!report_filter_should_publish(&st, 1009.0f, 1));
+    CHECK(report_filter_should_publish(&st, 1011.0f, 2));
+    // Przy wartości 0 próg procentowy wynosi 0: każda zmiana jest publikowana
+    report_filter_init(&st, &(report_config_t){ .deadband = 1.0f, .deadband_percent = true });
+    CHECK(report_filter_should_publish(&st, 0.0f, 0));
+    CHECK(!report_filter_should_publish(&st, 0.0f, 1));
+    CHECK(report_filter_should_publish(&st, 0.001f, 2));
+}
+
+static void test_intervals(void) {
+    report_state_t st;
+    report_filter_init(&st, &(report_config_t){ .deadband = 0.1f, .min_interval_ms = 1000,
+                                                .max_interval_ms = 60000 });
+
+    CHECK(report_filter_should_publish(&st, 10.0f, 0));
+    CHECK(!report_filter_should_publish(&st, 50.0f, 999));   // duża zmiana, ale za wcześnie
+    CHECK(report_filter_should_publish(&st, 50.0f, 1000));
+    CHECK(!report_filter_should_publish(&st, 50.0f, 60999));
+    CHECK(report_filter_should_publish(&st, 50.0f, 61000));  // heartbeat bez zmiany wartości
+
+    // Heartbeat ma pierwszeństwo przed min_interval_ms, gdy max < min
+    report_filter_init(&st, &(report_config_t){ .min_interval_ms = 5000, .max_interval_ms = 1000 });
+    CHECK(report_filter_should_publish(&st, 1.0f, 0));
+    CHECK(report_filter_should_publish(&st, 1.0f, 1000));
+}
+
+static void test_timer_wraparound(void) {
+    report_state_t st;
+    report_filter_init(&st, &(report_config_t){ .deadband = 1.0f, .min_interval_ms = 100,
+                                                .max_interval_ms = 1000 });
+    uint32_t start = UINT32_MAX - 50;
+    CHECK(report_filter_should_publish(&st, 1.0f, start));
+    CHECK(!report_filter_should_publish(&st, 5.0f, start + 99));  // przepełnienie licznika
+    CHECK(report_filter_should_publish(&st, 5.0f, start + 100));
+    CHECK(!report_filter_should_publish(&st, 5.0f, start + 1099));
+    CHECK(report_filter_should_publish(&st, 5.0f, start + 1100));
+}
+
+static void test_nan(void) {
+    report_state_t st;
+    report_filter_init(&st, &(report_config_t){ .deadband = 0.5f });
+
+    CHECK(report_filter_should_publish(&st, 1.0f, 0));
+    CHECK(report_filter_should_publish(&st, NAN, 1));   // awaria czujnika jest raportowana od razu
+    CHECK(!report_filter_should_publish(&st, NAN, 2));  // kolejne NaN nie zalewają brokera
+    CHECK(report_filter_should_publish(&st, 1.0f, 3));  // powrót do poprawnych odczytów
+}
+
+static void test_suppression_ratio(void) {
+    CHECK(report_filter_suppression_ratio(0, 0) == 0.0f);
+    CHECK(report_filter_suppression_ratio(1, 3) == 0.75f);
+    CHECK(report_filter_suppression_ratio(0, 10) == 1.0f);
+
+    // Wolno zmienna temperatura z szumem: filtr powinien odrzucić większość próbek
+    report_state_t st;
+    report_filter_init(&st, &(report_config_t){ .deadband = 0.2f, .max_interval_ms = 600000 });
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < 3600; i++) {
+        float noise = (float)(test_rand(&seed) % 100) / 1000.0f - 0.05f;
+        float value = 21.0f + 2.0f * sinf((float)i / 600.0f) + noise;
+        report_filter_should_publish(&st, value, i * 1000);
+    }
+    CHECK_EQ(st.published + st.suppressed, 3600);
+    CHECK(report_filter_suppression_ratio(st.published, st.suppressed) > 0.9f);
+}
+
+int main(void) {
+    test_absolute_deadband();
+    test_percent_deadband();
+    test_intervals();
+    test_timer_wraparound();
+    test_nan();
+    test_suppression_ratio();
+    TEST_DONE();
+}
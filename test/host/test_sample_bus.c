@@ -0,0 +1,211 @@
+// Szyna próbek (sample_bus.h): filtrowanie rodzajów, kolejność, utrata najstarszej
+// próbki przy pełnej kolejce oraz przepustowość i opóźnienie dostarczenia do czterech
+// odbiorców w osobnych wątkach (jak MQTT, monitor LED, HTTP i logger).
+#include "sample_bus.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void bus_lock(void *arg) {
+    pthread_mutex_lock(arg);
+}
+
+static void bus_unlock(void *arg) {
+    pthread_mutex_unlock(arg);
+}
+
+static int notified[SAMPLE_BUS_MAX_SUBSCRIBERS];
+
+static void count_notify(void *arg) {
+    (*(int *)arg)++;
+}
+
+static void test_delivery(void) {
+    sample_bus_t bus;
+    sample_subscriber_t all, light, full;
+    sample_t ring_all[8], ring_light[8], ring_full[2];
+    memset(notified, 0, sizeof(notified));
+    sample_bus_init(&bus, bus_lock, bus_unlock, &bus_mutex);
+
+    CHECK(sample_bus_subscribe(&bus, &all, ring_all, 8, SAMPLE_KIND_ALL, count_notify, &notified[0]));
+    CHECK(sample_bus_subscribe(&bus, &light, ring_light, 8, SAMPLE_KIND_BIT(SAMPLE_KIND_LIGHT), count_notify, &notified[1]));
+    CHECK(sample_bus_subscribe(&bus, &full, ring_full, 2, SAMPLE_KIND_ALL, NULL, NULL));
+    CHECK(!sample_bus_subscribe(&bus, &full, ring_full, 0, SAMPLE_KIND_ALL, NULL, NULL));
+
+    CHECK_EQ(sample_bus_publish(&bus, SAMPLE_KIND_TEMPERATURE_BMP280, 21.5f, 1000), 1);
+    CHECK_EQ(sample_bus_publish(&bus, SAMPLE_KIND_LIGHT, 300.0f, 1010), 2);
+    CHECK_EQ(sample_bus_publish(&bus, SAMPLE_KIND_PRESSURE_BMP280, 1013.25f, 1020), 3);
+    CHECK_EQ(notified[0], 3);
+    CHECK_EQ(notified[1], 1);
+
+    sample_t s;
+    CHECK(sample_bus_pop(&bus, &all, &s));
+    CHECK_EQ(s.seq, 1);
+    CHECK_EQ(s.kind, SAMPLE_KIND_TEMPERATURE_BMP280);
+    CHECK_EQ(s.timestamp_ms, 1000);
+    CHECK(s.value == 21.5f);
+    CHECK(sample_bus_pop(&bus, &light, &s));
+    CHECK_EQ(s.seq, 2);
+    CHECK(s.value == 300.0f);
+    CHECK(!sample_bus_pop(&bus, &light, &s));
+
+    // Pełna kolejka traci najstarszą próbkę, pozostałe zostają w kolejności
+    CHECK_EQ(full.dropped, 1);
+    CHECK_EQ(full.delivered, 3);
+    CHECK_EQ(full.max_depth, 2);
+    CHECK(sample_bus_pop(&bus, &full, &s));
+    CHECK_EQ(s.seq, 2);
+    CHECK(sample_bus_pop(&bus, &full, &s));
+    CHECK_EQ(s.seq, 3);
+    CHECK(!sample_bus_pop(&bus, &full, &s));
+
+    // Zawijanie indeksu kolejki
+    for (int i = 0; i < 5; i++) {
+        sample_bus_publish(&bus, SAMPLE_KIND_HUMIDITY_BLE, (float)i, 2000);
+        CHECK(sample_bus_pop(&bus, &full, &s));
+        CHECK(s.value == (float)i);
+    }
+    CHECK_EQ(full.dropped, 1);
+}
+
+static void test_subscriber_limit(void) {
+    sample_bus_t bus;
+    static sample_subscriber_t subs[SAMPLE_BUS_MAX_SUBSCRIBERS + 1];
+    static sample_t rings[SAMPLE_BUS_MAX_SUBSCRIBERS + 1][1];
+    sample_bus_init(&bus, bus_lock, bus_unlock, &bus_mutex);
+    for (int i = 0; i < SAMPLE_BUS_MAX_SUBSCRIBERS; i++) {
+        CHECK(sample_bus_subscribe(&bus, &subs[i], rings[i], 1, SAMPLE_KIND_ALL, NULL, NULL));
+    }
+    CHECK(!sample_bus_subscribe(&bus, &subs[SAMPLE_BUS_MAX_SUBSCRIBERS], rings[SAMPLE_BUS_MAX_SUBSCRIBERS], 1,
+                                SAMPLE_KIND_ALL, NULL, NULL));
+}
+
+// Odbiorca w osobnym wątku budzony przez notify (odpowiednik powiadomienia taska)
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool pending;
+    sample_subscriber_t sub;
+    sample_t ring[64];
+    double *latency;
+    size_t popped;
+    uint32_t out_of_order;
+} consumer_t;
+
+#define CONSUMERS 4
+#define FLOOD_SAMPLES 500000
+
+static sample_bus_t bench_bus;
+static consumer_t consumers[CONSUMERS];
+static double *published_at;
+static atomic_bool stopping;
+
+static void consumer_notify(void *arg) {
+    consumer_t *c = arg;
+    pthread_mutex_lock(&c->mutex);
+    c->pending = true;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->mutex);
+}
+
+static void *consumer_thread(void *arg) {
+    consumer_t *c = arg;
+    uint32_t last = 0;
+    while (1) {
+        pthread_mutex_lock(&c->mutex);
+        while (!c->pending && !atomic_load(&stopping)) {
+            pthread_cond_wait(&c->cond, &c->mutex);
+        }
+        c->pending = false;
+        pthread_mutex_unlock(&c->mutex);
+
+        bool got = false;
+        sample_t s;
+        while (sample_bus_pop(&bench_bus, &c->sub, &s)) {
+            got = true;
+            if (s.seq <= last) {
+                c->out_of_order++;
+            }
+            last = s.seq;
+            c->latency[c->popped++] = test_now_s() - published_at[s.seq];
+        }
+        if (!got && atomic_load(&stopping)) {
+            return NULL;
+        }
+    }
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// pace_s == 0: publikacja bez przerw (przepustowość), > 0: co pace_s (opóźnienie)
+static void bench_pipeline(int samples, double pace_s) {
+    static const uint32_t kinds[CONSUMERS] = {
+        SAMPLE_KIND_ALL,
+        SAMPLE_KIND_BIT(SAMPLE_KIND_TEMPERATURE_BMP280) | SAMPLE_KIND_BIT(SAMPLE_KIND_LIGHT),
+        SAMPLE_KIND_ALL,
+        SAMPLE_KIND_ALL,
+    };
+    pthread_t threads[CONSUMERS];
+    published_at = calloc((size_t)samples + 1, sizeof(double));
+    atomic_store(&stopping, false);
+    sample_bus_init(&bench_bus, bus_lock, bus_unlock, &bus_mutex);
+    for (int i = 0; i < CONSUMERS; i++) {
+        consumer_t *c = &consumers[i];
+        memset(c, 0, sizeof(*c));
+        pthread_mutex_init(&c->mutex, NULL);
+        pthread_cond_init(&c->cond, NULL);
+        c->latency = calloc((size_t)samples, sizeof(double));
+        CHECK(sample_bus_subscribe(&bench_bus, &c->sub, c->ring, 64, kinds[i], consumer_notify, c));
+        pthread_create(&threads[i], NULL, consumer_thread, c);
+    }
+
+    double t0 = test_now_s();
+    for (int k = 1; k <= samples; k++) {
+        published_at[k] = test_now_s();
+        sample_bus_publish(&bench_bus, (sample_kind_t)(k % SAMPLE_KIND_COUNT), (float)k, (uint32_t)k);
+        if (pace_s > 0) {
+            double until = published_at[k] + pace_s;
+            while (test_now_s() < until) {
+            }
+        }
+    }
+    double elapsed = test_now_s() - t0;
+
+    atomic_store(&stopping, true);
+    for (int i = 0; i < CONSUMERS; i++) {
+        consumer_notify(&consumers[i]);
+        pthread_join(threads[i], NULL);
+    }
+
+    printf("%s: %d próbek, %.0f ns/publikację\n", pace_s > 0 ? "co 50 us" : "bez przerw", samples,
+           elapsed * 1e9 / samples);
+    for (int i = 0; i < CONSUMERS; i++) {
+        consumer_t *c = &consumers[i];
+        CHECK_EQ(c->out_of_order, 0);
+        CHECK_EQ(c->sub.delivered, c->popped + c->sub.dropped);
+        if (c->popped > 0) {
+            qsort(c->latency, c->popped, sizeof(double), compare_double);
+            printf("  odbiorca %d: dostarczono %u, utracono %u, max kolejka %u, p50 %.1f us, p99 %.1f us\n", i,
+                   c->sub.delivered, c->sub.dropped, c->sub.max_depth, c->latency[c->popped / 2] * 1e6,
+                   c->latency[c->popped * 99 / 100] * 1e6);
+        }
+        free(c->latency);
+        pthread_mutex_destroy(&c->mutex);
+        pthread_cond_destroy(&c->cond);
+    }
+    free(published_at);
+}
+
+int main(void) {
+    test_delivery();
+    test_subscriber_limit();
+    bench_pipeline(FLOOD_SAMPLES, 0);
+    bench_pipeline(10000, 50e-6);
+    TEST_DONE();
+}
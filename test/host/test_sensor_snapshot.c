@@ -0,0 +1,151 @@
+// Seqlock ostatnich odczytów (sensor_snapshot.h): zawartość pojedynczych zapisów
+// oraz test obciążeniowy - dwa wątki zapisujące i cztery czytające, każdy odczyt
+// musi pochodzić w całości z jednego zapisu, a numer zapisu nie może maleć.
+#include "sensor_snapshot.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void writer_lock(void *arg) {
+    pthread_mutex_lock(arg);
+}
+
+static void writer_unlock(void *arg) {
+    pthread_mutex_unlock(arg);
+}
+
+static void test_single_thread(void) {
+    sensor_snapshot_t snap;
+    sensor_readings_t r;
+    sensor_snapshot_init(&snap, writer_lock, writer_unlock, &writer_mutex);
+    sensor_snapshot_read(&snap, &r);
+    CHECK_EQ(r.seq, 0);
+    CHECK_EQ(r.valid, 0);
+
+    sensor_snapshot_begin(&snap);
+    sensor_snapshot_set(&snap, SAMPLE_KIND_TEMPERATURE_BMP280, 21.5f, 1000);
+    sensor_snapshot_set(&snap, SAMPLE_KIND_PRESSURE_BMP280, 1013.25f, 1000);
+    sensor_snapshot_set(&snap, SAMPLE_KIND_COUNT, 1.0f, 1000); // poza zakresem - pomijane
+    sensor_snapshot_end(&snap);
+
+    sensor_snapshot_begin(&snap);
+    sensor_snapshot_set(&snap, SAMPLE_KIND_LIGHT, 350.0f, 1500);
+    sensor_snapshot_end(&snap);
+
+    sensor_snapshot_read(&snap, &r);
+    CHECK_EQ(r.seq, 2);
+    CHECK_EQ(r.valid, SAMPLE_KIND_BIT(SAMPLE_KIND_TEMPERATURE_BMP280) | SAMPLE_KIND_BIT(SAMPLE_KIND_PRESSURE_BMP280) |
+                      SAMPLE_KIND_BIT(SAMPLE_KIND_LIGHT));
+    CHECK(r.values[SAMPLE_KIND_TEMPERATURE_BMP280] == 21.5f);
+    CHECK(r.values[SAMPLE_KIND_PRESSURE_BMP280] == 1013.25f);
+    CHECK(r.values[SAMPLE_KIND_LIGHT] == 350.0f);
+    CHECK_EQ(r.updated_ms[SAMPLE_KIND_TEMPERATURE_BMP280], 1000);
+    CHECK_EQ(r.updated_ms[SAMPLE_KIND_LIGHT], 1500);
+    CHECK_EQ(r.timestamp_ms, 1500);
+    CHECK_EQ(atomic_load(&snap.read_retries), 0);
+}
+
+#define WRITERS 2
+#define READERS 4
+#define STRESS_SECONDS 0.5
+
+static sensor_snapshot_t stress_snap;
+static atomic_bool stop;
+static atomic_uint writes;
+
+typedef struct {
+    uint32_t reads;
+    uint32_t torn;        ///< Odczyty łączące pola różnych zapisów
+    uint32_t backwards;   ///< Numer zapisu mniejszy niż w poprzednim odczycie
+} reader_result_t;
+
+// Każdy zapis ustawia wszystkie rodzaje: wartość = baza + rodzaj, czas = znacznik zapisu
+static void *writer_thread(void *arg) {
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    for (uint32_t n = 1; !atomic_load_explicit(&stop, memory_order_relaxed); n++) {
+        uint32_t stamp = id << 28 | (n & 0x0fffffff);
+        float base = (float)((n % 1000000) * 8);
+        sensor_snapshot_begin(&stress_snap);
+        for (int kind = 0; kind < SAMPLE_KIND_COUNT; kind++) {
+            sensor_snapshot_set(&stress_snap, (sample_kind_t)kind, base + (float)kind, stamp);
+        }
+        sensor_snapshot_end(&stress_snap);
+        atomic_fetch_add_explicit(&writes, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+static void *reader_thread(void *arg) {
+    reader_result_t *res = arg;
+    uint32_t last_seq = 0;
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        sensor_readings_t r;
+        sensor_snapshot_read(&stress_snap, &r);
+        res->reads++;
+        if (r.seq < last_seq) {
+            res->backwards++;
+        }
+        last_seq = r.seq;
+        if (r.seq == 0) {
+            continue;
+        }
+        bool consistent = r.valid == SAMPLE_KIND_ALL && r.timestamp_ms == r.updated_ms[0];
+        for (int kind = 1; kind < SAMPLE_KIND_COUNT; kind++) {
+            consistent = consistent && r.updated_ms[kind] == r.updated_ms[0] &&
+                         r.values[kind] == r.values[0] + (float)kind;
+        }
+        if (!consistent) {
+            res->torn++;
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent(void) {
+    pthread_t writers[WRITERS], readers[READERS];
+    reader_result_t results[READERS];
+    memset(results, 0, sizeof(results));
+    sensor_snapshot_init(&stress_snap, writer_lock, writer_unlock, &writer_mutex);
+    atomic_store(&stop, false);
+    atomic_store(&writes, 0);
+
+    for (int i = 0; i < READERS; i++) {
+        pthread_create(&readers[i], NULL, reader_thread, &results[i]);
+    }
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_create(&writers[i], NULL, writer_thread, (void *)(uintptr_t)(i + 1));
+    }
+    double until = test_now_s() + STRESS_SECONDS;
+    while (test_now_s() < until) {
+        sched_yield();
+    }
+    atomic_store(&stop, true);
+    for (int i = 0; i < WRITERS; i++) {
+        pthread_join(writers[i], NULL);
+    }
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+
+    uint32_t reads = 0;
+    for (int i = 0; i < READERS; i++) {
+        CHECK_EQ(results[i].torn, 0);
+        CHECK_EQ(results[i].backwards, 0);
+        reads += results[i].reads;
+    }
+    sensor_readings_t r;
+    sensor_snapshot_read(&stress_snap, &r);
+    CHECK_EQ(r.seq, atomic_load(&writes));
+    CHECK(reads > 0 && r.seq > 0);
+    printf("%u zapisów, %u odczytów, %u powtórzonych kopii\n", r.seq, reads,
+           atomic_load(&stress_snap.read_retries));
+}
+
+int main(void) {
+    test_single_thread();
+    test_concurrent();
+    TEST_DONE();
+}
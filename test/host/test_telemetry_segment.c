@@ -0,0 +1,156 @@
+// Format segmentu kolejki telemetrii (telemetry_segment.h): nagłówek, rekordy, CRC,
+// urwane i uszkodzone zapisy.
+#include "telemetry_segment.h"
+#include "test_util.h"
+
+static const char *TOPIC = "/user1/device1/bmp280/temperature";
+static const char *PAYLOAD = "{\"temperature\": 21.53}";
+
+static size_t encode(uint8_t *buf, size_t cap, uint32_t ts) {
+    return telemetry_record_encode(buf, cap, ts, TOPIC, strlen(TOPIC),
+                                   (const uint8_t *)PAYLOAD, strlen(PAYLOAD));
+}
+
+static void test_crc32(void) {
+    // Wartość kontrolna CRC-32/ISO-HDLC (zlib)
+    CHECK_EQ(telemetry_crc32(0, (const uint8_t *)"123456789", 9), 0xCBF43926u);
+    // Obliczenie w kawałkach daje ten sam wynik
+    uint32_t crc = telemetry_crc32(0, (const uint8_t *)"1234", 4);
+    CHECK_EQ(telemetry_crc32(crc, (const uint8_t *)"56789", 5), 0xCBF43926u);
+}
+
+static void test_header(void) {
+    uint8_t header[TELEMETRY_SEGMENT_HEADER_SIZE];
+    uint32_t seq = 0;
+    CHECK_EQ(telemetry_segment_header_encode(header, 0x1234abcd), TELEMETRY_SEGMENT_HEADER_SIZE);
+    CHECK_EQ(telemetry_segment_header_decode(header, sizeof(header), &seq), 0);
+    CHECK_EQ(seq, 0x1234abcd);
+    CHECK_EQ(telemetry_segment_header_decode(header, sizeof(header), NULL), 0);
+
+    // Układ little-endian opisany w nagłówku modułu
+    static const uint8_t expected[] = { 'T', 'Q', 'S', 'G', 1, 0, 0, 0, 0xcd, 0xab, 0x34, 0x12 };
+    CHECK_MEM(header, expected, sizeof(expected));
+
+    CHECK_EQ(telemetry_segment_header_decode(header, sizeof(header) - 1, &seq), -1);
+    header[0] ^= 0xff;
+    CHECK_EQ(telemetry_segment_header_decode(header, sizeof(header), &seq), -1);
+    header[0] ^= 0xff;
+    header[4] = 2; // inna wersja formatu
+    CHECK_EQ(telemetry_segment_header_decode(header, sizeof(header), &seq), -1);
+}
+
+static void test_record_roundtrip(void) {
+    uint8_t buf[TELEMETRY_RECORD_MAX_SIZE];
+    size_t len = encode(buf, sizeof(buf), 1700000000u);
+    CHECK_EQ(len, TELEMETRY_RECORD_HEADER_SIZE + strlen(TOPIC) + strlen(PAYLOAD) + TELEMETRY_RECORD_CRC_SIZE);
+    CHECK_EQ(telemetry_record_size(buf), len);
+
+    telemetry_record_t rec;
+    size_t consumed = 0;
+    CHECK_EQ(telemetry_record_decode(buf, len, &rec, &consumed), TELEMETRY_RECORD_OK);
+    CHECK_EQ(consumed, len);
+    CHECK_EQ(rec.timestamp, 1700000000u);
+    CHECK_EQ(rec.topic_len, strlen(TOPIC));
+    CHECK_MEM(rec.topic, TOPIC, rec.topic_len);
+    CHECK_EQ(rec.payload_len, strlen(PAYLOAD));
+    CHECK_MEM(rec.payload, PAYLOAD, rec.payload_len);
+
+    // Dane binarne (CBOR) z bajtami zerowymi i pusty ładunek
+    static const uint8_t binary[] = { 0xa1, 0x00, 0x61, 0x74, 0x00, 0xff };
+    len = telemetry_record_encode(buf, sizeof(buf), 1, "t", 1, binary, sizeof(binary));
+    CHECK(len > 0);
+    CHECK_EQ(telemetry_record_decode(buf, len, &rec, NULL), TELEMETRY_RECORD_OK);
+    CHECK_EQ(rec.payload_len, sizeof(binary));
+    CHECK_MEM(rec.payload, binary, sizeof(binary));
+    len = telemetry_record_encode(buf, sizeof(buf), 1, "t", 1, binary, 0);
+    CHECK_EQ(telemetry_record_decode(buf, len, &rec, NULL), TELEMETRY_RECORD_OK);
+    CHECK_EQ(rec.payload_len, 0);
+}
+
+static void test_record_limits(void) {
+    static uint8_t buf[TELEMETRY_RECORD_MAX_SIZE + 16];
+    static char topic[TELEMETRY_MAX_TOPIC_LEN + 2];
+    static uint8_t payload[TELEMETRY_MAX_PAYLOAD_LEN + 2];
+    memset(topic, 'a', sizeof(topic));
+    memset(payload, 'p', sizeof(payload));
+
+    // Największy dopuszczalny rekord mieści się dokładnie w TELEMETRY_RECORD_MAX_SIZE
+    size_t len = telemetry_record_encode(buf, TELEMETRY_RECORD_MAX_SIZE, 0, topic, TELEMETRY_MAX_TOPIC_LEN,
+                                         payload, TELEMETRY_MAX_PAYLOAD_LEN);
+    CHECK_EQ(len, TELEMETRY_RECORD_MAX_SIZE);
+
+    CHECK_EQ(telemetry_record_encode(buf, sizeof(buf), 0, topic, 0, payload, 1), 0);
+    CHECK_EQ(telemetry_record_encode(buf, sizeof(buf), 0, topic, TELEMETRY_MAX_TOPIC_LEN + 1, payload, 1), 0);
+    CHECK_EQ(telemetry_record_encode(buf, sizeof(buf), 0, topic, 1, payload, TELEMETRY_MAX_PAYLOAD_LEN + 1), 0);
+    CHECK_EQ(telemetry_record_encode(buf, TELEMETRY_RECORD_MAX_SIZE - 1, 0, topic, TELEMETRY_MAX_TOPIC_LEN,
+                                     payload, TELEMETRY_MAX_PAYLOAD_LEN), 0);
+
+    // Długości spoza zakresu w nagłówku rekordu
+    static const uint8_t zero_topic[TELEMETRY_RECORD_HEADER_SIZE] = { 0 };
+    CHECK_EQ(telemetry_record_size(zero_topic), 0);
+    static const uint8_t huge_payload[TELEMETRY_RECORD_HEADER_SIZE] = { 1, 0, 0xff, 0xff };
+    CHECK_EQ(telemetry_record_size(huge_payload), 0);
+    telemetry_record_t rec;
+    CHECK_EQ(telemetry_record_decode(huge_payload, sizeof(huge_payload), &rec, NULL), TELEMETRY_RECORD_CORRUPT);
+}
+
+static void test_truncated_and_corrupt(void) {
+    uint8_t buf[TELEMETRY_RECORD_MAX_SIZE];
+    size_t len = encode(buf, sizeof(buf), 42);
+    telemetry_record_t rec;
+
+    // Urwany zapis: każdy prefiks rekordu jest niepełny
+    for (size_t i = 0; i < len; i++) {
+        CHECK_EQ(telemetry_record_decode(buf, i, &rec, NULL), TELEMETRY_RECORD_INCOMPLETE);
+    }
+
+    // Przekłamanie dowolnego bitu poza długościami wykrywa CRC; zmiana długości daje
+    // rekord niepełny albo błędny, ale nigdy poprawny
+    for (size_t i = 0; i < len; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            buf[i] ^= (uint8_t)(1u << bit);
+            telemetry_record_status_t status = telemetry_record_decode(buf, len, &rec, NULL);
+            CHECK(status != TELEMETRY_RECORD_OK);
+            buf[i] ^= (uint8_t)(1u << bit);
+        }
+    }
+    CHECK_EQ(telemetry_record_decode(buf, len, &rec, NULL), TELEMETRY_RECORD_OK);
+}
+
+// Pełny segment jak w telemetry_queue.c: nagłówek i rekordy do 24 KB, odczyt po kolei
+static void test_segment_scan(void) {
+    static uint8_t segment[24 * 1024];
+    size_t offset = telemetry_segment_header_encode(segment, 7);
+    uint32_t written = 0;
+    size_t len, last_len = 0;
+    while ((len = encode(segment + offset, sizeof(segment) - offset, 1700000000u + written)) > 0) {
+        offset += len;
+        last_len = len;
+        written++;
+    }
+    CHECK(written > 300);
+
+    // Ostatni rekord urwany w połowie (zanik zasilania podczas zapisu)
+    size_t torn = offset - last_len / 2;
+
+    size_t pos = TELEMETRY_SEGMENT_HEADER_SIZE;
+    uint32_t read = 0;
+    telemetry_record_t rec;
+    size_t consumed;
+    while (telemetry_record_decode(segment + pos, torn - pos, &rec, &consumed) == TELEMETRY_RECORD_OK) {
+        CHECK_EQ(rec.timestamp, 1700000000u + read);
+        pos += consumed;
+        read++;
+    }
+    CHECK_EQ(read, written - 1);
+}
+
+int main(void) {
+    test_crc32();
+    test_header();
+    test_record_roundtrip();
+    test_record_limits();
+    test_truncated_and_corrupt();
+    test_segment_scan();
+    TEST_DONE();
+}
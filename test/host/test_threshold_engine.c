@@ -0,0 +1,182 @@
+// Silnik reguł progowych (threshold_engine.h): przypadki brzegowe histerezy, debounce,
+// NaN i przekompilowania reguł oraz koszt sprawdzenia próbki.
+#include "threshold_engine.h"
+#include "test_util.h"
+#include <math.h>
+
+static threshold_table_t table;
+static threshold_event_t events[THRESHOLD_MAX_RULES];
+
+static int eval(uint8_t channel, float value) {
+    return threshold_evaluate(&table, channel, value, events, THRESHOLD_MAX_RULES);
+}
+
+static void test_compile(void) {
+    const threshold_rule_t rules[] = {
+        { .id = 1, .channel = 2, .low = 10, .high = 30, .hysteresis = 1 },
+        { .id = 2, .channel = 0, .low = NAN, .high = 50, .hysteresis = 0 },
+        { .id = 3, .channel = 2, .low = NAN, .high = NAN },               // bez progów - pomijana
+        { .id = 4, .channel = THRESHOLD_MAX_CHANNELS, .low = 0, .high = 1 }, // zły kanał - pomijana
+        { .id = 5, .channel = 2, .low = 0, .high = NAN, .hysteresis = NAN },
+    };
+    CHECK_EQ(threshold_table_compile(&table, rules, 5), 3);
+    // Posortowane wg kanału, w kolejności podania
+    CHECK_EQ(table.count[0], 1);
+    CHECK_EQ(table.count[2], 2);
+    CHECK_EQ(table.entries[table.first[0]].id, 2);
+    CHECK_EQ(table.entries[table.first[2]].id, 1);
+    CHECK_EQ(table.entries[table.first[2] + 1].id, 5);
+    CHECK(table.entries[table.first[0]].enter_low == -INFINITY);
+    CHECK(table.entries[table.first[2] + 1].exit_low == 0.0f); // histereza NaN = 0
+
+    // Limit reguł
+    threshold_rule_t many[THRESHOLD_MAX_RULES + 5];
+    for (int i = 0; i < THRESHOLD_MAX_RULES + 5; i++) {
+        many[i] = (threshold_rule_t){ .id = (uint16_t)i, .channel = (uint8_t)(i % THRESHOLD_MAX_CHANNELS),
+                                      .low = 0, .high = 1 };
+    }
+    CHECK_EQ(threshold_table_compile(&table, many, THRESHOLD_MAX_RULES + 5), THRESHOLD_MAX_RULES);
+    CHECK_EQ(threshold_table_compile(&table, many, 0), 0);
+    CHECK_EQ(eval(0, 100.0f), 0);
+}
+
+static void test_hysteresis(void) {
+    const threshold_rule_t rule = { .id = 7, .channel = 1, .low = 10, .high = 30, .hysteresis = 2 };
+    threshold_table_compile(&table, &rule, 1);
+
+    CHECK_EQ(eval(1, 30.0f), 0);   // równo progowi - jeszcze norma
+    CHECK_EQ(eval(1, 30.01f), 1);
+    CHECK_EQ(events[0].id, 7);
+    CHECK_EQ(events[0].from, THRESHOLD_STATE_NORMAL);
+    CHECK_EQ(events[0].to, THRESHOLD_STATE_HIGH);
+    CHECK(events[0].value == 30.01f);
+    CHECK(events[0].threshold == 30.0f);
+    CHECK_EQ(eval(1, 29.0f), 0);   // w paśmie histerezy - alarm trwa
+    CHECK_EQ(eval(1, 28.01f), 0);
+    CHECK_EQ(eval(1, 28.0f), 1);   // próg wyjścia high - h
+    CHECK_EQ(events[0].to, THRESHOLD_STATE_NORMAL);
+    CHECK(events[0].threshold == 28.0f);
+
+    // Skok z LOW bezpośrednio do HIGH
+    CHECK_EQ(eval(1, 5.0f), 1);
+    CHECK_EQ(events[0].to, THRESHOLD_STATE_LOW);
+    CHECK_EQ(eval(1, 11.0f), 0);
+    CHECK_EQ(eval(1, 40.0f), 1);
+    CHECK_EQ(events[0].from, THRESHOLD_STATE_LOW);
+    CHECK_EQ(events[0].to, THRESHOLD_STATE_HIGH);
+    CHECK_EQ(threshold_rule_state(&table, 7), THRESHOLD_STATE_HIGH);
+
+    // Histereza większa niż połowa pasma jest przycinana - progi wyjścia się nie mijają
+    const threshold_rule_t wide = { .id = 8, .channel = 1, .low = 10, .high = 20, .hysteresis = 100 };
+    threshold_table_compile(&table, &wide, 1);
+    CHECK(table.entries[0].exit_low == 15.0f && table.entries[0].exit_high == 15.0f);
+    CHECK_EQ(eval(1, 25.0f), 1);
+    CHECK_EQ(eval(1, 15.0f), 1);
+    CHECK_EQ(events[0].to, THRESHOLD_STATE_NORMAL);
+}
+
+static void test_special_values(void) {
+    const threshold_rule_t rule = { .id = 1, .channel = 0, .low = -10, .high = 40, .debounce = 2 };
+    threshold_table_compile(&table, &rule, 1);
+
+    // NaN (awaria czujnika) nie zmienia stanu ani nie przerywa debounce
+    CHECK_EQ(eval(0, 50.0f), 0);
+    CHECK_EQ(eval(0, NAN), 0);
+    CHECK_EQ(eval(0, 50.0f), 1);
+    CHECK_EQ(eval(0, NAN), 0);
+    CHECK_EQ(threshold_rule_state(&table, 1), THRESHOLD_STATE_HIGH);
+
+    CHECK_EQ(eval(0, -INFINITY), 0);
+    CHECK_EQ(eval(0, -INFINITY), 1);
+    CHECK_EQ(events[0].to, THRESHOLD_STATE_LOW);
+    CHECK_EQ(eval(THRESHOLD_MAX_CHANNELS, 0.0f), 0);
+    CHECK_EQ(threshold_rule_state(&table, 99), THRESHOLD_STATE_NORMAL);
+
+    CHECK_STR(threshold_state_name(THRESHOLD_STATE_NORMAL), "normal");
+    CHECK_STR(threshold_state_name(THRESHOLD_STATE_LOW), "low");
+    CHECK_STR(threshold_state_name(THRESHOLD_STATE_HIGH), "high");
+}
+
+static void test_debounce(void) {
+    const threshold_rule_t rules[] = {
+        { .id = 1, .channel = 3, .low = NAN, .high = 100, .debounce = 3 },
+        { .id = 2, .channel = 3, .low = NAN, .high = 100, .debounce = 0 }, // 0 jak 1
+    };
+    threshold_table_compile(&table, rules, 2);
+
+    CHECK_EQ(eval(3, 150.0f), 1);
+    CHECK_EQ(events[0].id, 2);
+    CHECK_EQ(eval(3, 150.0f), 0);
+    CHECK_EQ(eval(3, 50.0f), 1);   // przerwanie serii dla reguły 1, powrót reguły 2
+    CHECK_EQ(events[0].id, 2);
+    CHECK_EQ(eval(3, 150.0f), 1);
+    CHECK_EQ(eval(3, 150.0f), 0);
+    CHECK_EQ(eval(3, 150.0f), 1);  // trzecia kolejna próbka
+    CHECK_EQ(events[0].id, 1);
+
+    // Więcej zdarzeń niż miejsca: stan i tak się zmienia
+    threshold_table_compile(&table, rules, 2);
+    threshold_evaluate(&table, 3, 150.0f, events, 0);
+    CHECK_EQ(threshold_rule_state(&table, 2), THRESHOLD_STATE_HIGH);
+}
+
+static void test_restore(void) {
+    const threshold_rule_t rules[] = {
+        { .id = 1, .channel = 0, .low = NAN, .high = 30 },
+        { .id = 2, .channel = 0, .low = NAN, .high = 35 },
+        { .id = 3, .channel = 0, .low = NAN, .high = 40, .debounce = 3 },
+    };
+    threshold_table_compile(&table, rules, 3);
+    eval(0, 50.0f);
+    eval(0, 50.0f);
+    CHECK_EQ(threshold_rule_state(&table, 1), THRESHOLD_STATE_HIGH);
+    CHECK_EQ(threshold_rule_state(&table, 2), THRESHOLD_STATE_HIGH);
+
+    // Reguła 2 zmieniona, reguła 3 przeniesiona z niedokończonym debounce
+    threshold_table_t previous = table;
+    threshold_rule_t changed[] = { rules[2], rules[1], rules[0] };
+    changed[1].high = 36;
+    threshold_table_compile(&table, changed, 3);
+    threshold_table_restore(&table, &previous);
+    CHECK_EQ(threshold_rule_state(&table, 1), THRESHOLD_STATE_HIGH);
+    CHECK_EQ(threshold_rule_state(&table, 2), THRESHOLD_STATE_NORMAL);
+    CHECK_EQ(eval(0, 50.0f), 2); // reguła 2 od nowa i trzecia próbka reguły 3
+    CHECK_EQ(threshold_rule_state(&table, 3), THRESHOLD_STATE_HIGH);
+}
+
+// Koszt próbki: wszystkie reguły na kanale próbki kontra po 4 reguły na kanał
+static void bench_evaluate(void) {
+    threshold_rule_t rules[THRESHOLD_MAX_RULES];
+    for (int spread = 0; spread < 2; spread++) {
+        for (int i = 0; i < THRESHOLD_MAX_RULES; i++) {
+            rules[i] = (threshold_rule_t){ .id = (uint16_t)i,
+                                           .channel = spread ? (uint8_t)(i % THRESHOLD_MAX_CHANNELS) : 0,
+                                           .low = (float)i, .high = 60.0f + (float)i, .hysteresis = 1,
+                                           .debounce = 2 };
+        }
+        threshold_table_compile(&table, rules, THRESHOLD_MAX_RULES);
+
+        const int n = 2000000;
+        uint32_t seed = 7;
+        long total_events = 0;
+        double t0 = test_now_s();
+        for (int k = 0; k < n; k++) {
+            float value = (float)(test_rand(&seed) % 10000) / 100.0f;
+            total_events += eval(spread ? (uint8_t)(k % THRESHOLD_MAX_CHANNELS) : 0, value);
+        }
+        double ns = (test_now_s() - t0) * 1e9 / n;
+        printf("%d reguł, %s: %.1f ns/próbkę (%ld zdarzeń)\n", THRESHOLD_MAX_RULES,
+               spread ? "po 4 na kanał" : "wszystkie na kanale 0", ns, total_events);
+        CHECK(total_events > 0);
+    }
+}
+
+int main(void) {
+    test_compile();
+    test_hysteresis();
+    test_special_values();
+    test_debounce();
+    test_restore();
+    bench_evaluate();
+    TEST_DONE();
+}
@@ -0,0 +1,197 @@
+// Śledzenie opóźnień (trace_buffer.h): pierścień punktów z nadpisywaniem i zapisami
+// z wielu wątków, histogram i percentyle, łańcuchy etapów oraz odczyt msg_id z PUBLISH.
+#include "trace_buffer.h"
+#include "test_util.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define RING_CAPACITY 64
+
+static trace_slot_t slots[RING_CAPACITY];
+static trace_ring_t ring;
+
+static void test_ring(void) {
+    trace_record_t out[RING_CAPACITY];
+    trace_ring_init(&ring, slots, RING_CAPACITY);
+    CHECK_EQ(trace_ring_snapshot(&ring, out, RING_CAPACITY), 0);
+
+    trace_ring_write(&ring, 100, TRACE_STAGE_TRIGGER, 0, 0, 1);
+    trace_ring_write(&ring, 150, TRACE_STAGE_ENQUEUE, 42, 0xbeef, 0);
+    CHECK_EQ(trace_ring_snapshot(&ring, out, RING_CAPACITY), 2);
+    CHECK_EQ(out[0].seq, 1);
+    CHECK_EQ(out[0].core, 1);
+    CHECK_EQ(out[1].time_us, 150);
+    CHECK_EQ(out[1].stage, TRACE_STAGE_ENQUEUE);
+    CHECK_EQ(out[1].id, 42);
+    CHECK_EQ(out[1].msg_id, 0xbeef);
+    CHECK_EQ(trace_ring_snapshot(&ring, out, 1), 1);
+
+    // Po przepełnieniu zostaje RING_CAPACITY najnowszych zapisów, od najstarszego
+    for (uint32_t i = 3; i <= 200; i++) {
+        trace_ring_write(&ring, i * 10, TRACE_STAGE_SEND, i, (uint16_t)i, 0);
+    }
+    CHECK_EQ(trace_ring_snapshot(&ring, out, RING_CAPACITY), RING_CAPACITY);
+    for (uint32_t i = 0; i < RING_CAPACITY; i++) {
+        CHECK_EQ(out[i].seq, 200 - RING_CAPACITY + 1 + i);
+        CHECK_EQ(out[i].id, out[i].seq);
+    }
+}
+
+#define WRITER_THREADS 3
+#define WRITES_PER_THREAD 200000
+
+static atomic_bool writers_done;
+
+// Zapis spójny, gdy wszystkie pola pochodzą z jednego wywołania: time_us = id * 3, msg_id = (uint16_t)id
+static void *ring_writer(void *arg) {
+    uint32_t thread = (uint32_t)(uintptr_t)arg;
+    for (uint32_t i = 1; i <= WRITES_PER_THREAD; i++) {
+        uint32_t id = thread << 24 | i;
+        trace_ring_write(&ring, id * 3, (trace_stage_t)(i % TRACE_STAGE_COUNT), id, (uint16_t)id, (uint8_t)thread);
+    }
+    return NULL;
+}
+
+static void test_ring_concurrent(void) {
+    static trace_record_t out[RING_CAPACITY];
+    pthread_t threads[WRITER_THREADS];
+    trace_ring_init(&ring, slots, RING_CAPACITY);
+    atomic_store(&writers_done, false);
+    for (int i = 0; i < WRITER_THREADS; i++) {
+        pthread_create(&threads[i], NULL, ring_writer, (void *)(uintptr_t)(i + 1));
+    }
+
+    uint32_t snapshots = 0, records = 0, torn = 0, unordered = 0;
+    int joined = 0;
+    while (joined < WRITER_THREADS) {
+        uint32_t n = trace_ring_snapshot(&ring, out, RING_CAPACITY);
+        for (uint32_t i = 0; i < n; i++) {
+            if (out[i].time_us != out[i].id * 3 || out[i].msg_id != (uint16_t)out[i].id ||
+                out[i].core != out[i].id >> 24 || out[i].stage != (out[i].id & 0xffffff) % TRACE_STAGE_COUNT) {
+                torn++;
+            }
+            if (i > 0 && out[i].seq <= out[i - 1].seq) {
+                unordered++;
+            }
+        }
+        records += n;
+        snapshots++;
+        if (snapshots % 64 == 0) {
+            // Wątki kończą pracę po WRITES_PER_THREAD zapisach
+            if (atomic_load(&ring.head) == WRITER_THREADS * WRITES_PER_THREAD) {
+                for (; joined < WRITER_THREADS; joined++) {
+                    pthread_join(threads[joined], NULL);
+                }
+            }
+        }
+    }
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(unordered, 0);
+    CHECK_EQ(trace_ring_snapshot(&ring, out, RING_CAPACITY), RING_CAPACITY);
+    printf("%u odczytów pierścienia, %u zapisów skopiowanych w trakcie zapisu z %d wątków\n",
+           snapshots, records, WRITER_THREADS);
+}
+
+static void test_histogram(void) {
+    trace_hist_t hist;
+    uint32_t counts[TRACE_HIST_BUCKETS];
+    for (int i = 0; i < TRACE_HIST_BUCKETS; i++) {
+        atomic_init(&hist.counts[i], 0);
+    }
+
+    CHECK_EQ(trace_hist_bucket_limit(0), 16);
+    CHECK_EQ(trace_hist_bucket_limit(1), 32);
+    CHECK_EQ(trace_hist_bucket_limit(TRACE_HIST_BUCKETS - 2), 16u << (TRACE_HIST_BUCKETS - 2));
+    CHECK_EQ(trace_hist_bucket_limit(TRACE_HIST_BUCKETS - 1), UINT32_MAX);
+
+    trace_hist_add(&hist, 0);
+    trace_hist_add(&hist, 15);
+    trace_hist_add(&hist, 16);          // granica należy do następnego przedziału
+    trace_hist_add(&hist, 31);
+    trace_hist_add(&hist, UINT32_MAX);  // ostatni przedział
+    CHECK_EQ(trace_hist_take(&hist, counts), 5);
+    CHECK_EQ(counts[0], 2);
+    CHECK_EQ(counts[1], 2);
+    CHECK_EQ(counts[TRACE_HIST_BUCKETS - 1], 1);
+    CHECK_EQ(trace_hist_take(&hist, counts), 0); // odczyt zeruje
+
+    CHECK_EQ(trace_hist_percentile(counts, 500), 0);
+    // 90 próbek < 16 us, 9 w przedziale 1-2 ms, 1 powyżej 8 ms
+    memset(counts, 0, sizeof(counts));
+    counts[0] = 90;
+    counts[7] = 9;
+    counts[10] = 1;
+    CHECK_EQ(trace_hist_percentile(counts, 0), 16);
+    CHECK_EQ(trace_hist_percentile(counts, 500), 16);
+    CHECK_EQ(trace_hist_percentile(counts, 900), 16);
+    CHECK_EQ(trace_hist_percentile(counts, 901), 2048);
+    CHECK_EQ(trace_hist_percentile(counts, 990), 2048);
+    CHECK_EQ(trace_hist_percentile(counts, 999), 16384);
+    CHECK_EQ(trace_hist_percentile(counts, 1000), 16384);
+}
+
+static void test_chains(void) {
+    static trace_chains_t table;
+    memset(&table, 0, sizeof(table));
+    trace_chain_info_t info;
+
+    CHECK(!trace_chain_get(&table, 5, &info));
+    CHECK(!trace_chain_advance(&table, 5, 10, TRACE_STAGE_ENCODE));
+    trace_chain_open(&table, 5, &(trace_chain_info_t){ .start_us = 100, .last_us = 100,
+                                                      .first_stage = TRACE_STAGE_TRIGGER,
+                                                      .last_stage = TRACE_STAGE_TRIGGER });
+    CHECK(trace_chain_advance(&table, 5, 180, TRACE_STAGE_ENCODE));
+    CHECK(trace_chain_get(&table, 5, &info));
+    CHECK_EQ(info.start_us, 100);
+    CHECK_EQ(info.last_us, 180);
+    CHECK_EQ(info.first_stage, TRACE_STAGE_TRIGGER);
+    CHECK_EQ(info.last_stage, TRACE_STAGE_ENCODE);
+
+    // Klucz o tym samym gnieździe nadpisuje łańcuch
+    trace_chain_open(&table, 5 + TRACE_CHAINS, &(trace_chain_info_t){ .start_us = 200, .last_us = 200 });
+    CHECK(!trace_chain_get(&table, 5, &info));
+    CHECK(trace_chain_close(&table, 5 + TRACE_CHAINS, &info));
+    CHECK_EQ(info.start_us, 200);
+    CHECK(!trace_chain_close(&table, 5 + TRACE_CHAINS, &info)); // już zamknięty
+
+    // Klucz 0 (np. msg_id 0) i największy klucz
+    trace_chain_open(&table, 0, &(trace_chain_info_t){ .start_us = 1 });
+    CHECK(trace_chain_get(&table, 0, &info) && info.start_us == 1);
+    trace_chain_open(&table, UINT32_MAX - 1, &(trace_chain_info_t){ .start_us = 2 });
+    CHECK(trace_chain_get(&table, UINT32_MAX - 1, &info) && info.start_us == 2);
+}
+
+static void test_publish_id(void) {
+    uint16_t id = 0;
+    // PUBLISH QoS 1, temat "a/b", msg_id 0x1234, dane "x"
+    static const uint8_t qos1[] = { 0x32, 0x08, 0x00, 0x03, 'a', '/', 'b', 0x12, 0x34, 'x' };
+    CHECK(trace_mqtt_publish_id(qos1, sizeof(qos1), &id));
+    CHECK_EQ(id, 0x1234);
+    // Wystarczy nagłówek do msg_id włącznie
+    CHECK(trace_mqtt_publish_id(qos1, 9, &id));
+    for (size_t len = 0; len < 9; len++) {
+        CHECK(!trace_mqtt_publish_id(qos1, len, &id));
+    }
+
+    // QoS 2 z dwubajtową długością pozostałej części
+    uint8_t qos2[300] = { 0x34, 0xab, 0x02, 0x00, 0x01, 't', 0xff, 0xfe };
+    CHECK(trace_mqtt_publish_id(qos2, sizeof(qos2), &id));
+    CHECK_EQ(id, 0xfffe);
+
+    static const uint8_t qos0[] = { 0x30, 0x04, 0x00, 0x01, 't', 'x' };
+    CHECK(!trace_mqtt_publish_id(qos0, sizeof(qos0), &id));
+    static const uint8_t puback[] = { 0x40, 0x02, 0x12, 0x34 };
+    CHECK(!trace_mqtt_publish_id(puback, sizeof(puback), &id));
+    // Długość zapisana na ponad 4 bajtach
+    static const uint8_t bad_length[] = { 0x32, 0xff, 0xff, 0xff, 0xff, 0x01, 0x00, 0x01, 't', 0x00, 0x01 };
+    CHECK(!trace_mqtt_publish_id(bad_length, sizeof(bad_length), &id));
+}
+
+int main(void) {
+    test_ring();
+    test_ring_concurrent();
+    test_histogram();
+    test_chains();
+    test_publish_id();
+    TEST_DONE();
+}
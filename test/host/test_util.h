@@ -0,0 +1,72 @@
+/**
+ * @file test_util.h
+ * Asercje i pomiar czasu dla testów hosta (bez zewnętrznych bibliotek).
+ *
+ * CHECK*() zapisują błąd z plikiem i linią i pozwalają testowi działać dalej;
+ * TEST_DONE() kończy main() kodem 1, gdy którakolwiek asercja zawiodła.
+ */
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        long long a_ = (long long)(actual), e_ = (long long)(expected); \
+        if (a_ != e_) { \
+            fprintf(stderr, "%s:%d: %s == %lld, oczekiwano %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_STR(actual, expected) do { \
+        const char *a_ = (actual), *e_ = (expected); \
+        if (strcmp(a_, e_) != 0) { \
+            fprintf(stderr, "%s:%d: %s == \"%s\", oczekiwano \"%s\"\n", __FILE__, __LINE__, #actual, a_, e_); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_MEM(actual, expected, len) do { \
+        if (memcmp((actual), (expected), (len)) != 0) { \
+            fprintf(stderr, "%s:%d: %s - różne bajty\n", __FILE__, __LINE__, #actual); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define TEST_DONE() do { \
+        if (test_failures) { \
+            fprintf(stderr, "%d asercji nie powiodło się\n", test_failures); \
+            return 1; \
+        } \
+        printf("OK\n"); \
+        return 0; \
+    } while (0)
+
+static inline double test_now_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// Deterministyczny generator (xorshift32) - powtarzalne dane testów i fuzzingu
+static inline uint32_t test_rand(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+#endif // TEST_UTIL_H
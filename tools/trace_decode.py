@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""Dekoder zrzutu śledzenia opóźnień (GET /trace, main/latency_trace.h).
+
+Użycie:
+    curl http://<ip>/trace -o trace.bin
+    python3 tools/trace_decode.py trace.bin [--chains N]
+
+Wypisuje przebieg ostatnich łańcuchów (pomiar -> potwierdzenie brokera) i statystyki
+czasu między kolejnymi etapami. Czasy są liczone względem chwili zrzutu.
+"""
+import argparse
+import struct
+import sys
+
+DUMP_MAGIC = 0x4352544C
+DUMP_VERSION = 1
+
+_HEADER = struct.Struct('<IHHIHH')
+_COUNT = struct.Struct('<I')
+_RECORD = struct.Struct('<IIIHBB')
+
+STAGES = ['trigger', 'acquire', 'encode', 'enqueue', 'send', 'ack']
+TRIGGER, ACQUIRE, ENCODE, ENQUEUE, SEND, ACK = range(len(STAGES))
+
+
+class Record:
+    def __init__(self, time_us, id, seq, msg_id, stage, core, now_us):
+        # Wiek względem zrzutu rozwija przepełnienie 32-bitowego licznika (co ~71 min)
+        self.t = -((now_us - time_us) & 0xFFFFFFFF)
+        self.id = id
+        self.seq = seq
+        self.msg_id = msg_id
+        self.stage = stage
+        self.core = core
+
+
+def parse(data):
+    if len(data) < _HEADER.size:
+        raise ValueError("zrzut krótszy niż nagłówek")
+    magic, version, record_size, now_us, core_count, capacity = _HEADER.unpack_from(data, 0)
+    if magic != DUMP_MAGIC:
+        raise ValueError(f"nieprawidłowy znacznik 0x{magic:08x}")
+    if version != DUMP_VERSION or record_size != _RECORD.size:
+        raise ValueError(f"nieobsługiwana wersja {version} (zapis {record_size} B)")
+    pos = _HEADER.size
+    records = []
+    lost = 0
+    for core in range(core_count):
+        (count,) = _COUNT.unpack_from(data, pos)
+        pos += _COUNT.size
+        core_records = []
+        for _ in range(count):
+            core_records.append(Record(*_RECORD.unpack_from(data, pos), now_us))
+            pos += _RECORD.size
+        # Luki w numerach zapisów - gniazda nadpisane w czasie kopiowania
+        for a, b in zip(core_records, core_records[1:]):
+            lost += b.seq - a.seq - 1
+        records.extend(core_records)
+    records.sort(key=lambda r: (r.t, r.core, r.seq))
+    return capacity, core_count, records, lost
+
+
+def link(records):
+    """Łańcuchy: etapy próbki po numerze z szyny, dalej etapy wiadomości po msg_id."""
+    chains = []
+    samples = {}    # Numer próbki -> TRIGGER/ACQUIRE
+    encoded = set()
+    pending = {}    # Numer próbki -> łańcuch po ENCODE, czekający na ENQUEUE
+    messages = {}   # msg_id -> łańcuch czekający na SEND/ACK
+    last_trigger = None
+    for r in records:
+        if r.stage == TRIGGER:
+            last_trigger = r
+        elif r.stage == ACQUIRE:
+            samples[r.id] = {TRIGGER: last_trigger, ACQUIRE: r} if last_trigger else {ACQUIRE: r}
+            last_trigger = None
+        elif r.stage == ENCODE:
+            # Próbka publikowana dla kilku urządzeń - każde kodowanie to osobna wiadomość
+            chain = dict(samples.get(r.id, {}))
+            chain[ENCODE] = r
+            encoded.add(r.id)
+            pending[r.id] = chain
+            chains.append(chain)
+        elif r.stage == ENQUEUE:
+            chain = pending.pop(r.id, None)
+            if chain is None:
+                chain = {}
+                chains.append(chain)
+            chain[ENQUEUE] = r
+            if r.msg_id:
+                messages[r.msg_id] = chain
+        elif r.stage in (SEND, ACK):
+            chain = messages.get(r.msg_id)
+            if chain is None or r.stage in chain:
+                continue  # Ponowienie (DUP) albo wiadomość sprzed początku bufora
+            chain[r.stage] = r
+            if r.stage == ACK:
+                del messages[r.msg_id]
+    # Próbki bez publikacji (brak urządzenia w konfiguracji albo kodowanie poza buforem)
+    chains.extend(chain for seq, chain in samples.items() if seq not in encoded)
+    chains.sort(key=lambda c: min(r.t for r in c.values()))
+    return chains
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def print_chain(chain):
+    stages = sorted(chain)
+    first = chain[stages[0]]
+    seq = next((chain[s].id for s in (ACQUIRE, ENCODE, ENQUEUE) if s in chain), None)
+    msg_id = chain[ENQUEUE].msg_id if ENQUEUE in chain else 0
+    head = f"{first.t / 1000:12.3f} ms  próbka {seq if seq is not None else '?'}"
+    if msg_id:
+        head += f"  msg_id {msg_id}"
+    parts = []
+    prev = first
+    for s in stages:
+        r = chain[s]
+        parts.append(STAGES[s] if r is first else f"+{r.t - prev.t} us {STAGES[s]}")
+        prev = r
+    parts_text = " -> ".join(parts)
+    print(f"{head}\n    {parts_text} (rdzeń {'/'.join(str(chain[s].core) for s in stages)})")
+
+
+def print_stats(chains):
+    deltas = {}
+    for chain in chains:
+        stages = sorted(chain)
+        for a, b in zip(stages, stages[1:]):
+            deltas.setdefault(f"{STAGES[a]} -> {STAGES[b]}", []).append(chain[b].t - chain[a].t)
+        if ACQUIRE in chain and ACK in chain:
+            deltas.setdefault("acquire -> ack", []).append(chain[ACK].t - chain[ACQUIRE].t)
+    print(f"{'etap':<22}{'n':>6}{'min':>10}{'mediana':>10}{'p99':>10}{'max':>10}  [us]")
+    order = {f"{a} -> {b}": i * 10 + j for i, a in enumerate(STAGES) for j, b in enumerate(STAGES)}
+    for name in sorted(deltas, key=lambda n: (n == "acquire -> ack", order.get(n, 0))):
+        values = sorted(deltas[name])
+        print(f"{name:<22}{len(values):>6}{values[0]:>10}{percentile(values, 0.5):>10}"
+              f"{percentile(values, 0.99):>10}{values[-1]:>10}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Dekoder zrzutu GET /trace")
+    parser.add_argument("dump", help="plik zrzutu (curl http://<ip>/trace -o trace.bin)")
+    parser.add_argument("--chains", type=int, default=20, help="liczba wypisanych łańcuchów (0 - wszystkie)")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+    try:
+        capacity, core_count, records, lost = parse(data)
+    except (ValueError, struct.error) as e:
+        print(f"Błąd zrzutu: {e}", file=sys.stderr)
+        return 1
+
+    print(f"Zapisów: {len(records)} (rdzeni: {core_count}, bufor: {capacity} na rdzeń, pominiętych: {lost})")
+    if not records:
+        return 0
+    chains = link(records)
+    shown = chains if args.chains == 0 else chains[-args.chains:]
+    print(f"\nŁańcuchy: {len(chains)}, ostatnie {len(shown)} (czas względem zrzutu):")
+    for chain in shown:
+        print_chain(chain)
+    print()
+    print_stats(chains)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())